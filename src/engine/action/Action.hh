@@ -0,0 +1,104 @@
+#pragma once
+
+#include "state/Shop.hh"
+#include "state/Unit.hh"
+
+#include "def/Level.hh"
+#include "def/Location.hh"
+#include "def/UnitDef.hh"
+#include "def/WeaponDef.hh"
+
+#include <cstdint>
+
+namespace freeisle::action {
+
+/**
+ * A single action that the player at turn can take.
+ *
+ * Actions refer to the objects of the state they were generated from, and
+ * are only valid as long as that state is not modified.
+ */
+struct Action {
+  enum class Type : uint8_t {
+    /**
+     * Move unit to location.
+     */
+    Move,
+
+    /**
+     * Move unit, which is contained in a unit or shop, out of its container
+     * to location.
+     */
+    Unload,
+
+    /**
+     * Move unit to location, and load it into the container of target, or
+     * of shop if target is not set.
+     */
+    Load,
+
+    /**
+     * Move unit into shop at location, and take over the shop.
+     */
+    Capture,
+
+    /**
+     * Attack target with weapon of unit.
+     */
+    Attack,
+
+    /**
+     * Resupply target with the supplies of unit.
+     */
+    Resupply,
+
+    /**
+     * Change the level of unit to level.
+     */
+    Soar,
+
+    /**
+     * Produce a unit with definition unit_def in shop.
+     */
+    Produce,
+  };
+
+  Type type;
+
+  /**
+   * New level of the unit, for Soar.
+   */
+  def::Level level;
+
+  /**
+   * Unit performing the action. Not set for Produce.
+   */
+  const state::Unit *unit;
+
+  /**
+   * Unit that is attacked, resupplied or loaded into.
+   */
+  const state::Unit *target;
+
+  /**
+   * Shop that is loaded into, captured or produced in.
+   */
+  const state::Shop *shop;
+
+  /**
+   * Weapon used for Attack.
+   */
+  const def::WeaponDef *weapon;
+
+  /**
+   * Definition of the unit to produce, for Produce.
+   */
+  const def::UnitDef *unit_def;
+
+  /**
+   * Destination of the unit, for Move, Unload, Load and Capture.
+   */
+  def::Location location;
+};
+
+} // namespace freeisle::action
@@ -0,0 +1,192 @@
+#include "action/Generator.hh"
+
+#include "action/Rules.hh"
+
+#include "state/Allegiance.hh"
+
+#include <algorithm>
+
+namespace freeisle::action {
+
+Generator::Generator() = default;
+
+const std::vector<Action> &
+Generator::generate(const state::State &state,
+                    const spatial::UnitIndex &index) {
+  return run(state, index, [this, &state](const state::Unit &unit) -> auto & {
+    return pathfinder_.compute(state.map, unit);
+  });
+}
+
+const std::vector<Action> &
+Generator::generate(const state::State &state, const spatial::UnitIndex &index,
+                    const path::CostTable &costs) {
+  return run(state, index,
+             [this, &state, &costs](const state::Unit &unit) -> auto & {
+               return pathfinder_.compute(state.map, unit, costs);
+             });
+}
+
+const std::vector<Action> &Generator::actions() const { return actions_; }
+
+template <typename ComputeFn>
+const std::vector<Action> &Generator::run(const state::State &state,
+                                          const spatial::UnitIndex &index,
+                                          ComputeFn compute) {
+  actions_.clear();
+  if (!state.player_at_turn) {
+    return actions_;
+  }
+
+  const state::Player &player = *state.player_at_turn;
+  for (const def::Ref<state::Unit> &ref : player.units) {
+    const state::Unit &unit = *ref;
+    if (unit.health == 0) {
+      continue;
+    }
+
+    if (can_move(unit)) {
+      add_movement(state.map, unit, compute(unit));
+    }
+
+    if (!is_on_map(unit)) {
+      continue;
+    }
+
+    if (can_act(unit)) {
+      add_attacks(index, unit);
+      add_resupplies(index, unit);
+    }
+
+    if (unit.def->caps.is_set(def::UnitDef::Cap::Soar) && !unit.has_soared) {
+      add_soaring(state.map, unit);
+    }
+  }
+
+  add_production(state, player);
+  return actions_;
+}
+
+void Generator::add_movement(const state::Map &map, const state::Unit &unit,
+                             const std::vector<path::Node> &nodes) {
+  const bool subsurface = unit.level == def::Level::UnderWater;
+  const Action::Type move =
+      is_on_map(unit) ? Action::Type::Move : Action::Type::Unload;
+
+  // The first node is the unit's own location
+  for (size_t i = 1; i < nodes.size(); ++i) {
+    const path::Node &node = nodes[i];
+    const def::Location loc = node.location;
+    const state::Map::Hex hex = map.grid(loc.x, loc.y);
+
+    if (hex.has_shop()) {
+      const state::Shop &shop = *map.shop(loc.x, loc.y);
+      if (state::are_allied(shop.owner, unit.owner)) {
+        if (can_load(unit, shop.container, shop.owner)) {
+          actions_.push_back(Action{.type = Action::Type::Load,
+                                    .unit = &unit,
+                                    .shop = &shop,
+                                    .location = loc});
+        }
+      } else if (unit.def->caps.is_set(def::UnitDef::Cap::Capture) &&
+                 shop.container.units.empty()) {
+        actions_.push_back(Action{.type = Action::Type::Capture,
+                                  .unit = &unit,
+                                  .shop = &shop,
+                                  .location = loc});
+      }
+    } else if (node.can_stop) {
+      actions_.push_back(Action{.type = move, .unit = &unit, .location = loc});
+    } else {
+      // Occupied by a friendly unit, which the unit might be loaded into
+      const state::Unit &other = *map.unit(loc.x, loc.y, subsurface);
+      if (can_load(unit, other.container, other.owner)) {
+        actions_.push_back(Action{.type = Action::Type::Load,
+                                  .unit = &unit,
+                                  .target = &other,
+                                  .location = loc});
+      }
+    }
+  }
+}
+
+void Generator::add_attacks(const spatial::UnitIndex &index,
+                            const state::Unit &unit) {
+  const def::Location loc = unit.location;
+  for (const auto &[weapon, ammo] : unit.ammo) {
+    if (ammo == 0) {
+      continue;
+    }
+
+    const def::WeaponDef &weapon_def = *weapon;
+    index.for_each_enemy_in_range(
+        *unit.owner, loc.x, loc.y, weapon_def.min_range, weapon_def.max_range,
+        spatial::AllLevels, [this, &unit, &weapon_def](state::Unit &target) {
+          actions_.push_back(Action{.type = Action::Type::Attack,
+                                    .unit = &unit,
+                                    .target = &target,
+                                    .weapon = &weapon_def});
+        });
+  }
+}
+
+void Generator::add_resupplies(const spatial::UnitIndex &index,
+                               const state::Unit &unit) {
+  const def::Resupply &supplies = unit.supplies;
+  if (supplies.fuel == 0 && supplies.repair == 0 &&
+      std::all_of(supplies.ammo.data(),
+                  supplies.ammo.data() + supplies.ammo.size(),
+                  [](uint32_t ammo) { return ammo == 0; })) {
+    return;
+  }
+
+  const def::Location loc = unit.location;
+  index.for_each_in_range(
+      loc.x, loc.y, 0, 1, spatial::AllLevels,
+      [this, &unit](state::Unit &target) {
+        if (&target != &unit && state::are_allied(target.owner, unit.owner) &&
+            can_resupply(unit, target)) {
+          actions_.push_back(Action{.type = Action::Type::Resupply,
+                                    .unit = &unit,
+                                    .target = &target});
+        }
+      });
+}
+
+void Generator::add_soaring(const state::Map &map, const state::Unit &unit) {
+  const def::Level level = soar_level(unit.level);
+  if (level == unit.level) {
+    return;
+  }
+
+  // Changing between surface and subsurface needs the other layer free
+  const def::Location loc = unit.location;
+  const bool subsurface = level == def::Level::UnderWater;
+  if (subsurface != (unit.level == def::Level::UnderWater) &&
+      map.unit(loc.x, loc.y, subsurface)) {
+    return;
+  }
+
+  actions_.push_back(
+      Action{.type = Action::Type::Soar, .level = level, .unit = &unit});
+}
+
+void Generator::add_production(const state::State &state,
+                               const state::Player &player) {
+  for (const auto &[id, shop] : state.shops) {
+    if (!shop.owner || &*shop.owner != &player) {
+      continue;
+    }
+
+    for (const def::Ref<def::UnitDef> &unit_def : shop.def->production_list) {
+      if (unit_def->value <= player.wealth &&
+          can_contain(shop.container, *unit_def, unit_def->level)) {
+        actions_.push_back(Action{.type = Action::Type::Produce,
+                                  .shop = &shop,
+                                  .unit_def = &*unit_def});
+      }
+    }
+  }
+}
+
+} // namespace freeisle::action
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "action/Action.hh"
+
+#include "spatial/UnitIndex.hh"
+
+#include "path/CostTable.hh"
+#include "path/Pathfinder.hh"
+
+#include "state/State.hh"
+#include "state/Unit.hh"
+
+#include <vector>
+
+namespace freeisle::action {
+
+/**
+ * Generates all legal actions of the player at turn.
+ *
+ * A generator keeps its scratch memory, including the pathfinder and the
+ * list of actions, between calls, so that once it has seen a state of a
+ * given size, generating actions does not allocate. Reuse one generator
+ * object per thread.
+ *
+ * Rules, in addition to the movement rules of path::Pathfinder:
+ *  - Units with movement points and fuel left can move to any hex they can
+ *    stop on. Units contained in a unit or shop unload this way.
+ *  - Units can move into a unit or shop of the same owner if its container
+ *    has room for them, and if they do not contain units themselves.
+ *  - Units with the Capture capability can move into a shop that is not
+ *    owned by an ally, if the shop does not contain any units.
+ *  - Units on the map can attack enemy units within range of any weapon
+ *    with ammo left, and resupply allied units on the same or an adjacent
+ *    hex that need anything they can supply. Only one action is possible
+ *    per turn, and units with the NoActionAfterMove capability cannot act
+ *    after moving.
+ *  - After an action, only units with the MoveAfterAction capability can
+ *    move.
+ *  - Units with the Soar capability can change their level once per turn,
+ *    see soar_level(), if the hex is free at the new level.
+ *  - Shops owned by the player can produce every unit of their production
+ *    list that the player can afford and that fits into the shop.
+ */
+class Generator {
+public:
+  Generator();
+
+  Generator(const Generator &) = delete;
+  Generator(Generator &&) = default;
+  Generator &operator=(const Generator &) = delete;
+  Generator &operator=(Generator &&) = default;
+
+  /**
+   * Generate all legal actions of the player at turn in the given state.
+   * The index must contain all units on the map. The result is valid until
+   * the next call to generate().
+   */
+  const std::vector<Action> &generate(const state::State &state,
+                                      const spatial::UnitIndex &index);
+
+  /**
+   * Same as above, but looks up movement costs in the given precompiled
+   * cost table.
+   */
+  const std::vector<Action> &generate(const state::State &state,
+                                      const spatial::UnitIndex &index,
+                                      const path::CostTable &costs);
+
+  /**
+   * Returns the actions generated by the last call to generate().
+   */
+  const std::vector<Action> &actions() const;
+
+private:
+  template <typename ComputeFn>
+  const std::vector<Action> &run(const state::State &state,
+                                 const spatial::UnitIndex &index,
+                                 ComputeFn compute);
+
+  void add_movement(const state::Map &map, const state::Unit &unit,
+                    const std::vector<path::Node> &nodes);
+  void add_attacks(const spatial::UnitIndex &index, const state::Unit &unit);
+  void add_resupplies(const spatial::UnitIndex &index,
+                      const state::Unit &unit);
+  void add_soaring(const state::Map &map, const state::Unit &unit);
+  void add_production(const state::State &state, const state::Player &player);
+
+  path::Pathfinder pathfinder_;
+  std::vector<Action> actions_;
+};
+
+} // namespace freeisle::action
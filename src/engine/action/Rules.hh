@@ -0,0 +1,127 @@
+#pragma once
+
+#include "state/Allegiance.hh"
+#include "state/Container.hh"
+#include "state/Unit.hh"
+
+#include "def/ContainerDef.hh"
+#include "def/Level.hh"
+#include "def/UnitDef.hh"
+
+#include <cstdint>
+
+namespace freeisle::action {
+
+/**
+ * Returns whether the unit is on the map, i.e. not contained in a unit or
+ * shop.
+ */
+inline bool is_on_map(const state::Unit &unit) {
+  return !unit.contained_in_unit && !unit.contained_in_shop;
+}
+
+/**
+ * Returns whether the unit has moved during this turn.
+ */
+inline bool has_moved(const state::Unit &unit) {
+  return unit.movement < unit.def->movement;
+}
+
+/**
+ * Returns whether the unit can still move during this turn: it needs
+ * movement points and fuel, and after an action only units with the
+ * MoveAfterAction capability can move.
+ */
+inline bool can_move(const state::Unit &unit) {
+  return unit.movement > 0 && unit.fuel > 0 &&
+         (!unit.has_actioned ||
+          unit.def->caps.is_set(def::UnitDef::Cap::MoveAfterAction));
+}
+
+/**
+ * Returns whether the unit can still perform an action (attack or
+ * resupply) during this turn: only one action is possible per turn, and
+ * units with the NoActionAfterMove capability cannot act after moving.
+ */
+inline bool can_act(const state::Unit &unit) {
+  return !unit.has_actioned &&
+         !(unit.def->caps.is_set(def::UnitDef::Cap::NoActionAfterMove) &&
+           has_moved(unit));
+}
+
+/**
+ * Returns whether a unit with the given definition at the given level fits
+ * into the given container, in addition to the units already contained.
+ */
+inline bool can_contain(const state::Container &container,
+                        const def::UnitDef &def, def::Level level) {
+  if (container.units.size() >= container.def->max_units ||
+      !container.def->supported_levels.is_set(level)) {
+    return false;
+  }
+
+  uint32_t weight = def.weight;
+  for (const def::Ref<state::Unit> &unit : container.units) {
+    weight += unit->def->weight;
+  }
+
+  return weight <= container.def->max_weight;
+}
+
+/**
+ * Returns whether the given unit can be loaded into a container owned by
+ * the given player. Containers only hold units of their own owner, and
+ * units that contain other units cannot be loaded.
+ */
+inline bool can_load(const state::Unit &unit, const state::Container &container,
+                     const def::NullableRef<state::Player> &owner) {
+  return owner && unit.owner == owner && unit.container.units.empty() &&
+         can_contain(container, *unit.def, unit.level);
+}
+
+/**
+ * Returns the level that a unit with the Soar capability at the given
+ * level can change to: water units can dive under water and air units can
+ * climb to high air, and back. Returns the given level itself if no
+ * change is possible.
+ */
+inline def::Level soar_level(def::Level level) {
+  switch (level) {
+  case def::Level::UnderWater:
+    return def::Level::Water;
+  case def::Level::Water:
+    return def::Level::UnderWater;
+  case def::Level::Air:
+    return def::Level::HighAir;
+  case def::Level::HighAir:
+    return def::Level::Air;
+  default:
+    return level;
+  }
+}
+
+/**
+ * Returns whether the supplier can resupply the target with anything: fuel,
+ * repair, or ammo for one of its weapons.
+ */
+inline bool can_resupply(const state::Unit &supplier,
+                         const state::Unit &target) {
+  if (supplier.supplies.fuel > 0 && target.fuel < target.def->fuel) {
+    return true;
+  }
+
+  if (supplier.supplies.repair > 0 && target.health < 100) {
+    return true;
+  }
+
+  for (const auto &[weapon, ammo] : target.ammo) {
+    if (ammo < weapon->ammo &&
+        supplier.supplies.ammo[weapon->damage_type] > 0) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+} // namespace freeisle::action
@@ -0,0 +1,113 @@
+#include "action/Generator.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  Fixture(uint32_t size, uint32_t num_units) : Scenario(size, size) {
+    freeisle::def::UnitDef &tank =
+        add_unit_def("tank", freeisle::def::UnitDef{
+                                 .name = "tank",
+                                 .level = freeisle::def::Level::Land,
+                                 .movement = 300,
+                                 .fuel = 50,
+                             });
+    tank.movement_cost[freeisle::def::OverlayTerrainType::Road] = 50;
+    tank.weapons.try_emplace("cannon", freeisle::def::WeaponDef{
+                                           .damage = 100,
+                                           .min_range = 1,
+                                           .max_range = 2,
+                                           .ammo = 5,
+                                       });
+
+    // two teams of two players each
+    add_team("north");
+    add_team("south");
+    for (uint32_t i = 0; i < 4; ++i) {
+      add_player("player" + std::to_string(i), i % 2 ? "north" : "south");
+    }
+    state.player_at_turn = state.players.find("player0");
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> coord(0, size - 1);
+    for (uint32_t y = 0; y < size; ++y) {
+      for (uint32_t x = 0; x < size; ++x) {
+        if (coord(rng) % 5 == 0) {
+          scenario.map.grid(x, y).overlay_terrain =
+              freeisle::def::OverlayTerrainType::Road;
+        }
+      }
+    }
+
+    for (uint32_t i = 0; i < num_units; ++i) {
+      uint32_t x, y;
+      do {
+        x = coord(rng);
+        y = coord(rng);
+      } while (state.map.surface_unit(x, y));
+
+      add_unit("unit" + std::to_string(i), "tank",
+               "player" + std::to_string(i % 4), x, y);
+    }
+
+    index.rebuild(state);
+  }
+
+  freeisle::spatial::UnitIndex index;
+};
+
+/**
+ * Generating all legal actions for the player at turn.
+ */
+void BM_Generate(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+  freeisle::action::Generator generator;
+
+  size_t num_actions = 0;
+  for (auto _ : state) {
+    num_actions = generator.generate(fixture.state, fixture.index).size();
+  }
+
+  state.counters["actions"] = num_actions;
+  state.SetItemsProcessed(state.iterations() * num_actions);
+}
+
+/**
+ * Same as BM_Generate, with movement costs from a precompiled table.
+ */
+void BM_GenerateCostTable(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+  const freeisle::path::CostTable costs(fixture.scenario.map,
+                                        fixture.scenario.units);
+  freeisle::action::Generator generator;
+
+  size_t num_actions = 0;
+  for (auto _ : state) {
+    num_actions =
+        generator.generate(fixture.state, fixture.index, costs).size();
+  }
+
+  state.counters["actions"] = num_actions;
+  state.SetItemsProcessed(state.iterations() * num_actions);
+}
+
+} // namespace
+
+BENCHMARK(BM_Generate)
+    ->Args({64, 200})
+    ->Args({256, 2000})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_GenerateCostTable)
+    ->Args({64, 200})
+    ->Args({256, 2000})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,306 @@
+#include "action/Generator.hh"
+
+#include "action/Rules.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <string>
+
+class TestGenerator : public ::testing::Test,
+                      public freeisle::state::test::Scenario {
+public:
+  TestGenerator() : Scenario(7, 7) {
+    freeisle::def::UnitDef &tank =
+        add_unit_def("tank", freeisle::def::UnitDef{
+                                 .name = "tank",
+                                 .level = freeisle::def::Level::Land,
+                                 .movement = 100,
+                                 .fuel = 20,
+                                 .weight = 10,
+                                 .value = 100,
+                             });
+    tank.weapons.try_emplace("cannon", freeisle::def::WeaponDef{
+                                           .damage = 100,
+                                           .min_range = 1,
+                                           .max_range = 2,
+                                           .ammo = 5,
+                                       });
+
+    add_unit_def("grunt", freeisle::def::UnitDef{
+                              .name = "grunt",
+                              .level = freeisle::def::Level::Land,
+                              .caps = freeisle::def::UnitDef::Cap::Capture,
+                              .movement = 100,
+                              .fuel = 20,
+                              .weight = 1,
+                              .value = 50,
+                          });
+
+    add_unit_def("truck",
+                 freeisle::def::UnitDef{
+                     .name = "truck",
+                     .level = freeisle::def::Level::Land,
+                     .movement = 100,
+                     .fuel = 20,
+                     .supplies = {.fuel = 10},
+                     .container = {.max_units = 1,
+                                   .max_weight = 5,
+                                   .supported_levels =
+                                       freeisle::def::Level::Land},
+                 });
+
+    add_unit_def("sub", freeisle::def::UnitDef{
+                            .name = "sub",
+                            .level = freeisle::def::Level::Water,
+                            .caps = freeisle::def::UnitDef::Cap::Soar,
+                            .movement = 100,
+                            .fuel = 20,
+                        });
+
+    add_default_players();
+  }
+
+  freeisle::state::Shop &add_shop(const std::string &id,
+                                  const std::string &owner, uint32_t x,
+                                  uint32_t y) {
+    return Scenario::add_shop(
+        id, owner, x, y,
+        {.max_units = 2,
+         .max_weight = 100,
+         .supported_levels = freeisle::def::Level::Land});
+  }
+
+  const std::vector<freeisle::action::Action> &generate() {
+    index.rebuild(state);
+    return generator.generate(state, index);
+  }
+
+  static uint32_t count(const std::vector<freeisle::action::Action> &actions,
+                        freeisle::action::Action::Type type) {
+    return std::count_if(actions.begin(), actions.end(),
+                         [type](const freeisle::action::Action &action) {
+                           return action.type == type;
+                         });
+  }
+
+  static const freeisle::action::Action *
+  find(const std::vector<freeisle::action::Action> &actions,
+       freeisle::action::Action::Type type) {
+    const auto iter =
+        std::find_if(actions.begin(), actions.end(),
+                     [type](const freeisle::action::Action &action) {
+                       return action.type == type;
+                     });
+    return iter != actions.end() ? &*iter : nullptr;
+  }
+
+  freeisle::spatial::UnitIndex index;
+  freeisle::action::Generator generator;
+};
+
+TEST_F(TestGenerator, NoPlayerAtTurn) {
+  add_unit("unit001", "tank", "rose", 3, 3);
+  state.player_at_turn = {};
+  EXPECT_TRUE(generate().empty());
+}
+
+TEST_F(TestGenerator, Move) {
+  const freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  add_unit("unit002", "tank", "lily", 0, 0);
+
+  const std::vector<freeisle::action::Action> &actions = generate();
+  EXPECT_EQ(actions.size(), 6);
+  EXPECT_EQ(count(actions, freeisle::action::Action::Type::Move), 6);
+  for (const freeisle::action::Action &action : actions) {
+    EXPECT_EQ(action.unit, &unit);
+  }
+}
+
+TEST_F(TestGenerator, NoMoveAfterAction) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.has_actioned = true;
+  EXPECT_TRUE(generate().empty());
+
+  scenario.units["tank"].caps = freeisle::def::UnitDef::Cap::MoveAfterAction;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Move), 6);
+
+  unit.fuel = 0;
+  EXPECT_TRUE(generate().empty());
+}
+
+TEST_F(TestGenerator, Attack) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 0;
+  const freeisle::state::Unit &enemy =
+      add_unit("unit002", "grunt", "lily", 3, 5);
+  add_unit("unit003", "grunt", "daisy", 3, 4);
+  add_unit("unit004", "grunt", "lily", 3, 6);
+
+  const std::vector<freeisle::action::Action> &actions = generate();
+  ASSERT_EQ(actions.size(), 1);
+  EXPECT_EQ(actions[0].type, freeisle::action::Action::Type::Attack);
+  EXPECT_EQ(actions[0].unit, &unit);
+  EXPECT_EQ(actions[0].target, &enemy);
+  EXPECT_EQ(actions[0].weapon, &unit.def->weapons.find("cannon")->second);
+
+  unit.ammo.begin()->second = 0;
+  EXPECT_TRUE(generate().empty());
+}
+
+TEST_F(TestGenerator, NoActionAfterMove) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  add_unit("unit002", "grunt", "lily", 3, 5);
+  unit.movement = 50;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Attack), 1);
+
+  scenario.units["tank"].caps = freeisle::def::UnitDef::Cap::NoActionAfterMove;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Attack), 0);
+
+  unit.movement = 100;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Attack), 1);
+
+  unit.has_actioned = true;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Attack), 0);
+}
+
+TEST_F(TestGenerator, Resupply) {
+  freeisle::state::Unit &truck = add_unit("unit001", "truck", "rose", 3, 3);
+  truck.movement = 0;
+  truck.supplies.fuel = 10;
+  freeisle::state::Unit &ally = add_unit("unit002", "tank", "daisy", 3, 4);
+  ally.movement = 0;
+  freeisle::state::Unit &enemy = add_unit("unit003", "tank", "lily", 4, 3);
+  enemy.fuel = 1;
+
+  // nobody needs anything, and enemies are not resupplied
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Resupply), 0);
+
+  ally.fuel = 1;
+  const std::vector<freeisle::action::Action> &actions = generate();
+  ASSERT_EQ(count(actions, freeisle::action::Action::Type::Resupply), 1);
+  EXPECT_EQ(find(actions, freeisle::action::Action::Type::Resupply)->target,
+            &ally);
+
+  truck.supplies.fuel = 0;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Resupply), 0);
+}
+
+TEST_F(TestGenerator, LoadAndUnload) {
+  freeisle::state::Unit &truck = add_unit("unit001", "truck", "rose", 3, 3);
+  truck.movement = 0;
+  freeisle::state::Unit &grunt = add_unit("unit002", "grunt", "rose", 3, 4);
+
+  const freeisle::action::Action *load =
+      find(generate(), freeisle::action::Action::Type::Load);
+  ASSERT_NE(load, nullptr);
+  EXPECT_EQ(load->unit, &grunt);
+  EXPECT_EQ(load->target, &truck);
+  EXPECT_EQ(load->location.x, 3);
+  EXPECT_EQ(load->location.y, 3);
+
+  // tanks are too heavy
+  state.map.set_surface_unit(3, 4, {});
+  state.units.erase("unit002");
+  state.players["rose"].units.clear();
+  state.players["rose"].units.insert(state.units.find("unit001"));
+  add_unit("unit003", "tank", "rose", 3, 4);
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Load), 0);
+
+  // contained units unload to the hexes around the container
+  freeisle::state::Unit &passenger = add_unit("unit004", "grunt", "rose", 0, 0);
+  state.map.set_surface_unit(0, 0, {});
+  passenger.location = {.x = 3, .y = 3};
+  passenger.contained_in_unit = state.units.find("unit001");
+  truck.container.units.push_back(state.units.find("unit004"));
+
+  const std::vector<freeisle::action::Action> &actions = generate();
+  EXPECT_EQ(count(actions, freeisle::action::Action::Type::Unload), 5);
+  for (const freeisle::action::Action &action : actions) {
+    if (action.type == freeisle::action::Action::Type::Unload) {
+      EXPECT_EQ(action.unit, &passenger);
+    }
+  }
+}
+
+TEST_F(TestGenerator, ShopsAndCapture) {
+  add_shop("shop001", "rose", 3, 2);
+  add_shop("shop002", "lily", 3, 4);
+  add_unit("unit001", "grunt", "rose", 3, 3);
+
+  const std::vector<freeisle::action::Action> &actions = generate();
+  EXPECT_EQ(count(actions, freeisle::action::Action::Type::Move), 4);
+  ASSERT_EQ(count(actions, freeisle::action::Action::Type::Load), 1);
+  EXPECT_EQ(find(actions, freeisle::action::Action::Type::Load)->shop,
+            &state.shops["shop001"]);
+  ASSERT_EQ(count(actions, freeisle::action::Action::Type::Capture), 1);
+  EXPECT_EQ(find(actions, freeisle::action::Action::Type::Capture)->shop,
+            &state.shops["shop002"]);
+
+  // without the capture capability, enemy shops cannot be entered
+  scenario.units["grunt"].caps = {};
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Capture), 0);
+}
+
+TEST_F(TestGenerator, Soar) {
+  freeisle::state::Unit &sub = add_unit("unit001", "sub", "rose", 3, 3);
+  sub.movement = 0;
+
+  const freeisle::action::Action *soar =
+      find(generate(), freeisle::action::Action::Type::Soar);
+  ASSERT_NE(soar, nullptr);
+  EXPECT_EQ(soar->level, freeisle::def::Level::UnderWater);
+
+  // subsurface is occupied
+  freeisle::state::Unit &other = add_unit("unit002", "sub", "rose", 0, 0);
+  state.map.set_surface_unit(0, 0, {});
+  other.location = {.x = 3, .y = 3};
+  other.level = freeisle::def::Level::UnderWater;
+  other.movement = 0;
+  other.has_soared = true;
+  state.map.set_subsurface_unit(3, 3, state.units.find("unit002"));
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Soar), 0);
+
+  EXPECT_EQ(freeisle::action::soar_level(freeisle::def::Level::Air),
+            freeisle::def::Level::HighAir);
+  EXPECT_EQ(freeisle::action::soar_level(freeisle::def::Level::Land),
+            freeisle::def::Level::Land);
+}
+
+TEST_F(TestGenerator, Produce) {
+  freeisle::state::Shop &shop = add_shop("shop001", "rose", 3, 3);
+  freeisle::def::ShopDef &factory = scenario.shops["shop001"];
+  factory.production_list.emplace(scenario.units.find("tank"));
+  factory.production_list.emplace(scenario.units.find("grunt"));
+  add_shop("shop002", "lily", 5, 5);
+  scenario.shops["shop002"].production_list.emplace(
+      scenario.units.find("grunt"));
+
+  state.players["rose"].wealth = 50;
+  const std::vector<freeisle::action::Action> &actions = generate();
+  ASSERT_EQ(actions.size(), 1);
+  EXPECT_EQ(actions[0].type, freeisle::action::Action::Type::Produce);
+  EXPECT_EQ(actions[0].shop, &shop);
+  EXPECT_EQ(actions[0].unit_def, &scenario.units["grunt"]);
+
+  state.players["rose"].wealth = 100;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Produce), 2);
+
+  // shop is full
+  factory.container.max_units = 0;
+  EXPECT_EQ(count(generate(), freeisle::action::Action::Type::Produce), 0);
+}
+
+TEST_F(TestGenerator, ReusesMemory) {
+  add_unit("unit001", "tank", "rose", 3, 3);
+  add_unit("unit002", "grunt", "rose", 1, 1);
+
+  const std::vector<freeisle::action::Action> &actions = generate();
+  const size_t size = actions.size();
+  const freeisle::action::Action *data = actions.data();
+
+  EXPECT_EQ(generate().size(), size);
+  EXPECT_EQ(generator.actions().data(), data);
+}
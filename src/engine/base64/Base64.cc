@@ -1,8 +1,15 @@
 #include "base64/Base64.hh"
 
 #include <stdexcept>
+#include <string>
 
 #include <cassert>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define FREEISLE_BASE64_X86 1
+#include <immintrin.h>
+#endif
 
 namespace {
 
@@ -45,12 +52,11 @@ uint8_t inv(uint8_t v) {
   return inv_alphabet[v];
 }
 
-} // namespace
-
-namespace freeisle::base64 {
-
-uint64_t encode(const uint8_t *data, uint64_t len, uint8_t *result) {
-  uint8_t *res = result;
+/**
+ * Encodes full quanta of 3 bytes each. len must be a multiple of 3.
+ */
+void encode_scalar(const uint8_t *data, uint64_t len, uint8_t *res) {
+  assert(len % 3 == 0);
   while (len >= 3) {
     const uint8_t b1 = (data[0] & 0b11111100) >> 2;
     const uint8_t b2 =
@@ -69,9 +75,372 @@ uint64_t encode(const uint8_t *data, uint64_t len, uint8_t *result) {
 
     res += 4;
   }
+}
+
+/**
+ * Decodes full quanta of 4 characters each, without padding. len must be a
+ * multiple of 4.
+ */
+void decode_scalar(const uint8_t *data, uint64_t len, uint8_t *res) {
+  assert(len % 4 == 0);
+  while (len >= 4) {
+    const uint8_t b1 = inv(data[0]);
+    const uint8_t b2 = inv(data[1]);
+    const uint8_t b3 = inv(data[2]);
+    const uint8_t b4 = inv(data[3]);
+
+    data += 4;
+    len -= 4;
+
+    res[0] = (b1 << 2) | (b2 >> 4);
+    res[1] = (b2 << 4) | (b3 >> 2);
+    res[2] = (b3 << 6) | b4;
+    res += 3;
+  }
+}
+
+#ifdef FREEISLE_BASE64_X86
+
+// The vector kernels follow the approach by Wojciech Muła and Daniel Lemire:
+// bytes are spread out to one 6-bit value per byte with shuffles and
+// multiplications, and mapped to and from ASCII by adding a per-range
+// offset. They process as many whole blocks as possible and return the
+// number of input bytes consumed; the rest is left to the scalar code.
+// Decoding stops at the first block with an invalid character, so that the
+// scalar code reports the error.
+
+__attribute__((target("ssse3"))) inline __m128i
+to_ascii_ssse3(const __m128i indices) {
+  // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12:
+  __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  const __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  range = _mm_or_si128(range, _mm_and_si128(upper, _mm_set1_epi8(13)));
+
+  const __m128i offsets = _mm_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+  return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+}
+
+__attribute__((target("ssse3"))) inline __m128i
+to_indices_ssse3(const __m128i in) {
+  // in = [bbbbcccc|ccdddddd|aaaaaabb|bbbbcccc] per 32 bits
+  const __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+  const __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+  const __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+  const __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+  return _mm_or_si128(t1, t3);
+}
+
+__attribute__((target("ssse3"))) uint64_t
+encode_ssse3(const uint8_t *data, uint64_t len, uint8_t *result) {
+  const __m128i spread =
+      _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+  uint64_t done = 0;
+  // 16 bytes are loaded, of which 12 are used:
+  while (len - done >= 16) {
+    const __m128i in = _mm_shuffle_epi8(
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + done)),
+        spread);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(result),
+                     to_ascii_ssse3(to_indices_ssse3(in)));
+
+    done += 12;
+    result += 16;
+  }
+
+  return done;
+}
+
+__attribute__((target("ssse3"))) inline __m128i
+in_range_ssse3(const __m128i in, char lo, char hi) {
+  return _mm_and_si128(_mm_cmpgt_epi8(in, _mm_set1_epi8(lo - 1)),
+                       _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), in));
+}
+
+__attribute__((target("ssse3"))) uint64_t
+decode_ssse3(const uint8_t *data, uint64_t len, uint8_t *result) {
+  const __m128i pack = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12,
+                                     -1, -1, -1, -1);
+
+  uint64_t done = 0;
+  while (len - done >= 16) {
+    const __m128i in =
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + done));
+
+    // Bytes >= 0x80 compare as negative and fall into no range.
+    const __m128i upper = in_range_ssse3(in, 'A', 'Z');
+    const __m128i lower = in_range_ssse3(in, 'a', 'z');
+    const __m128i digit = in_range_ssse3(in, '0', '9');
+    const __m128i plus = _mm_cmpeq_epi8(in, _mm_set1_epi8('+'));
+    const __m128i slash = _mm_cmpeq_epi8(in, _mm_set1_epi8('/'));
+
+    const __m128i valid =
+        _mm_or_si128(_mm_or_si128(_mm_or_si128(upper, lower), digit),
+                     _mm_or_si128(plus, slash));
+    if (_mm_movemask_epi8(valid) != 0xffff) {
+      break;
+    }
+
+    const __m128i shift = _mm_or_si128(
+        _mm_or_si128(_mm_and_si128(upper, _mm_set1_epi8(-'A')),
+                     _mm_and_si128(lower, _mm_set1_epi8(26 - 'a'))),
+        _mm_or_si128(_mm_and_si128(digit, _mm_set1_epi8(52 - '0')),
+                     _mm_or_si128(_mm_and_si128(plus, _mm_set1_epi8(62 - '+')),
+                                  _mm_and_si128(slash,
+                                                _mm_set1_epi8(63 - '/')))));
+    const __m128i values = _mm_add_epi8(in, shift);
+
+    // Combine four 6-bit values into 24 bits per 32 bits, then pack:
+    const __m128i pairs =
+        _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+    const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+
+    // The last 4 bytes stored are garbage, which is fine unless this is
+    // the end of the output:
+    const __m128i out = _mm_shuffle_epi8(quads, pack);
+    if (len - done >= 24) {
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(result), out);
+    } else {
+      alignas(16) uint8_t buffer[16];
+      _mm_store_si128(reinterpret_cast<__m128i *>(buffer), out);
+      memcpy(result, buffer, 12);
+    }
+
+    done += 16;
+    result += 12;
+  }
+
+  return done;
+}
+
+__attribute__((target("avx2"))) inline __m256i
+to_ascii_avx2(const __m256i indices) {
+  __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+  const __m256i upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+  range = _mm256_or_si256(range, _mm256_and_si256(upper, _mm256_set1_epi8(13)));
+
+  const __m256i offsets = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0));
+  return _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+}
+
+__attribute__((target("avx2"))) uint64_t
+encode_avx2(const uint8_t *data, uint64_t len, uint8_t *result) {
+  const __m256i spread = _mm256_broadcastsi128_si256(
+      _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+
+  uint64_t done = 0;
+  // Two times 16 bytes are loaded, of which 24 are used:
+  while (len - done >= 28) {
+    const uint8_t *in = data + done;
+    const __m256i both = _mm256_inserti128_si256(
+        _mm256_castsi128_si256(
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(in))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + 12)), 1);
+    const __m256i spreaded = _mm256_shuffle_epi8(both, spread);
+
+    const __m256i t0 =
+        _mm256_and_si256(spreaded, _mm256_set1_epi32(0x0fc0fc00));
+    const __m256i t1 = _mm256_mulhi_epu16(t0, _mm256_set1_epi32(0x04000040));
+    const __m256i t2 =
+        _mm256_and_si256(spreaded, _mm256_set1_epi32(0x003f03f0));
+    const __m256i t3 = _mm256_mullo_epi16(t2, _mm256_set1_epi32(0x01000010));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(result),
+                        to_ascii_avx2(_mm256_or_si256(t1, t3)));
+
+    done += 24;
+    result += 32;
+  }
+
+  return done + encode_ssse3(data + done, len - done, result);
+}
+
+__attribute__((target("avx2"))) inline __m256i
+in_range_avx2(const __m256i in, char lo, char hi) {
+  return _mm256_and_si256(_mm256_cmpgt_epi8(in, _mm256_set1_epi8(lo - 1)),
+                          _mm256_cmpgt_epi8(_mm256_set1_epi8(hi + 1), in));
+}
+
+__attribute__((target("avx2"))) uint64_t
+decode_avx2(const uint8_t *data, uint64_t len, uint8_t *result) {
+  const __m256i pack = _mm256_broadcastsi128_si256(_mm_setr_epi8(
+      2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+  const __m256i join = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+
+  uint64_t done = 0;
+  while (len - done >= 32) {
+    const __m256i in =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + done));
+
+    const __m256i upper = in_range_avx2(in, 'A', 'Z');
+    const __m256i lower = in_range_avx2(in, 'a', 'z');
+    const __m256i digit = in_range_avx2(in, '0', '9');
+    const __m256i plus = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('+'));
+    const __m256i slash = _mm256_cmpeq_epi8(in, _mm256_set1_epi8('/'));
+
+    const __m256i valid = _mm256_or_si256(
+        _mm256_or_si256(_mm256_or_si256(upper, lower), digit),
+        _mm256_or_si256(plus, slash));
+    if (_mm256_movemask_epi8(valid) != -1) {
+      break;
+    }
+
+    const __m256i shift = _mm256_or_si256(
+        _mm256_or_si256(_mm256_and_si256(upper, _mm256_set1_epi8(-'A')),
+                        _mm256_and_si256(lower, _mm256_set1_epi8(26 - 'a'))),
+        _mm256_or_si256(
+            _mm256_and_si256(digit, _mm256_set1_epi8(52 - '0')),
+            _mm256_or_si256(
+                _mm256_and_si256(plus, _mm256_set1_epi8(62 - '+')),
+                _mm256_and_si256(slash, _mm256_set1_epi8(63 - '/')))));
+    const __m256i values = _mm256_add_epi8(in, shift);
+
+    const __m256i pairs =
+        _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    const __m256i quads =
+        _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000));
+
+    // The last 8 bytes stored are garbage, which is fine unless this is
+    // the end of the output:
+    const __m256i out =
+        _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(quads, pack), join);
+    if (len - done >= 44) {
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(result), out);
+    } else {
+      alignas(32) uint8_t buffer[32];
+      _mm256_store_si256(reinterpret_cast<__m256i *>(buffer), out);
+      memcpy(result, buffer, 24);
+    }
+
+    done += 32;
+    result += 24;
+  }
+
+  return done + decode_ssse3(data + done, len - done, result);
+}
+
+#endif
+
+/**
+ * Encodes full quanta of 3 bytes each with the given instruction set.
+ * Returns the number of bytes written.
+ */
+uint64_t encode_quanta(freeisle::base64::Isa isa, const uint8_t *data,
+                       uint64_t len, uint8_t *result) {
+  assert(len % 3 == 0);
 
-  assert(len < 3);
-  switch (len) {
+  uint64_t done = 0;
+#ifdef FREEISLE_BASE64_X86
+  switch (isa) {
+  case freeisle::base64::Isa::Scalar:
+    break;
+  case freeisle::base64::Isa::Ssse3:
+    done = encode_ssse3(data, len, result);
+    break;
+  case freeisle::base64::Isa::Avx2:
+    done = encode_avx2(data, len, result);
+    break;
+  }
+#endif
+
+  encode_scalar(data + done, len - done, result + done / 3 * 4);
+  return len / 3 * 4;
+}
+
+/**
+ * Decodes full quanta of 4 characters each with the given instruction set.
+ * Returns the number of bytes written.
+ */
+uint64_t decode_quanta(freeisle::base64::Isa isa, const uint8_t *data,
+                       uint64_t len, uint8_t *result) {
+  assert(len % 4 == 0);
+
+  uint64_t done = 0;
+#ifdef FREEISLE_BASE64_X86
+  switch (isa) {
+  case freeisle::base64::Isa::Scalar:
+    break;
+  case freeisle::base64::Isa::Ssse3:
+    done = decode_ssse3(data, len, result);
+    break;
+  case freeisle::base64::Isa::Avx2:
+    done = decode_avx2(data, len, result);
+    break;
+  }
+#endif
+
+  decode_scalar(data + done, len - done, result + done / 4 * 3);
+  return len / 4 * 3;
+}
+
+freeisle::base64::Isa detect_isa() {
+#ifdef FREEISLE_BASE64_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return freeisle::base64::Isa::Avx2;
+  }
+
+  if (__builtin_cpu_supports("ssse3")) {
+    return freeisle::base64::Isa::Ssse3;
+  }
+#endif
+
+  return freeisle::base64::Isa::Scalar;
+}
+
+} // namespace
+
+namespace freeisle::base64 {
+
+Isa best_isa() {
+  static const Isa isa = detect_isa();
+  return isa;
+}
+
+bool is_supported(Isa isa) {
+  return static_cast<uint32_t>(isa) <= static_cast<uint32_t>(best_isa());
+}
+
+Encoder::Encoder(Isa isa) : isa_(isa), pending_{}, num_pending_(0) {
+  if (!is_supported(isa)) {
+    throw std::invalid_argument("Instruction set not supported");
+  }
+}
+
+uint64_t Encoder::update(const uint8_t *data, uint64_t len, uint8_t *result) {
+  uint8_t *res = result;
+  if (num_pending_ > 0) {
+    while (num_pending_ < 3 && len > 0) {
+      pending_[num_pending_++] = *data++;
+      --len;
+    }
+
+    if (num_pending_ < 3) {
+      return 0;
+    }
+
+    encode_scalar(pending_, 3, res);
+    res += 4;
+    num_pending_ = 0;
+  }
+
+  const uint64_t whole = len - len % 3;
+  res += encode_quanta(isa_, data, whole, res);
+
+  num_pending_ = len - whole;
+  memcpy(pending_, data + whole, num_pending_);
+  return res - result;
+}
+
+uint64_t Encoder::finish(uint8_t *result) {
+  const uint8_t *data = pending_;
+  uint8_t *res = result;
+
+  assert(num_pending_ < 3);
+  switch (num_pending_) {
   case 0:
     break;
   case 1:
@@ -82,7 +451,7 @@ uint64_t encode(const uint8_t *data, uint64_t len, uint8_t *result) {
     res += 4;
     break;
   case 2:
-    res[0] = alphabet[(data[0] & 0b1111100) >> 2];
+    res[0] = alphabet[(data[0] & 0b11111100) >> 2];
     res[1] =
         alphabet[((data[0] & 0b00000011) << 4) | ((data[1] & 0b11110000) >> 4)];
     res[2] = alphabet[((data[1] & 0b00001111) << 2)];
@@ -91,33 +460,71 @@ uint64_t encode(const uint8_t *data, uint64_t len, uint8_t *result) {
     break;
   }
 
+  num_pending_ = 0;
   return res - result;
 }
 
-uint64_t decode(const uint8_t *data, uint64_t len, uint8_t *result) {
+Decoder::Decoder(Isa isa)
+    : isa_(isa), pending_{}, num_pending_(0), padded_(false) {
+  if (!is_supported(isa)) {
+    throw std::invalid_argument("Instruction set not supported");
+  }
+}
+
+uint64_t Decoder::update(const uint8_t *data, uint64_t len, uint8_t *result) {
   // TODO(armin): skip whitespace
-  while (len > 0 && data[len - 1] == '=') {
-    --len;
+  const uint8_t *padding = data;
+  if (!padded_) {
+    padding = len > 0 ? static_cast<const uint8_t *>(memchr(data, '=', len))
+                      : nullptr;
+  }
+
+  if (padding != nullptr) {
+    for (const uint8_t *p = padding; p != data + len; ++p) {
+      if (*p != '=') {
+        throw std::invalid_argument("Illegal character after padding: " +
+                                    std::string(p, p + 1));
+      }
+    }
+
+    len = padding - data;
+    padded_ = true;
   }
 
   uint8_t *res = result;
-  while (len >= 4) {
-    const uint8_t b1 = inv(data[0]);
-    const uint8_t b2 = inv(data[1]);
-    const uint8_t b3 = inv(data[2]);
-    const uint8_t b4 = inv(data[3]);
+  if (num_pending_ > 0) {
+    while (num_pending_ < 4 && len > 0) {
+      pending_[num_pending_++] = *data++;
+      --len;
+    }
 
-    data += 4;
-    len -= 4;
+    if (num_pending_ < 4) {
+      return 0;
+    }
 
-    res[0] = (b1 << 2) | (b2 >> 4);
-    res[1] = (b2 << 4) | (b3 >> 2);
-    res[2] = (b3 << 6) | b4;
+    decode_scalar(pending_, 4, res);
     res += 3;
+    num_pending_ = 0;
   }
 
-  assert(len < 4);
-  switch (len) {
+  const uint64_t whole = len - len % 4;
+  res += decode_quanta(isa_, data, whole, res);
+
+  num_pending_ = len - whole;
+  memcpy(pending_, data + whole, num_pending_);
+  return res - result;
+}
+
+uint64_t Decoder::finish(uint8_t *result) {
+  const uint8_t *data = pending_;
+  const uint32_t num_pending = num_pending_;
+  uint8_t *res = result;
+
+  num_pending_ = 0;
+  padded_ = false;
+
+  assert(num_pending < 4);
+  switch (num_pending) {
   case 0:
     break;
   case 1:
@@ -136,4 +543,16 @@ uint64_t decode(const uint8_t *data, uint64_t len, uint8_t *result) {
   return res - result;
 }
 
+uint64_t encode(const uint8_t *data, uint64_t len, uint8_t *result) {
+  Encoder encoder;
+  const uint64_t written = encoder.update(data, len, result);
+  return written + encoder.finish(result + written);
+}
+
+uint64_t decode(const uint8_t *data, uint64_t len, uint8_t *result) {
+  Decoder decoder;
+  const uint64_t written = decoder.update(data, len, result);
+  return written + decoder.finish(result + written);
+}
+
 } // namespace freeisle::base64
@@ -9,6 +9,117 @@ template <uint64_t X> constexpr uint64_t round_to_next_multiple_of(uint64_t v) {
   return (v + (X - 1)) & ~(X - 1);
 }
 
+/**
+ * Number of bytes needed to hold the base-64 encoding of len bytes,
+ * including padding.
+ */
+constexpr uint64_t encoded_size(uint64_t len) { return (len + 2) / 3 * 4; }
+
+/**
+ * Upper bound for the number of bytes decoded from len bytes of base-64
+ * encoded data.
+ */
+constexpr uint64_t decoded_size(uint64_t len) { return (len + 3) / 4 * 3; }
+
+/**
+ * Instruction set used for encoding and decoding. All of them produce the
+ * same results; they only differ in speed.
+ */
+enum class Isa {
+  /**
+   * Portable implementation, one quantum at a time.
+   */
+  Scalar,
+
+  /**
+   * 16 characters at a time, on x86 CPUs with SSSE3.
+   */
+  Ssse3,
+
+  /**
+   * 32 characters at a time, on x86 CPUs with AVX2.
+   */
+  Avx2,
+};
+
+/**
+ * Returns the fastest instruction set supported by the CPU. This is what is
+ * used unless specified otherwise.
+ */
+Isa best_isa();
+
+/**
+ * Returns whether the given instruction set is supported by the CPU.
+ */
+bool is_supported(Isa isa);
+
+/**
+ * Encodes a byte sequence in base-64 incrementally, one chunk at a time, so
+ * that large inputs do not need to be available all at once. Bytes that do
+ * not make up a full quantum are kept until the next chunk, or until
+ * finish() is called.
+ */
+class Encoder {
+public:
+  /**
+   * @param isa Instruction set to use, must be supported by the CPU.
+   */
+  explicit Encoder(Isa isa = best_isa());
+
+  /**
+   * Encodes the next chunk of data. result must be at least
+   * `encoded_size(len)` bytes long. Returns the number of bytes written.
+   */
+  uint64_t update(const uint8_t *data, uint64_t len, uint8_t *result);
+
+  /**
+   * Encodes the remaining bytes, with padding. result must be at least
+   * 4 bytes long. Returns the number of bytes written. Afterwards, the
+   * encoder can be used for a new byte sequence.
+   */
+  uint64_t finish(uint8_t *result);
+
+private:
+  Isa isa_;
+  uint8_t pending_[3];
+  uint32_t num_pending_;
+};
+
+/**
+ * Decodes base-64 encoded data incrementally, one chunk at a time. Characters
+ * that do not make up a full quantum are kept until the next chunk, or until
+ * finish() is called. Padding is optional, but once a padding character has
+ * been seen, only padding characters may follow.
+ *
+ * Throws std::invalid_argument if the input is incorrectly formatted.
+ */
+class Decoder {
+public:
+  /**
+   * @param isa Instruction set to use, must be supported by the CPU.
+   */
+  explicit Decoder(Isa isa = best_isa());
+
+  /**
+   * Decodes the next chunk of data. result must be at least
+   * `decoded_size(len)` bytes long. Returns the number of bytes written.
+   */
+  uint64_t update(const uint8_t *data, uint64_t len, uint8_t *result);
+
+  /**
+   * Decodes the remaining characters. result must be at least 2 bytes
+   * long. Returns the number of bytes written. Afterwards, the decoder can
+   * be used for new data.
+   */
+  uint64_t finish(uint8_t *result);
+
+private:
+  Isa isa_;
+  uint8_t pending_[4];
+  uint32_t num_pending_;
+  bool padded_;
+};
+
 /**
  * Encodes a given byte sequence in base-64.
  * Result must be a at least `round_to_next_multiple_of<4>(len * 4 / 3)` bytes
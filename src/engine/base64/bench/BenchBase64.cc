@@ -0,0 +1,77 @@
+#include "base64/Base64.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+/**
+ * Size of the data, e.g. an encoded map image.
+ */
+constexpr uint64_t Size = 1 << 20;
+
+void BM_Encode(benchmark::State &state) {
+  const freeisle::base64::Isa isa =
+      static_cast<freeisle::base64::Isa>(state.range(0));
+  if (!freeisle::base64::is_supported(isa)) {
+    state.SkipWithError("Instruction set not supported");
+    return;
+  }
+
+  std::vector<uint8_t> data(Size);
+  for (uint64_t i = 0; i < data.size(); ++i) {
+    data[i] = i * 7919;
+  }
+
+  std::vector<uint8_t> result(freeisle::base64::encoded_size(Size));
+  for (auto _ : state) {
+    freeisle::base64::Encoder encoder(isa);
+    const uint64_t len =
+        encoder.update(data.data(), data.size(), result.data());
+    encoder.finish(result.data() + len);
+    benchmark::DoNotOptimize(result.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * Size);
+}
+
+void BM_Decode(benchmark::State &state) {
+  const freeisle::base64::Isa isa =
+      static_cast<freeisle::base64::Isa>(state.range(0));
+  if (!freeisle::base64::is_supported(isa)) {
+    state.SkipWithError("Instruction set not supported");
+    return;
+  }
+
+  std::vector<uint8_t> data(Size);
+  for (uint64_t i = 0; i < data.size(); ++i) {
+    data[i] = i * 7919;
+  }
+
+  std::vector<uint8_t> encoded(freeisle::base64::encoded_size(Size));
+  freeisle::base64::encode(data.data(), data.size(), encoded.data());
+
+  for (auto _ : state) {
+    freeisle::base64::Decoder decoder(isa);
+    const uint64_t len =
+        decoder.update(encoded.data(), encoded.size(), data.data());
+    decoder.finish(data.data() + len);
+    benchmark::DoNotOptimize(data.data());
+  }
+
+  state.SetBytesProcessed(state.iterations() * Size);
+}
+
+} // namespace
+
+BENCHMARK(BM_Encode)
+    ->Arg(static_cast<int>(freeisle::base64::Isa::Scalar))
+    ->Arg(static_cast<int>(freeisle::base64::Isa::Ssse3))
+    ->Arg(static_cast<int>(freeisle::base64::Isa::Avx2));
+BENCHMARK(BM_Decode)
+    ->Arg(static_cast<int>(freeisle::base64::Isa::Scalar))
+    ->Arg(static_cast<int>(freeisle::base64::Isa::Ssse3))
+    ->Arg(static_cast<int>(freeisle::base64::Isa::Avx2));
+
+BENCHMARK_MAIN();
@@ -2,6 +2,10 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
 TEST(Base64, RoundToNextMultiple) {
   EXPECT_EQ(freeisle::base64::round_to_next_multiple_of<4>(0), 0);
   EXPECT_EQ(freeisle::base64::round_to_next_multiple_of<4>(1), 4);
@@ -203,3 +207,137 @@ TEST(Base64, Decode_above128) {
   EXPECT_EQ(out[2], 78);
   EXPECT_EQ(out[3], 71);
 }
+
+TEST(Base64, Encode_above128_two) {
+  uint8_t out[4];
+  const uint8_t in[2] = {0xff, 0xff};
+  EXPECT_EQ(freeisle::base64::encode(in, sizeof(in), out), 4);
+  EXPECT_EQ(std::string(out, out + 4), "//8=");
+}
+
+namespace {
+
+std::vector<uint8_t> random_bytes(size_t len) {
+  std::mt19937 rng(len);
+  std::vector<uint8_t> result(len);
+  for (uint8_t &byte : result) {
+    byte = rng();
+  }
+
+  return result;
+}
+
+std::vector<uint8_t> encode_chunked(freeisle::base64::Isa isa,
+                                    const std::vector<uint8_t> &data,
+                                    size_t chunk_size) {
+  freeisle::base64::Encoder encoder(isa);
+  std::vector<uint8_t> result(freeisle::base64::encoded_size(data.size()) + 4);
+
+  uint64_t written = 0;
+  for (size_t i = 0; i < data.size(); i += chunk_size) {
+    const size_t len = std::min(chunk_size, data.size() - i);
+    written += encoder.update(&data[i], len, &result[written]);
+  }
+
+  written += encoder.finish(&result[written]);
+  result.resize(written);
+  return result;
+}
+
+std::vector<uint8_t> decode_chunked(freeisle::base64::Isa isa,
+                                    const std::vector<uint8_t> &data,
+                                    size_t chunk_size) {
+  freeisle::base64::Decoder decoder(isa);
+  std::vector<uint8_t> result(freeisle::base64::decoded_size(data.size()) + 2);
+
+  uint64_t written = 0;
+  for (size_t i = 0; i < data.size(); i += chunk_size) {
+    const size_t len = std::min(chunk_size, data.size() - i);
+    written += decoder.update(&data[i], len, &result[written]);
+  }
+
+  written += decoder.finish(&result[written]);
+  result.resize(written);
+  return result;
+}
+
+const freeisle::base64::Isa isas[] = {
+    freeisle::base64::Isa::Scalar,
+    freeisle::base64::Isa::Ssse3,
+    freeisle::base64::Isa::Avx2,
+};
+
+} // namespace
+
+TEST(Base64, InstructionSets) {
+  EXPECT_TRUE(freeisle::base64::is_supported(freeisle::base64::Isa::Scalar));
+  EXPECT_TRUE(freeisle::base64::is_supported(freeisle::base64::best_isa()));
+
+  for (const size_t len : {0, 1, 2, 11, 12, 16, 27, 28, 100, 1000, 4099}) {
+    const std::vector<uint8_t> data = random_bytes(len);
+    const std::vector<uint8_t> expected =
+        encode_chunked(freeisle::base64::Isa::Scalar, data, data.size() + 1);
+    ASSERT_EQ(expected.size(), freeisle::base64::encoded_size(len));
+
+    for (const freeisle::base64::Isa isa : isas) {
+      if (!freeisle::base64::is_supported(isa)) {
+        continue;
+      }
+
+      SCOPED_TRACE(static_cast<int>(isa));
+      EXPECT_EQ(encode_chunked(isa, data, data.size() + 1), expected);
+      EXPECT_EQ(decode_chunked(isa, expected, expected.size() + 1), data);
+    }
+  }
+}
+
+TEST(Base64, Chunked) {
+  const std::vector<uint8_t> data = random_bytes(1000);
+  std::vector<uint8_t> encoded(freeisle::base64::encoded_size(data.size()));
+  encoded.resize(
+      freeisle::base64::encode(data.data(), data.size(), encoded.data()));
+
+  for (const size_t chunk_size : {1, 2, 3, 5, 7, 64, 100}) {
+    SCOPED_TRACE(chunk_size);
+    EXPECT_EQ(encode_chunked(freeisle::base64::best_isa(), data, chunk_size),
+              encoded);
+    EXPECT_EQ(decode_chunked(freeisle::base64::best_isa(), encoded, chunk_size),
+              data);
+  }
+}
+
+TEST(Base64, DecodeIllegalCharacterInBlock) {
+  std::vector<uint8_t> encoded(freeisle::base64::encoded_size(300));
+  const std::vector<uint8_t> data = random_bytes(300);
+  freeisle::base64::encode(data.data(), data.size(), encoded.data());
+
+  for (const size_t pos : {0, 17, 63, 200, 398}) {
+    for (const uint8_t illegal : {uint8_t{'-'}, uint8_t{'='}, uint8_t{0x80},
+                                   uint8_t{0xff}}) {
+      std::vector<uint8_t> corrupt = encoded;
+      corrupt[pos] = illegal;
+
+      for (const freeisle::base64::Isa isa : isas) {
+        if (!freeisle::base64::is_supported(isa)) {
+          continue;
+        }
+
+        EXPECT_THROW(decode_chunked(isa, corrupt, corrupt.size()),
+                     std::invalid_argument);
+      }
+    }
+  }
+}
+
+TEST(Base64, DecodeAfterPadding) {
+  const uint8_t in[8] = {'Z', 'g', '=', '=', 'Z', 'g', '=', '='};
+  uint8_t out[8];
+  EXPECT_THROW(freeisle::base64::decode(in, 8, out), std::invalid_argument);
+
+  // Padding can be split across chunks:
+  freeisle::base64::Decoder decoder;
+  EXPECT_EQ(decoder.update(in, 3, out), 0);
+  EXPECT_EQ(decoder.update(in + 3, 1, out), 0);
+  EXPECT_EQ(decoder.finish(out), 1);
+  EXPECT_EQ(out[0], 'f');
+}
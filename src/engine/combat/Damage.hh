@@ -0,0 +1,116 @@
+#pragma once
+
+#include "path/MovementCost.hh"
+
+#include "state/Unit.hh"
+
+#include "def/Level.hh"
+#include "def/MapDef.hh"
+#include "def/UnitDef.hh"
+#include "def/WeaponDef.hh"
+
+#include <algorithm>
+#include <cstdint>
+
+namespace freeisle::combat {
+
+/**
+ * Health of a unit that has not taken any damage.
+ */
+constexpr uint32_t MaxHealth = 100;
+
+/**
+ * Maximum damage bonus, in percent, that a unit gains from experience.
+ */
+constexpr uint32_t MaxExperienceBonus = 20;
+
+/**
+ * Base damage values are stored in hundredths of health points.
+ */
+constexpr uint32_t DamageScale = 100;
+
+/**
+ * Returns the protection of a unit with the given definition at the given
+ * level on the given hex. Like for movement, overlay terrain only counts for
+ * units on land level.
+ */
+inline uint32_t protection(const def::UnitDef &def, def::Level level,
+                           const def::MapDef::Hex &hex) {
+  if (hex.overlay_terrain && path::overlay_applies(level)) {
+    return def.protection[*hex.overlay_terrain];
+  }
+
+  return def.protection[hex.base_terrain];
+}
+
+/**
+ * Returns the damage, in hundredths of health points, that the given weapon
+ * inflicts on a unit with the given definition and protection before the
+ * attacker's experience is taken into account.
+ *
+ * The weapon's damage is divided by the armor of the defender, its
+ * resistance against the weapon's damage type and its protection, each of
+ * which is relative to 100. Values of 0 are treated as 1. The result is
+ * capped at MaxHealth, since more damage than that always destroys the
+ * defender.
+ */
+inline uint32_t base_damage(const def::WeaponDef &weapon,
+                            const def::UnitDef &defender,
+                            uint32_t protection) {
+  const uint64_t armor = std::max<uint32_t>(defender.armor, 1);
+  const uint64_t resistance =
+      std::max<uint32_t>(defender.resistance[weapon.damage_type], 1);
+
+  const uint64_t divisor =
+      armor * resistance * std::max<uint32_t>(protection, 1);
+  const uint64_t damage =
+      static_cast<uint64_t>(weapon.damage) * 100 * 100 * 100 * DamageScale /
+      divisor;
+  return std::min<uint64_t>(damage, MaxHealth * DamageScale);
+}
+
+/**
+ * Returns the damage bonus, in percent, of a unit with the given experience.
+ * Every point of experience adds one percent, up to MaxExperienceBonus.
+ */
+inline uint32_t experience_bonus(uint32_t experience) {
+  return std::min(experience, MaxExperienceBonus);
+}
+
+/**
+ * Returns the health points that a defender with the given health loses by
+ * an attack with the given base damage from an attacker with the given
+ * experience.
+ */
+inline uint32_t apply_damage(uint32_t base_damage, uint32_t experience,
+                             uint32_t health) {
+  const uint32_t damage = base_damage * (100 + experience_bonus(experience)) /
+                          (100 * DamageScale);
+  return std::min(damage, health);
+}
+
+/**
+ * Returns the health points that the defender loses when the attacker
+ * attacks it with the given weapon while the defender is on the given hex.
+ * Does not check whether the attack is possible at all.
+ *
+ * This evaluates the unit definitions directly; DamageTable provides the
+ * same result from precomputed tables.
+ */
+inline uint32_t damage(const state::Unit &attacker,
+                       const def::WeaponDef &weapon,
+                       const state::Unit &defender,
+                       const def::MapDef::Hex &hex) {
+  const uint32_t base = base_damage(
+      weapon, *defender.def, protection(*defender.def, defender.level, hex));
+  return apply_damage(base, attacker.experience, defender.health);
+}
+
+/**
+ * Returns whether the given weapon can reach a target at the given distance.
+ */
+inline bool in_range(const def::WeaponDef &weapon, uint32_t distance) {
+  return distance >= weapon.min_range && distance <= weapon.max_range;
+}
+
+} // namespace freeisle::combat
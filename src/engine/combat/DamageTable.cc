@@ -0,0 +1,152 @@
+#include "combat/DamageTable.hh"
+
+#include <algorithm>
+#include <cassert>
+
+namespace freeisle::combat {
+
+static_assert(MaxHealth * DamageScale <= 0xffff);
+
+namespace {
+
+constexpr uint32_t NumOverlayCodes =
+    static_cast<uint32_t>(def::OverlayTerrainType::Num) + 1;
+
+} // namespace
+
+void Attacks::clear() {
+  weapons.clear();
+  defenders.clear();
+  terrains.clear();
+  experience.clear();
+  health.clear();
+}
+
+DamageTable::DamageTable(const def::Collection<def::UnitDef> &defs)
+    : defs_(&defs), num_units_(0), num_weapons_(0) {
+  update_unit_defs();
+}
+
+uint32_t DamageTable::unit_index(const def::UnitDef &def) const {
+  const auto iter = units_.find(&def);
+  assert(iter != units_.end());
+  return iter->second;
+}
+
+uint32_t DamageTable::weapon_index(const def::WeaponDef &weapon) const {
+  const auto iter = weapons_.find(&weapon);
+  assert(iter != weapons_.end());
+  return iter->second;
+}
+
+path::TerrainCode DamageTable::terrain_code(const def::MapDef::Hex &hex,
+                                            def::Level level) {
+  const path::TerrainCode code = path::terrain_code(hex);
+  if (path::overlay_applies(level)) {
+    return code;
+  }
+
+  // Same base terrain, without overlay
+  return code - code % NumOverlayCodes + NumOverlayCodes - 1;
+}
+
+uint32_t DamageTable::damage(const state::Unit &attacker,
+                             const def::WeaponDef &weapon,
+                             const state::Unit &defender,
+                             const def::MapDef::Hex &hex) const {
+  const uint32_t base =
+      base_damage(weapon_index(weapon),
+                  unit_index(*defender.def), terrain_code(hex, defender.level));
+  return apply_damage(base, attacker.experience, defender.health);
+}
+
+void DamageTable::damage(const Attacks &attacks, uint32_t *out) const {
+  const size_t n = attacks.size();
+  const uint32_t *weapons = attacks.weapons.data();
+  const uint32_t *defenders = attacks.defenders.data();
+  const path::TerrainCode *terrains = attacks.terrains.data();
+  const uint32_t *experience = attacks.experience.data();
+  const uint32_t *health = attacks.health.data();
+
+  // Gather the base damage first, so that the arithmetic below is a plain
+  // loop over arrays that the compiler can vectorize.
+  for (size_t i = 0; i < n; ++i) {
+    out[i] = base_damage(weapons[i], defenders[i], terrains[i]);
+  }
+
+  for (size_t i = 0; i < n; ++i) {
+    const uint32_t bonus = std::min(experience[i], MaxExperienceBonus);
+    const uint32_t damage = out[i] * (100 + bonus) / (100 * DamageScale);
+    out[i] = std::min(damage, health[i]);
+  }
+}
+
+void DamageTable::add_attack(Attacks &attacks, const state::Unit &attacker,
+                             const def::WeaponDef &weapon,
+                             const state::Unit &defender,
+                             const def::MapDef::Hex &hex) const {
+  attacks.weapons.push_back(weapon_index(weapon));
+  attacks.defenders.push_back(unit_index(*defender.def));
+  attacks.terrains.push_back(terrain_code(hex, defender.level));
+  attacks.experience.push_back(attacker.experience);
+  attacks.health.push_back(defender.health);
+}
+
+void DamageTable::update_unit_defs() {
+  units_.clear();
+  weapons_.clear();
+
+  std::vector<const def::WeaponDef *> weapons;
+  std::vector<const def::UnitDef *> units;
+  for (const auto &[id, def] : *defs_) {
+    units_.emplace(&def, units.size());
+    units.push_back(&def);
+
+    for (const auto &[weapon_id, weapon] : def.weapons) {
+      weapons_.emplace(&weapon, weapons.size());
+      weapons.push_back(&weapon);
+    }
+  }
+
+  num_units_ = units.size();
+  num_weapons_ = weapons.size();
+  table_.resize(static_cast<size_t>(num_weapons_) * num_units_ *
+                path::NumTerrainCodes);
+
+  // Protection of every unit on every terrain code. The level does not
+  // matter here, since terrain codes passed to base_damage() already have
+  // inapplicable overlays removed.
+  std::vector<uint32_t> protections(static_cast<size_t>(num_units_) *
+                                    path::NumTerrainCodes);
+  for (uint32_t u = 0; u < num_units_; ++u) {
+    for (uint32_t b = 0; b < static_cast<uint32_t>(def::BaseTerrainType::Num);
+         ++b) {
+      def::MapDef::Hex hex{.base_terrain =
+                               static_cast<def::BaseTerrainType>(b)};
+
+      for (uint32_t o = 0; o < NumOverlayCodes; ++o) {
+        if (o < NumOverlayCodes - 1) {
+          hex.overlay_terrain = static_cast<def::OverlayTerrainType>(o);
+        } else {
+          hex.overlay_terrain = decltype(hex.overlay_terrain)();
+        }
+
+        protections[u * path::NumTerrainCodes + path::terrain_code(hex)] =
+            protection(*units[u], def::Level::Land, hex);
+      }
+    }
+  }
+
+  for (uint32_t w = 0; w < num_weapons_; ++w) {
+    for (uint32_t u = 0; u < num_units_; ++u) {
+      for (uint32_t t = 0; t < path::NumTerrainCodes; ++t) {
+        table_[(static_cast<size_t>(w) * num_units_ + u) *
+                   path::NumTerrainCodes +
+               t] = combat::base_damage(
+            *weapons[w], *units[u], protections[u * path::NumTerrainCodes + t]);
+      }
+    }
+  }
+}
+
+} // namespace freeisle::combat
@@ -0,0 +1,175 @@
+#pragma once
+
+#include "combat/Damage.hh"
+
+#include "path/CostTable.hh"
+
+#include "state/Unit.hh"
+
+#include "def/Collection.hh"
+#include "def/Level.hh"
+#include "def/MapDef.hh"
+#include "def/UnitDef.hh"
+#include "def/WeaponDef.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace freeisle::combat {
+
+/**
+ * A batch of attacks to be evaluated together, stored as one array per
+ * attribute so that DamageTable::damage() can process them in a tight loop.
+ */
+struct Attacks {
+  /**
+   * Remove all attacks from the batch, keeping the allocated memory.
+   */
+  void clear();
+
+  size_t size() const { return weapons.size(); }
+
+  /**
+   * Weapon index of the attacking weapon, see DamageTable::weapon_index().
+   */
+  std::vector<uint32_t> weapons;
+
+  /**
+   * Unit index of the defender's definition, see DamageTable::unit_index().
+   */
+  std::vector<uint32_t> defenders;
+
+  /**
+   * Terrain code of the defender's hex, with the overlay already removed if
+   * it does not apply at the defender's level, see
+   * DamageTable::terrain_code().
+   */
+  std::vector<path::TerrainCode> terrains;
+
+  /**
+   * Experience of the attacker.
+   */
+  std::vector<uint32_t> experience;
+
+  /**
+   * Health of the defender.
+   */
+  std::vector<uint32_t> health;
+};
+
+/**
+ * Base damage of all combinations of attacking weapon, defending unit
+ * definition and terrain, precomputed from the unit definitions of a
+ * scenario.
+ *
+ * Evaluating an attack then takes a single table lookup plus the
+ * experience bonus. For evaluating many hypothetical attacks, e.g. by the
+ * AI, the batched interface avoids per-call overhead and lets the compiler
+ * vectorize the arithmetic.
+ *
+ * The table refers to the unit definitions it was compiled from, which must
+ * outlive it. After unit definitions have been changed, added or removed,
+ * update_unit_defs() needs to be called.
+ */
+class DamageTable {
+public:
+  /**
+   * Compile the damage table for all given unit definitions.
+   */
+  explicit DamageTable(const def::Collection<def::UnitDef> &defs);
+
+  DamageTable(const DamageTable &) = delete;
+  DamageTable(DamageTable &&) = default;
+  DamageTable &operator=(const DamageTable &) = delete;
+  DamageTable &operator=(DamageTable &&) = default;
+
+  /**
+   * Number of weapons of all unit definitions together.
+   */
+  uint32_t num_weapons() const { return num_weapons_; }
+
+  /**
+   * Number of unit definitions.
+   */
+  uint32_t num_units() const { return num_units_; }
+
+  /**
+   * Returns the index of the given unit definition in the table. The unit
+   * definition must be part of the collection the table was compiled from.
+   */
+  uint32_t unit_index(const def::UnitDef &def) const;
+
+  /**
+   * Returns the index of the given weapon in the table. The weapon must
+   * belong to one of the unit definitions the table was compiled from.
+   */
+  uint32_t weapon_index(const def::WeaponDef &weapon) const;
+
+  /**
+   * Returns the terrain code of the given hex for protection of a unit at
+   * the given level, i.e. with the overlay terrain removed if it does not
+   * apply at that level.
+   */
+  static path::TerrainCode terrain_code(const def::MapDef::Hex &hex,
+                                        def::Level level);
+
+  /**
+   * Returns the base damage, in hundredths of health points, of the weapon
+   * with the given index against the unit definition with the given index
+   * on the given terrain. See combat::base_damage().
+   */
+  uint32_t base_damage(uint32_t weapon, uint32_t defender,
+                       path::TerrainCode terrain) const {
+    return table_[(static_cast<size_t>(weapon) * num_units_ + defender) *
+                      path::NumTerrainCodes +
+                  terrain];
+  }
+
+  /**
+   * Returns the health points that the defender loses when the attacker
+   * attacks it with the given weapon while the defender is on the given
+   * hex. Same as combat::damage().
+   */
+  uint32_t damage(const state::Unit &attacker, const def::WeaponDef &weapon,
+                  const state::Unit &defender,
+                  const def::MapDef::Hex &hex) const;
+
+  /**
+   * Evaluate all attacks of the given batch, and write the health points
+   * that each defender loses to out, which must have space for
+   * attacks.size() values.
+   */
+  void damage(const Attacks &attacks, uint32_t *out) const;
+
+  /**
+   * Add an attack to the given batch.
+   */
+  void add_attack(Attacks &attacks, const state::Unit &attacker,
+                  const def::WeaponDef &weapon, const state::Unit &defender,
+                  const def::MapDef::Hex &hex) const;
+
+  /**
+   * Recompile the table, e.g. after unit definitions have been modified,
+   * added or removed. Invalidates all unit and weapon indices.
+   */
+  void update_unit_defs();
+
+private:
+  const def::Collection<def::UnitDef> *defs_;
+
+  uint32_t num_units_;
+  uint32_t num_weapons_;
+
+  std::unordered_map<const def::UnitDef *, uint32_t> units_;
+  std::unordered_map<const def::WeaponDef *, uint32_t> weapons_;
+
+  /**
+   * Base damage indexed by weapon, defender and terrain code. The values are
+   * capped at MaxHealth * DamageScale, so they fit into 16 bit.
+   */
+  std::vector<uint16_t> table_;
+};
+
+} // namespace freeisle::combat
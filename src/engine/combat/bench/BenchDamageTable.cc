@@ -0,0 +1,140 @@
+#include "combat/DamageTable.hh"
+
+#include "combat/Damage.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Fixture {
+  Fixture(uint32_t num_defs, uint32_t num_attacks) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> value(50, 300);
+
+    for (uint32_t i = 0; i < num_defs; ++i) {
+      freeisle::def::UnitDef &def =
+          unit_defs.try_emplace("unit" + std::to_string(i)).first->second;
+      def.level = static_cast<freeisle::def::Level>(i % 5);
+      def.armor = value(rng);
+      std::generate(def.protection.data(),
+                    def.protection.data() + def.protection.size(),
+                    [&]() { return value(rng); });
+      std::generate(def.resistance.data(),
+                    def.resistance.data() + def.resistance.size(),
+                    [&]() { return value(rng); });
+
+      for (uint32_t w = 0; w < 2; ++w) {
+        def.weapons.try_emplace(
+            "weapon" + std::to_string(w),
+            freeisle::def::WeaponDef{
+                .damage_type = static_cast<freeisle::def::DamageType>(
+                    value(rng) % 5),
+                .damage = value(rng),
+            });
+      }
+    }
+
+    std::vector<freeisle::def::Collection<freeisle::def::UnitDef>::iterator>
+        defs;
+    for (auto iter = unit_defs.begin(); iter != unit_defs.end(); ++iter) {
+      defs.push_back(iter);
+    }
+
+    std::uniform_int_distribution<uint32_t> def_dist(0, num_defs - 1);
+    std::uniform_int_distribution<uint32_t> terrain(0, 34);
+    units.reserve(2 * num_attacks);
+    for (uint32_t i = 0; i < num_attacks; ++i) {
+      freeisle::state::Unit &attacker = units.emplace_back();
+      attacker.def = defs[def_dist(rng)];
+      attacker.level = attacker.def->level;
+      attacker.experience = i % 30;
+      attacker.health = 100;
+
+      freeisle::state::Unit &defender = units.emplace_back();
+      defender.def = defs[def_dist(rng)];
+      defender.level = defender.def->level;
+      defender.health = 1 + i % 100;
+
+      freeisle::def::MapDef::Hex &hex = hexes.emplace_back();
+      const uint32_t code = terrain(rng);
+      hex.base_terrain = static_cast<freeisle::def::BaseTerrainType>(code / 5);
+      if (code % 5 < 4) {
+        hex.overlay_terrain =
+            static_cast<freeisle::def::OverlayTerrainType>(code % 5);
+      }
+
+      weapons.push_back(&attacker.def->weapons.begin()->second);
+    }
+  }
+
+  freeisle::def::Collection<freeisle::def::UnitDef> unit_defs;
+  std::vector<freeisle::state::Unit> units;
+  std::vector<freeisle::def::MapDef::Hex> hexes;
+  std::vector<const freeisle::def::WeaponDef *> weapons;
+};
+
+/**
+ * Evaluating attacks one by one from the unit definitions.
+ */
+void BM_DamageFormula(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (uint32_t i = 0; i < fixture.hexes.size(); ++i) {
+      sum += freeisle::combat::damage(fixture.units[2 * i], *fixture.weapons[i],
+                                      fixture.units[2 * i + 1],
+                                      fixture.hexes[i]);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+/**
+ * Evaluating prepared batches of attacks with the damage table.
+ */
+void BM_DamageBatched(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+  const freeisle::combat::DamageTable table(fixture.unit_defs);
+
+  freeisle::combat::Attacks attacks;
+  for (uint32_t i = 0; i < fixture.hexes.size(); ++i) {
+    table.add_attack(attacks, fixture.units[2 * i], *fixture.weapons[i],
+                     fixture.units[2 * i + 1], fixture.hexes[i]);
+  }
+
+  std::vector<uint32_t> out(attacks.size());
+  for (auto _ : state) {
+    table.damage(attacks, out.data());
+    benchmark::DoNotOptimize(out.data());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+/**
+ * Compiling the damage table for a scenario.
+ */
+void BM_CompileDamageTable(benchmark::State &state) {
+  Fixture fixture(state.range(0), 1);
+
+  for (auto _ : state) {
+    freeisle::combat::DamageTable table(fixture.unit_defs);
+    benchmark::DoNotOptimize(table.num_weapons());
+  }
+}
+
+} // namespace
+
+BENCHMARK(BM_DamageFormula)->Args({50, 10000})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_DamageBatched)->Args({50, 10000})->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_CompileDamageTable)->Arg(50)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
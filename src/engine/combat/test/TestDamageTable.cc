@@ -0,0 +1,239 @@
+#include "combat/DamageTable.hh"
+
+#include "combat/Damage.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+class TestDamageTable : public ::testing::Test {
+public:
+  TestDamageTable() {
+    freeisle::def::UnitDef tank{
+        .name = "tank",
+        .level = freeisle::def::Level::Land,
+        .armor = 200,
+    };
+    set_all(tank, 100);
+    tank.protection[freeisle::def::OverlayTerrainType::Forest] = 200;
+    tank.resistance[freeisle::def::DamageType::SmallCaliber] = 400;
+    tank.weapons.try_emplace("cannon",
+                             freeisle::def::WeaponDef{
+                                 .damage_type =
+                                     freeisle::def::DamageType::BigCaliber,
+                                 .damage = 120,
+                                 .min_range = 1,
+                                 .max_range = 1,
+                             });
+    tank.weapons.try_emplace("mg", freeisle::def::WeaponDef{
+                                       .damage_type = freeisle::def::
+                                           DamageType::SmallCaliber,
+                                       .damage = 60,
+                                       .min_range = 1,
+                                       .max_range = 2,
+                                   });
+    unit_defs.try_emplace("tank", std::move(tank));
+
+    freeisle::def::UnitDef ship{
+        .name = "ship",
+        .level = freeisle::def::Level::Water,
+        .armor = 100,
+    };
+    set_all(ship, 100);
+    ship.protection[freeisle::def::BaseTerrainType::DeepWater] = 50;
+    ship.protection[freeisle::def::OverlayTerrainType::Road] = 1000;
+    ship.weapons.try_emplace(
+        "torpedo", freeisle::def::WeaponDef{
+                       .damage_type = freeisle::def::DamageType::Explosive,
+                       .damage = 500,
+                       .min_range = 1,
+                       .max_range = 3,
+                   });
+    unit_defs.try_emplace("ship", std::move(ship));
+  }
+
+  static void set_all(freeisle::def::UnitDef &def, uint32_t value) {
+    std::fill(def.protection.data(),
+              def.protection.data() + def.protection.size(), value);
+    std::fill(def.resistance.data(),
+              def.resistance.data() + def.resistance.size(), value);
+  }
+
+  freeisle::state::Unit unit(const std::string &def, uint32_t experience,
+                             uint32_t health) {
+    freeisle::state::Unit unit{
+        .def = unit_defs.find(def),
+        .health = health,
+        .experience = experience,
+    };
+    unit.level = unit.def->level;
+    return unit;
+  }
+
+  const freeisle::def::WeaponDef &weapon(const std::string &def,
+                                         const std::string &weapon) {
+    return unit_defs[def].weapons[weapon];
+  }
+
+  freeisle::def::Collection<freeisle::def::UnitDef> unit_defs;
+};
+
+TEST_F(TestDamageTable, Formula) {
+  const freeisle::state::Unit tank = unit("tank", 0, 100);
+  const freeisle::state::Unit ship = unit("ship", 0, 100);
+  const freeisle::def::MapDef::Hex grass{
+      .base_terrain = freeisle::def::BaseTerrainType::Grass};
+
+  // 120 damage against 200 armor
+  EXPECT_EQ(freeisle::combat::damage(tank, weapon("tank", "cannon"), tank,
+                                     grass),
+            60);
+  // resistance of 400
+  EXPECT_EQ(
+      freeisle::combat::damage(tank, weapon("tank", "mg"), tank, grass), 7);
+  // capped at the defender's health
+  EXPECT_EQ(freeisle::combat::damage(ship, weapon("ship", "torpedo"), ship,
+                                     grass),
+            100);
+  EXPECT_EQ(freeisle::combat::damage(ship, weapon("ship", "torpedo"),
+                                     unit("ship", 0, 30), grass),
+            30);
+}
+
+TEST_F(TestDamageTable, ExperienceBonus) {
+  const freeisle::state::Unit tank = unit("tank", 0, 100);
+  const freeisle::def::MapDef::Hex grass{
+      .base_terrain = freeisle::def::BaseTerrainType::Grass};
+
+  EXPECT_EQ(freeisle::combat::damage(unit("tank", 10, 100),
+                                     weapon("tank", "cannon"), tank, grass),
+            66);
+  EXPECT_EQ(freeisle::combat::damage(unit("tank", 20, 100),
+                                     weapon("tank", "cannon"), tank, grass),
+            72);
+  EXPECT_EQ(freeisle::combat::damage(unit("tank", 500, 100),
+                                     weapon("tank", "cannon"), tank, grass),
+            72);
+}
+
+TEST_F(TestDamageTable, OverlayProtection) {
+  const freeisle::state::Unit tank = unit("tank", 0, 100);
+  const freeisle::state::Unit ship = unit("ship", 0, 100);
+  const freeisle::def::MapDef::Hex forest{
+      .base_terrain = freeisle::def::BaseTerrainType::Grass,
+      .overlay_terrain = freeisle::def::OverlayTerrainType::Forest};
+  const freeisle::def::MapDef::Hex bridge{
+      .base_terrain = freeisle::def::BaseTerrainType::DeepWater,
+      .overlay_terrain = freeisle::def::OverlayTerrainType::Road};
+
+  const freeisle::combat::DamageTable table(unit_defs);
+
+  // Land units are protected by overlay terrain, water units are not
+  EXPECT_EQ(table.damage(tank, weapon("tank", "cannon"), tank, forest), 30);
+  EXPECT_EQ(table.damage(tank, weapon("tank", "cannon"), ship, bridge), 100);
+  EXPECT_EQ(freeisle::combat::damage(tank, weapon("tank", "cannon"), ship,
+                                     bridge),
+            100);
+
+  EXPECT_EQ(freeisle::combat::DamageTable::terrain_code(
+                bridge, freeisle::def::Level::Water),
+            freeisle::path::terrain_code(freeisle::def::MapDef::Hex{
+                .base_terrain = freeisle::def::BaseTerrainType::DeepWater}));
+  EXPECT_EQ(freeisle::combat::DamageTable::terrain_code(
+                bridge, freeisle::def::Level::Land),
+            freeisle::path::terrain_code(bridge));
+}
+
+TEST_F(TestDamageTable, Indices) {
+  const freeisle::combat::DamageTable table(unit_defs);
+  EXPECT_EQ(table.num_units(), 2);
+  EXPECT_EQ(table.num_weapons(), 3);
+  EXPECT_NE(table.unit_index(unit_defs["tank"]),
+            table.unit_index(unit_defs["ship"]));
+  EXPECT_NE(table.weapon_index(weapon("tank", "cannon")),
+            table.weapon_index(weapon("tank", "mg")));
+}
+
+TEST_F(TestDamageTable, MatchesFormula) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint32_t> value(0, 400);
+
+  for (auto &[id, def] : unit_defs) {
+    def.armor = value(rng);
+    std::generate(def.protection.data(),
+                  def.protection.data() + def.protection.size(),
+                  [&]() { return value(rng); });
+    std::generate(def.resistance.data(),
+                  def.resistance.data() + def.resistance.size(),
+                  [&]() { return value(rng); });
+  }
+
+  const freeisle::combat::DamageTable table(unit_defs);
+
+  freeisle::combat::Attacks attacks;
+  std::vector<uint32_t> expected;
+
+  for (const char *attacker_id : {"tank", "ship"}) {
+    for (const auto &[weapon_id, weapon] : unit_defs[attacker_id].weapons) {
+      for (const char *defender_id : {"tank", "ship"}) {
+        for (uint32_t b = 0;
+             b < static_cast<uint32_t>(freeisle::def::BaseTerrainType::Num);
+             ++b) {
+          for (uint32_t o = 0;
+               o <= static_cast<uint32_t>(
+                        freeisle::def::OverlayTerrainType::Num);
+               ++o) {
+            freeisle::def::MapDef::Hex hex{
+                .base_terrain = static_cast<freeisle::def::BaseTerrainType>(b)};
+            if (o < static_cast<uint32_t>(
+                        freeisle::def::OverlayTerrainType::Num)) {
+              hex.overlay_terrain =
+                  static_cast<freeisle::def::OverlayTerrainType>(o);
+            }
+
+            const freeisle::state::Unit attacker =
+                unit(attacker_id, value(rng) % 30, 100);
+            const freeisle::state::Unit defender =
+                unit(defender_id, 0, value(rng) % 101);
+
+            const uint32_t damage =
+                freeisle::combat::damage(attacker, weapon, defender, hex);
+            EXPECT_EQ(table.damage(attacker, weapon, defender, hex), damage);
+
+            table.add_attack(attacks, attacker, weapon, defender, hex);
+            expected.push_back(damage);
+          }
+        }
+      }
+    }
+  }
+
+  std::vector<uint32_t> out(attacks.size());
+  table.damage(attacks, out.data());
+  EXPECT_EQ(out, expected);
+
+  attacks.clear();
+  EXPECT_EQ(attacks.size(), 0);
+}
+
+TEST_F(TestDamageTable, UpdateUnitDefs) {
+  freeisle::combat::DamageTable table(unit_defs);
+  const freeisle::state::Unit tank = unit("tank", 0, 100);
+  const freeisle::def::MapDef::Hex grass{
+      .base_terrain = freeisle::def::BaseTerrainType::Grass};
+
+  unit_defs["tank"].armor = 400;
+  table.update_unit_defs();
+  EXPECT_EQ(table.damage(tank, weapon("tank", "cannon"), tank, grass), 30);
+}
+
+TEST(Damage, InRange) {
+  const freeisle::def::WeaponDef weapon{.min_range = 2, .max_range = 3};
+  EXPECT_FALSE(freeisle::combat::in_range(weapon, 1));
+  EXPECT_TRUE(freeisle::combat::in_range(weapon, 2));
+  EXPECT_TRUE(freeisle::combat::in_range(weapon, 3));
+  EXPECT_FALSE(freeisle::combat::in_range(weapon, 4));
+}
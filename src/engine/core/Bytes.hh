@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace freeisle::core {
+
+/**
+ * Non-owning view of a contiguous sequence of bytes. The bytes must outlive
+ * the span.
+ */
+class ByteSpan {
+public:
+  constexpr ByteSpan() : data_(nullptr), size_(0) {}
+  constexpr ByteSpan(const uint8_t *data, uint64_t size)
+      : data_(data), size_(size) {}
+  ByteSpan(const std::vector<uint8_t> &data)
+      : data_(data.data()), size_(data.size()) {}
+
+  const uint8_t *data() const { return data_; }
+  uint64_t size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  const uint8_t *begin() const { return data_; }
+  const uint8_t *end() const { return data_ + size_; }
+
+  uint8_t operator[](uint64_t index) const {
+    assert(index < size_);
+    return data_[index];
+  }
+
+  /**
+   * Returns the part of the span of the given length at the given offset.
+   */
+  ByteSpan subspan(uint64_t offset, uint64_t length) const {
+    assert(offset <= size_ && length <= size_ - offset);
+    return ByteSpan(data_ + offset, length);
+  }
+
+private:
+  const uint8_t *data_;
+  uint64_t size_;
+};
+
+/**
+ * Immutable sequence of bytes that shares ownership of its storage, which
+ * can be a buffer in memory, or e.g. a memory-mapped file. Copies refer to
+ * the same storage, so they are cheap, and the storage is released with the
+ * last copy.
+ */
+class SharedBytes {
+public:
+  SharedBytes() = default;
+
+  /**
+   * Takes ownership of the given buffer.
+   */
+  explicit SharedBytes(std::vector<uint8_t> data) {
+    std::shared_ptr<const std::vector<uint8_t>> buffer =
+        std::make_shared<const std::vector<uint8_t>>(std::move(data));
+    span_ = ByteSpan(*buffer);
+    storage_ = std::move(buffer);
+  }
+
+  /**
+   * Refers to the given bytes, which are kept alive by storage.
+   */
+  SharedBytes(std::shared_ptr<const void> storage, ByteSpan span)
+      : storage_(std::move(storage)), span_(span) {}
+
+  const uint8_t *data() const { return span_.data(); }
+  uint64_t size() const { return span_.size(); }
+  bool empty() const { return span_.empty(); }
+
+  const uint8_t *begin() const { return span_.begin(); }
+  const uint8_t *end() const { return span_.end(); }
+
+  uint8_t operator[](uint64_t index) const { return span_[index]; }
+
+  ByteSpan span() const { return span_; }
+
+private:
+  std::shared_ptr<const void> storage_;
+  ByteSpan span_;
+};
+
+} // namespace freeisle::core
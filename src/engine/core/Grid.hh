@@ -1,5 +1,6 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
 #include <memory>
@@ -41,6 +42,16 @@ public:
     return *this;
   }
 
+  /**
+   * Returns a copy of the grid. Grids are not copyable implicitly, so that
+   * large grids are not copied by accident.
+   */
+  Grid<T> clone() const {
+    Grid<T> result(width_, height_);
+    std::copy(grid_.get(), grid_.get() + width_ * height_, result.grid_.get());
+    return result;
+  }
+
   uint32_t width() const { return width_; }
   uint32_t height() const { return height_; }
 
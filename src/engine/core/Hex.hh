@@ -0,0 +1,101 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+
+/**
+ * Functions in core::hex implement the geometry of the hex grid. Hex tiles
+ * are stored in a core::Grid using "odd-q" offset coordinates: the hexes are
+ * flat-topped, and every odd column is shifted down by half a hex.
+ */
+namespace freeisle::core::hex {
+
+/**
+ * Number of neighbors of a hex tile.
+ */
+constexpr uint32_t NumNeighbors = 6;
+
+/**
+ * Offsets to the neighbors of a hex, indexed by the parity of the column
+ * first. Neighbors are listed clockwise, starting with the one at the top.
+ */
+constexpr int32_t NeighborOffsets[2][NumNeighbors][2] = {
+    {{0, -1}, {1, -1}, {1, 0}, {0, 1}, {-1, 0}, {-1, -1}},
+    {{0, -1}, {1, 0}, {1, 1}, {0, 1}, {-1, 1}, {-1, 0}},
+};
+
+/**
+ * Computes the neighbors of the hex at x, y that lie within a grid of the
+ * given width and height. The coordinates of the neighbors are written to
+ * out_x and out_y. Returns the number of neighbors written.
+ */
+inline uint32_t neighbors(uint32_t x, uint32_t y, uint32_t width,
+                          uint32_t height, uint32_t out_x[NumNeighbors],
+                          uint32_t out_y[NumNeighbors]) {
+  const int32_t(&offsets)[NumNeighbors][2] = NeighborOffsets[x & 1];
+
+  uint32_t n = 0;
+  for (uint32_t i = 0; i < NumNeighbors; ++i) {
+    // unsigned wrap-around takes care of the lower bounds
+    const uint32_t nx = x + offsets[i][0];
+    const uint32_t ny = y + offsets[i][1];
+    if (nx < width && ny < height) {
+      out_x[n] = nx;
+      out_y[n] = ny;
+      ++n;
+    }
+  }
+
+  return n;
+}
+
+/**
+ * Returns the distance between two hexes, in number of hex tiles.
+ */
+inline uint32_t distance(uint32_t x1, uint32_t y1, uint32_t x2, uint32_t y2) {
+  // Convert to axial coordinates first:
+  const int64_t q1 = x1;
+  const int64_t r1 = static_cast<int64_t>(y1) - (q1 - (q1 & 1)) / 2;
+  const int64_t q2 = x2;
+  const int64_t r2 = static_cast<int64_t>(y2) - (q2 - (q2 & 1)) / 2;
+
+  const int64_t dq = q1 - q2;
+  const int64_t dr = r1 - r2;
+  return static_cast<uint32_t>(
+      (std::llabs(dq) + std::llabs(dr) + std::llabs(dq + dr)) / 2);
+}
+
+/**
+ * Calls fn(x, y) for every hex within the given range of the hex at x, y,
+ * i.e. every hex whose distance to it is at most range, including the hex
+ * itself. Only hexes that lie within a grid of the given width and height are
+ * visited. Hexes are visited column by column.
+ */
+template <typename Fn>
+void for_each_in_range(uint32_t x, uint32_t y, uint32_t range, uint32_t width,
+                       uint32_t height, Fn fn) {
+  const int64_t cx = x;
+  const int64_t cr = static_cast<int64_t>(y) - (cx - (cx & 1)) / 2;
+  const int64_t n = range;
+
+  const int64_t x_min = std::max<int64_t>(cx - n, 0);
+  const int64_t x_max = std::min<int64_t>(cx + n, int64_t{width} - 1);
+
+  for (int64_t qx = x_min; qx <= x_max; ++qx) {
+    // Within one column, the hexes in range form a contiguous run of rows,
+    // which is easiest to compute in axial coordinates.
+    const int64_t dq = qx - cx;
+    const int64_t offset = (qx - (qx & 1)) / 2;
+    const int64_t y_min =
+        std::max<int64_t>(cr + std::max(-n, -dq - n) + offset, 0);
+    const int64_t y_max = std::min<int64_t>(cr + std::min(n, -dq + n) + offset,
+                                            int64_t{height} - 1);
+
+    for (int64_t qy = y_min; qy <= y_max; ++qy) {
+      fn(static_cast<uint32_t>(qx), static_cast<uint32_t>(qy));
+    }
+  }
+}
+
+} // namespace freeisle::core::hex
@@ -0,0 +1,54 @@
+#include "core/Bytes.hh"
+
+#include <gtest/gtest.h>
+
+TEST(Bytes, Span) {
+  const std::vector<uint8_t> data = {1, 2, 3, 4, 5};
+  const freeisle::core::ByteSpan span(data);
+
+  EXPECT_EQ(span.data(), data.data());
+  EXPECT_EQ(span.size(), 5);
+  EXPECT_FALSE(span.empty());
+  EXPECT_EQ(span[4], 5);
+  EXPECT_EQ(std::vector<uint8_t>(span.begin(), span.end()), data);
+
+  const freeisle::core::ByteSpan sub = span.subspan(1, 3);
+  EXPECT_EQ(sub.data(), data.data() + 1);
+  EXPECT_EQ(sub.size(), 3);
+  EXPECT_EQ(sub[0], 2);
+
+  EXPECT_TRUE(freeisle::core::ByteSpan().empty());
+  EXPECT_TRUE(span.subspan(5, 0).empty());
+}
+
+TEST(Bytes, SharedBuffer) {
+  std::vector<uint8_t> data = {7, 8, 9};
+  const uint8_t *buffer = data.data();
+
+  freeisle::core::SharedBytes copy;
+  {
+    const freeisle::core::SharedBytes bytes(std::move(data));
+
+    // The buffer is taken over without copying:
+    EXPECT_EQ(bytes.data(), buffer);
+    copy = bytes;
+  }
+
+  ASSERT_EQ(copy.size(), 3);
+  EXPECT_EQ(copy.data(), buffer);
+  EXPECT_EQ(copy[2], 9);
+  EXPECT_EQ(copy.span().size(), 3);
+}
+
+TEST(Bytes, SharedStorage) {
+  std::shared_ptr<const std::string> storage =
+      std::make_shared<const std::string>("storage");
+  const freeisle::core::ByteSpan span(
+      reinterpret_cast<const uint8_t *>(storage->data()) + 1, 3);
+
+  const freeisle::core::SharedBytes bytes(storage, span);
+  EXPECT_EQ(storage.use_count(), 2);
+  EXPECT_EQ(std::string(bytes.begin(), bytes.end()), "tor");
+
+  EXPECT_TRUE(freeisle::core::SharedBytes().empty());
+}
@@ -125,3 +125,19 @@ TEST(Grid, MoveAssignment) {
   EXPECT_EQ(grid2(0, 0), 0);
   EXPECT_EQ(grid2(1, 0), 22);
 }
+
+TEST(Grid, Clone) {
+  freeisle::core::Grid<int> grid(3, 2);
+  grid(2, 0) = 55;
+
+  freeisle::core::Grid<int> grid2 = grid.clone();
+  grid(2, 0) = 11;
+
+  ASSERT_EQ(grid2.width(), 3);
+  ASSERT_EQ(grid2.height(), 2);
+  EXPECT_EQ(grid2(2, 0), 55);
+  EXPECT_EQ(grid2(1, 1), 0);
+
+  const freeisle::core::Grid<int> empty;
+  EXPECT_EQ(empty.clone().width(), 0);
+}
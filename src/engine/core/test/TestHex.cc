@@ -0,0 +1,116 @@
+#include "core/Hex.hh"
+
+#include "core/Grid.hh"
+
+#include <gtest/gtest.h>
+
+#include <deque>
+
+TEST(Hex, NeighborsEvenColumn) {
+  uint32_t x[6], y[6];
+  ASSERT_EQ(freeisle::core::hex::neighbors(2, 2, 5, 5, x, y), 6);
+
+  const uint32_t expected[6][2] = {{2, 1}, {3, 1}, {3, 2},
+                                   {2, 3}, {1, 2}, {1, 1}};
+  for (uint32_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(x[i], expected[i][0]);
+    EXPECT_EQ(y[i], expected[i][1]);
+  }
+}
+
+TEST(Hex, NeighborsOddColumn) {
+  uint32_t x[6], y[6];
+  ASSERT_EQ(freeisle::core::hex::neighbors(3, 2, 5, 5, x, y), 6);
+
+  const uint32_t expected[6][2] = {{3, 1}, {4, 2}, {4, 3},
+                                   {3, 3}, {2, 3}, {2, 2}};
+  for (uint32_t i = 0; i < 6; ++i) {
+    EXPECT_EQ(x[i], expected[i][0]);
+    EXPECT_EQ(y[i], expected[i][1]);
+  }
+}
+
+TEST(Hex, NeighborsBorder) {
+  uint32_t x[6], y[6];
+  ASSERT_EQ(freeisle::core::hex::neighbors(0, 0, 5, 5, x, y), 2);
+  EXPECT_EQ(x[0], 1);
+  EXPECT_EQ(y[0], 0);
+  EXPECT_EQ(x[1], 0);
+  EXPECT_EQ(y[1], 1);
+
+  ASSERT_EQ(freeisle::core::hex::neighbors(4, 4, 5, 5, x, y), 3);
+  ASSERT_EQ(freeisle::core::hex::neighbors(0, 0, 1, 1, x, y), 0);
+}
+
+TEST(Hex, DistanceIsSymmetric) {
+  EXPECT_EQ(freeisle::core::hex::distance(0, 0, 0, 0), 0);
+  EXPECT_EQ(freeisle::core::hex::distance(0, 0, 3, 0), 3);
+  EXPECT_EQ(freeisle::core::hex::distance(3, 0, 0, 0), 3);
+  EXPECT_EQ(freeisle::core::hex::distance(0, 0, 0, 4), 4);
+  EXPECT_EQ(freeisle::core::hex::distance(1, 7, 6, 2), 8);
+  EXPECT_EQ(freeisle::core::hex::distance(6, 2, 1, 7), 8);
+}
+
+TEST(Hex, DistanceMatchesNeighbors) {
+  // Breadth-first search from every hex must agree with distance()
+  const uint32_t width = 9;
+  const uint32_t height = 8;
+
+  for (uint32_t sy = 0; sy < height; ++sy) {
+    for (uint32_t sx = 0; sx < width; ++sx) {
+      freeisle::core::Grid<uint32_t> dist(width, height);
+      freeisle::core::Grid<bool> seen(width, height);
+      std::deque<std::pair<uint32_t, uint32_t>> queue{{sx, sy}};
+      seen(sx, sy) = true;
+
+      while (!queue.empty()) {
+        const std::pair<uint32_t, uint32_t> cur = queue.front();
+        queue.pop_front();
+
+        uint32_t x[6], y[6];
+        const uint32_t n = freeisle::core::hex::neighbors(
+            cur.first, cur.second, width, height, x, y);
+        for (uint32_t i = 0; i < n; ++i) {
+          if (!seen(x[i], y[i])) {
+            seen(x[i], y[i]) = true;
+            dist(x[i], y[i]) = dist(cur.first, cur.second) + 1;
+            queue.push_back({x[i], y[i]});
+          }
+        }
+      }
+
+      for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+          EXPECT_EQ(freeisle::core::hex::distance(sx, sy, x, y), dist(x, y))
+              << sx << "," << sy << " -> " << x << "," << y;
+        }
+      }
+    }
+  }
+}
+
+TEST(Hex, RangeMatchesDistance) {
+  const uint32_t width = 9;
+  const uint32_t height = 8;
+
+  for (uint32_t range = 0; range < 5; ++range) {
+    for (uint32_t sy = 0; sy < height; ++sy) {
+      for (uint32_t sx = 0; sx < width; ++sx) {
+        freeisle::core::Grid<uint32_t> visited(width, height);
+        freeisle::core::hex::for_each_in_range(
+            sx, sy, range, width, height,
+            [&visited](uint32_t x, uint32_t y) { ++visited(x, y); });
+
+        for (uint32_t y = 0; y < height; ++y) {
+          for (uint32_t x = 0; x < width; ++x) {
+            const bool in_range =
+                freeisle::core::hex::distance(sx, sy, x, y) <= range;
+            EXPECT_EQ(visited(x, y), in_range ? 1 : 0)
+                << sx << "," << sy << " range " << range << " -> " << x << ","
+                << y;
+          }
+        }
+      }
+    }
+  }
+}
@@ -1,41 +1,720 @@
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <iterator>
 #include <map>
+#include <memory>
 #include <optional>
 #include <set>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
 namespace freeisle::def {
 
+template <typename T> class Collection;
+template <typename T> class Ref;
+template <typename T> class NullableRef;
+
+/**
+ * A compact handle to an object in a collection, consisting of the index
+ * of the object's slot in the collection and the generation of that slot.
+ * Every time an object is removed from a collection, the generation of its
+ * slot is increased, so that handles to removed objects can be detected.
+ *
+ * Handles are 32 bit in size and trivially copyable, which makes them
+ * suitable to be stored in large numbers, hashed, or copied around
+ * freely. Unlike a Ref, a handle can only be resolved with the collection
+ * that it refers to.
+ */
+template <typename T> class Handle {
+public:
+  /**
+   * Number of bits used for the slot index. The remaining bits are used for
+   * the generation.
+   */
+  static constexpr uint32_t IndexBits = 20;
+
+  /**
+   * Maximum number of slots in a collection.
+   */
+  static constexpr uint32_t MaxIndex = 1u << IndexBits;
+
+  /**
+   * Number of generations after which a slot generation wraps around.
+   */
+  static constexpr uint32_t MaxGeneration = 1u << (32 - IndexBits);
+
+  /**
+   * Construct an invalid handle, which does not refer to any object.
+   */
+  constexpr Handle() : value_(0xffffffff) {}
+
+  constexpr Handle(uint32_t index, uint32_t generation)
+      : value_(((generation % MaxGeneration) << IndexBits) | index) {
+    assert(index < MaxIndex);
+  }
+
+  /**
+   * Construct a handle from a raw value previously obtained with value().
+   */
+  static constexpr Handle from_value(uint32_t value) {
+    Handle handle;
+    handle.value_ = value;
+    return handle;
+  }
+
+  constexpr uint32_t index() const { return value_ & (MaxIndex - 1); }
+  constexpr uint32_t generation() const { return value_ >> IndexBits; }
+
+  /**
+   * Returns the raw 32-bit value of the handle.
+   */
+  constexpr uint32_t value() const { return value_; }
+
+  /**
+   * Returns whether the handle refers to an object. Note that this does not
+   * check whether the object still exists.
+   */
+  constexpr explicit operator bool() const { return value_ != 0xffffffff; }
+
+  constexpr bool operator==(const Handle &other) const {
+    return value_ == other.value_;
+  }
+  constexpr bool operator!=(const Handle &other) const {
+    return value_ != other.value_;
+  }
+  constexpr bool operator<(const Handle &other) const {
+    return value_ < other.value_;
+  }
+
+private:
+  uint32_t value_;
+};
+
+namespace detail {
+
+/**
+ * Storage for a single object in a collection.
+ */
+template <typename T> struct Slot {
+  /**
+   * Object ID and object, or empty if the slot is free.
+   */
+  std::optional<std::pair<const std::string, T>> entry;
+
+  /**
+   * Index of this slot in the collection.
+   */
+  uint32_t index = 0;
+
+  /**
+   * Generation of this slot, increased every time an object is removed.
+   */
+  uint32_t generation = 0;
+};
+
+/**
+ * Slot type referred to by references to T, which may be const.
+ */
+template <typename T>
+using SlotFor = std::conditional_t<std::is_const_v<T>,
+                                   const Slot<std::remove_const_t<T>>, Slot<T>>;
+
+/**
+ * Pointer to the slot of a referred object. In debug builds, it remembers
+ * the generation of the slot at the time the reference was taken, and get()
+ * asserts that the object has not been removed since. In release builds, it
+ * is a plain pointer.
+ */
+template <typename S> class SlotPtr {
+public:
+  SlotPtr() : slot_(nullptr) {
+#ifndef NDEBUG
+    generation_ = 0;
+#endif
+  }
+
+  explicit SlotPtr(S *slot) : slot_(slot) {
+#ifndef NDEBUG
+    generation_ = slot != nullptr ? slot->generation : 0;
+#endif
+  }
+
+  /**
+   * Returns the slot, which must not have been freed since the reference
+   * was taken.
+   */
+  S *get() const {
+#ifndef NDEBUG
+    assert(slot_ == nullptr ||
+           (slot_->entry && slot_->generation == generation_));
+#endif
+    return slot_;
+  }
+
+  /**
+   * Returns the slot without checking it, for comparisons only.
+   */
+  S *raw() const { return slot_; }
+
+private:
+  S *slot_;
+#ifndef NDEBUG
+  uint32_t generation_;
+#endif
+};
+
+/**
+ * Iterator over the objects of a collection. Free slots are skipped.
+ */
+template <typename T, bool Const> class CollectionIterator {
+public:
+  using CollectionType =
+      std::conditional_t<Const, const Collection<T>, Collection<T>>;
+  using SlotType = std::conditional_t<Const, const Slot<T>, Slot<T>>;
+
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = std::pair<const std::string, T>;
+  using difference_type = std::ptrdiff_t;
+  using pointer = std::conditional_t<Const, const value_type *, value_type *>;
+  using reference = std::conditional_t<Const, const value_type &, value_type &>;
+
+  CollectionIterator()
+      : collection_(nullptr), index_(0), slot_(nullptr), page_end_(nullptr) {}
+  CollectionIterator(CollectionType *collection, uint32_t index)
+      : collection_(collection), index_(index) {
+    load();
+  }
+
+  /**
+   * Conversion from non-const to const iterator.
+   */
+  template <bool OtherConst, typename = std::enable_if_t<Const && !OtherConst>>
+  CollectionIterator(const CollectionIterator<T, OtherConst> &other)
+      : collection_(other.collection_), index_(other.index_),
+        slot_(other.slot_), page_end_(other.page_end_) {}
+
+  reference operator*() const { return *slot()->entry; }
+  pointer operator->() const { return &*slot()->entry; }
+
+  CollectionIterator &operator++() {
+    do {
+      ++index_;
+      if (++slot_ == page_end_ || index_ >= collection_->end_) {
+        load();
+      }
+    } while (slot_ != nullptr && !slot_->entry);
+
+    return *this;
+  }
+
+  CollectionIterator operator++(int) {
+    CollectionIterator result = *this;
+    ++*this;
+    return result;
+  }
+
+  template <bool OtherConst>
+  bool operator==(const CollectionIterator<T, OtherConst> &other) const {
+    return collection_ == other.collection_ && index_ == other.index_;
+  }
+
+  template <bool OtherConst>
+  bool operator!=(const CollectionIterator<T, OtherConst> &other) const {
+    return !(*this == other);
+  }
+
+  /**
+   * Returns the slot that the iterator points to.
+   */
+  SlotType *slot() const {
+    assert(slot_ != nullptr);
+    return slot_;
+  }
+
+  /**
+   * Same as slot(), but returns nullptr for the end iterator.
+   */
+  SlotType *slot_or_null() const { return slot_; }
+
+private:
+  template <typename, bool> friend class CollectionIterator;
+
+  /**
+   * Look up the slot for the current index. Slots within one page are
+   * contiguous, so this is only needed when entering a new page.
+   */
+  void load() {
+    if (collection_ == nullptr || index_ >= collection_->end_) {
+      slot_ = nullptr;
+      page_end_ = nullptr;
+      return;
+    }
+
+    slot_ = collection_->slot(index_);
+    page_end_ = slot_ + (Collection<T>::page_end(index_) - index_);
+  }
+
+  CollectionType *collection_;
+  uint32_t index_;
+  SlotType *slot_;
+  SlotType *page_end_;
+};
+
+} // namespace detail
+
 /**
  * A collection of objects of type T. The collection is keyed by object
  * IDs of type string.
+ *
+ * Objects are stored in slots that are allocated in pages of growing size,
+ * so that iteration runs linearly through memory, while objects never move
+ * once they are inserted, even when the collection grows or is moved. The
+ * object IDs are only used for a separate lookup index.
+ *
+ * Removed objects leave a free slot behind, which is reused for the next
+ * inserted object. Iteration visits objects in the order of their slots,
+ * which is insertion order as long as no objects are removed.
+ *
+ * The interface mirrors the relevant parts of std::map.
  */
-template <typename T> using Collection = std::map<std::string, T>;
+template <typename T> class Collection {
+public:
+  using key_type = std::string;
+  using mapped_type = T;
+  using value_type = std::pair<const std::string, T>;
+  using size_type = std::size_t;
+  using iterator = detail::CollectionIterator<T, false>;
+  using const_iterator = detail::CollectionIterator<T, true>;
+
+  Collection() : end_(0), size_(0) {}
+
+  Collection(std::initializer_list<value_type> init) : end_(0), size_(0) {
+    for (const value_type &value : init) {
+      insert(value);
+    }
+  }
+
+  Collection(const Collection &other) : end_(0), size_(0) { *this = other; }
+  Collection(Collection &&other) noexcept
+      : pages_(std::move(other.pages_)), end_(other.end_), size_(other.size_),
+        free_(std::move(other.free_)), names_(std::move(other.names_)) {
+    other.end_ = 0;
+    other.size_ = 0;
+  }
+
+  /**
+   * Copies all objects of another collection. Objects keep their slots,
+   * so that handles remain valid for the copy.
+   */
+  Collection &operator=(const Collection &other) {
+    if (this == &other) {
+      return *this;
+    }
+
+    clear();
+    reserve_slots(other.end_);
+    for (uint32_t i = 0; i < other.end_; ++i) {
+      const detail::Slot<T> &from = *other.slot(i);
+      detail::Slot<T> &to = *slot(i);
+      to.generation = from.generation;
+      if (from.entry) {
+        to.entry.emplace(*from.entry);
+        names_.emplace(to.entry->first, i);
+      }
+    }
+
+    end_ = other.end_;
+    size_ = other.size_;
+    free_ = other.free_;
+    return *this;
+  }
+
+  /**
+   * Makes this collection contain the same object IDs in the same slots as
+   * another collection, with default-constructed objects. Handles of the
+   * other collection are valid for this collection afterwards. This allows
+   * copying objects that refer to each other in two passes: first the
+   * layout, and then the objects, with references re-bound by handle.
+   */
+  void copy_layout(const Collection &other) {
+    clear();
+    reserve_slots(other.end_);
+    for (uint32_t i = 0; i < other.end_; ++i) {
+      const detail::Slot<T> &from = *other.slot(i);
+      detail::Slot<T> &to = *slot(i);
+      to.generation = from.generation;
+      if (from.entry) {
+        to.entry.emplace(std::piecewise_construct,
+                         std::forward_as_tuple(from.entry->first),
+                         std::forward_as_tuple());
+        names_.emplace(to.entry->first, i);
+      }
+    }
+
+    end_ = other.end_;
+    size_ = other.size_;
+    free_ = other.free_;
+  }
+
+  Collection &operator=(Collection &&other) noexcept {
+    pages_ = std::move(other.pages_);
+    end_ = other.end_;
+    size_ = other.size_;
+    free_ = std::move(other.free_);
+    names_ = std::move(other.names_);
+    other.end_ = 0;
+    other.size_ = 0;
+    return *this;
+  }
+
+  size_type size() const { return size_; }
+  bool empty() const { return size_ == 0; }
+
+  iterator begin() { return iterator(this, next_index(0)); }
+  iterator end() { return iterator(this, end_); }
+  const_iterator begin() const { return const_iterator(this, next_index(0)); }
+  const_iterator end() const { return const_iterator(this, end_); }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+
+  iterator find(const std::string &key) {
+    const auto iter = names_.find(key);
+    return iter == names_.end() ? end() : iterator(this, iter->second);
+  }
+
+  const_iterator find(const std::string &key) const {
+    const auto iter = names_.find(key);
+    return iter == names_.end() ? end() : const_iterator(this, iter->second);
+  }
+
+  /**
+   * Find the object the given handle refers to. Returns end() if the handle
+   * is invalid or the object has been removed.
+   */
+  iterator find(Handle<T> handle) { return iterator(this, lookup(handle)); }
+  const_iterator find(Handle<T> handle) const {
+    return const_iterator(this, lookup(handle));
+  }
+
+  size_type count(const std::string &key) const {
+    return names_.count(key);
+  }
+
+  T &operator[](const std::string &key) {
+    return try_emplace(key).first->second;
+  }
+
+  T &at(const std::string &key) {
+    const iterator iter = find(key);
+    if (iter == end()) {
+      throw std::out_of_range("No object with ID " + key);
+    }
+    return iter->second;
+  }
+
+  const T &at(const std::string &key) const {
+    const const_iterator iter = find(key);
+    if (iter == end()) {
+      throw std::out_of_range("No object with ID " + key);
+    }
+    return iter->second;
+  }
+
+  /**
+   * Insert a new object with the given ID, constructed from the given
+   * arguments, unless an object with that ID exists already.
+   */
+  template <typename... Args>
+  std::pair<iterator, bool> try_emplace(const std::string &key,
+                                        Args &&... args) {
+    const auto iter = names_.find(key);
+    if (iter != names_.end()) {
+      return std::make_pair(iterator(this, iter->second), false);
+    }
+
+    const uint32_t index = allocate_slot();
+    detail::Slot<T> &s = *slot(index);
+    s.entry.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+    names_.emplace(s.entry->first, index);
+    ++size_;
+
+    return std::make_pair(iterator(this, index), true);
+  }
+
+  /**
+   * Insert a new object with the given ID into the slot of the given handle,
+   * so that the handle refers to the new object. The slot must be free, and
+   * no object with that ID must exist. This restores a removed object with
+   * its old handle, or repeats an insertion on a copy of the collection.
+   */
+  template <typename... Args>
+  iterator emplace_at(Handle<T> handle, const std::string &key,
+                      Args &&... args) {
+    assert(handle && names_.count(key) == 0);
+
+    const uint32_t index = handle.index();
+    if (index >= end_) {
+      reserve_slots(index + 1);
+      for (uint32_t i = index; i > end_; --i) {
+        free_.push_back(i - 1);
+      }
+      end_ = index + 1;
+    } else {
+      const auto iter = std::find(free_.rbegin(), free_.rend(), index);
+      assert(iter != free_.rend());
+      free_.erase(std::next(iter).base());
+    }
+
+    detail::Slot<T> &s = *slot(index);
+    assert(!s.entry);
+    s.generation = handle.generation();
+    s.entry.emplace(std::piecewise_construct, std::forward_as_tuple(key),
+                    std::forward_as_tuple(std::forward<Args>(args)...));
+    names_.emplace(s.entry->first, index);
+    ++size_;
+
+    return iterator(this, index);
+  }
+
+  /**
+   * Returns the handle that the next object inserted with try_emplace() will
+   * get.
+   */
+  Handle<T> next_handle() const {
+    const uint32_t index = free_.empty() ? end_ : free_.back();
+    return Handle<T>(index, index < end_ ? slot(index)->generation : 0);
+  }
+
+  /**
+   * Insert a pair of object ID and object, unless an object with that ID
+   * exists already.
+   */
+  template <typename P> std::pair<iterator, bool> insert(P &&pair) {
+    return try_emplace(std::string(pair.first),
+                       std::forward<P>(pair).second);
+  }
+
+  /**
+   * Remove the object the iterator points to. Refs to the object become
+   * dangling, and handles to it no longer resolve.
+   */
+  iterator erase(const_iterator pos) {
+    detail::Slot<T> &s = *slot(pos.slot()->index);
+    assert(s.entry);
+
+    names_.erase(s.entry->first);
+    s.entry.reset();
+    ++s.generation;
+    --size_;
+    free_.push_back(s.index);
+
+    return iterator(this, next_index(s.index + 1));
+  }
+
+  iterator erase(iterator pos) { return erase(const_iterator(pos)); }
+
+  size_type erase(const std::string &key) {
+    const iterator iter = find(key);
+    if (iter == end()) {
+      return 0;
+    }
+
+    erase(iter);
+    return 1;
+  }
+
+  /**
+   * Remove all objects. All slots become free, so that handles to the
+   * removed objects no longer resolve.
+   */
+  void clear() {
+    for (uint32_t i = 0; i < end_; ++i) {
+      detail::Slot<T> &s = *slot(i);
+      if (s.entry) {
+        s.entry.reset();
+        ++s.generation;
+      }
+    }
+
+    names_.clear();
+    free_.clear();
+    for (uint32_t i = end_; i > 0; --i) {
+      free_.push_back(i - 1);
+    }
+
+    size_ = 0;
+  }
+
+  /**
+   * Returns the handle for the object the iterator points to.
+   */
+  static Handle<T> handle(const_iterator iter) {
+    return Handle<T>(iter.slot()->index, iter.slot()->generation);
+  }
+
+private:
+  template <typename, bool> friend class detail::CollectionIterator;
+
+  /**
+   * Size of the first page. Every following page is as large as all
+   * previous pages together.
+   */
+  static constexpr uint32_t FirstPageBits = 3;
+
+  static uint32_t page_of(uint32_t index) {
+    const uint32_t i = index >> FirstPageBits;
+    return i == 0 ? 0 : 32 - __builtin_clz(i);
+  }
+
+  static uint32_t page_begin(uint32_t page) {
+    return page == 0 ? 0 : (1u << (FirstPageBits + page - 1));
+  }
+
+  static uint32_t page_size(uint32_t page) {
+    return page == 0 ? (1u << FirstPageBits)
+                     : (1u << (FirstPageBits + page - 1));
+  }
+
+  /**
+   * Returns the index following the last slot of the page that the given
+   * index is in.
+   */
+  static uint32_t page_end(uint32_t index) {
+    const uint32_t page = page_of(index);
+    return page_begin(page) + page_size(page);
+  }
+
+  detail::Slot<T> *slot(uint32_t index) {
+    const uint32_t page = page_of(index);
+    assert(page < pages_.size());
+    return &pages_[page][index - page_begin(page)];
+  }
+
+  const detail::Slot<T> *slot(uint32_t index) const {
+    const uint32_t page = page_of(index);
+    assert(page < pages_.size());
+    return &pages_[page][index - page_begin(page)];
+  }
+
+  /**
+   * Returns the index of the first occupied slot starting at the given
+   * index, or end_ if there is none.
+   */
+  uint32_t next_index(uint32_t index) const {
+    while (index < end_ && !slot(index)->entry) {
+      ++index;
+    }
+    return index;
+  }
+
+  uint32_t lookup(Handle<T> handle) const {
+    if (!handle || handle.index() >= end_) {
+      return end_;
+    }
+
+    const detail::Slot<T> &s = *slot(handle.index());
+    if (!s.entry || Handle<T>(s.index, s.generation) != handle) {
+      return end_;
+    }
+
+    return handle.index();
+  }
+
+  /**
+   * Make sure that slots up to the given index exist.
+   */
+  void reserve_slots(uint32_t num) {
+    while (num > page_begin(pages_.size())) {
+      const uint32_t page = pages_.size();
+      if (page_begin(page) >= Handle<T>::MaxIndex) {
+        throw std::length_error("Too many objects in collection");
+      }
+
+      std::unique_ptr<detail::Slot<T>[]> slots(
+          new detail::Slot<T>[page_size(page)]);
+      for (uint32_t i = 0; i < page_size(page); ++i) {
+        slots[i].index = page_begin(page) + i;
+      }
+      pages_.push_back(std::move(slots));
+    }
+  }
+
+  uint32_t allocate_slot() {
+    if (!free_.empty()) {
+      const uint32_t index = free_.back();
+      free_.pop_back();
+      return index;
+    }
+
+    reserve_slots(end_ + 1);
+    return end_++;
+  }
+
+  std::vector<std::unique_ptr<detail::Slot<T>[]>> pages_;
+
+  /**
+   * Number of slots that have ever been used. All slots from end_ on are
+   * unused.
+   */
+  uint32_t end_;
+
+  /**
+   * Number of objects in the collection.
+   */
+  uint32_t size_;
+
+  /**
+   * Free slots below end_, the one to be reused next at the back.
+   */
+  std::vector<uint32_t> free_;
+
+  /**
+   * Index from object ID to slot index. The keys point to the object IDs
+   * stored in the slots.
+   */
+  std::unordered_map<std::string_view, uint32_t> names_;
+};
 
 /**
  * A reference to an object in a collection. It can only be copied from
  * non-const reference for const correctness. Use a Ref<const T> if you have
  * a const Ref and need to make a copy.
+ *
+ * A Ref points directly to the object's slot, so dereferencing it does not
+ * need the collection. Use handle() to obtain a compact handle. In debug
+ * builds, accessing a Ref to an object that has been removed from its
+ * collection trips an assertion, even if the slot has been reused since.
  */
 template <typename T> class Ref {
 public:
   /**
    * Construct an object reference from an iterator into the collection.
    */
-  Ref(typename Collection<T>::iterator iter) : iter(iter) {}
+  Ref(detail::CollectionIterator<T, false> iter) : slot_(iter.slot()) {}
 
-  Ref(Ref &other) noexcept : iter(other.iter) {}
-  Ref(Ref &&other) noexcept : iter(other.iter) {}
+  Ref(Ref &other) noexcept : slot_(other.slot_) {}
+  Ref(Ref &&other) noexcept : slot_(other.slot_) {}
   Ref(const Ref &) = delete;
 
   Ref &operator=(Ref<T> &other) noexcept {
-    iter = other.iter;
+    slot_ = other.slot_;
     return *this;
   }
   Ref &operator=(Ref<T> &&other) noexcept {
-    iter = other.iter;
+    slot_ = other.slot_;
     return *this;
   }
   Ref &operator=(const Ref<T> &) = delete;
@@ -43,51 +722,73 @@ public:
   /**
    * Return the object ID of the referred object.
    */
-  const std::string &id() const { return iter->first; }
+  const std::string &id() const { return slot_.get()->entry->first; }
 
-  T &operator*() { return iter->second; }
-  const T &operator*() const { return iter->second; }
-  T *operator->() { return &iter->second; }
-  const T *operator->() const { return &iter->second; }
+  /**
+   * Return the handle of the referred object.
+   */
+  Handle<T> handle() const {
+    return Handle<T>(slot_.get()->index, slot_.get()->generation);
+  }
 
-  bool operator==(const Ref &other) const { return iter == other.iter; }
-  bool operator!=(const Ref &other) const { return iter != other.iter; }
+  T &operator*() { return slot_.get()->entry->second; }
+  const T &operator*() const { return slot_.get()->entry->second; }
+  T *operator->() { return &slot_.get()->entry->second; }
+  const T *operator->() const { return &slot_.get()->entry->second; }
+
+  bool operator==(const Ref &other) const {
+    return slot_.raw() == other.slot_.raw();
+  }
+  bool operator!=(const Ref &other) const {
+    return slot_.raw() != other.slot_.raw();
+  }
 
   /**
-   * Compare to other references. A reference compares less than another
-   * reference if its object ID compares less than the other reference's
-   * object ID.
+   * Compare to other references. References are ordered by the slot index
+   * of the referred object, i.e. by the index part of their handles, which
+   * is also the order in which the collection is iterated. Comparing does
+   * not touch the object IDs.
    */
   struct Compare {
     bool operator()(const Ref &a, const Ref &b) const {
-      return a.iter->first < b.iter->first;
+      return a.index() < b.index();
     }
 
     bool operator()(const Ref &a,
-                    const typename Collection<T>::iterator &b) const {
-      return a.iter->first < b->first;
+                    const detail::CollectionIterator<T, false> &b) const {
+      return a.index() < b.slot()->index;
     }
 
     bool operator()(const Ref &a,
-                    const typename Collection<T>::const_iterator &b) const {
-      return a.iter->first < b->first;
+                    const detail::CollectionIterator<T, true> &b) const {
+      return a.index() < b.slot()->index;
     }
 
-    bool operator()(const typename Collection<T>::const_iterator &a,
+    bool operator()(const detail::CollectionIterator<T, true> &a,
                     const Ref &b) const {
-      return a->first < b.iter->first;
+      return a.slot()->index < b.index();
     }
 
-    bool operator()(const typename Collection<T>::iterator &a,
+    bool operator()(const detail::CollectionIterator<T, false> &a,
                     const Ref &b) const {
-      return a->first < b.iter->first;
+      return a.slot()->index < b.index();
     }
 
     typedef Ref is_transparent;
   };
 
 private:
-  typename Collection<T>::iterator iter;
+  friend class NullableRef<T>;
+
+  explicit Ref(detail::SlotPtr<detail::Slot<T>> slot) : slot_(slot) {}
+
+  /**
+   * Slot index of the referred object. This stays the same when the object
+   * is removed, so that a dangling Ref can still be erased from a RefSet.
+   */
+  uint32_t index() const { return slot_.raw()->index; }
+
+  detail::SlotPtr<detail::Slot<T>> slot_;
 };
 
 /**
@@ -96,28 +797,40 @@ private:
  */
 template <typename T> class Ref<const T> {
 public:
-  Ref(typename Collection<T>::iterator iter) : iter(iter) {}
-  Ref(typename Collection<T>::const_iterator iter) : iter(iter) {}
+  Ref(detail::CollectionIterator<T, false> iter) : slot_(iter.slot()) {}
+  Ref(detail::CollectionIterator<T, true> iter) : slot_(iter.slot()) {}
 
   /**
    * Return the object ID of the referred object.
    */
-  const std::string &id() const { return iter->first; }
+  const std::string &id() const { return slot_.get()->entry->first; }
+
+  /**
+   * Return the handle of the referred object.
+   */
+  Handle<T> handle() const {
+    return Handle<T>(slot_.get()->index, slot_.get()->generation);
+  }
 
-  const T &operator*() const { return iter->second; }
-  const T *operator->() const { return &iter->second; }
+  const T &operator*() const { return slot_.get()->entry->second; }
+  const T *operator->() const { return &slot_.get()->entry->second; }
 
   /**
    * Augment this reference to a non-const ref. This needs a non-const
    * collection.
    */
   Ref<T> augment(Collection<T> &collection) {
-    assert(collection.find(iter->first) == iter);
-    return collection.find(iter->first);
+    const typename Collection<T>::iterator iter = collection.find(handle());
+    assert(iter != collection.end() && iter.slot() == slot_.raw());
+    return iter;
   }
 
 private:
-  typename Collection<T>::const_iterator iter;
+  friend class NullableRef<const T>;
+
+  explicit Ref(detail::SlotPtr<const detail::Slot<T>> slot) : slot_(slot) {}
+
+  detail::SlotPtr<const detail::Slot<T>> slot_;
 };
 
 /**
@@ -126,74 +839,95 @@ private:
  */
 template <typename T> class NullableRef {
 public:
-  NullableRef() noexcept = default;
-  NullableRef(typename Collection<T>::iterator iter) noexcept : ref_(iter) {}
-  NullableRef(Ref<T> ref) noexcept : ref_(std::move(ref)) {}
+  NullableRef() noexcept {}
+  /**
+   * Construct a reference from an iterator into the collection. The end
+   * iterator yields a reference that does not point to any object.
+   */
+  NullableRef(detail::CollectionIterator<T, false> iter) noexcept
+      : slot_(iter.slot_or_null()) {}
+  NullableRef(Ref<T> ref) noexcept : slot_(ref.slot_) {}
 
-  NullableRef(NullableRef<T> &other) : ref_(std::move(other.ref_)) {}
-  NullableRef(NullableRef<T> &&other) : ref_(std::move(other.ref_)) {}
+  NullableRef(NullableRef<T> &other) : slot_(other.slot_) {}
+  NullableRef(NullableRef<T> &&other) : slot_(other.slot_) {}
 
-  bool operator==(const NullableRef &other) const { return ref_ == other.ref_; }
-  bool operator!=(const NullableRef &other) const { return ref_ != other.ref_; }
-  bool operator==(const Ref<T> &other) const { return ref_ && *ref_ == other; }
-  bool operator==(const typename Collection<T>::iterator iter) const {
-    return *this == NullableRef<T>(iter);
+  bool operator==(const NullableRef &other) const {
+    return slot_.raw() == other.slot_.raw();
+  }
+  bool operator!=(const NullableRef &other) const {
+    return slot_.raw() != other.slot_.raw();
+  }
+  bool operator==(const Ref<T> &other) const {
+    return slot_.raw() != nullptr && slot_.raw() == other.slot_.raw();
+  }
+  bool operator==(const detail::CollectionIterator<T, false> iter) const {
+    return slot_.raw() != nullptr && slot_.raw() == iter.slot_or_null();
   }
-  bool operator==(const typename Collection<T>::const_iterator iter) const {
-    return ref_ && &**ref_ == &iter->second;
+  bool operator==(const detail::CollectionIterator<T, true> iter) const {
+    return slot_.raw() != nullptr && slot_.raw() == iter.slot_or_null();
   }
 
   NullableRef &operator=(NullableRef &other) {
-    ref_ = std::move(other.ref_);
+    slot_ = other.slot_;
     return *this;
   }
   NullableRef &operator=(NullableRef &&other) {
-    ref_ = std::move(other.ref_);
+    slot_ = other.slot_;
     return *this;
   }
 
   /**
    * Returns whether the NullableRef points to a valid object or not.
    */
-  explicit operator bool() const { return ref_.has_value(); }
+  explicit operator bool() const { return slot_.raw() != nullptr; }
 
   /**
    * Returns whether the NullableRef is invalid or not.
    */
-  bool operator!() const { return !ref_.has_value(); }
+  bool operator!() const { return slot_.raw() == nullptr; }
 
   /**
    * Return the object ID of the referred object.
    */
   const std::string &id() const {
-    assert(ref_);
-    return ref_->id();
+    assert(slot_.raw());
+    return slot_.get()->entry->first;
+  }
+
+  /**
+   * Return the handle of the referred object, or an invalid handle if the
+   * NullableRef does not point to any object.
+   */
+  Handle<std::remove_const_t<T>> handle() const {
+    return slot_.raw() ? Handle<std::remove_const_t<T>>(
+                             slot_.get()->index, slot_.get()->generation)
+                       : Handle<std::remove_const_t<T>>();
   }
 
   T &operator*() {
-    assert(ref_);
-    return **ref_;
+    assert(slot_.raw());
+    return slot_.get()->entry->second;
   }
   const T &operator*() const {
-    assert(ref_);
-    return **ref_;
+    assert(slot_.raw());
+    return slot_.get()->entry->second;
   }
   T *operator->() {
-    assert(ref_);
-    return &**ref_;
+    assert(slot_.raw());
+    return &slot_.get()->entry->second;
   }
   const T *operator->() const {
-    assert(ref_);
-    return &**ref_;
+    assert(slot_.raw());
+    return &slot_.get()->entry->second;
   }
 
   operator Ref<T>() {
-    assert(ref_);
-    return *ref_;
+    assert(slot_.raw());
+    return Ref<T>(slot_);
   }
 
 private:
-  std::optional<Ref<T>> ref_;
+  detail::SlotPtr<detail::SlotFor<T>> slot_;
 };
 
 /**
@@ -201,14 +935,14 @@ private:
  * when there exists collection of type T, and for each element in the
  * collection, additional data needs to be maintained. In this case, every
  * entry in the original collection typically has one corresponding entry
- * in the RefMap.
+ * in the RefMap. Entries are ordered by slot index, like the collection.
  */
 template <typename C, typename T>
 using RefMap = std::map<Ref<C>, T, typename Ref<C>::Compare>;
 
 /**
  * A set of object references. Typically used to create a subset of a
- * collection.
+ * collection. Entries are ordered by slot index, like the collection.
  */
 template <typename T> using RefSet = std::set<Ref<T>, typename Ref<T>::Compare>;
 
@@ -249,3 +983,19 @@ RefSet<T> make_ref_set(Args &&... args) {
 }
 
 } // namespace freeisle::def
+
+namespace std {
+
+template <typename T> struct hash<freeisle::def::Handle<T>> {
+  size_t operator()(freeisle::def::Handle<T> handle) const noexcept {
+    return hash<uint32_t>()(handle.value());
+  }
+};
+
+template <typename T> struct hash<freeisle::def::Ref<T>> {
+  size_t operator()(const freeisle::def::Ref<T> &ref) const noexcept {
+    return hash<uint32_t>()(ref.handle().value());
+  }
+};
+
+} // namespace std
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cstdint>
+
 namespace freeisle::def {
 
 // TODO(armin): replace with core::Point2u
@@ -0,0 +1,97 @@
+#include "def/Collection.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <map>
+#include <string>
+
+namespace {
+
+struct Object {
+  uint32_t health;
+  uint32_t movement;
+  uint32_t fuel;
+  uint32_t experience;
+};
+
+template <typename C> void fill(C &collection, uint32_t num) {
+  for (uint32_t i = 0; i < num; ++i) {
+    collection.try_emplace("unit" + std::to_string(i),
+                           Object{.health = i % 100, .movement = 600});
+  }
+}
+
+/**
+ * Per-turn style pass over all objects of a collection.
+ */
+template <typename C> void BM_Iterate(benchmark::State &state) {
+  C collection;
+  fill(collection, state.range(0));
+
+  for (auto _ : state) {
+    uint64_t sum = 0;
+    for (auto &[id, obj] : collection) {
+      obj.movement = 600;
+      sum += obj.health;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Lookup of objects by ID.
+ */
+template <typename C> void BM_FindById(benchmark::State &state) {
+  C collection;
+  fill(collection, state.range(0));
+
+  uint32_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(
+        collection.find("unit" + std::to_string(i++ % state.range(0))));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Lookup of objects by handle.
+ */
+void BM_FindByHandle(benchmark::State &state) {
+  freeisle::def::Collection<Object> collection;
+  fill(collection, state.range(0));
+
+  std::vector<freeisle::def::Handle<Object>> handles;
+  for (auto iter = collection.begin(); iter != collection.end(); ++iter) {
+    handles.push_back(freeisle::def::Collection<Object>::handle(iter));
+  }
+
+  uint32_t i = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(collection.find(handles[i++ % handles.size()]));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK_TEMPLATE(BM_Iterate, freeisle::def::Collection<Object>)
+    ->Arg(1000)
+    ->Arg(10000);
+BENCHMARK_TEMPLATE(BM_Iterate, std::map<std::string, Object>)
+    ->Arg(1000)
+    ->Arg(10000);
+
+BENCHMARK_TEMPLATE(BM_FindById, freeisle::def::Collection<Object>)
+    ->Arg(1000)
+    ->Arg(10000);
+BENCHMARK_TEMPLATE(BM_FindById, std::map<std::string, Object>)
+    ->Arg(1000)
+    ->Arg(10000);
+
+BENCHMARK(BM_FindByHandle)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "log/Logger.hh"
+#include "png/Png.hh"
 
 #include <map>
 #include <string>
@@ -9,6 +10,11 @@ namespace freeisle::def::serialize {
 
 struct AuxData {
   log::Logger &logger;
+
+  /**
+   * Compression used for map images when saving.
+   */
+  png::Compression map_compression = png::Compression::Default;
 };
 
 } // namespace freeisle::def::serialize
@@ -31,14 +31,15 @@ public:
     assert(collection_ != nullptr);
     collection_->clear();
 
-    const Json::Value::Members &members = value.getMemberNames();
-    for (const std::string &key : members) {
+    for (Json::Value::iterator iter = value.begin(); iter != value.end();
+         ++iter) {
       const std::pair<typename def::Collection<T>::iterator, bool> result =
-          collection_->try_emplace(key);
+          collection_->try_emplace(iter.name());
       assert(result.second);
 
       child_handler_.set(result.first);
-      json::loader::load_object(ctx, value, key.c_str(), child_handler_);
+      json::loader::load_child(ctx, value, result.first->first.c_str(),
+                               child_handler_);
     }
   }
 
@@ -59,13 +60,44 @@ public:
 };
 
 /**
- * A shortcut for a CollectionLoader with an empty child handler. This can
- * be useful when loading the actual information into the objects later
- * with CollectionLoaderPass. It can be used to load objects with cyclic
- * references.
+ * Like a CollectionLoader with an empty child handler, it populates the
+ * collection with empty objects. This can be useful when loading the actual
+ * information into the objects later with CollectionLoaderPass. It can be
+ * used to load objects with cyclic references.
+ *
+ * Only the keys are read, so child objects that have not been parsed yet
+ * (see json::loader::Context::deferred) are not parsed for this pass, and
+ * their include references are resolved by the later pass.
  */
-template <typename T>
-using EmptyCollectionLoader = CollectionLoader<T, EmptyChildHandler<T>>;
+template <typename T> class EmptyCollectionLoader {
+public:
+  explicit EmptyCollectionLoader(def::Collection<T> &collection)
+      : collection_(&collection) {}
+
+  /**
+   * Load the container from the given json value. The value needs to be
+   * of type object.
+   */
+  void load(json::loader::Context &ctx, Json::Value &value) {
+    assert(collection_ != nullptr);
+    collection_->clear();
+
+    for (Json::Value::iterator iter = value.begin(); iter != value.end();
+         ++iter) {
+      if (!iter->isObject()) {
+        throw json::loader::Error::create(
+            ctx, iter.name(), *iter, "Expected value to be of object type");
+      }
+
+      const std::pair<typename def::Collection<T>::iterator, bool> result =
+          collection_->try_emplace(iter.name());
+      assert(result.second);
+    }
+  }
+
+private:
+  def::Collection<T> *collection_;
+};
 
 /**
  * For a given def::Collection of type T, loads additional information from
@@ -82,8 +114,8 @@ public:
     for (typename def::Collection<T>::iterator iter = collection_->begin();
          iter != collection_->end(); ++iter) {
       child_handler_.set(iter);
-      json::loader::load_object(ctx, value, iter->first.c_str(),
-                                child_handler_);
+      json::loader::load_child(ctx, value, iter->first.c_str(),
+                               child_handler_);
     }
   }
 
@@ -148,8 +180,8 @@ public:
       assert(result.second);
 
       child_handler_.set(iter, result.first->second);
-      json::loader::load_object(ctx, value, iter->first.c_str(),
-                                child_handler_);
+      json::loader::load_child(ctx, value, iter->first.c_str(),
+                               child_handler_);
     }
   }
 
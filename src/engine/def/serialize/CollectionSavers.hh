@@ -5,6 +5,10 @@
 #include "json/SaveUtil.hh"
 #include "json/Saver.hh"
 
+#include <algorithm>
+#include <string>
+#include <vector>
+
 namespace freeisle::def::serialize {
 
 /**
@@ -93,17 +97,28 @@ private:
 
 /**
  * Save a reference set in the JSON document. It is saved as an array with
- * string values, each denoting the object ID of an item in the set.
+ * string values, each denoting the object ID of an item in the set. The
+ * IDs are sorted, so that the output does not depend on the slots of the
+ * objects in the collection.
  */
 template <typename T>
 void save_ref_set(json::saver::Context &ctx, Json::Value &value,
                   const char *key, const def::RefSet<T> &set,
                   const def::Collection<T> &collection) {
+  std::vector<const std::string *> ids;
+  ids.reserve(set.size());
+  for (const def::Ref<T> &ref : set) {
+    ids.push_back(&ref.id());
+  }
+
+  std::sort(ids.begin(), ids.end(),
+            [](const std::string *a, const std::string *b) { return *a < *b; });
+
   value[key] = Json::Value(Json::ValueType::arrayValue);
   Json::Value &val = value[key];
 
-  for (const def::Ref<T> &ref : set) {
-    val.append(ref.id());
+  for (const std::string *id : ids) {
+    val.append(*id);
   }
 }
 
@@ -9,8 +9,21 @@
 
 #include "png/Png.hh"
 
+#include <array>
+#include <thread>
+
 namespace freeisle::def::serialize {
 
+namespace {
+
+/**
+ * Number of hexes from which on map images are compressed on multiple
+ * threads.
+ */
+constexpr uint64_t ParallelEncodeSize = 1024 * 1024;
+
+} // namespace
+
 DecorationDefLoader::DecorationDefLoader(
     std::map<uint32_t, const def::DecorationDef *> &indices)
     : def_(nullptr), indices(indices) {}
@@ -88,60 +101,70 @@ void MapDefLoader::load(json::loader::Context &ctx, Json::Value &value) {
   DecorationDefContainerLoader decorations_loader(map_.decoration_defs, aux_);
   json::loader::load_object(ctx, value, "decorations", decorations_loader);
 
-  const std::vector<uint8_t> png_data =
+  const core::SharedBytes png_data =
       json::loader::load_binary(ctx, value, "grid");
 
-  core::Grid<core::color::Rgb8> image_data;
-  try {
-    image_data = png::decode_rgb8(png_data.data(), png_data.size(),
-                                  aux_.logger.make_child_logger("png-decode"));
-  } catch (const std::exception &ex) {
-    throw json::loader::Error::create(ctx, "grid", value["grid"], ex.what());
+  // Decoration for each B channel value, nullptr for invalid ones:
+  std::array<const def::DecorationDef *, 256> decorations;
+  for (uint32_t i = 0; i < decorations.size(); ++i) {
+    decorations[i] = decorations_loader.get_decoration_for_index(i);
   }
 
-  map_.grid =
-      core::Grid<def::MapDef::Hex>(image_data.width(), image_data.height());
-  for (uint32_t y = 0; y < image_data.height(); ++y) {
-    for (uint32_t x = 0; x < image_data.width(); ++x) {
-      uint32_t base_terrain_index = image_data(x, y).r;
-      uint32_t overlay_terrain_index = image_data(x, y).g;
-      uint32_t decoration_index = image_data(x, y).b;
+  // Rows are converted as they are decoded, without an intermediate image.
+  // Most rows are valid, so the terrain channels are range-checked for the
+  // whole row at once, and only checked pixel by pixel to find the exact
+  // location if that fails.
+  const png::SizeFn size = [&](uint32_t width, uint32_t height) {
+    map_.grid = core::Grid<def::MapDef::Hex>(width, height);
+  };
+
+  const png::ReadRowFn read_row = [&](uint32_t y,
+                                      const core::color::Rgb8 *row) {
+    const uint32_t width = map_.grid.width();
+    const core::color::Rgb8 max = png::channel_max(row, width);
+    const bool terrain_valid =
+        max.r < static_cast<uint32_t>(def::BaseTerrainType::Num) &&
+        max.g <= static_cast<uint32_t>(def::OverlayTerrainType::Num);
+
+    for (uint32_t x = 0; x < width; ++x) {
+      uint32_t base_terrain_index = row[x].r;
+      uint32_t overlay_terrain_index = row[x].g;
+      uint32_t decoration_index = row[x].b;
+
+      if (!terrain_valid) {
+        if (base_terrain_index >=
+            static_cast<uint32_t>(def::BaseTerrainType::Num)) {
+          throw json::loader::Error::create(
+              ctx, "grid", value["grid"],
+              fmt::format(
+                  "Map at {},{}: invalid base terrain type {} in R channel", x,
+                  y, base_terrain_index));
+        }
 
-      if (base_terrain_index >=
-          static_cast<uint32_t>(def::BaseTerrainType::Num)) {
-        throw json::loader::Error::create(
-            ctx, "grid", value["grid"],
-            fmt::format(
-                "Map at {},{}: invalid base terrain type {} in R channel", x, y,
-                base_terrain_index));
+        if (overlay_terrain_index >
+            static_cast<uint32_t>(def::OverlayTerrainType::Num)) {
+          throw json::loader::Error::create(
+              ctx, "grid", value["grid"],
+              fmt::format(
+                  "Map at {},{}: invalid overlay terrain type {} in G channel",
+                  x, y, overlay_terrain_index));
+        }
       }
 
       core::Sentinel<def::OverlayTerrainType, def::OverlayTerrainType::Num>
           overlay_terrain;
-      if (overlay_terrain_index >
-          static_cast<uint32_t>(def::OverlayTerrainType::Num)) {
-        throw json::loader::Error::create(
-            ctx, "grid", value["grid"],
-            fmt::format(
-                "Map at {},{}: invalid overlay terrain type {} in G channel", x,
-                y, overlay_terrain_index));
-      }
-
       if (overlay_terrain_index > 0) {
         overlay_terrain =
             static_cast<def::OverlayTerrainType>(overlay_terrain_index - 1);
       }
 
-      const def::DecorationDef *deco = nullptr;
-      if (decoration_index != 0) {
-        deco = decorations_loader.get_decoration_for_index(decoration_index);
-        if (deco == nullptr) {
-          throw json::loader::Error::create(
-              ctx, "grid", value["grid"],
-              fmt::format(
-                  "Map at {},{}: invalid decoration index {} in B channel", x,
-                  y, decoration_index));
-        }
+      const def::DecorationDef *deco = decorations[decoration_index];
+      if (deco == nullptr && decoration_index != 0) {
+        throw json::loader::Error::create(
+            ctx, "grid", value["grid"],
+            fmt::format(
+                "Map at {},{}: invalid decoration index {} in B channel", x, y,
+                decoration_index));
       }
 
       map_.grid(x, y) = def::MapDef::Hex{
@@ -149,6 +172,15 @@ void MapDefLoader::load(json::loader::Context &ctx, Json::Value &value) {
           .overlay_terrain = overlay_terrain,
           .decoration = deco};
     }
+  };
+
+  try {
+    png::decode_rgb8_rows(png_data.data(), png_data.size(), size, read_row,
+                          aux_.logger.make_child_logger("png-decode"));
+  } catch (const json::loader::Error &) {
+    throw;
+  } catch (const std::exception &ex) {
+    throw json::loader::Error::create(ctx, "grid", value["grid"], ex.what());
   }
 }
 
@@ -164,37 +196,73 @@ void MapDefSaver::save(json::saver::Context &ctx, Json::Value &value) {
       map_.decoration_defs, reverse_index_map);
   json::saver::save_object(ctx, value, "decorations", decorations_saver);
 
-  // Encode hex grid as RGB8 image data, so we can save it as PNG
-  core::Grid<core::color::Rgb8> image_data(map_.grid.width(),
-                                           map_.grid.height());
-  for (uint32_t y = 0; y < map_.grid.height(); ++y) {
+  // Encode hex grid as RGB8 image data, so we can save it as PNG. Rows are
+  // converted as they are needed, without an intermediate image.
+  std::vector<core::color::Rgb8> converted(map_.grid.width());
+  const png::WriteRowFn write_row = [&](uint32_t y, core::color::Rgb8 *row) {
     for (uint32_t x = 0; x < map_.grid.width(); ++x) {
-      image_data(x, y).r = static_cast<uint32_t>(map_.grid(x, y).base_terrain);
+      const def::MapDef::Hex &hex = map_.grid(x, y);
+      row[x].r = static_cast<uint32_t>(hex.base_terrain);
 
-      if (!map_.grid(x, y).overlay_terrain) {
-        image_data(x, y).g = 0;
+      if (!hex.overlay_terrain) {
+        row[x].g = 0;
       } else {
-        image_data(x, y).g =
-            static_cast<uint32_t>(*map_.grid(x, y).overlay_terrain) + 1;
+        row[x].g = static_cast<uint32_t>(*hex.overlay_terrain) + 1;
       }
 
-      if (map_.grid(x, y).decoration == nullptr) {
-        image_data(x, y).b = 0;
+      if (hex.decoration == nullptr) {
+        row[x].b = 0;
       } else {
         std::map<const def::DecorationDef *, uint32_t>::const_iterator iter =
-            reverse_index_map.find(map_.grid(x, y).decoration);
+            reverse_index_map.find(hex.decoration);
         assert(iter != reverse_index_map.end());
         assert(iter->second < 0xff);
-        image_data(x, y).b = iter->second;
+        row[x].b = iter->second;
       }
     }
-  }
+  };
 
-  std::vector<uint8_t> png_data =
-      png::encode_rgb8(image_data, aux_.logger.make_child_logger("png-encode"));
+  // PNG encoding is by far the most expensive part of saving the map, so
+  // it is skipped if the image is unchanged since the last save. The
+  // version combines the hashes of all rows:
+  uint64_t hashes[2] = {0, 0};
+  for (uint32_t y = 0; y < map_.grid.height(); ++y) {
+    write_row(y, converted.data());
+    hashes[1] = json::saver::SaveCache::hash(
+        reinterpret_cast<const uint8_t *>(converted.data()),
+        converted.size() * sizeof(core::color::Rgb8));
+    hashes[0] = json::saver::SaveCache::hash(
+        reinterpret_cast<const uint8_t *>(hashes), sizeof(hashes));
+  }
 
-  json::saver::save_binary(ctx, value, "grid", png_data.data(), png_data.size(),
-                           map_filename_.c_str());
+  // The same rows make a different file with another compression, and
+  // rows can be split differently with the same content, so both go into
+  // the version as well:
+  const uint64_t version[4] = {
+      hashes[0],
+      map_.grid.width(),
+      map_.grid.height(),
+      static_cast<uint64_t>(aux_.map_compression),
+  };
+  hashes[0] = json::saver::SaveCache::hash(
+      reinterpret_cast<const uint8_t *>(version), sizeof(version));
+
+  // Compressing large maps takes long enough to be worth spreading over
+  // all cores:
+  const uint32_t num_threads =
+      static_cast<uint64_t>(map_.grid.width()) * map_.grid.height() >=
+              ParallelEncodeSize
+          ? std::thread::hardware_concurrency()
+          : 1;
+
+  json::saver::save_binary_cached(
+      ctx, value, "grid", map_filename_.c_str(), hashes[0], [&]() {
+        return png::encode_rgb8_rows(
+            map_.grid.width(), map_.grid.height(), write_row,
+            png::EncodeOptions{.compression = aux_.map_compression,
+                               .num_threads = num_threads},
+            aux_.logger.make_child_logger("png-encode"));
+      });
 }
 
 } // namespace freeisle::def::serialize
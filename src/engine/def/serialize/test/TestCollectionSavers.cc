@@ -24,7 +24,7 @@ struct Objects {
 };
 
 struct ObjectHandler {
-  const Object *obj;
+  const Object *obj = nullptr;
 
   void set(freeisle::def::Ref<const Object> o) { obj = &*o; }
 
@@ -34,7 +34,7 @@ struct ObjectHandler {
 };
 
 struct ObjectNumberHandler {
-  uint32_t n;
+  uint32_t n = 0;
 
   void set(freeisle::def::Ref<const Object>, uint32_t o) { n = o; }
 
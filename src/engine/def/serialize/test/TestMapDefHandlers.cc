@@ -332,8 +332,8 @@ TEST_F(TestMapDefHandlers, SaveEmpty5x5) {
       "{\"decorations\": {\"obj001\": {\"name\": \"flowers\", \"index\": 1}}, "
       "\"grid\": "
       "\"base64:"
-      "iVBORw0KGgoAAAANSUhEUgAAAAUAAAAFCAIAAAACDbGyAAAADElEQVQImWNgoC4AAABQAA"
-      "GmLdqcAAAAAElFTkSuQmCC\"}";
+      "iVBORw0KGgoAAAANSUhEUgAAAAUAAAAFAQMAAAC3obSmAAAAA1BMVEUAAACnej3aAAAAC0"
+      "lEQVQImWNggAEAAAoAAWeL7ekAAAAASUVORK5CYII=\"}";
   freeisle::json::test::check(value, expected_value);
 
   // TODO(armin): load back and compare to original instead?
@@ -370,8 +370,8 @@ TEST_F(TestMapDefHandlers, SaveEmpty5x5ToFile) {
       freeisle::base64::encode(file_content.data(), file_content.size(),
                                reinterpret_cast<uint8_t *>(&base64[0]));
   base64.resize(len);
-  EXPECT_EQ(base64, "iVBORw0KGgoAAAANSUhEUgAAAAUAAAAFCAIAAAACDbGyAAAADElEQVQImW"
-                    "NgoC4AAABQAAGmLdqcAAAAAElFTkSuQmCC");
+  EXPECT_EQ(base64, "iVBORw0KGgoAAAANSUhEUgAAAAUAAAAFAQMAAAC3obSmAAAAA1BMVEUAAA"
+                    "Cnej3aAAAAC0lEQVQImWNggAEAAAoAAWeL7ekAAAAASUVORK5CYII=");
 }
 
 TEST_F(TestMapDefHandlers, SaveVarying4x4) {
@@ -422,8 +422,9 @@ TEST_F(TestMapDefHandlers, SaveVarying4x4) {
       "{\"decorations\": {\"obj001\": {\"name\": \"flowers\", \"index\": 1}, "
       "\"obj002\": {\"name\": \"pebbles\", \"index\": 2}}, \"grid\": "
       "\"base64:"
-      "iVBORw0KGgoAAAANSUhEUgAAAAQAAAAECAIAAAAmkwkpAAAAJUlEQVQImS3GsQ0AIAwDMC"
-      "cD//+LRBnAk7MYsKt/igg0ctTkLVzAPAcL8VlLnAAAAABJRU5ErkJggg==\"}";
+      "iVBORw0KGgoAAAANSUhEUgAAAAQAAAAEBAMAAABb34NNAAAAG1BMVEUGAAAFAAAAAgAAAA"
+      "IAAQACAgADAAAAAAEEAAAiJSIkAAAAFElEQVQImWNgFGIQNGJwCWMozQAABq8BztjnMKkA"
+      "AAAASUVORK5CYII=\"}";
   freeisle::json::test::check(value, expected_value);
 }
 
@@ -0,0 +1,250 @@
+#include "def/Collection.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <type_traits>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+struct Object {
+  std::string name;
+};
+
+std::vector<std::string>
+ids(const freeisle::def::Collection<Object> &collection) {
+  std::vector<std::string> result;
+  for (const auto &[id, obj] : collection) {
+    result.push_back(id);
+  }
+  return result;
+}
+
+} // namespace
+
+static_assert(sizeof(freeisle::def::Handle<Object>) == 4);
+static_assert(
+    std::is_trivially_copyable_v<freeisle::def::Handle<Object>>);
+
+TEST(Collection, Empty) {
+  freeisle::def::Collection<Object> collection;
+  EXPECT_TRUE(collection.empty());
+  EXPECT_EQ(collection.size(), 0);
+  EXPECT_EQ(collection.begin(), collection.end());
+  EXPECT_EQ(collection.find("obj001"), collection.end());
+  EXPECT_EQ(collection.find(freeisle::def::Handle<Object>()),
+            collection.end());
+}
+
+TEST(Collection, TryEmplace) {
+  freeisle::def::Collection<Object> collection;
+
+  const auto first = collection.try_emplace("obj001", Object{"first"});
+  EXPECT_TRUE(first.second);
+  EXPECT_EQ(first.first->first, "obj001");
+  EXPECT_EQ(first.first->second.name, "first");
+
+  const auto second = collection.try_emplace("obj001", Object{"second"});
+  EXPECT_FALSE(second.second);
+  EXPECT_EQ(second.first, first.first);
+  EXPECT_EQ(second.first->second.name, "first");
+
+  EXPECT_EQ(collection.size(), 1);
+  EXPECT_EQ(collection.count("obj001"), 1);
+  EXPECT_EQ(collection.count("obj002"), 0);
+}
+
+TEST(Collection, IterationInInsertionOrder) {
+  freeisle::def::Collection<Object> collection;
+  for (const char *id : {"c", "a", "b", "e", "d", "g", "f", "i", "h", "j"}) {
+    collection.try_emplace(id);
+  }
+
+  EXPECT_EQ(ids(collection), (std::vector<std::string>{"c", "a", "b", "e", "d",
+                                                        "g", "f", "i", "h",
+                                                        "j"}));
+}
+
+TEST(Collection, ObjectsDoNotMove) {
+  freeisle::def::Collection<Object> collection;
+  Object *first = &collection["obj0"];
+
+  for (uint32_t i = 1; i < 1000; ++i) {
+    collection.try_emplace("obj" + std::to_string(i));
+  }
+
+  EXPECT_EQ(&collection["obj0"], first);
+
+  freeisle::def::Collection<Object> moved = std::move(collection);
+  EXPECT_EQ(&moved["obj0"], first);
+  EXPECT_EQ(moved.size(), 1000);
+}
+
+TEST(Collection, Erase) {
+  freeisle::def::Collection<Object> collection{
+      {"obj001", {"first"}}, {"obj002", {"second"}}, {"obj003", {"third"}}};
+
+  const freeisle::def::Handle<Object> handle =
+      freeisle::def::Collection<Object>::handle(collection.find("obj002"));
+  EXPECT_EQ(collection.find(handle), collection.find("obj002"));
+
+  EXPECT_EQ(collection.erase("obj002"), 1);
+  EXPECT_EQ(collection.erase("obj002"), 0);
+  EXPECT_EQ(collection.size(), 2);
+  EXPECT_EQ(collection.find("obj002"), collection.end());
+  EXPECT_EQ(collection.find(handle), collection.end());
+  EXPECT_EQ(ids(collection), (std::vector<std::string>{"obj001", "obj003"}));
+
+  // free slot is reused, but the old handle stays invalid
+  collection.try_emplace("obj004");
+  EXPECT_EQ(ids(collection),
+            (std::vector<std::string>{"obj001", "obj004", "obj003"}));
+  EXPECT_EQ(collection.find(handle), collection.end());
+
+  const freeisle::def::Handle<Object> new_handle =
+      freeisle::def::Collection<Object>::handle(collection.find("obj004"));
+  EXPECT_EQ(new_handle.index(), handle.index());
+  EXPECT_NE(new_handle, handle);
+  EXPECT_EQ(freeisle::def::Handle<Object>::from_value(new_handle.value()),
+            new_handle);
+}
+
+TEST(Collection, EmplaceAt) {
+  freeisle::def::Collection<Object> collection{{"obj001", {"first"}},
+                                               {"obj002", {"second"}}};
+  const freeisle::def::Handle<Object> handle =
+      freeisle::def::Collection<Object>::handle(collection.find("obj001"));
+  EXPECT_EQ(collection.next_handle(), freeisle::def::Handle<Object>(2, 0));
+
+  // Restore a removed object with its old handle
+  collection.erase("obj001");
+  EXPECT_EQ(collection.next_handle(), freeisle::def::Handle<Object>(0, 1));
+  collection.emplace_at(handle, "obj001", Object{"restored"});
+  EXPECT_EQ(collection.find(handle), collection.find("obj001"));
+  EXPECT_EQ(collection.find(handle)->second.name, "restored");
+  EXPECT_EQ(collection.next_handle(), freeisle::def::Handle<Object>(2, 0));
+
+  // Repeat an insertion of another collection beyond the end
+  const freeisle::def::Handle<Object> other(5, 3);
+  collection.emplace_at(other, "obj005");
+  EXPECT_EQ(collection.find(other), collection.find("obj005"));
+  EXPECT_EQ(ids(collection),
+            (std::vector<std::string>{"obj001", "obj002", "obj005"}));
+
+  // Skipped slots are free
+  collection.try_emplace("obj003");
+  collection.try_emplace("obj004");
+  collection.try_emplace("obj006");
+  EXPECT_EQ(ids(collection),
+            (std::vector<std::string>{"obj001", "obj002", "obj003", "obj004",
+                                      "obj006", "obj005"}));
+}
+
+TEST(Collection, Clear) {
+  freeisle::def::Collection<Object> collection{{"obj001", {"first"}}};
+  const freeisle::def::Handle<Object> handle =
+      freeisle::def::Collection<Object>::handle(collection.begin());
+
+  collection.clear();
+  EXPECT_TRUE(collection.empty());
+  EXPECT_EQ(collection.begin(), collection.end());
+  EXPECT_EQ(collection.find(handle), collection.end());
+
+  collection.try_emplace("obj001");
+  EXPECT_EQ(collection.size(), 1);
+  EXPECT_EQ(collection.find(handle), collection.end());
+}
+
+TEST(Collection, Copy) {
+  const freeisle::def::Collection<Object> collection{{"obj001", {"first"}},
+                                                     {"obj002", {"second"}}};
+  const freeisle::def::Handle<Object> handle =
+      freeisle::def::Collection<Object>::handle(collection.find("obj002"));
+
+  freeisle::def::Collection<Object> copy = collection;
+  EXPECT_EQ(ids(copy), ids(collection));
+  ASSERT_NE(copy.find(handle), copy.end());
+  EXPECT_EQ(copy.find(handle)->second.name, "second");
+  EXPECT_NE(&copy.find("obj002")->second, &collection.find("obj002")->second);
+}
+
+TEST(Collection, Ref) {
+  freeisle::def::Collection<Object> collection{{"obj001", {"first"}},
+                                               {"obj002", {"second"}}};
+
+  freeisle::def::Ref<Object> ref = collection.find("obj002");
+  EXPECT_EQ(ref.id(), "obj002");
+  EXPECT_EQ(ref->name, "second");
+  EXPECT_EQ(collection.find(ref.handle()), collection.find("obj002"));
+
+  freeisle::def::Ref<const Object> const_ref = collection.find("obj001");
+  EXPECT_EQ(const_ref.id(), "obj001");
+
+  freeisle::def::Ref<Object> augmented = const_ref.augment(collection);
+  augmented->name = "changed";
+  EXPECT_EQ(collection.find("obj001")->second.name, "changed");
+
+  std::unordered_set<freeisle::def::Ref<Object>> set;
+  set.emplace(collection.find("obj001"));
+  set.emplace(collection.find("obj002"));
+  set.emplace(collection.find("obj002"));
+  EXPECT_EQ(set.size(), 2);
+  EXPECT_EQ(set.count(ref), 1);
+}
+
+TEST(Collection, NullableRef) {
+  freeisle::def::Collection<Object> collection{{"obj001", {"first"}}};
+
+  freeisle::def::NullableRef<Object> null;
+  EXPECT_FALSE(null);
+  EXPECT_FALSE(null.handle());
+
+  freeisle::def::NullableRef<Object> end = collection.find("obj002");
+  EXPECT_FALSE(end);
+
+  freeisle::def::NullableRef<Object> ref = collection.find("obj001");
+  ASSERT_TRUE(ref);
+  EXPECT_EQ(ref, collection.find("obj001"));
+  EXPECT_FALSE(ref == collection.end());
+  EXPECT_EQ(ref.id(), "obj001");
+  EXPECT_EQ(ref.handle(),
+            freeisle::def::Collection<Object>::handle(collection.begin()));
+}
+
+TEST(Collection, RefSetOrderedBySlot) {
+  freeisle::def::Collection<Object> collection{{"obj003", {"first"}},
+                                               {"obj001", {"second"}},
+                                               {"obj002", {"third"}}};
+
+  freeisle::def::RefSet<Object> set = freeisle::def::make_ref_set<Object>(
+      collection.find("obj002"), collection.find("obj003"),
+      collection.find("obj001"));
+
+  std::vector<std::string> result;
+  for (const freeisle::def::Ref<Object> &ref : set) {
+    result.push_back(ref.id());
+  }
+  EXPECT_EQ(result, ids(collection));
+  EXPECT_EQ(set.count(collection.find("obj001")), 1);
+
+  // A dangling reference can still be erased from the set:
+  freeisle::def::Ref<Object> removed = collection.find("obj001");
+  collection.erase("obj001");
+  EXPECT_EQ(set.erase(removed), 1);
+  EXPECT_EQ(set.size(), 2);
+}
+
+#ifndef NDEBUG
+TEST(CollectionDeathTest, DanglingRef) {
+  freeisle::def::Collection<Object> collection{{"obj001", {"first"}}};
+
+  freeisle::def::Ref<Object> ref = collection.find("obj001");
+  collection.erase("obj001");
+  // The slot is reused by the next object:
+  collection.try_emplace("obj002");
+
+  EXPECT_DEATH(ref.id(), "");
+}
+#endif
@@ -0,0 +1,139 @@
+#include "fow/View.hh"
+
+#include "state/Allegiance.hh"
+
+#include "core/Hex.hh"
+
+#include <cassert>
+
+namespace freeisle::fow {
+
+namespace {
+
+void adjust(state::Player::Fow &fow, int32_t delta) {
+  fow.view += delta;
+  if (fow.view > 0) {
+    fow.discovered = true;
+  }
+}
+
+/**
+ * Adds delta to the view factor of all hexes within range of loc.
+ */
+void apply_range(core::Grid<state::Player::Fow> &fow, def::Location loc,
+                 uint32_t range, int32_t delta) {
+  if (range == 0) {
+    return;
+  }
+
+  core::hex::for_each_in_range(
+      loc.x, loc.y, range, fow.width(), fow.height(),
+      [&fow, delta](uint32_t x, uint32_t y) { adjust(fow(x, y), delta); });
+}
+
+/**
+ * Moves a range from one location to another: removes delta from the hexes
+ * that are only within range of from, and adds it to the hexes that are
+ * only within range of to. Hexes within range of both are not touched.
+ */
+void move_range(core::Grid<state::Player::Fow> &fow, def::Location from,
+                def::Location to, uint32_t range, int32_t delta) {
+  if (range == 0) {
+    return;
+  }
+
+  core::hex::for_each_in_range(
+      from.x, from.y, range, fow.width(), fow.height(),
+      [&fow, to, range, delta](uint32_t x, uint32_t y) {
+        if (core::hex::distance(x, y, to.x, to.y) > range) {
+          adjust(fow(x, y), -delta);
+        }
+      });
+
+  core::hex::for_each_in_range(
+      to.x, to.y, range, fow.width(), fow.height(),
+      [&fow, from, range, delta](uint32_t x, uint32_t y) {
+        if (core::hex::distance(x, y, from.x, from.y) > range) {
+          adjust(fow(x, y), delta);
+        }
+      });
+}
+
+/**
+ * Calls fn(player, range, delta) for every player whose view is affected by
+ * the given unit, with the range of the effect and its sign.
+ */
+template <typename Fn>
+void for_each_affected(def::Collection<state::Player> &players,
+                       const state::Unit &unit, Fn fn) {
+  const state::Player &owner = *unit.owner;
+
+  for (auto &[id, player] : players) {
+    if (&player == &owner) {
+      fn(player, unit.def->view_range, 1);
+    } else if (!state::are_allied(player, owner)) {
+      fn(player, unit.def->jamming_range, -1);
+    }
+  }
+}
+
+void apply_unit(def::Collection<state::Player> &players,
+                const state::Unit &unit, int32_t sign) {
+  if (!is_active(unit)) {
+    return;
+  }
+
+  for_each_affected(players, unit,
+                    [&unit, sign](state::Player &player, uint32_t range,
+                                  int32_t delta) {
+                      apply_range(player.fow, unit.location, range,
+                                  sign * delta);
+                    });
+}
+
+} // namespace
+
+bool is_active(const state::Unit &unit) {
+  return unit.def && unit.owner && !unit.contained_in_unit &&
+         !unit.contained_in_shop;
+}
+
+void rebuild(state::State &state) {
+  for (auto &[id, player] : state.players) {
+    core::Grid<state::Player::Fow> &fow = player.fow;
+    for (uint32_t y = 0; y < fow.height(); ++y) {
+      for (uint32_t x = 0; x < fow.width(); ++x) {
+        fow(x, y).view = 0;
+      }
+    }
+  }
+
+  for (const auto &[id, unit] : state.units) {
+    apply_unit(state.players, unit, 1);
+  }
+}
+
+void add_unit(def::Collection<state::Player> &players,
+              const state::Unit &unit) {
+  apply_unit(players, unit, 1);
+}
+
+void remove_unit(def::Collection<state::Player> &players,
+                 const state::Unit &unit) {
+  apply_unit(players, unit, -1);
+}
+
+void move_unit(def::Collection<state::Player> &players,
+               const state::Unit &unit, def::Location from) {
+  if (!is_active(unit)) {
+    return;
+  }
+
+  for_each_affected(
+      players, unit,
+      [&unit, from](state::Player &player, uint32_t range, int32_t delta) {
+        move_range(player.fow, from, unit.location, range, delta);
+      });
+}
+
+} // namespace freeisle::fow
@@ -0,0 +1,70 @@
+#pragma once
+
+#include "state/Player.hh"
+#include "state/State.hh"
+#include "state/Unit.hh"
+
+#include "def/Collection.hh"
+#include "def/Location.hh"
+
+/**
+ * Functions in fow maintain the view factors of the players' fog of war.
+ *
+ * Every unit on the map increases the view factor of its owner in all hexes
+ * within its view range, and decreases the view factor of all players that
+ * are not allied with its owner in all hexes within its jamming range. A
+ * range of 0 means that the unit does not view or jam at all. A hex is
+ * visible for a player if its view factor is positive, and it becomes
+ * discovered as soon as it is visible.
+ *
+ * Units without owner and units that are contained in another unit or in a
+ * shop neither view nor jam.
+ *
+ * The view factors are maintained incrementally: whenever a unit appears,
+ * disappears or moves, the corresponding function needs to be called, which
+ * updates only the hexes whose view factor changes.
+ */
+namespace freeisle::fow {
+
+/**
+ * Returns whether the given fog of war tile is currently visible.
+ */
+inline bool is_visible(const state::Player::Fow &fow) { return fow.view > 0; }
+
+/**
+ * Returns whether the given unit affects the view factors, i.e. whether it
+ * is on the map and owned by a player.
+ */
+bool is_active(const state::Unit &unit);
+
+/**
+ * Recompute the view factors of all players from scratch, from all units in
+ * the given state. Also marks all visible hexes as discovered.
+ */
+void rebuild(state::State &state);
+
+/**
+ * Add the view and jamming of the given unit at its current location. Call
+ * this when a unit is placed on the map, e.g. when it is produced or when it
+ * is unloaded from a container.
+ */
+void add_unit(def::Collection<state::Player> &players,
+              const state::Unit &unit);
+
+/**
+ * Remove the view and jamming of the given unit at its current location.
+ * Call this before a unit is removed from the map, e.g. when it is
+ * destroyed, or when it is loaded into a container.
+ */
+void remove_unit(def::Collection<state::Player> &players,
+                 const state::Unit &unit);
+
+/**
+ * Move the view and jamming of the given unit from the given location to
+ * its current location. Call this after the unit's location has been
+ * updated. Only hexes that enter or leave the unit's ranges are touched.
+ */
+void move_unit(def::Collection<state::Player> &players,
+               const state::Unit &unit, def::Location from);
+
+} // namespace freeisle::fow
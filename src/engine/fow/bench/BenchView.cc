@@ -0,0 +1,98 @@
+#include "fow/View.hh"
+
+#include "core/Hex.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  Fixture(uint32_t size, uint32_t num_units) : Scenario(size, size) {
+    add_unit_def("tank", freeisle::def::UnitDef{
+                             .name = "tank",
+                             .view_range = 4,
+                             .jamming_range = 1,
+                         });
+
+    // two teams of two players each
+    add_team("north");
+    add_team("south");
+    for (uint32_t i = 0; i < 4; ++i) {
+      add_player("player" + std::to_string(i), i % 2 ? "north" : "south");
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> coord(0, size - 1);
+    for (uint32_t i = 0; i < num_units; ++i) {
+      const uint32_t x = coord(rng);
+      const uint32_t y = coord(rng);
+      add_unit("unit" + std::to_string(i), "tank",
+               "player" + std::to_string(i % 4), x, y);
+    }
+
+    freeisle::fow::rebuild(state);
+  }
+};
+
+/**
+ * Incremental update of all players' view factors when a single unit moves
+ * by one hex.
+ */
+void BM_MoveUnit(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+
+  std::vector<freeisle::state::Unit *> units;
+  for (auto &[id, unit] : fixture.state.units) {
+    units.push_back(&unit);
+  }
+
+  uint32_t i = 0;
+  for (auto _ : state) {
+    freeisle::state::Unit &unit = *units[i++ % units.size()];
+    const freeisle::def::Location from = unit.location;
+
+    uint32_t nx[freeisle::core::hex::NumNeighbors];
+    uint32_t ny[freeisle::core::hex::NumNeighbors];
+    const uint32_t n = freeisle::core::hex::neighbors(
+        from.x, from.y, state.range(0), state.range(0), nx, ny);
+    unit.location = {.x = nx[i % n], .y = ny[i % n]};
+    freeisle::fow::move_unit(fixture.state.players, unit, from);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Recomputing all players' view factors from scratch, which is what each
+ * move would cost without incremental updates.
+ */
+void BM_Rebuild(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    freeisle::fow::rebuild(fixture.state);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_MoveUnit)
+    ->Args({256, 1000})
+    ->Args({256, 5000})
+    ->Args({1024, 5000})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_Rebuild)
+    ->Args({256, 1000})
+    ->Args({256, 5000})
+    ->Args({1024, 5000})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
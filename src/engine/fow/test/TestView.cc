@@ -0,0 +1,194 @@
+#include "fow/View.hh"
+
+#include "core/Hex.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+class TestView : public ::testing::Test,
+                 public freeisle::state::test::Scenario {
+public:
+  TestView() : Scenario(9, 9) {
+    add_unit_def("scout", freeisle::def::UnitDef{
+                              .name = "scout",
+                              .view_range = 2,
+                              .jamming_range = 0,
+                          });
+    add_unit_def("jammer", freeisle::def::UnitDef{
+                               .name = "jammer",
+                               .view_range = 1,
+                               .jamming_range = 1,
+                           });
+
+    add_default_players();
+  }
+
+  const freeisle::core::Grid<freeisle::state::Player::Fow> &
+  fow(const std::string &player) {
+    return state.players[player].fow;
+  }
+
+  void expect_view(const std::string &player, uint32_t x, uint32_t y,
+                   uint32_t range, int32_t in_range) {
+    for (uint32_t j = 0; j < 9; ++j) {
+      for (uint32_t i = 0; i < 9; ++i) {
+        const bool within = freeisle::core::hex::distance(x, y, i, j) <= range;
+        EXPECT_EQ(fow(player)(i, j).view, within ? in_range : 0)
+            << player << ": " << i << "," << j;
+      }
+    }
+  }
+};
+
+TEST_F(TestView, OwnUnitViews) {
+  const freeisle::state::Unit &unit =
+      add_unit("unit001", "scout", "rose", 4, 4);
+  freeisle::fow::add_unit(state.players, unit);
+
+  expect_view("rose", 4, 4, 2, 1);
+  EXPECT_TRUE(fow("rose")(4, 2).discovered);
+  EXPECT_FALSE(fow("rose")(4, 1).discovered);
+  EXPECT_TRUE(freeisle::fow::is_visible(fow("rose")(4, 2)));
+  EXPECT_FALSE(freeisle::fow::is_visible(fow("rose")(4, 1)));
+
+  // Allies do not share view, and scouts do not jam
+  expect_view("daisy", 4, 4, 0, 0);
+  expect_view("lily", 4, 4, 0, 0);
+}
+
+TEST_F(TestView, EnemyUnitJams) {
+  const freeisle::state::Unit &unit =
+      add_unit("unit001", "jammer", "lily", 4, 4);
+  freeisle::fow::add_unit(state.players, unit);
+
+  expect_view("lily", 4, 4, 1, 1);
+  expect_view("rose", 4, 4, 1, -1);
+  expect_view("daisy", 4, 4, 1, -1);
+}
+
+TEST_F(TestView, AlliedUnitDoesNotJam) {
+  const freeisle::state::Unit &unit =
+      add_unit("unit001", "jammer", "daisy", 4, 4);
+  freeisle::fow::add_unit(state.players, unit);
+
+  expect_view("daisy", 4, 4, 1, 1);
+  expect_view("rose", 4, 4, 0, 0);
+  expect_view("lily", 4, 4, 1, -1);
+}
+
+TEST_F(TestView, JammingHidesUnitsInView) {
+  const freeisle::state::Unit &scout =
+      add_unit("unit001", "scout", "rose", 4, 4);
+  const freeisle::state::Unit &jammer =
+      add_unit("unit002", "jammer", "lily", 5, 4);
+  freeisle::fow::add_unit(state.players, scout);
+  freeisle::fow::add_unit(state.players, jammer);
+
+  EXPECT_FALSE(freeisle::fow::is_visible(fow("rose")(5, 4)));
+  EXPECT_TRUE(freeisle::fow::is_visible(fow("rose")(3, 4)));
+}
+
+TEST_F(TestView, RemoveUnitKeepsDiscovered) {
+  const freeisle::state::Unit &unit =
+      add_unit("unit001", "scout", "rose", 4, 4);
+  freeisle::fow::add_unit(state.players, unit);
+  freeisle::fow::remove_unit(state.players, unit);
+
+  expect_view("rose", 4, 4, 0, 0);
+  EXPECT_TRUE(fow("rose")(4, 2).discovered);
+}
+
+TEST_F(TestView, ContainedUnitDoesNotView) {
+  add_unit("unit001", "scout", "rose", 4, 4);
+  freeisle::state::Unit &unit = add_unit("unit002", "scout", "rose", 4, 4);
+  unit.contained_in_unit = state.units.find("unit001");
+  EXPECT_FALSE(freeisle::fow::is_active(unit));
+
+  freeisle::fow::add_unit(state.players, unit);
+  expect_view("rose", 4, 4, 0, 0);
+}
+
+TEST_F(TestView, UnownedUnitDoesNotView) {
+  freeisle::state::Unit &unit = add_unit("unit001", "jammer", "rose", 4, 4);
+  unit.owner = freeisle::def::NullableRef<freeisle::state::Player>();
+  EXPECT_FALSE(freeisle::fow::is_active(unit));
+
+  freeisle::fow::add_unit(state.players, unit);
+  expect_view("rose", 4, 4, 0, 0);
+  expect_view("lily", 4, 4, 0, 0);
+}
+
+TEST_F(TestView, MoveUnit) {
+  freeisle::state::Unit &unit = add_unit("unit001", "jammer", "rose", 4, 4);
+  freeisle::fow::add_unit(state.players, unit);
+
+  unit.location = {.x = 5, .y = 5};
+  freeisle::fow::move_unit(state.players, unit, {.x = 4, .y = 4});
+
+  expect_view("rose", 5, 5, 1, 1);
+  expect_view("lily", 5, 5, 1, -1);
+  EXPECT_TRUE(fow("rose")(4, 3).discovered);
+}
+
+TEST_F(TestView, MoveAtMapBorder) {
+  freeisle::state::Unit &unit = add_unit("unit001", "scout", "rose", 0, 0);
+  freeisle::fow::add_unit(state.players, unit);
+
+  unit.location = {.x = 8, .y = 8};
+  freeisle::fow::move_unit(state.players, unit, {.x = 0, .y = 0});
+  expect_view("rose", 8, 8, 2, 1);
+}
+
+TEST_F(TestView, IncrementalMatchesRebuild) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint32_t> coord(0, 8);
+  std::uniform_int_distribution<uint32_t> step(0, 5);
+
+  const char *players[] = {"rose", "daisy", "lily"};
+  for (uint32_t i = 0; i < 12; ++i) {
+    freeisle::state::Unit &unit =
+        add_unit("unit" + std::to_string(i), i % 2 ? "scout" : "jammer",
+                 players[i % 3], coord(rng), coord(rng));
+    freeisle::fow::add_unit(state.players, unit);
+  }
+
+  for (uint32_t i = 0; i < 200; ++i) {
+    freeisle::state::Unit &unit =
+        state.units["unit" + std::to_string(i % 12)];
+    const freeisle::def::Location from = unit.location;
+
+    uint32_t nx[freeisle::core::hex::NumNeighbors];
+    uint32_t ny[freeisle::core::hex::NumNeighbors];
+    const uint32_t n = freeisle::core::hex::neighbors(from.x, from.y, 9, 9,
+                                                      nx, ny);
+    const uint32_t j = step(rng) % n;
+    unit.location = {.x = nx[j], .y = ny[j]};
+    freeisle::fow::move_unit(state.players, unit, from);
+  }
+
+  std::map<std::string, std::vector<int32_t>> views;
+  for (const auto &[id, player] : state.players) {
+    for (uint32_t y = 0; y < 9; ++y) {
+      for (uint32_t x = 0; x < 9; ++x) {
+        views[id].push_back(player.fow(x, y).view);
+      }
+    }
+  }
+
+  freeisle::fow::rebuild(state);
+
+  for (const auto &[id, player] : state.players) {
+    for (uint32_t y = 0; y < 9; ++y) {
+      for (uint32_t x = 0; x < 9; ++x) {
+        EXPECT_EQ(views[id][y * 9 + x], player.fow(x, y).view)
+            << id << ": " << x << "," << y;
+      }
+    }
+  }
+}
@@ -0,0 +1,86 @@
+#include "fs/BufferedReader.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <stdexcept>
+
+namespace freeisle::fs {
+
+BufferedReader::BufferedReader(File &file, size_t buffer_size)
+    : file_(&file), buffer_size_(buffer_size),
+      buffer_(new uint8_t[buffer_size]), begin_(0), end_(0), position_(0) {
+  assert(buffer_size > 0);
+}
+
+uint64_t BufferedReader::read(uint8_t *data, uint64_t length) {
+  if (length == 0) {
+    return 0;
+  }
+
+  if (begin_ == end_ && length >= buffer_size_) {
+    const uint64_t len = file_->read(data, length);
+    position_ += len;
+    return len;
+  }
+
+  if (!fill()) {
+    return 0;
+  }
+
+  const uint64_t len = std::min<uint64_t>(length, end_ - begin_);
+  std::memcpy(data, buffer_.get() + begin_, len);
+  begin_ += len;
+  position_ += len;
+  return len;
+}
+
+void BufferedReader::read_all(uint8_t *data, uint64_t length) {
+  while (length > 0) {
+    const uint64_t consumed = read(data, length);
+    if (consumed == 0) {
+      throw std::runtime_error("File is too short");
+    }
+
+    data += consumed;
+    length -= consumed;
+  }
+}
+
+bool BufferedReader::read_line(std::string &line) {
+  line.clear();
+
+  bool found = false;
+  while (fill()) {
+    found = true;
+
+    const uint8_t *begin = buffer_.get() + begin_;
+    const uint8_t *end = buffer_.get() + end_;
+    const uint8_t *newline =
+        static_cast<const uint8_t *>(std::memchr(begin, '\n', end - begin));
+    if (newline != nullptr) {
+      line.append(begin, newline);
+      begin_ += newline - begin + 1;
+      position_ += newline - begin + 1;
+      return true;
+    }
+
+    line.append(begin, end);
+    begin_ = end_;
+    position_ += end - begin;
+  }
+
+  return found;
+}
+
+bool BufferedReader::fill() {
+  if (begin_ < end_) {
+    return true;
+  }
+
+  begin_ = 0;
+  end_ = file_->read(buffer_.get(), buffer_size_);
+  return end_ > 0;
+}
+
+} // namespace freeisle::fs
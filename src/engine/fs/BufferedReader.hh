@@ -0,0 +1,72 @@
+#pragma once
+
+#include "fs/File.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace freeisle::fs {
+
+/**
+ * BufferedReader reads a file through a buffer of fixed size, so that many
+ * small reads, e.g. of records or lines, result in few system calls. Reads
+ * that are at least as large as the buffer bypass it.
+ */
+class BufferedReader {
+public:
+  static constexpr size_t DefaultBufferSize = 64 * 1024;
+
+  /**
+   * Create a reader for the given file, which must be open for reading and
+   * stay open while the reader is in use.
+   * @param buffer_size Size of the buffer, must not be 0.
+   */
+  explicit BufferedReader(File &file, size_t buffer_size = DefaultBufferSize);
+
+  BufferedReader(const BufferedReader &) = delete;
+  BufferedReader(BufferedReader &&) = default;
+  BufferedReader &operator=(const BufferedReader &) = delete;
+  BufferedReader &operator=(BufferedReader &&) = default;
+
+  /**
+   * Read up to length bytes. Throws std::runtime_error if the data cannot
+   * be read.
+   * @return The number of bytes actually read. Returns 0 on end of file.
+   */
+  uint64_t read(uint8_t *data, uint64_t length);
+
+  /**
+   * Read exactly length bytes. Throws std::runtime_error if the file is not
+   * long enough, or if the data cannot be read.
+   */
+  void read_all(uint8_t *data, uint64_t length);
+
+  /**
+   * Read the next line, without the terminating newline. The last line
+   * does not need to be terminated.
+   * @return false on end of file, in which case line is empty.
+   */
+  bool read_line(std::string &line);
+
+  /**
+   * Total number of bytes consumed from the reader.
+   */
+  uint64_t position() const { return position_; }
+
+private:
+  /**
+   * Refill the buffer if it is empty. Returns false on end of file.
+   */
+  bool fill();
+
+  File *file_;
+  size_t buffer_size_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t begin_;
+  size_t end_;
+  uint64_t position_;
+};
+
+} // namespace freeisle::fs
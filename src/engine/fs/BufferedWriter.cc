@@ -0,0 +1,100 @@
+#include "fs/BufferedWriter.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace freeisle::fs {
+
+BufferedWriter::BufferedWriter(File &file, size_t buffer_size,
+                               size_t copy_threshold)
+    : file_(&file), buffer_size_(buffer_size),
+      copy_threshold_(copy_threshold != 0
+                          ? std::min(copy_threshold, buffer_size)
+                          : std::max<size_t>(1, buffer_size / 4)),
+      buffer_(new uint8_t[buffer_size]), used_(0), flushed_(0) {
+  assert(buffer_size > 0);
+}
+
+void BufferedWriter::write(const File::Fragment *fragments, uint32_t num) {
+  // Start of the buffered data that is not part of the batch yet:
+  size_t mark = 0;
+
+  for (uint32_t i = 0; i < num; ++i) {
+    const File::Fragment &fragment = fragments[i];
+    if (fragment.length >= copy_threshold_) {
+      if (used_ > mark) {
+        batch_.push_back({buffer_.get() + mark, used_ - mark});
+        mark = used_;
+      }
+
+      batch_.push_back(fragment);
+      continue;
+    }
+
+    if (fragment.length > buffer_size_ - used_) {
+      // The buffer cannot be reused before everything referring to it is
+      // written:
+      if (used_ > mark) {
+        batch_.push_back({buffer_.get() + mark, used_ - mark});
+      }
+
+      write_batch();
+      mark = 0;
+    }
+
+    std::memcpy(buffer_.get() + used_, fragment.data, fragment.length);
+    used_ += fragment.length;
+  }
+
+  // Data passed in directly must be written before returning, since the
+  // caller may free it afterwards:
+  if (!batch_.empty()) {
+    if (used_ > mark) {
+      batch_.push_back({buffer_.get() + mark, used_ - mark});
+    }
+
+    write_batch();
+  }
+}
+
+void BufferedWriter::flush() {
+  if (used_ > 0) {
+    batch_.push_back({buffer_.get(), used_});
+    write_batch();
+  }
+}
+
+void BufferedWriter::sync() {
+  flush();
+  file_->sync();
+}
+
+void BufferedWriter::write_batch() {
+  // Everything in the buffer is part of the batch at this point, and it is
+  // dropped even if writing fails, so that the writer stays consistent:
+  uint64_t length = 0;
+  for (const File::Fragment &fragment : batch_) {
+    length += fragment.length;
+  }
+
+  try {
+    write_all(*file_, batch_.data(), batch_.size());
+  } catch (...) {
+    batch_.clear();
+    used_ = 0;
+    throw;
+  }
+
+  if (observer_) {
+    for (const File::Fragment &fragment : batch_) {
+      observer_(fragment.data, fragment.length);
+    }
+  }
+
+  flushed_ += length;
+  batch_.clear();
+  used_ = 0;
+}
+
+} // namespace freeisle::fs
@@ -0,0 +1,137 @@
+#pragma once
+
+#include "fs/File.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace freeisle::fs {
+
+/**
+ * BufferedWriter streams data into a file through a buffer of fixed size,
+ * so that many small writes result in few system calls, and output does not
+ * need to be held in memory as a whole.
+ *
+ * Data that is at least as large as the copy threshold is not copied into
+ * the buffer. Instead, it is written together with the buffered data with
+ * a single gather write, see File::write(). This also applies to sequences
+ * of fragments, e.g. a record header followed by its payload.
+ *
+ * Buffered data is only written to the file when the buffer is full, or by
+ * flush(). Data that was not flushed when the writer is destroyed is
+ * discarded, so that an aborted write, e.g. due to an exception, does not
+ * leave more of the output behind than necessary.
+ */
+class BufferedWriter {
+public:
+  static constexpr size_t DefaultBufferSize = 64 * 1024;
+
+  /**
+   * Create a writer for the given file, which must be open for writing and
+   * stay open while the writer is in use.
+   * @param buffer_size    Size of the buffer, must not be 0.
+   * @param copy_threshold Data of at least this size is written directly
+   *                       rather than copied into the buffer. Defaults to
+   *                       a quarter of the buffer size, and is at most the
+   *                       buffer size.
+   */
+  explicit BufferedWriter(File &file, size_t buffer_size = DefaultBufferSize,
+                          size_t copy_threshold = 0);
+
+  BufferedWriter(const BufferedWriter &) = delete;
+  BufferedWriter(BufferedWriter &&) = default;
+  BufferedWriter &operator=(const BufferedWriter &) = delete;
+  BufferedWriter &operator=(BufferedWriter &&) = default;
+
+  /**
+   * Write data into the file. Throws std::runtime_error if writing out the
+   * buffer fails.
+   */
+  void write(const uint8_t *data, uint64_t length) {
+    // Small data that fits into the buffer is the common case:
+    if (length < copy_threshold_ && length <= buffer_size_ - used_) {
+      std::memcpy(buffer_.get() + used_, data, length);
+      used_ += length;
+      return;
+    }
+
+    const File::Fragment fragment = {data, length};
+    write(&fragment, 1);
+  }
+
+  void write(std::string_view str) {
+    write(reinterpret_cast<const uint8_t *>(str.data()), str.size());
+  }
+
+  /**
+   * Write a single byte into the file.
+   */
+  void put(uint8_t byte) {
+    if (used_ == buffer_size_) {
+      flush();
+    }
+
+    buffer_[used_++] = byte;
+  }
+
+  /**
+   * Write a sequence of fragments into the file, one after the other.
+   * Small fragments are copied into the buffer, large ones are written
+   * together with the buffered data before this function returns.
+   */
+  void write(const File::Fragment *fragments, uint32_t num);
+
+  /**
+   * Write out all buffered data. Throws std::runtime_error on failure.
+   */
+  void flush();
+
+  /**
+   * Write out all buffered data and flush the file to the storage device,
+   * see File::sync(). Throws std::runtime_error on failure.
+   */
+  void sync();
+
+  /**
+   * Total number of bytes written through the writer, including the ones
+   * still in the buffer.
+   */
+  uint64_t position() const { return flushed_ + used_; }
+
+  /**
+   * Function that is called with the data written to the file, in order,
+   * e.g. to compute a checksum while writing.
+   */
+  using Observer = std::function<void(const uint8_t *data, uint64_t length)>;
+
+  /**
+   * Call the given function with all data that is written to the file from
+   * now on. Data still in the buffer counts as not written yet.
+   */
+  void observe(Observer observer) { observer_ = std::move(observer); }
+
+private:
+  void write_batch();
+
+  File *file_;
+  size_t buffer_size_;
+  size_t copy_threshold_;
+  std::unique_ptr<uint8_t[]> buffer_;
+  size_t used_;
+  uint64_t flushed_;
+
+  /**
+   * Fragments to be written with the next gather write, referring to the
+   * buffer and to data passed in directly. Kept to avoid reallocating.
+   */
+  std::vector<File::Fragment> batch_;
+
+  Observer observer_;
+};
+
+} // namespace freeisle::fs
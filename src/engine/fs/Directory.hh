@@ -7,6 +7,8 @@ namespace freeisle::fs {
  */
 class Directory {
   friend class File;
+  friend void rename_file(const char *from, const char *to, Directory *dir);
+  friend void remove_file(const char *path, Directory *dir);
 
 public:
   /**
@@ -2,11 +2,14 @@
 
 #include <fmt/format.h>
 
+#include <algorithm>
+#include <cstdio>
 #include <stdexcept>
 
 #include <fcntl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <sys/uio.h>
 #include <unistd.h>
 
 namespace freeisle::fs {
@@ -85,12 +88,10 @@ FileInfo File::info() const {
   }
 
   return FileInfo{
-      .id =
-          FileId{
-              .dev = buf.st_dev,
-              .ino = buf.st_ino,
-          },
+      .id = FileId(buf.st_dev, buf.st_ino),
       .size = static_cast<uint64_t>(buf.st_size),
+      .mtime_ns = static_cast<uint64_t>(buf.st_mtim.tv_sec) * 1000000000 +
+                  static_cast<uint64_t>(buf.st_mtim.tv_nsec),
   };
 }
 
@@ -126,6 +127,38 @@ uint64_t File::write(const uint8_t *data, uint64_t length) {
   }
 }
 
+uint64_t File::write(const Fragment *fragments, uint32_t num) {
+  struct iovec iov[MaxFragments];
+  const uint32_t count = std::min(num, MaxFragments);
+  for (uint32_t i = 0; i < count; ++i) {
+    iov[i].iov_base = const_cast<uint8_t *>(fragments[i].data);
+    iov[i].iov_len = fragments[i].length;
+  }
+
+  while (true) {
+    const ssize_t res = ::writev(fd, iov, count);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+
+      throw std::runtime_error(
+          fmt::format("Failed to write: {}", ::strerror(errno)));
+    }
+
+    return static_cast<uint64_t>(res);
+  }
+}
+
+void File::sync() {
+  while (::fsync(fd) != 0) {
+    if (errno != EINTR) {
+      throw std::runtime_error(
+          fmt::format("Failed to sync: {}", ::strerror(errno)));
+    }
+  }
+}
+
 File::operator bool() const { return fd != -1; }
 
 void read_all(File &file, uint8_t *data, uint64_t length) {
@@ -154,6 +187,41 @@ void write_all(File &file, const uint8_t *data, uint64_t length) {
   }
 }
 
+void write_all(File &file, const File::Fragment *fragments, uint32_t num) {
+  // Fragments that are written partially are replaced by their remainder,
+  // so work on a copy:
+  std::vector<File::Fragment> pending(fragments, fragments + num);
+  File::Fragment *current = pending.data();
+  File::Fragment *const end = current + pending.size();
+
+  while (true) {
+    while (current != end && current->length == 0) {
+      ++current;
+    }
+
+    if (current == end) {
+      return;
+    }
+
+    uint64_t consumed = file.write(current, end - current);
+    if (consumed == 0) {
+      throw std::runtime_error("Failed to write fragments");
+    }
+
+    while (consumed > 0) {
+      assert(current != end);
+      const uint64_t len = std::min(consumed, current->length);
+      current->data += len;
+      current->length -= len;
+      consumed -= len;
+
+      if (current->length == 0) {
+        ++current;
+      }
+    }
+  }
+}
+
 std::vector<uint8_t> read_file(const char *path, Directory *dir) {
   File f(path, File::OpenMode::Read, dir);
   const FileInfo info = f.info();
@@ -177,4 +245,21 @@ void write_file(const char *path, const uint8_t *data, uint64_t length,
   }
 }
 
+void rename_file(const char *from, const char *to, Directory *dir) {
+  const int dirfd = dir != nullptr ? dir->fd : AT_FDCWD;
+  if (::renameat(dirfd, from, dirfd, to) != 0) {
+    throw std::runtime_error(
+        fmt::format("Failed to rename \"{}\" to \"{}\": {}", from, to,
+                    ::strerror(errno)));
+  }
+}
+
+void remove_file(const char *path, Directory *dir) {
+  const int dirfd = dir != nullptr ? dir->fd : AT_FDCWD;
+  if (::unlinkat(dirfd, path, 0) != 0) {
+    throw std::runtime_error(fmt::format("Failed to remove file \"{}\": {}",
+                                         path, ::strerror(errno)));
+  }
+}
+
 } // namespace freeisle::fs
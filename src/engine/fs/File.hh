@@ -5,6 +5,7 @@
 
 #include "core/Bitmask.hh"
 
+#include <cstddef>
 #include <cstdint>
 #include <vector>
 
@@ -92,12 +93,39 @@ public:
    */
   uint64_t write(const uint8_t *data, uint64_t length);
 
+  /**
+   * A contiguous portion of memory, to be written as part of a sequence.
+   */
+  struct Fragment {
+    const uint8_t *data;
+    uint64_t length;
+  };
+
+  /**
+   * Write a sequence of fragments to the file, one after the other, with a
+   * single system call. At most MaxFragments fragments are written at once.
+   * Throws std::runtime_error if the data cannot be written.
+   * @return The number of bytes actually written. May be less than the
+   *         total length of the fragments.
+   */
+  uint64_t write(const Fragment *fragments, uint32_t num);
+
+  static constexpr uint32_t MaxFragments = 64;
+
+  /**
+   * Flush the data written to the file to the storage device, so that it
+   * survives a system crash. Throws std::runtime_error on failure.
+   */
+  void sync();
+
   /**
    * Returns whether the file is open or not.
    */
   explicit operator bool() const;
 
 private:
+  friend class MappedFile;
+
   int fd;
 };
 
@@ -113,6 +141,13 @@ void read_all(File &file, uint8_t *data, uint64_t length);
  */
 void write_all(File &file, const uint8_t *data, uint64_t length);
 
+/**
+ * Write all of the given fragments to the file, with as few system calls as
+ * possible. Throws std::runtime_error if not all data can be written to the
+ * file.
+ */
+void write_all(File &file, const File::Fragment *fragments, uint32_t num);
+
 /**
  * Utility function to read a file into memory in one chunk.
  */
@@ -125,4 +160,18 @@ std::vector<uint8_t> read_file(const char *path, Directory *dir);
 void write_file(const char *path, const uint8_t *data, size_t len,
                 Directory *dir);
 
+/**
+ * Rename the file at path from to path to, atomically replacing any file
+ * at path to. Both paths must be on the same file system. Relative paths
+ * are looked up relative to dir, or to the CWD if dir is null. Throws
+ * std::runtime_error on failure.
+ */
+void rename_file(const char *from, const char *to, Directory *dir);
+
+/**
+ * Remove the file at the given path, which is looked up relative to dir,
+ * or to the CWD if dir is null. Throws std::runtime_error on failure.
+ */
+void remove_file(const char *path, Directory *dir);
+
 } // namespace freeisle::fs
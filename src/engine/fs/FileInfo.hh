@@ -44,6 +44,11 @@ struct FileInfo {
    * File size, in bytes.
    */
   uint64_t size;
+
+  /**
+   * Time of the last modification, in nanoseconds since the Unix epoch.
+   */
+  uint64_t mtime_ns;
 };
 
 } // namespace freeisle::fs
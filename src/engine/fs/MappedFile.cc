@@ -0,0 +1,113 @@
+#include "fs/MappedFile.hh"
+
+#include <fmt/format.h>
+
+#include <cstring>
+#include <stdexcept>
+
+#include <sys/mman.h>
+
+namespace freeisle::fs {
+
+namespace {
+
+int to_advice(MappedFile::Access access) {
+  switch (access) {
+  case MappedFile::Access::Sequential:
+    return MADV_SEQUENTIAL;
+  case MappedFile::Access::Random:
+    return MADV_RANDOM;
+  case MappedFile::Access::WillNeed:
+    return MADV_WILLNEED;
+  }
+
+  return MADV_NORMAL;
+}
+
+} // namespace
+
+MappedFile::MappedFile() : data_(nullptr), size_(0) {}
+
+MappedFile::MappedFile(File &file, Access access)
+    : data_(nullptr), size_(0) {
+  map(file, access);
+}
+
+MappedFile::MappedFile(const char *path, Directory *dir, Access access)
+    : data_(nullptr), size_(0) {
+  File file(path, File::OpenMode::Read, dir);
+  map(file, access);
+}
+
+MappedFile::~MappedFile() {
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+  }
+}
+
+MappedFile::MappedFile(MappedFile &&other)
+    : data_(other.data_), size_(other.size_) {
+  other.data_ = nullptr;
+  other.size_ = 0;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) {
+  if (this == &other) {
+    return *this;
+  }
+
+  if (data_ != nullptr) {
+    ::munmap(data_, size_);
+  }
+
+  data_ = other.data_;
+  size_ = other.size_;
+  other.data_ = nullptr;
+  other.size_ = 0;
+
+  return *this;
+}
+
+void MappedFile::map(File &file, Access access) {
+  const FileInfo info = file.info();
+
+  // Empty mappings are not possible:
+  if (info.size == 0) {
+    return;
+  }
+
+  void *addr = ::mmap(nullptr, info.size, PROT_READ, MAP_PRIVATE, file.fd, 0);
+  if (addr == MAP_FAILED) {
+    throw std::runtime_error(
+        fmt::format("Failed to map file: {}", ::strerror(errno)));
+  }
+
+  data_ = static_cast<uint8_t *>(addr);
+  size_ = info.size;
+
+  // This is only a hint, so it does not matter if it is not taken:
+  ::madvise(data_, size_, to_advice(access));
+}
+
+core::SharedBytes map_file(File &file, MappedFile::Access access) {
+  std::shared_ptr<const MappedFile> mapping;
+  try {
+    mapping = std::make_shared<const MappedFile>(file, access);
+  } catch (const std::runtime_error &) {
+    // Not all files support mapping, e.g. on some special filesystems:
+    std::vector<uint8_t> data(file.info().size);
+    read_all(file, data.data(), data.size());
+    return core::SharedBytes(std::move(data));
+  }
+
+  const core::ByteSpan span = mapping->span();
+  return core::SharedBytes(std::move(mapping), span);
+}
+
+core::SharedBytes map_file(const char *path, Directory *dir,
+                           MappedFile::Access access) {
+  File file(path, File::OpenMode::Read, dir);
+  return map_file(file, access);
+}
+
+} // namespace freeisle::fs
@@ -0,0 +1,102 @@
+#pragma once
+
+#include "fs/Directory.hh"
+#include "fs/File.hh"
+
+#include "core/Bytes.hh"
+
+#include <cstdint>
+
+namespace freeisle::fs {
+
+/**
+ * MappedFile maps the contents of a file read-only into memory, so that it
+ * can be used in place without reading it into a buffer first. Pages are
+ * only read from disk when they are accessed, and they can be dropped again
+ * by the kernel under memory pressure.
+ *
+ * The mapping reflects the file as it is on disk, so the file must not be
+ * modified in place while it is mapped; accessing a mapping of a file that
+ * was truncated in the meantime raises SIGBUS. Mappings are therefore meant
+ * to be short-lived, e.g. for the duration of a load. Replacing the file,
+ * i.e. renaming another file over it, does not affect existing mappings.
+ */
+class MappedFile {
+public:
+  /**
+   * Hint to the kernel how the mapping is going to be accessed, so that it
+   * can read ahead accordingly.
+   */
+  enum class Access {
+    /**
+     * From start to end, e.g. when parsing.
+     */
+    Sequential,
+
+    /**
+     * In no particular order, e.g. when looking up sections of a container.
+     */
+    Random,
+
+    /**
+     * All of it, soon, so it is read ahead completely.
+     */
+    WillNeed,
+  };
+
+  /**
+   * The default constructor creates an empty mapping.
+   */
+  MappedFile();
+
+  /**
+   * Map the whole content of a file that is open for reading. The file can
+   * be closed afterwards. Throws std::runtime_error if the file cannot be
+   * mapped.
+   */
+  MappedFile(File &file, Access access);
+
+  /**
+   * Open the file at the given path and map its whole content. Throws
+   * std::runtime_error if the file cannot be opened or mapped.
+   * @param path   Path in the filesystem to the file to be mapped.
+   * @param dir    If path is relative, interpret it relative to this
+   *               directory, or to the CWD of the process if null.
+   * @param access How the mapping is going to be accessed.
+   */
+  MappedFile(const char *path, Directory *dir, Access access);
+  ~MappedFile();
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other);
+
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile &operator=(MappedFile &&other);
+
+  const uint8_t *data() const { return data_; }
+  uint64_t size() const { return size_; }
+
+  core::ByteSpan span() const { return core::ByteSpan(data_, size_); }
+
+private:
+  void map(File &file, Access access);
+
+  uint8_t *data_;
+  uint64_t size_;
+};
+
+/**
+ * Utility function to map a file that is open for reading into memory, with
+ * shared ownership of the mapping. Files that cannot be mapped, e.g. on some
+ * special filesystems, are read into a buffer instead.
+ */
+core::SharedBytes map_file(File &file, MappedFile::Access access);
+
+/**
+ * Utility function to open the file at the given path and map it into
+ * memory, like map_file() above.
+ */
+core::SharedBytes map_file(const char *path, Directory *dir,
+                           MappedFile::Access access);
+
+} // namespace freeisle::fs
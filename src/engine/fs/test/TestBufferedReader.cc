@@ -0,0 +1,110 @@
+#include "fs/test/util/TempDirFixture.hh"
+
+#include "fs/BufferedReader.hh"
+#include "fs/File.hh"
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+
+extern "C" {
+
+// Mock errors from ::read system calls.
+void set_next_read_error(int err) __attribute__((weak));
+}
+
+namespace {
+
+class BufferedReaderTest : public freeisle::fs::test::TempDirFixture {
+public:
+  void write(const char *path, const std::string &content) {
+    freeisle::fs::write_file(path,
+                             reinterpret_cast<const uint8_t *>(content.data()),
+                             content.size(), nullptr);
+  }
+
+  freeisle::fs::File open(const char *path) {
+    return freeisle::fs::File(
+        path,
+        freeisle::core::Bitmask<freeisle::fs::File::OpenMode>(
+            freeisle::fs::File::OpenMode::Read),
+        nullptr);
+  }
+};
+
+} // namespace
+
+TEST_F(BufferedReaderTest, Read) {
+  write("bla.txt", "hi everyone");
+
+  freeisle::fs::File f = open("bla.txt");
+  freeisle::fs::BufferedReader reader(f, 4);
+
+  uint8_t buf[16];
+  ASSERT_EQ(reader.read(buf, 3), 3);
+  EXPECT_EQ(std::memcmp(buf, "hi ", 3), 0);
+  // Reads do not go beyond the buffered data:
+  ASSERT_EQ(reader.read(buf, 3), 1);
+  EXPECT_EQ(buf[0], 'e');
+  EXPECT_EQ(reader.position(), 4);
+
+  // Large reads bypass the buffer:
+  ASSERT_EQ(reader.read(buf, 16), 7);
+  EXPECT_EQ(std::memcmp(buf, "veryone", 7), 0);
+
+  EXPECT_EQ(reader.read(buf, 16), 0);
+  EXPECT_EQ(reader.position(), 11);
+}
+
+TEST_F(BufferedReaderTest, ReadAll) {
+  const std::string content(1000, 'x');
+  write("bla.txt", content + "abc");
+
+  freeisle::fs::File f = open("bla.txt");
+  freeisle::fs::BufferedReader reader(f, 64);
+
+  std::string buf(1000, '\0');
+  reader.read_all(reinterpret_cast<uint8_t *>(&buf[0]), 10);
+  reader.read_all(reinterpret_cast<uint8_t *>(&buf[10]), 990);
+  EXPECT_EQ(buf, content);
+
+  uint8_t rest[4];
+  EXPECT_THROW(reader.read_all(rest, 4), std::runtime_error);
+}
+
+TEST_F(BufferedReaderTest, ReadLine) {
+  const std::string long_line(100, 'x');
+  write("bla.txt", "first\n\n" + long_line + "\nlast");
+
+  freeisle::fs::File f = open("bla.txt");
+  freeisle::fs::BufferedReader reader(f, 8);
+
+  std::string line;
+  ASSERT_TRUE(reader.read_line(line));
+  EXPECT_EQ(line, "first");
+  ASSERT_TRUE(reader.read_line(line));
+  EXPECT_EQ(line, "");
+  ASSERT_TRUE(reader.read_line(line));
+  EXPECT_EQ(line, long_line);
+  ASSERT_TRUE(reader.read_line(line));
+  EXPECT_EQ(line, "last");
+  EXPECT_FALSE(reader.read_line(line));
+  EXPECT_EQ(line, "");
+  EXPECT_EQ(reader.position(), 112);
+}
+
+TEST_F(BufferedReaderTest, Errors) {
+  write("bla.txt", "hi everyone");
+
+  freeisle::fs::File f = open("bla.txt");
+  freeisle::fs::BufferedReader reader(f, 4);
+
+  uint8_t buf[4];
+  set_next_read_error(EIO);
+  EXPECT_THROW(reader.read(buf, 2), std::runtime_error);
+
+  ASSERT_EQ(reader.read(buf, 2), 2);
+  EXPECT_EQ(std::memcmp(buf, "hi", 2), 0);
+}
@@ -0,0 +1,173 @@
+#include "fs/test/util/TempDirFixture.hh"
+
+#include "fs/BufferedWriter.hh"
+#include "fs/File.hh"
+
+#include <gtest/gtest.h>
+
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <vector>
+
+extern "C" {
+
+// Mock errors and partial writes from ::writev system calls.
+void set_next_write_error(int err) __attribute__((weak));
+void set_max_writev_length(size_t len) __attribute__((weak));
+}
+
+namespace {
+
+class BufferedWriterTest : public freeisle::fs::test::TempDirFixture {
+public:
+  freeisle::fs::File create(const char *path) {
+    return freeisle::fs::File(
+        path,
+        freeisle::core::Bitmask<freeisle::fs::File::OpenMode>(
+            freeisle::fs::File::OpenMode::Write,
+            freeisle::fs::File::OpenMode::Create,
+            freeisle::fs::File::OpenMode::Truncate),
+        nullptr);
+  }
+
+  std::string read(const char *path) {
+    const std::vector<uint8_t> data = freeisle::fs::read_file(path, nullptr);
+    return std::string(data.begin(), data.end());
+  }
+};
+
+freeisle::fs::File::Fragment fragment(const std::string &str) {
+  return {reinterpret_cast<const uint8_t *>(str.data()), str.size()};
+}
+
+} // namespace
+
+TEST_F(BufferedWriterTest, SmallWrites) {
+  freeisle::fs::File f = create("bla.txt");
+  freeisle::fs::BufferedWriter writer(f, 8, 8);
+
+  writer.write("hi ");
+  writer.put('e');
+  EXPECT_EQ(writer.position(), 4);
+  // Nothing was written to the file yet:
+  EXPECT_EQ(read("bla.txt"), "");
+
+  // Writes are not split, the buffer is written before it overflows:
+  writer.write("veryone");
+  EXPECT_EQ(writer.position(), 11);
+  EXPECT_EQ(read("bla.txt"), "hi e");
+
+  writer.flush();
+  EXPECT_EQ(read("bla.txt"), "hi everyone");
+  EXPECT_EQ(writer.position(), 11);
+
+  writer.put('!');
+  writer.sync();
+  EXPECT_EQ(read("bla.txt"), "hi everyone!");
+  EXPECT_EQ(writer.position(), 12);
+}
+
+TEST_F(BufferedWriterTest, LargeWrites) {
+  const std::string large(1000, 'x');
+
+  freeisle::fs::File f = create("bla.txt");
+  freeisle::fs::BufferedWriter writer(f, 64);
+
+  writer.write("head");
+  writer.write(large);
+  // Large writes go to the file right away, together with the buffer:
+  EXPECT_EQ(read("bla.txt"), "head" + large);
+  EXPECT_EQ(writer.position(), 1004);
+
+  writer.write("tail");
+  writer.flush();
+  EXPECT_EQ(read("bla.txt"), "head" + large + "tail");
+}
+
+TEST_F(BufferedWriterTest, Fragments) {
+  const std::string large(100, 'x');
+  const std::string small = "small";
+  const std::string empty;
+
+  freeisle::fs::File f = create("bla.txt");
+  freeisle::fs::BufferedWriter writer(f, 64);
+
+  std::vector<freeisle::fs::File::Fragment> fragments;
+  std::string expected = "start";
+  writer.write("start");
+  for (uint32_t i = 0; i < 100; ++i) {
+    const std::string &str = i % 3 == 0 ? large : i % 3 == 1 ? small : empty;
+    fragments.push_back(fragment(str));
+    expected += str;
+  }
+
+  // Large fragments are written once the call returns, together with the
+  // buffered data around them:
+  writer.write(fragments.data(), fragments.size());
+  EXPECT_EQ(writer.position(), expected.size());
+  EXPECT_EQ(read("bla.txt"), expected);
+
+  // Only small fragments stay in the buffer:
+  const freeisle::fs::File::Fragment tail[] = {fragment(small),
+                                               fragment(small)};
+  writer.write(tail, 2);
+  EXPECT_EQ(read("bla.txt"), expected);
+
+  writer.flush();
+  EXPECT_EQ(read("bla.txt"), expected + small + small);
+}
+
+TEST_F(BufferedWriterTest, PartialWrites) {
+  const std::string large(100, 'x');
+  const std::string small = "abc";
+  const std::string other(100, 'y');
+
+  freeisle::fs::File f = create("bla.txt");
+  freeisle::fs::BufferedWriter writer(f, 16);
+
+  const freeisle::fs::File::Fragment fragments[] = {
+      fragment(large), fragment(small), fragment(other)};
+
+  set_max_writev_length(7);
+  writer.write(fragments, 3);
+  set_max_writev_length(0);
+
+  EXPECT_EQ(read("bla.txt"), large + small + other);
+}
+
+TEST_F(BufferedWriterTest, Errors) {
+  freeisle::fs::File f = create("bla.txt");
+  freeisle::fs::BufferedWriter writer(f, 8, 8);
+
+  writer.write("hi");
+  set_next_write_error(EIO);
+  EXPECT_THROW(writer.flush(), std::runtime_error);
+
+  // The writer can still be used afterwards:
+  writer.write("ho");
+  writer.flush();
+  EXPECT_EQ(read("bla.txt"), "ho");
+}
+
+TEST_F(BufferedWriterTest, Observe) {
+  const std::string large(100, 'x');
+
+  freeisle::fs::File f = create("bla.txt");
+  freeisle::fs::BufferedWriter writer(f, 16);
+  writer.write("buf");
+  std::string observed;
+  writer.observe([&observed](const uint8_t *data, uint64_t length) {
+    observed.append(reinterpret_cast<const char *>(data), length);
+  });
+
+  writer.write("head");
+  writer.write(large);
+  writer.write("end");
+  // Data is observed when it is written to the file:
+  EXPECT_EQ(observed, "bufhead" + large);
+
+  writer.flush();
+  EXPECT_EQ(observed, "bufhead" + large + "end");
+  EXPECT_EQ(read("bla.txt"), observed);
+}
@@ -93,6 +93,7 @@ TEST_F(FileTest, OpenRead) {
 
   const freeisle::fs::FileInfo info = f.info();
   ASSERT_EQ(info.size, 2);
+  EXPECT_GT(info.mtime_ns, 0);
 
   uint8_t buf[16];
   ASSERT_EQ(f.read(buf, 16), 2);
@@ -430,3 +431,27 @@ TEST_F(FileTest, WriteFile) {
   ASSERT_EQ(read_file("dir/child.txt"), "firerod");
   ASSERT_EQ(read_file("dir/child2.txt"), "icerod");
 }
+
+TEST_F(FileTest, RenameAndRemoveFile) {
+  ASSERT_EQ(mkdir("dir", 0755), 0);
+  freeisle::fs::Directory dir("dir", nullptr);
+
+  write_file("old.txt", "hi everyone");
+  write_file("target.txt", "firerod");
+  freeisle::fs::rename_file("old.txt", "target.txt", nullptr);
+  EXPECT_EQ(read_file("target.txt"), "hi everyone");
+  EXPECT_NE(::access("old.txt", F_OK), 0);
+
+  write_file("dir/child.txt", "icerod");
+  freeisle::fs::rename_file("child.txt", "renamed.txt", &dir);
+  EXPECT_EQ(read_file("dir/renamed.txt"), "icerod");
+  EXPECT_THROW(freeisle::fs::rename_file("child.txt", "other.txt", &dir),
+               std::runtime_error);
+
+  freeisle::fs::remove_file("renamed.txt", &dir);
+  freeisle::fs::remove_file("target.txt", nullptr);
+  EXPECT_NE(::access("dir/renamed.txt", F_OK), 0);
+  EXPECT_NE(::access("target.txt", F_OK), 0);
+  EXPECT_THROW(freeisle::fs::remove_file("target.txt", nullptr),
+               std::runtime_error);
+}
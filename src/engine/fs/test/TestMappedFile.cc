@@ -0,0 +1,100 @@
+#include "fs/test/util/TempDirFixture.hh"
+
+#include "fs/File.hh"
+#include "fs/MappedFile.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+
+namespace {
+
+class MappedFileTest : public freeisle::fs::test::TempDirFixture {
+public:
+  void write(const char *path, const char *content) {
+    freeisle::fs::write_file(path,
+                             reinterpret_cast<const uint8_t *>(content),
+                             std::strlen(content), nullptr);
+  }
+};
+
+} // namespace
+
+TEST_F(MappedFileTest, Map) {
+  write("file.txt", "Hello, mapped world");
+
+  const freeisle::fs::MappedFile mapping(
+      "file.txt", nullptr, freeisle::fs::MappedFile::Access::Sequential);
+  ASSERT_EQ(mapping.size(), 19);
+  EXPECT_EQ(std::string(reinterpret_cast<const char *>(mapping.data()),
+                        mapping.size()),
+            "Hello, mapped world");
+  EXPECT_EQ(mapping.span().size(), 19);
+  EXPECT_EQ(mapping.span()[7], 'm');
+}
+
+TEST_F(MappedFileTest, MapOpenFile) {
+  write("file.txt", "abc");
+
+  freeisle::fs::MappedFile mapping;
+  {
+    freeisle::fs::File file("file.txt", freeisle::fs::File::OpenMode::Read,
+                            nullptr);
+    mapping = freeisle::fs::MappedFile(
+        file, freeisle::fs::MappedFile::Access::Random);
+  }
+
+  // The mapping stays valid after the file is closed:
+  ASSERT_EQ(mapping.size(), 3);
+  EXPECT_EQ(mapping.data()[2], 'c');
+}
+
+TEST_F(MappedFileTest, MapEmpty) {
+  write("empty.txt", "");
+
+  const freeisle::fs::MappedFile mapping(
+      "empty.txt", nullptr, freeisle::fs::MappedFile::Access::WillNeed);
+  EXPECT_EQ(mapping.size(), 0);
+  EXPECT_EQ(mapping.data(), nullptr);
+}
+
+TEST_F(MappedFileTest, MapNonExisting) {
+  EXPECT_THROW(freeisle::fs::MappedFile(
+                   "missing.txt", nullptr,
+                   freeisle::fs::MappedFile::Access::Sequential),
+               std::runtime_error);
+}
+
+TEST_F(MappedFileTest, Move) {
+  write("file.txt", "xyz");
+
+  freeisle::fs::MappedFile mapping(
+      "file.txt", nullptr, freeisle::fs::MappedFile::Access::Sequential);
+  const uint8_t *data = mapping.data();
+
+  freeisle::fs::MappedFile moved(std::move(mapping));
+  EXPECT_EQ(moved.data(), data);
+  EXPECT_EQ(moved.size(), 3);
+  EXPECT_EQ(mapping.data(), nullptr);
+  EXPECT_EQ(mapping.size(), 0);
+}
+
+TEST_F(MappedFileTest, MapFileShared) {
+  write("file.txt", "shared");
+
+  freeisle::core::SharedBytes copy;
+  {
+    const freeisle::core::SharedBytes bytes = freeisle::fs::map_file(
+        "file.txt", nullptr, freeisle::fs::MappedFile::Access::Sequential);
+    copy = bytes;
+    EXPECT_EQ(copy.data(), bytes.data());
+  }
+
+  // Replacing the file does not affect the mapping:
+  write("new.txt", "replaced");
+  ASSERT_EQ(::rename("new.txt", "file.txt"), 0);
+
+  ASSERT_EQ(copy.size(), 6);
+  EXPECT_EQ(std::string(copy.begin(), copy.end()), "shared");
+}
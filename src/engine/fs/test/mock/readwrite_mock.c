@@ -6,13 +6,16 @@
 #include <dlfcn.h>
 #include <stdlib.h>
 #include <assert.h>
+#include <sys/uio.h>
 
 typedef ssize_t (*read_func)(int fd, void* buf, size_t count);
 typedef ssize_t (*write_func)(int fd, const void* buf, size_t count);
+typedef ssize_t (*writev_func)(int fd, const struct iovec* iov, int iovcnt);
 
 static int next_read_error = 0;
 static int next_write_error = 0;
 static int next_write_length_is_zero = 0;
+static size_t max_writev_length = 0;
 
 void set_next_read_error(int err) {
   next_read_error = err;
@@ -25,6 +28,10 @@ void set_next_write_error(int err) {
 void set_next_write_length_to_zero() {
   next_write_length_is_zero = 1;
 }
+
+void set_max_writev_length(size_t len) {
+  max_writev_length = len;
+}
  
 ssize_t read(int fd, void* buf, size_t count) {
   if (next_read_error != 0) {
@@ -57,3 +64,35 @@ ssize_t write(int fd, const void* buf, size_t count) {
 
   return f(fd, buf, count);
 }
+
+ssize_t writev(int fd, const struct iovec* iov, int iovcnt) {
+  if (next_write_error != 0) {
+    errno = next_write_error;
+    next_write_error = 0;
+    return -1;
+  }
+
+  if (next_write_length_is_zero) {
+    errno = 0;
+    --next_write_length_is_zero;
+    return 0;
+  }
+
+  if (max_writev_length != 0 && iovcnt > 0) {
+    // Only write (part of) the first fragment, to simulate partial writes.
+    size_t len = iov[0].iov_len;
+    if (len > max_writev_length) {
+      len = max_writev_length;
+    }
+
+    write_func f = (write_func)dlsym(RTLD_NEXT, "write");
+    assert(f != NULL);
+
+    return f(fd, iov[0].iov_base, len);
+  }
+
+  writev_func f = (writev_func)dlsym(RTLD_NEXT, "writev");
+  assert(f != NULL);
+
+  return f(fd, iov, iovcnt);
+}
@@ -0,0 +1,206 @@
+#pragma once
+
+#include "state/Unit.hh"
+
+#include "def/Level.hh"
+#include "def/Location.hh"
+#include "def/Resupply.hh"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace freeisle::journal {
+
+/**
+ * A single recorded mutation of the game state.
+ *
+ * Commands store both the old and the new value of what they change, so
+ * that they can be applied in either direction without looking at anything
+ * else. Objects are referred to by the value of their collection handle,
+ * which makes commands independent of the memory layout of a particular
+ * state: they can be applied to any state with the same handles, such as a
+ * fork, or the same save loaded again.
+ */
+struct Command {
+  enum class Type : uint8_t {
+    /**
+     * Set field of unit object from from to to. For Field::SupplyAmmo, arg
+     * is the damage type.
+     */
+    UnitValue,
+
+    /**
+     * Move unit object from location and level from to location and level
+     * to. Locations are packed with pack_location(), levels are packed into
+     * arg with pack_levels().
+     */
+    UnitPosition,
+
+    /**
+     * Set ammo of the weapon with handle arg of unit object from from to to.
+     */
+    UnitAmmo,
+
+    /**
+     * Set the owner of unit object from player handle from to player handle
+     * to. Invalid handles mean no owner.
+     */
+    UnitOwner,
+
+    /**
+     * Create unit object from the UnitRecord with index arg.
+     */
+    UnitCreate,
+
+    /**
+     * Remove unit object, which is described by the UnitRecord with index
+     * arg.
+     */
+    UnitRemove,
+
+    /**
+     * Take unit object off the map at location from, and put it at position
+     * index into the container of the unit with handle arg, which is at
+     * location to.
+     */
+    LoadIntoUnit,
+
+    /**
+     * Same as LoadIntoUnit, for the container of the shop with handle arg.
+     */
+    LoadIntoShop,
+
+    /**
+     * Take unit object, which is at location from, out of position index of
+     * the container of the unit with handle arg, and put it onto the map at
+     * location to.
+     */
+    UnloadFromUnit,
+
+    /**
+     * Same as UnloadFromUnit, for the container of the shop with handle arg.
+     */
+    UnloadFromShop,
+
+    /**
+     * Set the owner of shop object from player handle from to player handle
+     * to. Invalid handles mean no owner.
+     */
+    ShopOwner,
+
+    /**
+     * Set the wealth of player object from from to to.
+     */
+    PlayerWealth,
+
+    /**
+     * Set the captain of player object from unit handle from to unit handle
+     * to. Invalid handles mean no captain.
+     */
+    PlayerCaptain,
+
+    /**
+     * Set is_eliminated of player object from from to to.
+     */
+    PlayerEliminated,
+
+    /**
+     * Set turn_num from from to to, and player_at_turn from player handle
+     * object to player handle arg.
+     */
+    Turn,
+  };
+
+  /**
+   * Fields of a unit that can be set with Type::UnitValue.
+   */
+  enum class Field : uint8_t {
+    Health,
+    Movement,
+    Fuel,
+    Experience,
+    HasActioned,
+    HasSoared,
+    SupplyFuel,
+    SupplyRepair,
+    SupplyAmmo,
+  };
+
+  Type type;
+  Field field;
+
+  /**
+   * Position of a unit in a container, for loading and unloading.
+   */
+  uint16_t index;
+
+  uint32_t object;
+  uint32_t arg;
+  uint32_t from;
+  uint32_t to;
+};
+
+/**
+ * Everything needed to create a unit, or to restore it after it has been
+ * removed. Like commands, it refers to other objects by handle value, with
+ * invalid handles for absent objects.
+ */
+struct UnitRecord {
+  std::string id;
+  uint32_t def;
+  uint32_t owner;
+  def::Location location;
+  def::Level level;
+  uint32_t health;
+  uint32_t movement;
+  uint32_t fuel;
+  uint32_t experience;
+  bool has_actioned;
+  bool has_soared;
+  def::Resupply supplies;
+
+  /**
+   * Weapon handle and ammo for every weapon of the unit.
+   */
+  std::vector<std::pair<uint32_t, uint32_t>> ammo;
+
+  uint32_t contained_in_unit;
+  uint32_t contained_in_shop;
+
+  /**
+   * Position of the unit in its container, if it is contained.
+   */
+  uint16_t index;
+
+  state::Unit::Stats stats;
+};
+
+/**
+ * Packs a location into a single 32-bit value.
+ */
+inline uint32_t pack_location(def::Location loc) {
+  return (loc.y << 16) | (loc.x & 0xffff);
+}
+
+inline def::Location unpack_location(uint32_t value) {
+  return {.x = value & 0xffff, .y = value >> 16};
+}
+
+/**
+ * Packs two levels into a single 32-bit value.
+ */
+inline uint32_t pack_levels(def::Level from, def::Level to) {
+  return (static_cast<uint32_t>(from) << 8) | static_cast<uint32_t>(to);
+}
+
+inline def::Level unpack_from_level(uint32_t value) {
+  return static_cast<def::Level>(value >> 8);
+}
+
+inline def::Level unpack_to_level(uint32_t value) {
+  return static_cast<def::Level>(value & 0xff);
+}
+
+} // namespace freeisle::journal
@@ -0,0 +1,928 @@
+#include "journal/Journal.hh"
+
+#include "fow/View.hh"
+#include "zobrist/Zobrist.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <string_view>
+#include <utility>
+
+namespace freeisle::journal {
+
+namespace {
+
+template <typename T>
+typename def::Collection<T>::iterator find(def::Collection<T> &collection,
+                                           uint32_t handle) {
+  const typename def::Collection<T>::iterator iter =
+      collection.find(def::Handle<T>::from_value(handle));
+  assert(iter != collection.end());
+  return iter;
+}
+
+template <typename T>
+def::NullableRef<T> find_nullable(def::Collection<T> &collection,
+                                  uint32_t handle) {
+  return collection.find(def::Handle<T>::from_value(handle));
+}
+
+template <typename T>
+typename def::Collection<T>::const_iterator
+find(const def::Collection<T> &collection, uint32_t handle) {
+  const typename def::Collection<T>::const_iterator iter =
+      collection.find(def::Handle<T>::from_value(handle));
+  assert(iter != collection.end());
+  return iter;
+}
+
+/**
+ * Returns the ID of the object with the given handle, or the empty string
+ * if the handle is invalid.
+ */
+template <typename T>
+std::string_view id(const def::Collection<T> &collection, uint32_t handle) {
+  const typename def::Collection<T>::const_iterator iter =
+      collection.find(def::Handle<T>::from_value(handle));
+  return iter != collection.end() ? std::string_view(iter->first)
+                                  : std::string_view();
+}
+
+zobrist::Feature unit_feature(Command::Field field) {
+  switch (field) {
+  case Command::Field::Health:
+    return zobrist::Feature::UnitHealth;
+  case Command::Field::Movement:
+    return zobrist::Feature::UnitMovement;
+  case Command::Field::Fuel:
+    return zobrist::Feature::UnitFuel;
+  case Command::Field::Experience:
+    return zobrist::Feature::UnitExperience;
+  case Command::Field::HasActioned:
+    return zobrist::Feature::UnitHasActioned;
+  case Command::Field::HasSoared:
+    return zobrist::Feature::UnitHasSoared;
+  case Command::Field::SupplyFuel:
+    return zobrist::Feature::UnitSupplyFuel;
+  case Command::Field::SupplyRepair:
+    return zobrist::Feature::UnitSupplyRepair;
+  case Command::Field::SupplyAmmo:
+    return zobrist::Feature::UnitSupplyAmmo;
+  }
+
+  assert(false);
+  return zobrist::Feature::UnitHealth;
+}
+
+uint32_t &unit_value(state::Unit &unit, Command::Field field, uint32_t arg) {
+  switch (field) {
+  case Command::Field::Health:
+    return unit.health;
+  case Command::Field::Movement:
+    return unit.movement;
+  case Command::Field::Fuel:
+    return unit.fuel;
+  case Command::Field::Experience:
+    return unit.experience;
+  case Command::Field::SupplyFuel:
+    return unit.supplies.fuel;
+  case Command::Field::SupplyRepair:
+    return unit.supplies.repair;
+  case Command::Field::SupplyAmmo:
+    return unit.supplies.ammo[static_cast<def::DamageType>(arg)];
+  default:
+    break;
+  }
+
+  assert(false);
+  return unit.health;
+}
+
+void set_unit_value(state::Unit &unit, Command::Field field, uint32_t arg,
+                    uint32_t value) {
+  switch (field) {
+  case Command::Field::HasActioned:
+    unit.has_actioned = value;
+    break;
+  case Command::Field::HasSoared:
+    unit.has_soared = value;
+    break;
+  default:
+    unit_value(unit, field, arg) = value;
+    break;
+  }
+}
+
+uint32_t get_unit_value(state::Unit &unit, Command::Field field,
+                        uint32_t arg) {
+  switch (field) {
+  case Command::Field::HasActioned:
+    return unit.has_actioned;
+  case Command::Field::HasSoared:
+    return unit.has_soared;
+  default:
+    return unit_value(unit, field, arg);
+  }
+}
+
+uint32_t &ammo(state::Unit &unit, uint32_t weapon) {
+  const def::Collection<def::WeaponDef>::iterator iter =
+      find(unit.def->weapons, weapon);
+  const auto ammo = unit.ammo.find(iter);
+  assert(ammo != unit.ammo.end());
+  return ammo->second;
+}
+
+void move(state::State &state, uint32_t handle, def::Location from,
+          def::Level from_level, def::Location to, def::Level to_level) {
+  const def::Collection<state::Unit>::iterator iter = find(state.units, handle);
+  state::Unit &unit = iter->second;
+
+  const bool on_map = !unit.contained_in_unit && !unit.contained_in_shop;
+  if (on_map) {
+    state.map.set_unit(from.x, from.y, from_level == def::Level::UnderWater,
+                       def::NullableRef<state::Unit>());
+  }
+
+  unit.location = to;
+  unit.level = to_level;
+
+  if (on_map) {
+    state.map.set_unit(to.x, to.y, to_level == def::Level::UnderWater, iter);
+  }
+
+  fow::move_unit(state.players, unit, from);
+}
+
+/**
+ * Put the unit onto the map at its location and level.
+ */
+void put_on_map(state::State &state,
+                def::Collection<state::Unit>::iterator iter) {
+  state::Unit &unit = iter->second;
+  state.map.set_unit(unit.location.x, unit.location.y,
+                     unit.level == def::Level::UnderWater, iter);
+  fow::add_unit(state.players, unit);
+}
+
+/**
+ * Take the unit off the map at its location and level.
+ */
+void take_off_map(state::State &state, state::Unit &unit) {
+  fow::remove_unit(state.players, unit);
+  state.map.set_unit(unit.location.x, unit.location.y,
+                     unit.level == def::Level::UnderWater,
+                     def::NullableRef<state::Unit>());
+}
+
+state::Container &unit_container(state::Unit &unit) {
+  if (unit.contained_in_unit) {
+    return unit.contained_in_unit->container;
+  }
+
+  assert(unit.contained_in_shop);
+  return unit.contained_in_shop->container;
+}
+
+/**
+ * Put the unit into the container it is contained in, at the given
+ * position.
+ */
+void insert(state::Unit &unit, def::Collection<state::Unit>::iterator iter,
+            uint32_t index) {
+  std::list<def::Ref<state::Unit>> &units = unit_container(unit).units;
+  assert(index <= units.size());
+  units.insert(std::next(units.begin(), index), iter);
+}
+
+/**
+ * Take the unit out of the container it is contained in, where it is at the
+ * given position.
+ */
+void extract(state::Unit &unit, uint32_t index) {
+  std::list<def::Ref<state::Unit>> &units = unit_container(unit).units;
+  assert(index < units.size());
+  const auto pos = std::next(units.begin(), index);
+  assert(&**pos == &unit);
+  units.erase(pos);
+}
+
+/**
+ * Move the unit between the map and a container, for the load and unload
+ * commands.
+ */
+void contain(state::State &state, const Command &command, bool load) {
+  const def::Collection<state::Unit>::iterator iter =
+      find(state.units, command.object);
+  state::Unit &unit = iter->second;
+
+  const bool loads = command.type == Command::Type::LoadIntoUnit ||
+                     command.type == Command::Type::LoadIntoShop;
+  const def::Location on_map =
+      unpack_location(loads ? command.from : command.to);
+  const def::Location in_container =
+      unpack_location(loads ? command.to : command.from);
+
+  if (load) {
+    take_off_map(state, unit);
+    unit.location = in_container;
+    if (command.type == Command::Type::LoadIntoUnit ||
+        command.type == Command::Type::UnloadFromUnit) {
+      unit.contained_in_unit = find(state.units, command.arg);
+    } else {
+      unit.contained_in_shop = find(state.shops, command.arg);
+    }
+    insert(unit, iter, command.index);
+  } else {
+    extract(unit, command.index);
+    unit.contained_in_unit = def::NullableRef<state::Unit>();
+    unit.contained_in_shop = def::NullableRef<state::Shop>();
+    unit.location = on_map;
+    put_on_map(state, iter);
+  }
+}
+
+/**
+ * Set the owner of the unit, and keep the players' units and fog of war in
+ * sync.
+ */
+void set_owner(state::State &state, uint32_t handle, uint32_t owner) {
+  const def::Collection<state::Unit>::iterator iter = find(state.units, handle);
+  state::Unit &unit = iter->second;
+
+  fow::remove_unit(state.players, unit);
+  if (unit.owner) {
+    unit.owner->units.erase(def::Ref<state::Unit>(iter));
+  }
+
+  unit.owner = find_nullable(state.players, owner);
+
+  if (unit.owner) {
+    unit.owner->units.insert(iter);
+  }
+  fow::add_unit(state.players, unit);
+}
+
+/**
+ * Create a unit with the given handle from the given record.
+ */
+void create(state::State &state, uint32_t handle, const UnitRecord &record) {
+  const def::Collection<state::Unit>::iterator iter = state.units.emplace_at(
+      def::Handle<state::Unit>::from_value(handle), record.id);
+  state::Unit &unit = iter->second;
+
+  // Definitions are shared with the scenario, which the state only has a
+  // const pointer to, see state::fork().
+  unit.def = find(const_cast<def::Collection<def::UnitDef> &>(
+                      state.scenario->units),
+                  record.def);
+  unit.owner = find_nullable(state.players, record.owner);
+  unit.location = record.location;
+  unit.level = record.level;
+  unit.health = record.health;
+  unit.movement = record.movement;
+  unit.fuel = record.fuel;
+  unit.experience = record.experience;
+  unit.has_actioned = record.has_actioned;
+  unit.has_soared = record.has_soared;
+  unit.supplies = record.supplies;
+  for (const auto &[weapon, ammo] : record.ammo) {
+    unit.ammo.emplace(find(unit.def->weapons, weapon), ammo);
+  }
+  unit.container.def = &unit.def->container;
+  unit.contained_in_unit = find_nullable(state.units, record.contained_in_unit);
+  unit.contained_in_shop = find_nullable(state.shops, record.contained_in_shop);
+  unit.stats = record.stats;
+
+  if (unit.owner) {
+    unit.owner->units.insert(iter);
+  }
+
+  if (unit.contained_in_unit || unit.contained_in_shop) {
+    insert(unit, iter, record.index);
+  } else {
+    put_on_map(state, iter);
+  }
+}
+
+/**
+ * Remove the unit with the given handle, which is described by the given
+ * record.
+ */
+void remove(state::State &state, uint32_t handle, const UnitRecord &record) {
+  const def::Collection<state::Unit>::iterator iter = find(state.units, handle);
+  state::Unit &unit = iter->second;
+  assert(unit.container.units.empty());
+
+  if (unit.contained_in_unit || unit.contained_in_shop) {
+    extract(unit, record.index);
+  } else {
+    take_off_map(state, unit);
+  }
+
+  if (unit.owner) {
+    unit.owner->units.erase(def::Ref<state::Unit>(iter));
+  }
+
+  state.units.erase(iter);
+}
+
+/**
+ * Returns whether the command refers to a UnitRecord.
+ */
+bool has_record(const Command &command) {
+  return command.type == Command::Type::UnitCreate ||
+         command.type == Command::Type::UnitRemove;
+}
+
+/**
+ * Returns whether applying the command in the given direction adds a unit
+ * to the state.
+ */
+bool adds_unit(const Command &command, bool forward) {
+  return has_record(command) &&
+         (command.type == Command::Type::UnitCreate) == forward;
+}
+
+} // namespace
+
+void apply(state::State &state, const Command &command,
+           const std::vector<UnitRecord> &units, bool forward) {
+  const uint32_t value = forward ? command.to : command.from;
+
+  switch (command.type) {
+  case Command::Type::UnitValue:
+    set_unit_value(find(state.units, command.object)->second, command.field,
+                   command.arg, value);
+    break;
+  case Command::Type::UnitPosition: {
+    const def::Location from = unpack_location(command.from);
+    const def::Location to = unpack_location(command.to);
+    const def::Level from_level = unpack_from_level(command.arg);
+    const def::Level to_level = unpack_to_level(command.arg);
+    if (forward) {
+      move(state, command.object, from, from_level, to, to_level);
+    } else {
+      move(state, command.object, to, to_level, from, from_level);
+    }
+    break;
+  }
+  case Command::Type::UnitAmmo:
+    ammo(find(state.units, command.object)->second, command.arg) = value;
+    break;
+  case Command::Type::UnitOwner:
+    set_owner(state, command.object, value);
+    break;
+  case Command::Type::UnitCreate:
+  case Command::Type::UnitRemove:
+    assert(command.arg < units.size());
+    if (adds_unit(command, forward)) {
+      create(state, command.object, units[command.arg]);
+    } else {
+      remove(state, command.object, units[command.arg]);
+    }
+    break;
+  case Command::Type::LoadIntoUnit:
+  case Command::Type::LoadIntoShop:
+    contain(state, command, forward);
+    break;
+  case Command::Type::UnloadFromUnit:
+  case Command::Type::UnloadFromShop:
+    contain(state, command, !forward);
+    break;
+  case Command::Type::ShopOwner:
+    find(state.shops, command.object)->second.owner =
+        find_nullable(state.players, value);
+    break;
+  case Command::Type::PlayerWealth:
+    find(state.players, command.object)->second.wealth = value;
+    break;
+  case Command::Type::PlayerCaptain:
+    find(state.players, command.object)->second.captain =
+        find_nullable(state.units, value);
+    break;
+  case Command::Type::PlayerEliminated:
+    find(state.players, command.object)->second.is_eliminated = value;
+    break;
+  case Command::Type::Turn:
+    state.turn_num = value;
+    state.player_at_turn =
+        find_nullable(state.players, forward ? command.arg : command.object);
+    break;
+  }
+}
+
+void replay(state::State &state, const std::vector<Command> &commands,
+            const std::vector<UnitRecord> &units) {
+  for (const Command &command : commands) {
+    apply(state, command, units);
+  }
+}
+
+uint64_t hash_delta(const state::State &state, const Command &command) {
+  // Keys only depend on IDs, which do not change, and on the values in the
+  // command. The delta is therefore the same in both directions.
+  switch (command.type) {
+  case Command::Type::UnitValue: {
+    const uint64_t object = zobrist::object_key(
+        id(state.units, command.object));
+    if (command.field == Command::Field::SupplyAmmo) {
+      const def::DamageType type = static_cast<def::DamageType>(command.arg);
+      return zobrist::supply_ammo_key(object, type, command.from) ^
+             zobrist::supply_ammo_key(object, type, command.to);
+    }
+
+    const zobrist::Feature feature = unit_feature(command.field);
+    return zobrist::key(feature, object, command.from) ^
+           zobrist::key(feature, object, command.to);
+  }
+  case Command::Type::UnitPosition: {
+    const uint64_t object = zobrist::object_key(
+        id(state.units, command.object));
+    return zobrist::position_key(object, unpack_location(command.from),
+                                 unpack_from_level(command.arg)) ^
+           zobrist::position_key(object, unpack_location(command.to),
+                                 unpack_to_level(command.arg));
+  }
+  case Command::Type::UnitAmmo: {
+    const def::Collection<state::Unit>::const_iterator unit =
+        find(state.units, command.object);
+    const uint64_t object = zobrist::object_key(unit->first);
+    const uint64_t weapon =
+        zobrist::object_key(id(unit->second.def->weapons, command.arg));
+    return zobrist::ammo_key(object, weapon, command.from) ^
+           zobrist::ammo_key(object, weapon, command.to);
+  }
+  case Command::Type::UnitOwner: {
+    const uint64_t object = zobrist::object_key(
+        id(state.units, command.object));
+    return zobrist::key(zobrist::Feature::UnitOwner, object,
+                        zobrist::object_key(id(state.players, command.from))) ^
+           zobrist::key(zobrist::Feature::UnitOwner, object,
+                        zobrist::object_key(id(state.players, command.to)));
+  }
+  case Command::Type::UnitCreate:
+  case Command::Type::UnitRemove: {
+    const def::Collection<state::Unit>::const_iterator unit =
+        find(state.units, command.object);
+    return zobrist::hash(unit->first, unit->second);
+  }
+  case Command::Type::LoadIntoUnit:
+  case Command::Type::LoadIntoShop:
+  case Command::Type::UnloadFromUnit:
+  case Command::Type::UnloadFromShop: {
+    const def::Collection<state::Unit>::const_iterator unit =
+        find(state.units, command.object);
+    const uint64_t object = zobrist::object_key(unit->first);
+    return zobrist::position_key(object, unpack_location(command.from),
+                                 unit->second.level) ^
+           zobrist::position_key(object, unpack_location(command.to),
+                                 unit->second.level);
+  }
+  case Command::Type::ShopOwner: {
+    const uint64_t object = zobrist::object_key(
+        id(state.shops, command.object));
+    return zobrist::key(zobrist::Feature::ShopOwner, object,
+                        zobrist::object_key(id(state.players, command.from))) ^
+           zobrist::key(zobrist::Feature::ShopOwner, object,
+                        zobrist::object_key(id(state.players, command.to)));
+  }
+  case Command::Type::PlayerWealth: {
+    const uint64_t object = zobrist::object_key(
+        id(state.players, command.object));
+    return zobrist::key(zobrist::Feature::PlayerWealth, object,
+                        command.from) ^
+           zobrist::key(zobrist::Feature::PlayerWealth, object, command.to);
+  }
+  case Command::Type::PlayerCaptain: {
+    const uint64_t object = zobrist::object_key(
+        id(state.players, command.object));
+    return zobrist::key(zobrist::Feature::PlayerCaptain, object,
+                        zobrist::object_key(id(state.units, command.from))) ^
+           zobrist::key(zobrist::Feature::PlayerCaptain, object,
+                        zobrist::object_key(id(state.units, command.to)));
+  }
+  case Command::Type::PlayerEliminated: {
+    const uint64_t object = zobrist::object_key(
+        id(state.players, command.object));
+    return zobrist::key(zobrist::Feature::PlayerEliminated, object,
+                        command.from) ^
+           zobrist::key(zobrist::Feature::PlayerEliminated, object,
+                        command.to);
+  }
+  case Command::Type::Turn:
+    return zobrist::key(zobrist::Feature::TurnNum, 0, command.from) ^
+           zobrist::key(zobrist::Feature::TurnNum, 0, command.to) ^
+           zobrist::key(
+               zobrist::Feature::PlayerAtTurn, 0,
+               zobrist::object_key(id(state.players, command.object))) ^
+           zobrist::key(zobrist::Feature::PlayerAtTurn, 0,
+                        zobrist::object_key(id(state.players, command.arg)));
+  }
+
+  assert(false);
+  return 0;
+}
+
+Journal::Journal(state::State &state)
+    : state_(&state), position_(0), hash_(zobrist::hash(state)) {}
+
+std::vector<Command> Journal::applied() const {
+  if (position_ == steps_.size()) {
+    return commands_;
+  }
+
+  return std::vector<Command>(commands_.begin(),
+                              commands_.begin() +
+                                  (position_ > 0 ? steps_[position_ - 1] : 0));
+}
+
+bool Journal::can_undo() const {
+  return position_ > 0 ||
+         (position_ == steps_.size() && !commands_.empty());
+}
+
+bool Journal::can_redo() const { return position_ < steps_.size(); }
+
+void Journal::commit() {
+  if (position_ != steps_.size()) {
+    // Nothing recorded since the last undo
+    return;
+  }
+
+  const size_t begin = steps_.empty() ? 0 : steps_.back();
+  if (commands_.size() > begin) {
+    steps_.push_back(commands_.size());
+    ++position_;
+  }
+}
+
+void Journal::undo() {
+  commit();
+  assert(position_ > 0);
+
+  const size_t begin = position_ > 1 ? steps_[position_ - 2] : 0;
+  for (size_t i = steps_[position_ - 1]; i > begin; --i) {
+    step(commands_[i - 1], false);
+  }
+
+  --position_;
+}
+
+void Journal::redo() {
+  assert(can_redo());
+
+  const size_t begin = position_ > 0 ? steps_[position_ - 1] : 0;
+  for (size_t i = begin; i < steps_[position_]; ++i) {
+    step(commands_[i], true);
+  }
+
+  ++position_;
+}
+
+void Journal::move_unit(def::Handle<state::Unit> unit, def::Location location,
+                        def::Level level) {
+  const state::Unit &current = find(state_->units, unit.value())->second;
+  record(Command{
+      .type = Command::Type::UnitPosition,
+      .object = unit.value(),
+      .arg = pack_levels(current.level, level),
+      .from = pack_location(current.location),
+      .to = pack_location(location),
+  });
+}
+
+void Journal::set_health(def::Handle<state::Unit> unit, uint32_t health) {
+  set_unit_value(unit, Command::Field::Health, health);
+}
+
+void Journal::set_movement(def::Handle<state::Unit> unit, uint32_t movement) {
+  set_unit_value(unit, Command::Field::Movement, movement);
+}
+
+void Journal::set_fuel(def::Handle<state::Unit> unit, uint32_t fuel) {
+  set_unit_value(unit, Command::Field::Fuel, fuel);
+}
+
+void Journal::set_experience(def::Handle<state::Unit> unit,
+                             uint32_t experience) {
+  set_unit_value(unit, Command::Field::Experience, experience);
+}
+
+void Journal::set_has_actioned(def::Handle<state::Unit> unit,
+                               bool has_actioned) {
+  set_unit_value(unit, Command::Field::HasActioned, has_actioned);
+}
+
+void Journal::set_has_soared(def::Handle<state::Unit> unit, bool has_soared) {
+  set_unit_value(unit, Command::Field::HasSoared, has_soared);
+}
+
+void Journal::set_ammo(def::Handle<state::Unit> unit,
+                       def::Handle<def::WeaponDef> weapon, uint32_t value) {
+  record(Command{
+      .type = Command::Type::UnitAmmo,
+      .object = unit.value(),
+      .arg = weapon.value(),
+      .from = ammo(find(state_->units, unit.value())->second, weapon.value()),
+      .to = value,
+  });
+}
+
+void Journal::set_supplies(def::Handle<state::Unit> unit,
+                           const def::Resupply &supplies) {
+  set_unit_value(unit, Command::Field::SupplyFuel, supplies.fuel);
+  set_unit_value(unit, Command::Field::SupplyRepair, supplies.repair);
+  for (uint32_t i = 0; i < supplies.ammo.size(); ++i) {
+    set_unit_value(unit, Command::Field::SupplyAmmo,
+                   supplies.ammo[static_cast<def::DamageType>(i)], i);
+  }
+}
+
+void Journal::set_unit_owner(def::Handle<state::Unit> unit,
+                             def::Handle<state::Player> owner) {
+  const state::Unit &current = find(state_->units, unit.value())->second;
+  record(Command{
+      .type = Command::Type::UnitOwner,
+      .object = unit.value(),
+      .from = current.owner.handle().value(),
+      .to = owner.value(),
+  });
+}
+
+def::Handle<state::Unit> Journal::create_unit(
+    const std::string &id, def::Handle<def::UnitDef> def,
+    def::Handle<state::Player> owner, def::Location location,
+    def::Level level) {
+  return create_unit(id, def, owner, location, level,
+                     def::Handle<state::Shop>());
+}
+
+def::Handle<state::Unit>
+Journal::create_unit_in_shop(const std::string &id,
+                             def::Handle<def::UnitDef> def,
+                             def::Handle<state::Player> owner,
+                             def::Handle<state::Shop> shop) {
+  const state::Shop &current = find(state_->shops, shop.value())->second;
+  return create_unit(id, def, owner, current.def->location,
+                     find(state_->scenario->units, def.value())->second.level,
+                     shop);
+}
+
+void Journal::remove_unit(def::Handle<state::Unit> unit) {
+  const def::Collection<state::Unit>::const_iterator iter =
+      find(std::as_const(state_->units), unit.value());
+  const state::Unit &current = iter->second;
+  assert(current.container.units.empty());
+  assert(std::none_of(state_->players.begin(), state_->players.end(),
+                      [&iter](const auto &entry) {
+                        return entry.second.captain == iter;
+                      }));
+
+  UnitRecord record{
+      .id = iter->first,
+      .def = current.def.handle().value(),
+      .owner = current.owner.handle().value(),
+      .location = current.location,
+      .level = current.level,
+      .health = current.health,
+      .movement = current.movement,
+      .fuel = current.fuel,
+      .experience = current.experience,
+      .has_actioned = current.has_actioned,
+      .has_soared = current.has_soared,
+      .supplies = current.supplies,
+      .contained_in_unit = current.contained_in_unit.handle().value(),
+      .contained_in_shop = current.contained_in_shop.handle().value(),
+      .index = 0,
+      .stats = current.stats,
+  };
+  for (const auto &[weapon, ammo] : current.ammo) {
+    record.ammo.emplace_back(weapon.handle().value(), ammo);
+  }
+  if (current.contained_in_unit || current.contained_in_shop) {
+    record.index = container_index(current);
+  }
+
+  discard_redo();
+  units_.push_back(std::move(record));
+  this->record(Command{
+      .type = Command::Type::UnitRemove,
+      .object = unit.value(),
+      .arg = static_cast<uint32_t>(units_.size() - 1),
+  });
+}
+
+void Journal::load_unit(def::Handle<state::Unit> unit,
+                        def::Handle<state::Unit> container) {
+  const state::Unit &target = find(state_->units, container.value())->second;
+  load_unit(unit, Command::Type::LoadIntoUnit, container.value(),
+            target.location, target.container);
+}
+
+void Journal::load_unit(def::Handle<state::Unit> unit,
+                        def::Handle<state::Shop> container) {
+  const state::Shop &target = find(state_->shops, container.value())->second;
+  load_unit(unit, Command::Type::LoadIntoShop, container.value(),
+            target.def->location, target.container);
+}
+
+void Journal::unload_unit(def::Handle<state::Unit> unit,
+                          def::Location location) {
+  const state::Unit &current = find(state_->units, unit.value())->second;
+  record(Command{
+      .type = current.contained_in_unit ? Command::Type::UnloadFromUnit
+                                        : Command::Type::UnloadFromShop,
+      .index = container_index(current),
+      .object = unit.value(),
+      .arg = current.contained_in_unit
+                 ? current.contained_in_unit.handle().value()
+                 : current.contained_in_shop.handle().value(),
+      .from = pack_location(current.location),
+      .to = pack_location(location),
+  });
+}
+
+void Journal::set_shop_owner(def::Handle<state::Shop> shop,
+                             def::Handle<state::Player> owner) {
+  const state::Shop &current = find(state_->shops, shop.value())->second;
+  record(Command{
+      .type = Command::Type::ShopOwner,
+      .object = shop.value(),
+      .from = current.owner.handle().value(),
+      .to = owner.value(),
+  });
+}
+
+void Journal::set_wealth(def::Handle<state::Player> player, uint32_t wealth) {
+  record(Command{
+      .type = Command::Type::PlayerWealth,
+      .object = player.value(),
+      .from = find(state_->players, player.value())->second.wealth,
+      .to = wealth,
+  });
+}
+
+void Journal::set_captain(def::Handle<state::Player> player,
+                          def::Handle<state::Unit> unit) {
+  record(Command{
+      .type = Command::Type::PlayerCaptain,
+      .object = player.value(),
+      .from = find(state_->players, player.value())
+                  ->second.captain.handle()
+                  .value(),
+      .to = unit.value(),
+  });
+}
+
+void Journal::set_eliminated(def::Handle<state::Player> player,
+                             bool is_eliminated) {
+  record(Command{
+      .type = Command::Type::PlayerEliminated,
+      .object = player.value(),
+      .from = find(state_->players, player.value())->second.is_eliminated,
+      .to = is_eliminated,
+  });
+}
+
+void Journal::set_turn(uint32_t turn_num, def::Handle<state::Player> player) {
+  record(Command{
+      .type = Command::Type::Turn,
+      .object = state_->player_at_turn.handle().value(),
+      .arg = player.value(),
+      .from = state_->turn_num,
+      .to = turn_num,
+  });
+}
+
+def::Handle<state::Unit> Journal::create_unit(
+    const std::string &id, def::Handle<def::UnitDef> def,
+    def::Handle<state::Player> owner, def::Location location,
+    def::Level level, def::Handle<state::Shop> shop) {
+  assert(state_->units.count(id) == 0);
+  const def::UnitDef &unit_def =
+      find(state_->scenario->units, def.value())->second;
+
+  UnitRecord record{
+      .id = id,
+      .def = def.value(),
+      .owner = owner.value(),
+      .location = location,
+      .level = level,
+      .health = 100,
+      .movement = unit_def.movement,
+      .fuel = unit_def.fuel,
+      .experience = 0,
+      .has_actioned = false,
+      .has_soared = false,
+      .supplies = unit_def.supplies,
+      .contained_in_unit = def::Handle<state::Unit>().value(),
+      .contained_in_shop = shop.value(),
+      .index = 0,
+      .stats = {},
+  };
+  for (auto weapon = unit_def.weapons.begin(); weapon != unit_def.weapons.end();
+       ++weapon) {
+    record.ammo.emplace_back(
+        def::Collection<def::WeaponDef>::handle(weapon).value(),
+        weapon->second.ammo);
+  }
+  if (shop) {
+    const size_t size =
+        find(state_->shops, shop.value())->second.container.units.size();
+    assert(size <= UINT16_MAX);
+    record.index = static_cast<uint16_t>(size);
+  }
+
+  const def::Handle<state::Unit> unit = state_->units.next_handle();
+  discard_redo();
+  units_.push_back(std::move(record));
+  this->record(Command{
+      .type = Command::Type::UnitCreate,
+      .object = unit.value(),
+      .arg = static_cast<uint32_t>(units_.size() - 1),
+  });
+
+  return unit;
+}
+
+void Journal::load_unit(def::Handle<state::Unit> unit, Command::Type type,
+                        uint32_t container, def::Location location,
+                        const state::Container &target) {
+  const state::Unit &current = find(state_->units, unit.value())->second;
+  assert(!current.contained_in_unit && !current.contained_in_shop);
+  assert(target.units.size() <= UINT16_MAX);
+
+  record(Command{
+      .type = type,
+      .index = static_cast<uint16_t>(target.units.size()),
+      .object = unit.value(),
+      .arg = container,
+      .from = pack_location(current.location),
+      .to = pack_location(location),
+  });
+}
+
+uint16_t Journal::container_index(const state::Unit &unit) const {
+  const std::list<def::Ref<state::Unit>> &units =
+      unit.contained_in_unit ? unit.contained_in_unit->container.units
+                             : unit.contained_in_shop->container.units;
+  const auto pos =
+      std::find_if(units.begin(), units.end(),
+                   [&unit](const def::Ref<state::Unit> &contained) {
+                     return &*contained == &unit;
+                   });
+  assert(pos != units.end());
+  return static_cast<uint16_t>(std::distance(units.begin(), pos));
+}
+
+void Journal::set_unit_value(def::Handle<state::Unit> unit,
+                             Command::Field field, uint32_t value,
+                             uint32_t arg) {
+  record(Command{
+      .type = Command::Type::UnitValue,
+      .field = field,
+      .object = unit.value(),
+      .arg = arg,
+      .from = get_unit_value(find(state_->units, unit.value())->second, field,
+                             arg),
+      .to = value,
+  });
+}
+
+void Journal::record(const Command &command) {
+  discard_redo();
+  step(command, true);
+  commands_.push_back(command);
+}
+
+void Journal::discard_redo() {
+  if (position_ == steps_.size()) {
+    return;
+  }
+
+  const size_t end = position_ > 0 ? steps_[position_ - 1] : 0;
+  // Records are added in the order of their commands
+  const auto first = std::find_if(commands_.begin() + end, commands_.end(),
+                                  has_record);
+  if (first != commands_.end()) {
+    units_.resize(first->arg);
+  }
+
+  commands_.resize(end);
+  steps_.resize(position_);
+}
+
+void Journal::step(const Command &command, bool forward) {
+  // The keys of a unit can only be computed while it exists
+  if (adds_unit(command, forward)) {
+    apply(*state_, command, units_, forward);
+    hash_ ^= hash_delta(*state_, command);
+  } else {
+    hash_ ^= hash_delta(*state_, command);
+    apply(*state_, command, units_, forward);
+  }
+}
+
+} // namespace freeisle::journal
@@ -0,0 +1,286 @@
+#pragma once
+
+#include "journal/Command.hh"
+
+#include "state/State.hh"
+
+#include "def/Collection.hh"
+#include "def/Level.hh"
+#include "def/Location.hh"
+#include "def/Resupply.hh"
+#include "def/UnitDef.hh"
+#include "def/WeaponDef.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace freeisle::journal {
+
+/**
+ * Apply a command to the given state, in forward direction if forward is
+ * true, or undo it otherwise. Units refers to the records of the journal
+ * that recorded the command. Moving, creating and removing units also
+ * updates the map occupancy, the players' units and their fog of war.
+ */
+void apply(state::State &state, const Command &command,
+           const std::vector<UnitRecord> &units, bool forward = true);
+
+/**
+ * Apply all given commands to the given state in order. Starting from the
+ * state the commands were recorded on, or a copy of it, this reproduces the
+ * recorded game exactly, including the handles of created units.
+ */
+void replay(state::State &state, const std::vector<Command> &commands,
+            const std::vector<UnitRecord> &units);
+
+/**
+ * Returns the value to XOR into the zobrist hash of the given state when
+ * the given command is applied or undone. The delta of creating or removing
+ * a unit covers all keys of the unit, so the state must contain the unit,
+ * i.e. it is the state after creation or before removal.
+ */
+uint64_t hash_delta(const state::State &state, const Command &command);
+
+/**
+ * Records mutations of a game state, so that they can be undone, redone and
+ * replayed.
+ *
+ * All modifications of the state go through the mutator functions, which
+ * apply them to the state and record a command. Commands are grouped into
+ * steps, e.g. all the changes that make up one action; commit() ends the
+ * current step. undo() and redo() move backwards and forwards by one step,
+ * at a cost proportional to the number of commands in the step. Recording
+ * a new command after undo() discards the steps that could be redone.
+ *
+ * Undoing a move does not undo the discovery of hexes in the fog of war:
+ * discovered hexes stay discovered.
+ *
+ * Units are created and removed with their collection handles: undoing the
+ * removal of a unit restores it with its old handle, and replaying the
+ * creation of a unit gives it the same handle as when it was recorded, so
+ * that later commands still refer to it. A removed unit is kept as a
+ * UnitRecord; this covers all of its state except the units it contains,
+ * which have to be removed or unloaded first.
+ *
+ * The journal covers the state that changes during a game. Scenario data,
+ * teams, player names, colors, lose conditions and unit statistics other
+ * than on creation and removal are not recorded.
+ *
+ * The journal also maintains the zobrist hash of the state, which is updated
+ * in constant time for every command that is applied or undone.
+ */
+class Journal {
+public:
+  /**
+   * Create an empty journal for the given state. The state must outlive
+   * the journal. This computes the hash of the state from scratch.
+   */
+  explicit Journal(state::State &state);
+
+  Journal(const Journal &) = delete;
+  Journal(Journal &&) = default;
+  Journal &operator=(const Journal &) = delete;
+  Journal &operator=(Journal &&) = default;
+
+  /**
+   * Returns all recorded commands of completed steps, including the ones
+   * that have been undone, followed by the commands of the current step.
+   */
+  const std::vector<Command> &commands() const { return commands_; }
+
+  /**
+   * Returns the commands that are currently applied to the state, in order.
+   * Replaying them on the initial state, together with unit_records(),
+   * reproduces the current state.
+   */
+  std::vector<Command> applied() const;
+
+  /**
+   * Returns the records of created and removed units that the commands
+   * refer to.
+   */
+  const std::vector<UnitRecord> &unit_records() const { return units_; }
+
+  /**
+   * Number of completed steps that are currently applied.
+   */
+  size_t position() const { return position_; }
+
+  /**
+   * Zobrist hash of the current state.
+   */
+  uint64_t hash() const { return hash_; }
+
+  bool can_undo() const;
+  bool can_redo() const;
+
+  /**
+   * End the current step. Does nothing if no commands were recorded since
+   * the last step.
+   */
+  void commit();
+
+  /**
+   * Revert the last step. The current step is committed first.
+   */
+  void undo();
+
+  /**
+   * Re-apply the last step that was undone.
+   */
+  void redo();
+
+  /**
+   * Move the unit to the given location and level. If the unit is on the
+   * map, the map occupancy and fog of war are updated as well.
+   */
+  void move_unit(def::Handle<state::Unit> unit, def::Location location,
+                 def::Level level);
+
+  void set_health(def::Handle<state::Unit> unit, uint32_t health);
+  void set_movement(def::Handle<state::Unit> unit, uint32_t movement);
+  void set_fuel(def::Handle<state::Unit> unit, uint32_t fuel);
+  void set_experience(def::Handle<state::Unit> unit, uint32_t experience);
+  void set_has_actioned(def::Handle<state::Unit> unit, bool has_actioned);
+  void set_has_soared(def::Handle<state::Unit> unit, bool has_soared);
+
+  /**
+   * Set the ammo of one of the unit's weapons.
+   */
+  void set_ammo(def::Handle<state::Unit> unit,
+                def::Handle<def::WeaponDef> weapon, uint32_t ammo);
+
+  /**
+   * Set the supplies that the unit carries. Only the values that change
+   * are recorded.
+   */
+  void set_supplies(def::Handle<state::Unit> unit,
+                    const def::Resupply &supplies);
+
+  /**
+   * Set the owner of the unit. An invalid handle means no owner.
+   */
+  void set_unit_owner(def::Handle<state::Unit> unit,
+                      def::Handle<state::Player> owner);
+
+  /**
+   * Create a unit with the given ID and definition, owned by the given
+   * player, and put it onto the map at the given location and level. The
+   * unit starts with full health, and with movement, fuel, ammo and supplies
+   * as given by its definition. Returns the handle of the new unit.
+   */
+  def::Handle<state::Unit> create_unit(const std::string &id,
+                                       def::Handle<def::UnitDef> def,
+                                       def::Handle<state::Player> owner,
+                                       def::Location location,
+                                       def::Level level);
+
+  /**
+   * Same as create_unit(), but the unit is put into the container of the
+   * given shop, e.g. when it is produced there.
+   */
+  def::Handle<state::Unit> create_unit_in_shop(
+      const std::string &id, def::Handle<def::UnitDef> def,
+      def::Handle<state::Player> owner, def::Handle<state::Shop> shop);
+
+  /**
+   * Remove the unit from the map or the container it is in, and from the
+   * state. The unit must not contain other units, and must not be the
+   * captain of a player.
+   */
+  void remove_unit(def::Handle<state::Unit> unit);
+
+  /**
+   * Take the unit, which must be on the map, off the map and put it into
+   * the container of the given unit or shop. Its location becomes the
+   * location of the container.
+   */
+  void load_unit(def::Handle<state::Unit> unit,
+                 def::Handle<state::Unit> container);
+  void load_unit(def::Handle<state::Unit> unit,
+                 def::Handle<state::Shop> container);
+
+  /**
+   * Take the unit out of its container and put it onto the map at the
+   * given location, at its current level.
+   */
+  void unload_unit(def::Handle<state::Unit> unit, def::Location location);
+
+  /**
+   * Set the owner of the shop. An invalid handle means no owner.
+   */
+  void set_shop_owner(def::Handle<state::Shop> shop,
+                      def::Handle<state::Player> owner);
+
+  void set_wealth(def::Handle<state::Player> player, uint32_t wealth);
+
+  /**
+   * Set the captain of the player. An invalid handle means no captain.
+   */
+  void set_captain(def::Handle<state::Player> player,
+                   def::Handle<state::Unit> unit);
+
+  void set_eliminated(def::Handle<state::Player> player, bool is_eliminated);
+
+  /**
+   * Set the turn number and the player at turn. An invalid handle means
+   * that nobody is at turn.
+   */
+  void set_turn(uint32_t turn_num, def::Handle<state::Player> player);
+
+private:
+  def::Handle<state::Unit> create_unit(const std::string &id,
+                                       def::Handle<def::UnitDef> def,
+                                       def::Handle<state::Player> owner,
+                                       def::Location location,
+                                       def::Level level,
+                                       def::Handle<state::Shop> shop);
+  void load_unit(def::Handle<state::Unit> unit, Command::Type type,
+                 uint32_t container, def::Location location,
+                 const state::Container &target);
+
+  /**
+   * Returns the position of the unit in the container it is in.
+   */
+  uint16_t container_index(const state::Unit &unit) const;
+
+  void set_unit_value(def::Handle<state::Unit> unit, Command::Field field,
+                      uint32_t value, uint32_t arg = 0);
+  void record(const Command &command);
+
+  /**
+   * Discard the steps that could be redone, and the records they refer to.
+   */
+  void discard_redo();
+
+  /**
+   * Apply or undo the command, and update the hash.
+   */
+  void step(const Command &command, bool forward);
+
+  state::State *state_;
+
+  std::vector<Command> commands_;
+
+  /**
+   * Records of the units that are created or removed by commands_, in the
+   * order of the commands.
+   */
+  std::vector<UnitRecord> units_;
+
+  /**
+   * Index into commands_ one past the end of each completed step.
+   */
+  std::vector<size_t> steps_;
+
+  /**
+   * Number of steps in steps_ that are applied.
+   */
+  size_t position_;
+
+  uint64_t hash_;
+};
+
+} // namespace freeisle::journal
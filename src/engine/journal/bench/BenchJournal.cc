@@ -0,0 +1,82 @@
+#include "journal/Journal.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  Fixture(uint32_t size, uint32_t num_units) : Scenario(size, size) {
+    add_unit_def("tank",
+                 freeisle::def::UnitDef{.name = "tank",
+                                        .level = freeisle::def::Level::Land});
+    add_player("player0");
+
+    for (uint32_t i = 0; i < num_units; ++i) {
+      const std::string id = "unit" + std::to_string(i);
+      add_unit(id, "tank", "", i % size, i / size * 2);
+      units.push_back(handle(state.units, id));
+    }
+  }
+
+  std::vector<freeisle::def::Handle<freeisle::state::Unit>> units;
+};
+
+/**
+ * One turn of actions recorded in the journal: every unit moves one hex
+ * and spends its movement, one step per unit.
+ */
+void BM_Record(benchmark::State &state) {
+  Fixture fixture(64, state.range(0));
+
+  for (auto _ : state) {
+    freeisle::journal::Journal journal(fixture.state);
+    for (const freeisle::def::Handle<freeisle::state::Unit> unit :
+         fixture.units) {
+      const freeisle::def::Location location =
+          fixture.state.units.find(unit)->second.location;
+      journal.move_unit(unit, {.x = location.x, .y = location.y + 1},
+                        freeisle::def::Level::Land);
+      journal.set_movement(unit, 0);
+      journal.commit();
+    }
+
+    // Revert so that the next iteration starts from the same state
+    while (journal.can_undo()) {
+      journal.undo();
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Undo and redo of a single step, e.g. for a search that explores one
+ * action and backs out again.
+ */
+void BM_UndoRedo(benchmark::State &state) {
+  Fixture fixture(64, 1);
+  freeisle::journal::Journal journal(fixture.state);
+  journal.move_unit(fixture.units[0], {.x = 0, .y = 1},
+                    freeisle::def::Level::Land);
+  journal.set_movement(fixture.units[0], 0);
+  journal.commit();
+
+  for (auto _ : state) {
+    journal.undo();
+    journal.redo();
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_Record)->Arg(200)->Arg(2000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_UndoRedo);
+
+BENCHMARK_MAIN();
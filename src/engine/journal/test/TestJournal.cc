@@ -0,0 +1,420 @@
+#include "journal/Journal.hh"
+
+#include "state/Fork.hh"
+
+#include "zobrist/Zobrist.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <gtest/gtest.h>
+
+class TestJournal : public ::testing::Test,
+                    public freeisle::state::test::Scenario {
+public:
+  TestJournal() : Scenario(5, 5) {
+    freeisle::def::UnitDef &def =
+        add_unit_def("def001", freeisle::def::UnitDef{
+                                   .name = "def001",
+                                   .level = freeisle::def::Level::Land,
+                                   .movement = 600,
+                               });
+    def.weapons.try_emplace("weapon001", freeisle::def::WeaponDef{.ammo = 4});
+
+    state.turn_num = 7;
+    add_player("rose").wealth = 100;
+    add_player("lily").wealth = 100;
+    state.player_at_turn = state.players.find("rose");
+
+    add_shop("shop001", "rose", 3, 1);
+    add_unit("unit001", "def001", "rose", 0, 0);
+
+    unit_handle = handle(state.units, "unit001");
+    weapon_handle = handle(def.weapons, "weapon001");
+  }
+
+  freeisle::def::Handle<freeisle::state::Player> player(const char *id) {
+    return handle(state.players, id);
+  }
+
+  freeisle::state::Unit &unit() { return state.units["unit001"]; }
+
+  freeisle::def::Handle<freeisle::state::Unit> unit_handle;
+  freeisle::def::Handle<freeisle::def::WeaponDef> weapon_handle;
+};
+
+TEST_F(TestJournal, UndoRedo) {
+  freeisle::journal::Journal journal(state);
+  EXPECT_FALSE(journal.can_undo());
+  EXPECT_FALSE(journal.can_redo());
+
+  journal.set_movement(unit_handle, 200);
+  journal.set_has_actioned(unit_handle, true);
+  journal.commit();
+  journal.set_health(unit_handle, 60);
+  EXPECT_EQ(unit().movement, 200);
+  EXPECT_TRUE(unit().has_actioned);
+  EXPECT_EQ(unit().health, 60);
+  EXPECT_EQ(journal.commands().size(), 3);
+
+  // undo commits the open step
+  ASSERT_TRUE(journal.can_undo());
+  journal.undo();
+  EXPECT_EQ(journal.position(), 1);
+  EXPECT_EQ(unit().health, 100);
+  EXPECT_EQ(unit().movement, 200);
+
+  journal.undo();
+  EXPECT_EQ(journal.position(), 0);
+  EXPECT_EQ(unit().movement, 600);
+  EXPECT_FALSE(unit().has_actioned);
+  EXPECT_FALSE(journal.can_undo());
+  EXPECT_TRUE(journal.applied().empty());
+
+  ASSERT_TRUE(journal.can_redo());
+  journal.redo();
+  EXPECT_EQ(unit().movement, 200);
+  EXPECT_TRUE(unit().has_actioned);
+  EXPECT_EQ(unit().health, 100);
+  EXPECT_EQ(journal.applied().size(), 2);
+
+  journal.redo();
+  EXPECT_EQ(unit().health, 60);
+  EXPECT_FALSE(journal.can_redo());
+}
+
+TEST_F(TestJournal, RecordDiscardsRedo) {
+  freeisle::journal::Journal journal(state);
+  journal.set_fuel(unit_handle, 10);
+  journal.commit();
+  journal.set_fuel(unit_handle, 20);
+  journal.commit();
+
+  journal.undo();
+  journal.set_experience(unit_handle, 3);
+  EXPECT_FALSE(journal.can_redo());
+  EXPECT_EQ(journal.commands().size(), 2);
+  EXPECT_EQ(unit().fuel, 10);
+  EXPECT_EQ(unit().experience, 3);
+
+  journal.undo();
+  journal.undo();
+  EXPECT_EQ(unit().fuel, 0);
+  EXPECT_EQ(unit().experience, 0);
+}
+
+TEST_F(TestJournal, MoveUnit) {
+  state.players["rose"].fow(0, 0).view = 1;
+
+  freeisle::journal::Journal journal(state);
+  journal.move_unit(unit_handle, {.x = 2, .y = 3},
+                    freeisle::def::Level::Land);
+
+  EXPECT_EQ(unit().location.x, 2);
+  EXPECT_EQ(unit().location.y, 3);
+  EXPECT_FALSE(state.map.surface_unit(0, 0));
+  EXPECT_EQ(state.map.surface_unit(2, 3), state.units.find("unit001"));
+
+  journal.undo();
+  EXPECT_EQ(unit().location.x, 0);
+  EXPECT_EQ(unit().location.y, 0);
+  EXPECT_EQ(state.map.surface_unit(0, 0), state.units.find("unit001"));
+  EXPECT_FALSE(state.map.surface_unit(2, 3));
+  EXPECT_TRUE(state.map.grid(2, 3).empty());
+}
+
+TEST_F(TestJournal, MoveUnitLevel) {
+  freeisle::journal::Journal journal(state);
+  journal.move_unit(unit_handle, {.x = 1, .y = 0},
+                    freeisle::def::Level::UnderWater);
+
+  EXPECT_EQ(unit().level, freeisle::def::Level::UnderWater);
+  EXPECT_FALSE(state.map.surface_unit(1, 0));
+  EXPECT_EQ(state.map.subsurface_unit(1, 0), state.units.find("unit001"));
+
+  journal.undo();
+  EXPECT_EQ(unit().level, freeisle::def::Level::Land);
+  EXPECT_FALSE(state.map.subsurface_unit(1, 0));
+  EXPECT_EQ(state.map.surface_unit(0, 0), state.units.find("unit001"));
+}
+
+TEST_F(TestJournal, Ammo) {
+  freeisle::journal::Journal journal(state);
+  journal.set_ammo(unit_handle, weapon_handle, 1);
+  EXPECT_EQ(unit().ammo.begin()->second, 1);
+
+  journal.undo();
+  EXPECT_EQ(unit().ammo.begin()->second, 4);
+}
+
+TEST_F(TestJournal, ShopOwnerAndWealth) {
+  const freeisle::def::Handle<freeisle::state::Shop> shop =
+      freeisle::def::Collection<freeisle::state::Shop>::handle(
+          state.shops.find("shop001"));
+
+  freeisle::journal::Journal journal(state);
+  journal.set_shop_owner(shop, player("lily"));
+  journal.set_wealth(player("lily"), 250);
+  EXPECT_EQ(state.shops["shop001"].owner, state.players.find("lily"));
+  EXPECT_EQ(state.players["lily"].wealth, 250);
+
+  journal.commit();
+  journal.set_shop_owner(shop,
+                         freeisle::def::Handle<freeisle::state::Player>());
+  EXPECT_FALSE(state.shops["shop001"].owner);
+
+  journal.undo();
+  EXPECT_EQ(state.shops["shop001"].owner, state.players.find("lily"));
+
+  journal.undo();
+  EXPECT_EQ(state.shops["shop001"].owner, state.players.find("rose"));
+  EXPECT_EQ(state.players["lily"].wealth, 100);
+}
+
+TEST_F(TestJournal, Turn) {
+  freeisle::journal::Journal journal(state);
+  journal.set_turn(8, player("lily"));
+  EXPECT_EQ(state.turn_num, 8);
+  EXPECT_EQ(state.player_at_turn, state.players.find("lily"));
+
+  journal.undo();
+  EXPECT_EQ(state.turn_num, 7);
+  EXPECT_EQ(state.player_at_turn, state.players.find("rose"));
+}
+
+TEST_F(TestJournal, Replay) {
+  const freeisle::state::State base = freeisle::state::fork(state);
+
+  freeisle::journal::Journal journal(state);
+  journal.move_unit(unit_handle, {.x = 1, .y = 1},
+                    freeisle::def::Level::Land);
+  journal.set_movement(unit_handle, 100);
+  journal.commit();
+  journal.set_ammo(unit_handle, weapon_handle, 2);
+  journal.set_turn(8, player("lily"));
+  journal.commit();
+  journal.set_health(unit_handle, 10);
+  journal.undo();
+
+  freeisle::state::State replayed = freeisle::state::fork(base);
+  freeisle::journal::replay(replayed, journal.applied(),
+                            journal.unit_records());
+
+  const freeisle::state::Unit &unit = replayed.units["unit001"];
+  EXPECT_EQ(unit.location.x, 1);
+  EXPECT_EQ(unit.location.y, 1);
+  EXPECT_EQ(unit.movement, 100);
+  EXPECT_EQ(unit.health, 100);
+  EXPECT_EQ(unit.ammo.begin()->second, 2);
+  EXPECT_EQ(replayed.map.surface_unit(1, 1), replayed.units.find("unit001"));
+  EXPECT_FALSE(replayed.map.surface_unit(0, 0));
+  EXPECT_EQ(replayed.turn_num, 8);
+  EXPECT_EQ(replayed.player_at_turn, replayed.players.find("lily"));
+}
+
+TEST_F(TestJournal, Hash) {
+  const uint64_t base = freeisle::zobrist::hash(state);
+
+  freeisle::journal::Journal journal(state);
+  EXPECT_EQ(journal.hash(), base);
+
+  journal.move_unit(unit_handle, {.x = 1, .y = 2},
+                    freeisle::def::Level::Land);
+  journal.set_health(unit_handle, 50);
+  journal.set_has_actioned(unit_handle, true);
+  journal.set_ammo(unit_handle, weapon_handle, 0);
+  journal.set_shop_owner(
+      freeisle::def::Collection<freeisle::state::Shop>::handle(
+          state.shops.find("shop001")),
+      player("lily"));
+  journal.set_wealth(player("rose"), 0);
+  journal.set_turn(8, player("lily"));
+  EXPECT_NE(journal.hash(), base);
+  EXPECT_EQ(journal.hash(), freeisle::zobrist::hash(state));
+
+  const uint64_t changed = journal.hash();
+  journal.undo();
+  EXPECT_EQ(journal.hash(), base);
+  EXPECT_EQ(freeisle::zobrist::hash(state), base);
+
+  journal.redo();
+  EXPECT_EQ(journal.hash(), changed);
+}
+
+TEST_F(TestJournal, CreateAndRemoveUnit) {
+  const uint64_t base = freeisle::zobrist::hash(state);
+
+  freeisle::journal::Journal journal(state);
+  const freeisle::def::Handle<freeisle::state::Unit> created =
+      journal.create_unit("unit002", handle(scenario.units, "def001"),
+                          player("lily"), {.x = 2, .y = 2},
+                          freeisle::def::Level::Land);
+  journal.commit();
+  ASSERT_NE(state.units.find(created), state.units.end());
+  EXPECT_EQ(state.units.find(created), state.units.find("unit002"));
+  EXPECT_EQ(state.map.surface_unit(2, 2), state.units.find("unit002"));
+  EXPECT_EQ(state.players["lily"].units.count(state.units.find("unit002")),
+            1);
+  EXPECT_EQ(state.units["unit002"].health, 100);
+  EXPECT_EQ(state.units["unit002"].ammo.begin()->second, 4);
+
+  journal.remove_unit(unit_handle);
+  EXPECT_EQ(state.units.count("unit001"), 0);
+  EXPECT_FALSE(state.map.surface_unit(0, 0));
+  EXPECT_TRUE(state.players["rose"].units.empty());
+  EXPECT_EQ(journal.hash(), freeisle::zobrist::hash(state));
+
+  // The removed unit comes back with its old handle
+  journal.undo();
+  EXPECT_EQ(state.units.find(unit_handle), state.units.find("unit001"));
+  EXPECT_EQ(state.map.surface_unit(0, 0), state.units.find("unit001"));
+  EXPECT_EQ(state.players["rose"].units.count(state.units.find("unit001")),
+            1);
+  EXPECT_EQ(unit().movement, 600);
+  EXPECT_EQ(unit().ammo.begin()->second, 4);
+
+  journal.undo();
+  EXPECT_EQ(state.units.count("unit002"), 0);
+  EXPECT_FALSE(state.map.surface_unit(2, 2));
+  EXPECT_EQ(journal.hash(), base);
+
+  // So does the created one
+  journal.redo();
+  EXPECT_EQ(state.units.find(created), state.units.find("unit002"));
+  EXPECT_EQ(journal.hash(), freeisle::zobrist::hash(state));
+}
+
+TEST_F(TestJournal, CreateUnitInShop) {
+  freeisle::journal::Journal journal(state);
+  const freeisle::def::Handle<freeisle::state::Unit> created =
+      journal.create_unit_in_shop("unit002", handle(scenario.units, "def001"),
+                                  player("rose"),
+                                  handle(state.shops, "shop001"));
+
+  const freeisle::state::Unit &unit = state.units.find(created)->second;
+  EXPECT_EQ(unit.contained_in_shop, state.shops.find("shop001"));
+  EXPECT_EQ(unit.location.x, 3);
+  EXPECT_EQ(unit.location.y, 1);
+  EXPECT_FALSE(state.map.surface_unit(3, 1));
+  ASSERT_EQ(state.shops["shop001"].container.units.size(), 1);
+  EXPECT_EQ(state.shops["shop001"].container.units.front(),
+            state.units.find("unit002"));
+
+  journal.remove_unit(created);
+  EXPECT_TRUE(state.shops["shop001"].container.units.empty());
+
+  journal.undo();
+  EXPECT_TRUE(state.shops["shop001"].container.units.empty());
+  EXPECT_EQ(state.units.count("unit002"), 0);
+}
+
+TEST_F(TestJournal, LoadAndUnload) {
+  add_unit("unit002", "def001", "rose", 1, 0);
+  add_unit("unit003", "def001", "rose", 2, 0);
+  const freeisle::def::Handle<freeisle::state::Unit> second =
+      handle(state.units, "unit002");
+  const freeisle::def::Handle<freeisle::state::Unit> third =
+      handle(state.units, "unit003");
+  const uint64_t base = freeisle::zobrist::hash(state);
+
+  freeisle::journal::Journal journal(state);
+  journal.load_unit(second, unit_handle);
+  journal.load_unit(third, unit_handle);
+  journal.commit();
+
+  const freeisle::state::Unit &loaded = state.units["unit002"];
+  EXPECT_EQ(loaded.contained_in_unit, state.units.find("unit001"));
+  EXPECT_EQ(loaded.location.x, 0);
+  EXPECT_FALSE(state.map.surface_unit(1, 0));
+  EXPECT_FALSE(state.map.surface_unit(2, 0));
+  EXPECT_EQ(unit().container.units.size(), 2);
+  EXPECT_EQ(journal.hash(), freeisle::zobrist::hash(state));
+
+  // Unloading the first unit, and undoing it, keeps the order
+  journal.unload_unit(second, {.x = 1, .y = 1});
+  EXPECT_FALSE(loaded.contained_in_unit);
+  EXPECT_EQ(state.map.surface_unit(1, 1), state.units.find("unit002"));
+  EXPECT_EQ(unit().container.units.front(), state.units.find("unit003"));
+  EXPECT_EQ(journal.hash(), freeisle::zobrist::hash(state));
+
+  journal.undo();
+  EXPECT_EQ(loaded.contained_in_unit, state.units.find("unit001"));
+  EXPECT_FALSE(state.map.surface_unit(1, 1));
+  EXPECT_EQ(unit().container.units.front(), state.units.find("unit002"));
+  EXPECT_EQ(unit().container.units.back(), state.units.find("unit003"));
+
+  journal.undo();
+  EXPECT_TRUE(unit().container.units.empty());
+  EXPECT_FALSE(loaded.contained_in_unit);
+  EXPECT_EQ(loaded.location.x, 1);
+  EXPECT_EQ(state.map.surface_unit(1, 0), state.units.find("unit002"));
+  EXPECT_EQ(state.map.surface_unit(2, 0), state.units.find("unit003"));
+  EXPECT_EQ(journal.hash(), base);
+
+  journal.load_unit(second, handle(state.shops, "shop001"));
+  EXPECT_EQ(loaded.contained_in_shop, state.shops.find("shop001"));
+  EXPECT_EQ(loaded.location.x, 3);
+  EXPECT_EQ(loaded.location.y, 1);
+}
+
+TEST_F(TestJournal, OwnerSuppliesAndPlayers) {
+  freeisle::journal::Journal journal(state);
+  journal.set_unit_owner(unit_handle, player("lily"));
+  EXPECT_EQ(unit().owner, state.players.find("lily"));
+  EXPECT_TRUE(state.players["rose"].units.empty());
+  EXPECT_EQ(state.players["lily"].units.size(), 1);
+
+  freeisle::def::Resupply supplies = unit().supplies;
+  supplies.fuel = 20;
+  supplies.ammo[freeisle::def::DamageType::Missile] = 3;
+  journal.set_supplies(unit_handle, supplies);
+  EXPECT_EQ(unit().supplies.fuel, 20);
+  EXPECT_EQ(unit().supplies.ammo[freeisle::def::DamageType::Missile], 3);
+
+  journal.set_captain(player("lily"), unit_handle);
+  journal.set_eliminated(player("rose"), true);
+  EXPECT_EQ(state.players["lily"].captain, state.units.find("unit001"));
+  EXPECT_TRUE(state.players["rose"].is_eliminated);
+  EXPECT_EQ(journal.hash(), freeisle::zobrist::hash(state));
+
+  journal.undo();
+  EXPECT_EQ(unit().owner, state.players.find("rose"));
+  EXPECT_EQ(state.players["rose"].units.size(), 1);
+  EXPECT_TRUE(state.players["lily"].units.empty());
+  EXPECT_EQ(unit().supplies.fuel, 0);
+  EXPECT_EQ(unit().supplies.ammo[freeisle::def::DamageType::Missile], 0);
+  EXPECT_FALSE(state.players["lily"].captain);
+  EXPECT_FALSE(state.players["rose"].is_eliminated);
+  EXPECT_EQ(journal.hash(), freeisle::zobrist::hash(state));
+}
+
+TEST_F(TestJournal, ReplayCreateAndRemove) {
+  const freeisle::state::State base = freeisle::state::fork(state);
+
+  freeisle::journal::Journal journal(state);
+  journal.create_unit("unit002", handle(scenario.units, "def001"),
+                      player("lily"), {.x = 4, .y = 4},
+                      freeisle::def::Level::Land);
+  journal.commit();
+  journal.remove_unit(unit_handle);
+  journal.commit();
+
+  // A discarded creation takes a slot that is reused
+  journal.undo();
+  journal.undo();
+  const freeisle::def::Handle<freeisle::state::Unit> created =
+      journal.create_unit("unit003", handle(scenario.units, "def001"),
+                          player("rose"), {.x = 1, .y = 1},
+                          freeisle::def::Level::Land);
+  journal.remove_unit(unit_handle);
+  EXPECT_EQ(journal.unit_records().size(), 2);
+
+  freeisle::state::State replayed = freeisle::state::fork(base);
+  freeisle::journal::replay(replayed, journal.applied(),
+                            journal.unit_records());
+
+  EXPECT_EQ(replayed.units.count("unit001"), 0);
+  EXPECT_EQ(replayed.units.count("unit002"), 0);
+  EXPECT_EQ(replayed.units.find(created), replayed.units.find("unit003"));
+  EXPECT_EQ(replayed.map.surface_unit(1, 1), replayed.units.find("unit003"));
+  EXPECT_EQ(freeisle::zobrist::hash(replayed), journal.hash());
+}
@@ -0,0 +1,102 @@
+#include "json/IncludeCache.hh"
+#include "json/Parser.hh"
+
+namespace freeisle::json::loader {
+
+IncludeCache::IncludeCache(uint64_t max_bytes)
+    : max_bytes_(max_bytes), bytes_(0), hits_(0), misses_(0) {}
+
+IncludeCache &IncludeCache::global() {
+  static IncludeCache cache;
+  return cache;
+}
+
+std::shared_ptr<const IncludeCache::Document>
+IncludeCache::load(fs::File &file, const fs::FileInfo &info) {
+  {
+    const std::lock_guard<std::mutex> lock(mutex_);
+    const std::map<fs::FileId, Entry>::iterator iter = entries_.find(info.id);
+    if (iter != entries_.end() && iter->second.size == info.size &&
+        iter->second.mtime_ns == info.mtime_ns) {
+      lru_.splice(lru_.begin(), lru_, iter->second.lru);
+      ++hits_;
+      return iter->second.document;
+    }
+
+    ++misses_;
+  }
+
+  // Read and parse without holding the lock, so that other files can be
+  // loaded concurrently. If two threads load the same file at the same
+  // time, both parse it, and the last one wins.
+  // The source text is kept for as long as the document is cached, which
+  // can be much longer than a load, so it is copied rather than mapped.
+  std::vector<uint8_t> data(info.size);
+  fs::read_all(file, data.data(), data.size());
+
+  auto document = std::make_shared<Document>();
+  document->root = json::parse(data.data(), data.size());
+  document->source_data = core::SharedBytes(std::move(data));
+
+  const std::lock_guard<std::mutex> lock(mutex_);
+  const std::map<fs::FileId, Entry>::iterator iter = entries_.find(info.id);
+  if (iter != entries_.end()) {
+    erase(iter);
+  }
+
+  if (info.size > max_bytes_) {
+    return document;
+  }
+
+  while (bytes_ + info.size > max_bytes_) {
+    erase(entries_.find(lru_.back()));
+  }
+
+  lru_.push_front(info.id);
+  entries_.emplace(info.id, Entry{
+                                .size = info.size,
+                                .mtime_ns = info.mtime_ns,
+                                .document = document,
+                                .lru = lru_.begin(),
+                            });
+  bytes_ += info.size;
+
+  return document;
+}
+
+void IncludeCache::clear() {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  lru_.clear();
+  bytes_ = 0;
+  hits_ = 0;
+  misses_ = 0;
+}
+
+size_t IncludeCache::size() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+uint64_t IncludeCache::bytes() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return bytes_;
+}
+
+uint64_t IncludeCache::hits() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return hits_;
+}
+
+uint64_t IncludeCache::misses() const {
+  const std::lock_guard<std::mutex> lock(mutex_);
+  return misses_;
+}
+
+void IncludeCache::erase(std::map<fs::FileId, Entry>::iterator iter) {
+  bytes_ -= iter->second.size;
+  lru_.erase(iter->second.lru);
+  entries_.erase(iter);
+}
+
+} // namespace freeisle::json::loader
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <json/json.h>
+
+#include "core/Bytes.hh"
+#include "fs/File.hh"
+#include "fs/FileInfo.hh"
+
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace freeisle::json::loader {
+
+/**
+ * A cache of parsed include files, shared by all loads in the process.
+ *
+ * Scenarios typically include the same files over and over, e.g. a common
+ * catalog of unit definitions. With the cache, each such file is read and
+ * parsed only once, and subsequent includes copy the parsed document
+ * instead. Entries are keyed by fs::FileId, and an entry is only used if
+ * the size and modification time of the file are still the same as when it
+ * was parsed, so changes to a file are picked up.
+ *
+ * The total size of the cached source files is limited. When an entry would
+ * exceed the limit, the least recently used entries are evicted. Documents
+ * that are still in use by a load stay valid, since they are shared.
+ *
+ * The cache is thread-safe.
+ */
+class IncludeCache {
+public:
+  /**
+   * A parsed document together with the source text it was parsed from.
+   * Documents are immutable once they are in the cache.
+   */
+  struct Document {
+    core::SharedBytes source_data;
+    Json::Value root;
+  };
+
+  /**
+   * Default limit for the total size of the cached source files.
+   */
+  static constexpr uint64_t DefaultMaxBytes = 64 * 1024 * 1024;
+
+  explicit IncludeCache(uint64_t max_bytes = DefaultMaxBytes);
+
+  IncludeCache(const IncludeCache &) = delete;
+  IncludeCache(IncludeCache &&) = delete;
+  IncludeCache &operator=(const IncludeCache &) = delete;
+  IncludeCache &operator=(IncludeCache &&) = delete;
+
+  /**
+   * Returns the cache instance used by the loader.
+   */
+  static IncludeCache &global();
+
+  /**
+   * Returns the parsed document of the given file, which must be opened
+   * for reading and must have the given info. If it is not in the cache
+   * yet, or if it changed since it was cached, the file is read and parsed,
+   * and the result is added to the cache, unless the file alone is larger
+   * than the limit. Throws json::ParseError if the file cannot be parsed;
+   * failures are not cached.
+   */
+  std::shared_ptr<const Document> load(fs::File &file,
+                                       const fs::FileInfo &info);
+
+  /**
+   * Remove all entries from the cache, and reset hits() and misses().
+   */
+  void clear();
+
+  /**
+   * Number of files in the cache.
+   */
+  size_t size() const;
+
+  /**
+   * Total size of the source files in the cache, in bytes.
+   */
+  uint64_t bytes() const;
+
+  /**
+   * Number of calls to load() that were served from the cache, and that
+   * had to read and parse the file, respectively.
+   */
+  uint64_t hits() const;
+  uint64_t misses() const;
+
+private:
+  struct Entry {
+    uint64_t size;
+    uint64_t mtime_ns;
+    std::shared_ptr<const Document> document;
+
+    /**
+     * Position of the entry in lru_.
+     */
+    std::list<fs::FileId>::iterator lru;
+  };
+
+  /**
+   * Remove the given entry.
+   */
+  void erase(std::map<fs::FileId, Entry>::iterator iter);
+
+  const uint64_t max_bytes_;
+
+  mutable std::mutex mutex_;
+  std::map<fs::FileId, Entry> entries_;
+
+  /**
+   * IDs of all entries, the most recently used first.
+   */
+  std::list<fs::FileId> lru_;
+
+  uint64_t bytes_;
+  uint64_t hits_;
+  uint64_t misses_;
+};
+
+} // namespace freeisle::json::loader
@@ -0,0 +1,35 @@
+#include "json/LineIndex.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+namespace freeisle::json {
+
+LineIndex::LineIndex(const uint8_t *data, size_t len) : len_(len), starts_{0} {
+  const uint8_t *cur = data;
+  const uint8_t *const end = data + len;
+  while (cur != end) {
+    const void *newline = std::memchr(cur, '\n', end - cur);
+    if (newline == nullptr) {
+      break;
+    }
+
+    cur = static_cast<const uint8_t *>(newline) + 1;
+    starts_.push_back(cur - data);
+  }
+}
+
+std::pair<uint32_t, uint32_t> LineIndex::position(size_t offset) const {
+  assert(offset <= len_);
+
+  // first line starting after offset; the one before it contains offset
+  const std::vector<size_t>::const_iterator iter =
+      std::upper_bound(starts_.begin(), starts_.end(), offset);
+  assert(iter != starts_.begin());
+
+  const size_t line = iter - starts_.begin();
+  return {line, offset - *(iter - 1) + 1};
+}
+
+} // namespace freeisle::json
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace freeisle::json {
+
+/**
+ * Index of the beginnings of lines in a text buffer. It is built with a
+ * single pass over the buffer, after which byte offsets can be translated
+ * to line and column numbers in logarithmic time.
+ */
+class LineIndex {
+public:
+  LineIndex(const uint8_t *data, size_t len);
+
+  /**
+   * Returns the line and column, both starting at 1, of the given byte
+   * offset. Columns count bytes, not characters. The offset must not be
+   * larger than the length of the buffer.
+   */
+  std::pair<uint32_t, uint32_t> position(size_t offset) const;
+
+  /**
+   * Number of lines in the buffer. A buffer that is empty or does not end
+   * with a newline still counts its last line.
+   */
+  size_t lines() const { return starts_.size(); }
+
+private:
+  const size_t len_;
+
+  /**
+   * Byte offset of the first character of each line, in increasing order.
+   */
+  std::vector<size_t> starts_;
+};
+
+} // namespace freeisle::json
@@ -2,13 +2,25 @@
 
 #include "base64/Base64.hh"
 #include "fs/File.hh"
+#include "fs/MappedFile.hh"
 #include "fs/Path.hh"
 
 namespace freeisle::json::loader {
 
-std::vector<uint8_t> load_binary(Context &ctx, Json::Value &value,
-                                 const char *key) {
-  const std::string val = json::loader::load<std::string>(ctx, value, key);
+core::SharedBytes load_binary(Context &ctx, Json::Value &value,
+                              const char *key) {
+  // Embedded data can be large, so refer to the string in the document
+  // instead of copying it, if possible:
+  std::string copy;
+  std::string_view val;
+  const char *begin = nullptr;
+  const char *end = nullptr;
+  if (value.isMember(key) && value[key].getString(&begin, &end)) {
+    val = std::string_view(begin, end - begin);
+  } else {
+    copy = json::loader::load<std::string>(ctx, value, key);
+    val = copy;
+  }
 
   try {
     if (core::string::has_prefix(val, "base64:")) {
@@ -16,12 +28,12 @@ std::vector<uint8_t> load_binary(Context &ctx, Json::Value &value,
       view.remove_prefix(7);
 
       // Decode from base64:
-      std::vector<uint8_t> data((view.length() * 3 + 3) / 4);
+      std::vector<uint8_t> data(base64::decoded_size(view.length()));
       uint64_t len =
           base64::decode(reinterpret_cast<const uint8_t *>(view.data()),
                          view.length(), data.data());
       data.resize(len);
-      return data;
+      return core::SharedBytes(std::move(data));
     } else if (core::string::has_prefix(val, "file:")) {
       if (ctx.current_source->path.empty()) {
         throw json::loader::Error::create(
@@ -40,7 +52,8 @@ std::vector<uint8_t> load_binary(Context &ctx, Json::Value &value,
 
       const std::string full_path =
           fs::path::join(fs::path::dirname(ctx.current_source->path), resolved);
-      return fs::read_file(full_path.c_str(), nullptr);
+      return fs::map_file(full_path.c_str(), nullptr,
+                          fs::MappedFile::Access::Sequential);
     } else {
       throw json::loader::Error::create(
           ctx, key, value[key],
@@ -3,12 +3,14 @@
 #include "json/Loader.hh"
 
 #include "core/Bitmask.hh"
+#include "core/Bytes.hh"
 #include "core/Enum.hh"
 #include "core/EnumMap.hh"
 #include "core/String.hh"
 
 #include <fmt/format.h>
 
+#include <algorithm>
 #include <cassert>
 
 namespace freeisle::json::loader {
@@ -124,34 +126,103 @@ core::Bitmask<T> load_bitmask(Context &ctx, Json::Value &value, const char *key,
  * Load a byte sequence from the given key in an object value. If the context
  * has a file reference, the content of the value in the JSON document is
  * expected to be a reference to a file with the binary content, otherwise it
- * is interpreted as base64-encoded binary data.
+ * is interpreted as base64-encoded binary data. Referenced files are mapped
+ * into memory rather than copied.
  */
-std::vector<uint8_t> load_binary(Context &ctx, Json::Value &value,
-                                 const char *key);
+core::SharedBytes load_binary(Context &ctx, Json::Value &value,
+                              const char *key);
+
+namespace detail {
 
 /**
- * Load an object from a JSON object. The given handler is responsible for
- * loading the fields of the object from the JSON object. This function handles
- * include references and keeps tracking the tree walking in the context.
+ * Implementation of load_object() and load_child(). If the context collects
+ * errors and collect is set, an error while loading the object is recorded
+ * in the context rather than thrown.
  */
 template <typename THandler>
 void load_object(Context &ctx, Json::Value &value, const char *key,
-                 THandler &handler) {
+                 THandler &handler, bool collect) {
   if (!value.isMember(key)) {
     throw Error::create(ctx, "", value,
                         fmt::format("Mandatory field \"{}\" is missing", key));
   }
 
-  if (!value[key].isObject()) {
-    throw Error::create(ctx, key, value[key],
-                        "Expected value to be of object type");
+  Json::Value &obj = value[key];
+  if (!obj.isObject()) {
+    throw Error::create(ctx, key, obj, "Expected value to be of object type");
   }
 
   const TreeDescent descent(ctx, key);
+  expand(ctx, obj);
+
+  if (!ctx.collect_errors || !collect) {
+    resolve_includes(ctx, obj);
+    handler.load(ctx, obj);
+    return;
+  }
 
-  resolve_includes(ctx, value[key]);
+  const bool collecting = ctx.collecting;
+  ctx.collecting = true;
 
-  handler.load(ctx, value[key]);
+  try {
+    resolve_includes(ctx, obj);
+    handler.load(ctx, obj);
+  } catch (const Error &ex) {
+    ctx.errors.push_back(ex);
+  } catch (...) {
+    ctx.collecting = collecting;
+    throw;
+  }
+
+  ctx.collecting = collecting;
+}
+
+} // namespace detail
+
+/**
+ * Load an object from a JSON object. The given handler is responsible for
+ * loading the fields of the object from the JSON object. This function handles
+ * include references and keeps tracking the tree walking in the context.
+ *
+ * If the context collects errors, an error while loading the object is
+ * recorded in the context and the object is left partially loaded, so that
+ * the caller can go on with the next object. This only applies to the
+ * outermost objects and to children of collections (see load_child()).
+ * Errors in objects nested in them, such as a field of object type, stop
+ * the enclosing object instead.
+ *
+ * If the object has not been parsed yet (see Context::deferred), it is
+ * parsed first.
+ */
+template <typename THandler>
+void load_object(Context &ctx, Json::Value &value, const char *key,
+                 THandler &handler) {
+  detail::load_object(ctx, value, key, handler, !ctx.collecting);
+}
+
+/**
+ * Load a child object of a collection like load_object(). If the context
+ * collects errors, an error while loading the child is always recorded, so
+ * that the remaining children are still checked.
+ *
+ * If the object had not been parsed yet (see Context::deferred), its
+ * members are dropped again once it is loaded, unless included files were
+ * merged into it, so that only one child object at a time is kept in
+ * memory. The object must therefore not be accessed afterwards other than
+ * through load_object() or load_child().
+ */
+template <typename THandler>
+void load_child(Context &ctx, Json::Value &value, const char *key,
+                THandler &handler) {
+  const bool deferred =
+      value.isMember(key) && ctx.deferred.count(&value[key]) != 0;
+  const size_t num_sources = ctx.sources.size();
+
+  detail::load_object(ctx, value, key, handler, true);
+
+  if (deferred && ctx.sources.size() == num_sources) {
+    collapse(ctx, value[key]);
+  }
 }
 
 /**
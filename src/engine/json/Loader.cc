@@ -1,7 +1,10 @@
 #include "json/Loader.hh"
+#include "json/IncludeCache.hh"
+#include "json/Parser.hh"
 
 #include "core/String.hh"
 #include "fs/File.hh"
+#include "fs/MappedFile.hh"
 #include "fs/Path.hh"
 
 #include <fmt/format.h>
@@ -13,21 +16,14 @@ namespace freeisle::json::loader {
 
 namespace {
 
-Json::Value read_json_document(const std::vector<uint8_t> &data) {
-  Json::Reader reader;
-  const char *begin = reinterpret_cast<const char *>(&data.data()[0]);
-  const char *end = begin + data.size();
-
-  Json::Value root;
-  if (!reader.parse(begin, end, root, false)) {
-    throw std::runtime_error(reader.getFormattedErrorMessages());
-  }
-
-  return root;
-}
+/**
+ * Depth below the root at which objects of the root document are deferred,
+ * see Context::deferred.
+ */
+constexpr uint32_t DeferDepth = 2;
 
 std::pair<Context, Json::Value>
-make_context(std::vector<uint8_t> data, const char *path, fs::FileId file_id) {
+make_context(core::SharedBytes data, const char *path, fs::FileId file_id) {
   std::vector<std::string> search_paths;
   if (path == nullptr) {
     path = "";
@@ -47,21 +43,32 @@ make_context(std::vector<uint8_t> data, const char *path, fs::FileId file_id) {
 
   Context ctx{
       .search_paths = search_paths,
-      .sources = {std::move(source)},
-      .current_location = "",
+      .current_location = TreePaths::Root,
   };
 
+  ctx.sources.push_back(std::move(source));
   ctx.current_source = &ctx.sources.back();
 
-  Json::Value root = read_json_document(ctx.sources.back().source_data);
-  return {std::move(ctx), root};
+  Json::Value root;
+  std::vector<Json::Value *> deferred;
+  try {
+    root = json::parse(ctx.current_source->source_data.data(),
+                       ctx.current_source->source_data.size(), DeferDepth,
+                       deferred);
+  } catch (const ParseError &ex) {
+    Json::Value location;
+    location.setOffsetStart(ex.offset());
+    throw Error::create(ctx, "", location, ex.message());
+  }
+
+  ctx.deferred.insert(deferred.begin(), deferred.end());
+  return {std::move(ctx), std::move(root)};
 }
 
 void extract_include_info(Context &ctx, const std::string &filename,
-                          const std::string &location,
-                          const Json::Value &value) {
+                          uint32_t location, Json::Value &value) {
   // might exist already if there was another include at a higher level:
-  IncludeInfo &info = ctx.include_map[location];
+  IncludeInfo &info = ctx.include_map[ctx.paths.render(location)];
 
   info.filename = filename;
   for (const std::string &member : value.getMemberNames()) {
@@ -73,8 +80,10 @@ void extract_include_info(Context &ctx, const std::string &filename,
 
     info.override_keys[member] = !value[member].isNull();
     if (value[member].isObject()) {
+      expand(ctx, value[member]);
       // filename is unset for higher levels:
-      extract_include_info(ctx, "", location + "." + member, value[member]);
+      extract_include_info(ctx, "", ctx.paths.child(location, member),
+                           value[member]);
     }
   }
 }
@@ -116,26 +125,9 @@ void merge_map(Json::Value &base, Json::Value &overlay,
   }
 }
 
-std::pair<uint32_t, uint32_t> get_line_info(const uint8_t *data, size_t len,
-                                            size_t offset) {
-  assert(offset < len);
-  uint32_t line = 0;
-  uint32_t col = 0;
-  for (const uint8_t *cur = data; cur != data + offset; ++cur) {
-    if (*cur == '\n') {
-      ++line;
-      col = 0;
-    } else {
-      ++col;
-    }
-  }
-
-  return {line + 1, col + 1};
-}
-
 const SourceInfo &get_source_for_key(const Context &ctx,
                                      const std::string &key) {
-  std::map<std::string, OriginInfo>::const_iterator iter =
+  std::unordered_map<uint32_t, OriginInfo>::const_iterator iter =
       ctx.origin_map.find(ctx.current_location);
   if (iter == ctx.origin_map.end()) {
     return *ctx.current_source;
@@ -154,6 +146,15 @@ const SourceInfo &get_source_for_key(const Context &ctx,
 
 } // namespace
 
+const LineIndex &line_index(const SourceInfo &source) {
+  if (!source.lines) {
+    source.lines = std::make_unique<const LineIndex>(
+        source.source_data.data(), source.source_data.size());
+  }
+
+  return *source.lines;
+}
+
 Error::Error(std::string formatted_message, std::string message,
              std::string path, uint32_t line, uint32_t col)
     : std::runtime_error(formatted_message), message_(std::move(message)),
@@ -162,8 +163,8 @@ Error::Error(std::string formatted_message, std::string message,
 Error Error::create(const Context &ctx, const std::string &key,
                     const Json::Value &val, std::string message) {
   const SourceInfo &info = get_source_for_key(ctx, key);
-  const std::pair<uint32_t, uint32_t> line_info = get_line_info(
-      info.source_data.data(), info.source_data.size(), val.getOffsetStart());
+  const std::pair<uint32_t, uint32_t> line_info =
+      line_index(info).position(val.getOffsetStart());
 
   std::string formatted_message;
   if (info.path.empty()) {
@@ -198,14 +199,12 @@ TreeSourceChange::~TreeSourceChange() { ctx_.current_source = &source_; }
 
 TreeLocationChange::TreeLocationChange(Context &ctx, const std::string &key)
     : ctx_(ctx), location_(ctx.current_location) {
-  ctx.current_location = location_ + "." + key;
+  ctx.current_location = ctx.paths.child(location_, key);
 }
 
 TreeLocationChange::~TreeLocationChange() {
-  assert(ctx_.current_location.rfind('.') != std::string::npos);
   assert(ctx_.current_location == location_ ||
-         ctx_.current_location.substr(0, ctx_.current_location.rfind('.')) ==
-             location_);
+         ctx_.paths.parent(ctx_.current_location) == location_);
 
   ctx_.current_location = location_;
 }
@@ -213,7 +212,50 @@ TreeLocationChange::~TreeLocationChange() {
 TreeDescent::TreeDescent(Context &ctx, const std::string &key)
     : source_(ctx, get_source_for_key(ctx, key)), location_(ctx, key) {}
 
+IncludeFile open_include(const std::vector<std::string> &search_paths,
+                         uint32_t level, const std::string &filename,
+                         std::vector<std::string> &tried_candidates) {
+  IncludeFile include{};
+  for (uint32_t i = level; i < search_paths.size(); ++i) {
+    std::string candidate_path = fs::path::join(search_paths[i], filename);
+
+    try {
+      include.file =
+          fs::File(candidate_path.c_str(), fs::File::OpenMode::Read, nullptr);
+      include.path = std::move(candidate_path);
+      include.level = i;
+      break;
+    } catch (const std::exception &ex) {
+      tried_candidates.push_back(candidate_path);
+    }
+  }
+
+  return include;
+}
+
+bool expand(Context &ctx, Json::Value &value) {
+  if (ctx.deferred.erase(&value) == 0) {
+    return false;
+  }
+
+  json::parse_deferred(ctx.sources.front().source_data.data(), value);
+  return true;
+}
+
+void collapse(Context &ctx, Json::Value &value) {
+  assert(value.isObject());
+
+  // clear() also resets the offsets, which parse_deferred() needs:
+  const ptrdiff_t begin = value.getOffsetStart();
+  const ptrdiff_t end = value.getOffsetLimit();
+  value.clear();
+  value.setOffsetStart(begin);
+  value.setOffsetLimit(end);
+  ctx.deferred.insert(&value);
+}
+
 void resolve_includes(Context &ctx, Json::Value &value) {
+  expand(ctx, value);
   if (!value.isMember("include")) {
     return;
   }
@@ -233,25 +275,12 @@ void resolve_includes(Context &ctx, Json::Value &value) {
   // TODO(armin): before going through search paths, try from
   // dirname(info->path)?
 
-  fs::File include_file;
   std::vector<std::string> tried_candidates;
-  std::string full_path;
-  uint32_t level;
-
-  for (uint32_t i = ctx.current_source->level; i < ctx.search_paths.size();
-       ++i) {
-    std::string candidate_path = fs::path::join(ctx.search_paths[i], filename);
-
-    try {
-      include_file =
-          fs::File(candidate_path.c_str(), fs::File::OpenMode::Read, nullptr);
-      full_path = std::move(candidate_path);
-      level = i;
-      break;
-    } catch (const std::exception &ex) {
-      tried_candidates.push_back(candidate_path);
-    }
-  }
+  IncludeFile include = open_include(
+      ctx.search_paths, ctx.current_source->level, filename, tried_candidates);
+  fs::File &include_file = include.file;
+  const std::string &full_path = include.path;
+  const uint32_t level = include.level;
 
   if (!include_file) {
     if (tried_candidates.empty()) {
@@ -267,21 +296,10 @@ void resolve_includes(Context &ctx, Json::Value &value) {
   }
 
   const fs::FileInfo file_info = include_file.info();
-  std::vector<uint8_t> source_data(file_info.size);
-  fs::read_all(include_file, source_data.data(), source_data.size());
-
-  SourceInfo source{
-      .filename = filename,
-      .path = full_path,
-      .id = file_info.id,
-      .level = level,
-      .origin = ctx.current_source,
-      .source_data = std::move(source_data),
-  };
 
-  for (const SourceInfo *cur = source.origin; cur != nullptr;
+  for (const SourceInfo *cur = ctx.current_source; cur != nullptr;
        cur = cur->origin) {
-    if (cur->id == source.id) {
+    if (cur->id == file_info.id) {
       // TODO(armin): show information on where the original include directive
       // was
       throw Error::create(ctx, "include", value["include"],
@@ -289,15 +307,27 @@ void resolve_includes(Context &ctx, Json::Value &value) {
     }
   }
 
-  Json::Value root;
+  std::shared_ptr<const IncludeCache::Document> document;
   try {
-    root = read_json_document(source.source_data);
-  } catch (const std::runtime_error &ex) {
+    document = IncludeCache::global().load(include_file, file_info);
+  } catch (const ParseError &ex) {
     std::string message = fmt::format(
         "Failed to parse JSON document at \"{}\": {}", full_path, ex.what());
     throw Error::create(ctx, "include", value["include"], std::move(message));
   }
 
+  // The cached document is shared, so merge a copy of it
+  Json::Value root = document->root;
+
+  SourceInfo source{
+      .filename = filename,
+      .path = full_path,
+      .id = file_info.id,
+      .level = level,
+      .origin = ctx.current_source,
+      .source_data = document->source_data,
+  };
+
   ctx.sources.push_back(std::move(source));
 
   value.removeMember("include");
@@ -315,14 +345,15 @@ void resolve_includes(Context &ctx, Json::Value &value) {
 
 std::pair<Context, Json::Value>
 make_root_source_context(std::vector<uint8_t> data, const char *path) {
-  return make_context(std::move(data), path, fs::FileId{});
+  return make_context(core::SharedBytes(std::move(data)), path, fs::FileId{});
 }
 
 std::pair<Context, Json::Value> make_root_file_context(const char *path) {
   fs::File file(path, fs::File::OpenMode::Read, nullptr);
 
-  std::vector<uint8_t> data(file.info().size);
-  fs::read_all(file, data.data(), data.size());
+  // The document is parsed in place from the mapped file:
+  core::SharedBytes data =
+      fs::map_file(file, fs::MappedFile::Access::Sequential);
 
   return make_context(std::move(data), path, file.info().id);
 };
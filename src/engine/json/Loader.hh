@@ -2,14 +2,21 @@
 
 #include <json/json.h>
 
+#include "core/Bytes.hh"
+#include "fs/File.hh"
 #include "fs/FileInfo.hh"
 #include "json/IncludeInfo.hh"
+#include "json/LineIndex.hh"
+#include "json/TreePaths.hh"
 
 #include <cstdint>
 #include <list>
 #include <map>
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 namespace freeisle::json::loader {
@@ -48,10 +55,23 @@ struct SourceInfo {
   /**
    * Source text. This is only used for looking up line/column information
    * for error messages which is unfortunately not available in the json::Value.
+   * It is immutable and can be shared with the include cache. For the root
+   * file, it is a mapping of the file rather than a copy.
    */
-  const std::vector<uint8_t> source_data;
+  const core::SharedBytes source_data;
+
+  /**
+   * Line index of source_data. It is built on the first error that needs
+   * a line number in this source, see line_index().
+   */
+  mutable std::unique_ptr<const LineIndex> lines;
 };
 
+/**
+ * Returns the line index of the given source, building it if needed.
+ */
+const LineIndex &line_index(const SourceInfo &source);
+
 /**
  * Information about the origin of an object node in the JSON document.
  */
@@ -70,6 +90,8 @@ struct OriginInfo {
   std::map<std::string, const SourceInfo *> included_from;
 };
 
+class Error;
+
 /**
  * Loading context. This is transient state used by the loader while loading
  * an object. Part of the context can be used/preserved and used by the saver
@@ -100,18 +122,22 @@ struct Context {
   const SourceInfo *current_source;
 
   /**
-   * Location in the object tree in the form ".a.b.c" where the object
+   * Locations in the object tree that have been visited so far.
+   */
+  TreePaths paths;
+
+  /**
+   * Node in paths for the location in the object tree where the object
    * currently being loaded is loaded from.
    */
-  std::string current_location;
+  uint32_t current_location;
 
   /**
-   * Mapping from paths in the object tree in the form of ".a.b.c" to
-   * the source information of where it was loaded from. If for a given
-   * tree path there is no entry in the include_map, then the path
-   * from the parent applies.
+   * Mapping from nodes in paths to the source information of where the
+   * corresponding object was loaded from. If for a given tree path there
+   * is no entry in the origin_map, then the path from the parent applies.
    */
-  std::map<std::string, OriginInfo> origin_map;
+  std::unordered_map<uint32_t, OriginInfo> origin_map;
 
   /**
    * Mapping from paths in the object tree in the form of ".a.b.c" to
@@ -119,6 +145,33 @@ struct Context {
    * main file wil get one entry in the include map.
    */
   std::map<std::string, IncludeInfo> include_map;
+
+  /**
+   * Objects in the tree of the root document that have not been parsed yet.
+   * To save building the whole tree up front, objects nested two levels
+   * below the root, such as each unit of a saved game, are left empty until
+   * they are loaded, and dropped again afterwards. See expand().
+   */
+  std::unordered_set<const Json::Value *> deferred;
+
+  /**
+   * If set, errors in an object loaded by load_object() are collected in
+   * errors instead of being thrown, and loading continues with the next
+   * object. See validate_root_object().
+   */
+  bool collect_errors = false;
+
+  /**
+   * Errors collected so far if collect_errors is set.
+   */
+  std::vector<Error> errors;
+
+  /**
+   * Set while an object whose errors are collected is being loaded. Errors
+   * in objects nested in it are not collected separately, but stop it, so
+   * that its handler does not go on with fields that failed to load.
+   */
+  bool collecting = false;
 };
 
 /**
@@ -219,7 +272,7 @@ public:
 
 private:
   Context &ctx_;
-  const std::string location_;
+  const uint32_t location_;
 };
 
 /**
@@ -241,6 +294,49 @@ private:
   const TreeLocationChange location_;
 };
 
+/**
+ * An include file opened by open_include().
+ */
+struct IncludeFile {
+  /**
+   * The opened file, or a closed file if it was not found.
+   */
+  fs::File file;
+
+  /**
+   * Full path of the file.
+   */
+  std::string path;
+
+  /**
+   * Level in the search path where the file was found.
+   */
+  uint32_t level;
+};
+
+/**
+ * Open the include file with the given (relative, normalized) filename.
+ * The search paths are tried in order, starting at the given level. Paths
+ * that were tried but not found are added to tried_candidates.
+ */
+IncludeFile open_include(const std::vector<std::string> &search_paths,
+                         uint32_t level, const std::string &filename,
+                         std::vector<std::string> &tried_candidates);
+
+/**
+ * Parse the members of the given object if it is one of the deferred
+ * objects of the root document, see Context::deferred. Returns whether it
+ * was.
+ */
+bool expand(Context &ctx, Json::Value &value);
+
+/**
+ * Drop the members of an object that was filled in by expand() again, to
+ * free them once the object has been loaded. If the object is needed once
+ * more, expand() parses it again.
+ */
+void collapse(Context &ctx, Json::Value &value);
+
 /**
  * Resolves include references in the given JSON object, i.e. if the
  * given JSON object has a key named "include", it opens the corresponding
@@ -255,12 +351,30 @@ private:
  */
 void resolve_includes(Context &ctx, Json::Value &value);
 
+/**
+ * Load all files that are included from the given document, directly or
+ * indirectly, into the include cache, using the given number of worker
+ * threads. The document is the root document of the given context.
+ *
+ * This only warms the IncludeCache: the include graph is discovered by
+ * scanning each parsed document for include references, and independent
+ * files are opened, read and parsed concurrently. The includes are still
+ * merged afterwards by resolve_includes, in document order, so the result,
+ * the override semantics and cycle detection are the same as without
+ * prefetching. Files that cannot be found or parsed are skipped here; the
+ * error is reported when resolve_includes gets to them.
+ */
+void prefetch_includes(const Context &ctx, uint32_t num_threads);
+
 /**
  * Create a new loading context with the given data. If path is not null,
  * include references are resolved relative to it, otherwise the context will
  * not be able to resolve any include references.
  *
  * Use load_object subsequently to use the context to load an object.
+ * Parts of the returned tree are only parsed as they are loaded, see
+ * Context::deferred, so the tree must be loaded in place rather than from
+ * a copy.
  */
 std::pair<Context, Json::Value>
 make_root_source_context(std::vector<uint8_t> data, const char *path);
@@ -269,7 +383,8 @@ make_root_source_context(std::vector<uint8_t> data, const char *path);
  * Create a new loading context from a given root path on the filesystem.
  * The JSON document at this location will be parsed and returned together
  * with the context. If objects aro loaded from this JSON object, then
- * include references will be resolved relative to this root path.
+ * include references will be resolved relative to this root path. As with
+ * make_root_source_context(), the tree must be loaded in place.
  */
 std::pair<Context, Json::Value> make_root_file_context(const char *path);
 
@@ -291,14 +406,59 @@ std::map<std::string, IncludeInfo> load_root_object(std::vector<uint8_t> data,
  * Main entry point to the loader for loading a file-backed JSON
  * representation. Include references are resolved relative to the
  * file path.
+ *
+ * If prefetch_threads is not zero, all included files are first read and
+ * parsed concurrently with that many threads (see prefetch_includes),
+ * which speeds up loading documents with many includes from a cold cache.
+ * The result is the same either way.
  */
 template <typename THandler>
-std::map<std::string, IncludeInfo> load_root_object(const char *path,
-                                                    THandler &handler) {
+std::map<std::string, IncludeInfo>
+load_root_object(const char *path, THandler &handler,
+                 uint32_t prefetch_threads = 0) {
   std::pair<Context, Json::Value> pair = make_root_file_context(path);
+  prefetch_includes(pair.first, prefetch_threads);
   resolve_includes(pair.first, pair.second);
   handler.load(pair.first, pair.second);
   return std::move(pair.first.include_map);
 }
 
+/**
+ * Check a file-backed JSON document with the given handler, and return all
+ * errors found instead of stopping at the first one. Each object that is
+ * loaded with load_object() is checked on its own, so an error in one
+ * object does not prevent the remaining objects from being checked. Errors
+ * that cannot be recovered from, such as a syntax error in the root
+ * document or an error in the root object itself, end the check early but
+ * are still returned along with the errors found before.
+ *
+ * Objects loaded by the handler are in an unspecified state if any errors
+ * are returned. Errors that follow from an earlier one, for example a
+ * reference to an object that failed to load, may also be reported.
+ */
+template <typename THandler>
+std::vector<Error> validate_root_object(const char *path, THandler &handler,
+                                        uint32_t prefetch_threads = 0) {
+  std::vector<Error> errors;
+
+  try {
+    std::pair<Context, Json::Value> pair = make_root_file_context(path);
+    pair.first.collect_errors = true;
+
+    try {
+      prefetch_includes(pair.first, prefetch_threads);
+      resolve_includes(pair.first, pair.second);
+      handler.load(pair.first, pair.second);
+    } catch (const Error &ex) {
+      pair.first.errors.push_back(ex);
+    }
+
+    errors = std::move(pair.first.errors);
+  } catch (const Error &ex) {
+    errors.push_back(ex);
+  }
+
+  return errors;
+}
+
 } // namespace freeisle::json::loader
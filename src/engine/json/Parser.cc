@@ -0,0 +1,564 @@
+#include "json/Parser.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cstring>
+#include <limits>
+
+namespace freeisle::json {
+
+namespace {
+
+bool is_digit(uint8_t c) { return c >= '0' && c <= '9'; }
+
+void append_utf8(std::string &str, uint32_t cp) {
+  if (cp < 0x80) {
+    str.push_back(static_cast<char>(cp));
+  } else if (cp < 0x800) {
+    str.push_back(static_cast<char>(0xc0 | (cp >> 6)));
+    str.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else if (cp < 0x10000) {
+    str.push_back(static_cast<char>(0xe0 | (cp >> 12)));
+    str.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    str.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  } else {
+    str.push_back(static_cast<char>(0xf0 | (cp >> 18)));
+    str.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3f)));
+    str.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3f)));
+    str.push_back(static_cast<char>(0x80 | (cp & 0x3f)));
+  }
+}
+
+/**
+ * Removes the deferred objects within value from the list, as value is about
+ * to be replaced by a repeated key. Nested values lie within the offsets of
+ * their parent.
+ */
+void drop_deferred(const Json::Value &value,
+                   std::vector<Json::Value *> &deferred) {
+  deferred.erase(std::remove_if(deferred.begin(), deferred.end(),
+                                [&value](const Json::Value *child) {
+                                  return child->getOffsetStart() >=
+                                             value.getOffsetStart() &&
+                                         child->getOffsetLimit() <=
+                                             value.getOffsetLimit();
+                                }),
+                 deferred.end());
+}
+
+/**
+ * Parse the value whose first event is given into value. If deferred is
+ * not null, objects depth levels further down are skipped and added to it.
+ */
+void parse_value(Parser &parser, Parser::Event event, Json::Value &value,
+                 uint32_t depth = 0,
+                 std::vector<Json::Value *> *deferred = nullptr) {
+  const size_t begin = parser.offset();
+
+  switch (event) {
+  case Parser::Event::BeginObject:
+    value = Json::Value(Json::objectValue);
+    if (deferred != nullptr && depth == 0) {
+      parser.skip();
+      deferred->push_back(&value);
+      break;
+    }
+
+    while ((event = parser.next()) == Parser::Event::Key) {
+      // Same as Json::Reader, the last of repeated keys wins:
+      if (deferred != nullptr && value.isMember(parser.string())) {
+        drop_deferred(value[parser.string()], *deferred);
+      }
+
+      Json::Value &child = value[parser.string()];
+      parse_value(parser, parser.next(), child, depth - 1, deferred);
+    }
+    assert(event == Parser::Event::EndObject);
+    break;
+  case Parser::Event::BeginArray:
+    value = Json::Value(Json::arrayValue);
+    while ((event = parser.next()) != Parser::Event::EndArray) {
+      // Array elements are moved into place, so they are never deferred:
+      Json::Value child;
+      parse_value(parser, event, child);
+      value.append(std::move(child));
+    }
+    break;
+  case Parser::Event::String:
+    value = Json::Value(parser.take_string());
+    break;
+  case Parser::Event::Int:
+    value = Json::Value(static_cast<Json::Int64>(parser.int_value()));
+    break;
+  case Parser::Event::UInt:
+    // Same types as Json::Reader: small values are signed.
+    if (parser.uint_value() <=
+        static_cast<uint64_t>(std::numeric_limits<Json::Int>::max())) {
+      value = Json::Value(static_cast<Json::Int64>(parser.uint_value()));
+    } else {
+      value = Json::Value(static_cast<Json::UInt64>(parser.uint_value()));
+    }
+    break;
+  case Parser::Event::Real:
+    value = Json::Value(parser.real_value());
+    break;
+  case Parser::Event::Bool:
+    value = Json::Value(parser.bool_value());
+    break;
+  case Parser::Event::Null:
+    value = Json::Value();
+    break;
+  default:
+    assert(false);
+    break;
+  }
+
+  value.setOffsetStart(begin);
+  value.setOffsetLimit(parser.end_offset());
+}
+
+} // namespace
+
+ParseError::ParseError(std::string message, size_t offset, uint32_t line,
+                       uint32_t col)
+    : std::runtime_error(fmt::format("line {}, column {}: {}", line, col,
+                                     message)),
+      message_(std::move(message)), offset_(offset), line_(line), col_(col) {}
+
+const std::string &ParseError::message() const { return message_; }
+
+size_t ParseError::offset() const { return offset_; }
+
+uint32_t ParseError::line() const { return line_; }
+
+uint32_t ParseError::col() const { return col_; }
+
+Parser::Parser(const uint8_t *data, size_t len, size_t begin)
+    : data_(data), len_(len), pos_(begin), state_(State::Value),
+      last_(Event::End), token_begin_(begin), token_end_(begin), int_(0),
+      uint_(0), real_(0.0), bool_(false) {
+  assert(begin <= len);
+}
+
+Parser::Event Parser::next() {
+  last_ = read_event();
+  return last_;
+}
+
+void Parser::skip() {
+  if (last_ != Event::BeginObject && last_ != Event::BeginArray) {
+    return;
+  }
+
+  const size_t depth = stack_.size();
+  while (stack_.size() >= depth) {
+    next();
+  }
+}
+
+void Parser::fail(const std::string &message, size_t offset) const {
+  uint32_t line = 1;
+  uint32_t col = 1;
+  for (size_t i = 0; i < offset; ++i) {
+    if (data_[i] == '\n') {
+      ++line;
+      col = 1;
+    } else {
+      ++col;
+    }
+  }
+
+  throw ParseError(message, offset, line, col);
+}
+
+void Parser::skip_whitespace() {
+  while (pos_ < len_) {
+    const uint8_t c = data_[pos_];
+    if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+      ++pos_;
+    } else if (c == '/' && pos_ + 1 < len_ && data_[pos_ + 1] == '/') {
+      while (pos_ < len_ && data_[pos_] != '\n') {
+        ++pos_;
+      }
+    } else if (c == '/' && pos_ + 1 < len_ && data_[pos_ + 1] == '*') {
+      const size_t begin = pos_;
+      pos_ += 2;
+      while (pos_ + 1 < len_ &&
+             !(data_[pos_] == '*' && data_[pos_ + 1] == '/')) {
+        ++pos_;
+      }
+
+      if (pos_ + 1 >= len_) {
+        fail("Unterminated comment", begin);
+      }
+
+      pos_ += 2;
+    } else {
+      break;
+    }
+  }
+}
+
+Parser::Event Parser::read_event() {
+  skip_whitespace();
+
+  switch (state_) {
+  case State::Value:
+    return read_value();
+  case State::FirstKey:
+    if (pos_ < len_ && data_[pos_] == '}') {
+      return read_end(Event::EndObject);
+    }
+    return read_key();
+  case State::NextMember:
+    if (pos_ < len_ && data_[pos_] == '}') {
+      return read_end(Event::EndObject);
+    }
+    if (pos_ == len_ || data_[pos_] != ',') {
+      fail("Missing ',' or '}' in object declaration", pos_);
+    }
+    ++pos_;
+    skip_whitespace();
+    return read_key();
+  case State::FirstElement:
+    if (pos_ < len_ && data_[pos_] == ']') {
+      return read_end(Event::EndArray);
+    }
+    return read_value();
+  case State::NextElement:
+    if (pos_ < len_ && data_[pos_] == ']') {
+      return read_end(Event::EndArray);
+    }
+    if (pos_ == len_ || data_[pos_] != ',') {
+      fail("Missing ',' or ']' in array declaration", pos_);
+    }
+    ++pos_;
+    skip_whitespace();
+    return read_value();
+  case State::Done:
+    if (pos_ != len_) {
+      fail("Extra characters after the end of the document", pos_);
+    }
+    token_begin_ = token_end_ = pos_;
+    return Event::End;
+  }
+
+  assert(false);
+  return Event::End;
+}
+
+Parser::Event Parser::read_key() {
+  if (pos_ == len_ || data_[pos_] != '"') {
+    fail("Missing '}' or object member name", pos_);
+  }
+
+  read_string();
+
+  skip_whitespace();
+  if (pos_ == len_ || data_[pos_] != ':') {
+    fail("Missing ':' after object member name", pos_);
+  }
+
+  ++pos_;
+  state_ = State::Value;
+  return Event::Key;
+}
+
+Parser::Event Parser::read_value() {
+  if (pos_ == len_) {
+    fail("Unexpected end of document", pos_);
+  }
+
+  token_begin_ = pos_;
+
+  switch (data_[pos_]) {
+  case '{':
+  case '[': {
+    if (stack_.size() == MaxDepth) {
+      fail(fmt::format("Exceeded maximum nesting depth of {}", MaxDepth),
+           pos_);
+    }
+
+    const bool is_object = data_[pos_] == '{';
+    ++pos_;
+    token_end_ = pos_;
+    stack_.push_back(is_object);
+    state_ = is_object ? State::FirstKey : State::FirstElement;
+    return is_object ? Event::BeginObject : Event::BeginArray;
+  }
+  case '"':
+    read_string();
+    return end_value(Event::String);
+  case 't':
+    expect_literal("true");
+    bool_ = true;
+    return end_value(Event::Bool);
+  case 'f':
+    expect_literal("false");
+    bool_ = false;
+    return end_value(Event::Bool);
+  case 'n':
+    expect_literal("null");
+    return end_value(Event::Null);
+  default:
+    if (data_[pos_] == '-' || is_digit(data_[pos_])) {
+      return end_value(read_number());
+    }
+
+    fail("Syntax error: value, object or array expected", pos_);
+  }
+}
+
+Parser::Event Parser::read_end(Event event) {
+  token_begin_ = pos_;
+  ++pos_;
+  token_end_ = pos_;
+  stack_.pop_back();
+  return end_value(event);
+}
+
+Parser::Event Parser::end_value(Event event) {
+  if (stack_.empty()) {
+    state_ = State::Done;
+  } else {
+    state_ = stack_.back() ? State::NextMember : State::NextElement;
+  }
+
+  return event;
+}
+
+void Parser::read_string() {
+  token_begin_ = pos_;
+  ++pos_;
+  string_.clear();
+
+  for (;;) {
+    const size_t begin = pos_;
+    while (pos_ < len_ && data_[pos_] != '"' && data_[pos_] != '\\') {
+      ++pos_;
+    }
+
+    string_.append(reinterpret_cast<const char *>(data_ + begin), pos_ - begin);
+
+    if (pos_ == len_) {
+      fail("Missing '\"' at the end of the string", token_begin_);
+    }
+
+    if (data_[pos_] == '"') {
+      ++pos_;
+      break;
+    }
+
+    const size_t escape = pos_;
+    if (++pos_ == len_) {
+      fail("Missing '\"' at the end of the string", token_begin_);
+    }
+
+    switch (data_[pos_++]) {
+    case '"':
+      string_.push_back('"');
+      break;
+    case '\\':
+      string_.push_back('\\');
+      break;
+    case '/':
+      string_.push_back('/');
+      break;
+    case 'b':
+      string_.push_back('\b');
+      break;
+    case 'f':
+      string_.push_back('\f');
+      break;
+    case 'n':
+      string_.push_back('\n');
+      break;
+    case 'r':
+      string_.push_back('\r');
+      break;
+    case 't':
+      string_.push_back('\t');
+      break;
+    case 'u': {
+      uint32_t cp = read_hex4();
+      if (cp >= 0xd800 && cp < 0xdc00) {
+        if (pos_ + 1 >= len_ || data_[pos_] != '\\' || data_[pos_ + 1] != 'u') {
+          fail("Missing low surrogate in unicode escape", escape);
+        }
+
+        pos_ += 2;
+        const uint32_t low = read_hex4();
+        if (low < 0xdc00 || low >= 0xe000) {
+          fail("Invalid low surrogate in unicode escape", escape);
+        }
+
+        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+      } else if (cp >= 0xdc00 && cp < 0xe000) {
+        fail("Unexpected low surrogate in unicode escape", escape);
+      }
+
+      append_utf8(string_, cp);
+      break;
+    }
+    default:
+      fail("Bad escape sequence in string", escape);
+    }
+  }
+
+  token_end_ = pos_;
+}
+
+Parser::Event Parser::read_number() {
+  const size_t begin = pos_;
+  const bool negative = data_[pos_] == '-';
+  if (negative) {
+    ++pos_;
+  }
+
+  if (pos_ == len_ || !is_digit(data_[pos_])) {
+    fail("Invalid number", begin);
+  }
+
+  uint64_t magnitude = 0;
+  bool overflow = false;
+  if (data_[pos_] == '0') {
+    ++pos_;
+  } else {
+    while (pos_ < len_ && is_digit(data_[pos_])) {
+      const uint64_t digit = data_[pos_] - '0';
+      if (magnitude > (std::numeric_limits<uint64_t>::max() - digit) / 10) {
+        overflow = true;
+      }
+      magnitude = magnitude * 10 + digit;
+      ++pos_;
+    }
+  }
+
+  bool is_real = overflow;
+  if (pos_ < len_ && data_[pos_] == '.') {
+    is_real = true;
+    ++pos_;
+    if (pos_ == len_ || !is_digit(data_[pos_])) {
+      fail("Invalid number", begin);
+    }
+    while (pos_ < len_ && is_digit(data_[pos_])) {
+      ++pos_;
+    }
+  }
+
+  if (pos_ < len_ && (data_[pos_] == 'e' || data_[pos_] == 'E')) {
+    is_real = true;
+    ++pos_;
+    if (pos_ < len_ && (data_[pos_] == '+' || data_[pos_] == '-')) {
+      ++pos_;
+    }
+    if (pos_ == len_ || !is_digit(data_[pos_])) {
+      fail("Invalid number", begin);
+    }
+    while (pos_ < len_ && is_digit(data_[pos_])) {
+      ++pos_;
+    }
+  }
+
+  token_end_ = pos_;
+
+  constexpr uint64_t MinIntMagnitude =
+      static_cast<uint64_t>(std::numeric_limits<int64_t>::max()) + 1;
+  if (negative && !is_real && magnitude > MinIntMagnitude) {
+    is_real = true;
+  }
+
+  if (is_real) {
+    const char *first = reinterpret_cast<const char *>(data_ + begin);
+    const char *last = reinterpret_cast<const char *>(data_ + pos_);
+    const std::from_chars_result result = std::from_chars(first, last, real_);
+    if (result.ec == std::errc::invalid_argument || result.ptr != last) {
+      fail("Invalid number", begin);
+    }
+
+    // Out of range values saturate to infinity, like strtod does.
+    if (result.ec == std::errc::result_out_of_range) {
+      real_ = negative ? -std::numeric_limits<double>::infinity()
+                       : std::numeric_limits<double>::infinity();
+    }
+
+    return Event::Real;
+  }
+
+  if (negative) {
+    int_ = magnitude == MinIntMagnitude ? std::numeric_limits<int64_t>::min()
+                                        : -static_cast<int64_t>(magnitude);
+    return Event::Int;
+  }
+
+  uint_ = magnitude;
+  return Event::UInt;
+}
+
+void Parser::expect_literal(const char *literal) {
+  const size_t len = std::strlen(literal);
+  if (len_ - pos_ < len || std::memcmp(data_ + pos_, literal, len) != 0) {
+    fail("Syntax error: value, object or array expected", pos_);
+  }
+
+  pos_ += len;
+  token_end_ = pos_;
+}
+
+uint32_t Parser::read_hex4() {
+  if (len_ - pos_ < 4) {
+    fail("Bad unicode escape sequence in string", pos_);
+  }
+
+  uint32_t cp = 0;
+  for (uint32_t i = 0; i < 4; ++i) {
+    const uint8_t c = data_[pos_++];
+    cp <<= 4;
+    if (c >= '0' && c <= '9') {
+      cp |= c - '0';
+    } else if (c >= 'a' && c <= 'f') {
+      cp |= c - 'a' + 10;
+    } else if (c >= 'A' && c <= 'F') {
+      cp |= c - 'A' + 10;
+    } else {
+      fail("Bad unicode escape sequence in string", pos_ - 1);
+    }
+  }
+
+  return cp;
+}
+
+Json::Value parse(const uint8_t *data, size_t len) {
+  Parser parser(data, len);
+
+  Json::Value root;
+  parse_value(parser, parser.next(), root);
+
+  // Check for trailing characters
+  parser.next();
+  return root;
+}
+
+Json::Value parse(const uint8_t *data, size_t len, uint32_t depth,
+                  std::vector<Json::Value *> &deferred) {
+  assert(depth > 0);
+  Parser parser(data, len);
+
+  Json::Value root;
+  parse_value(parser, parser.next(), root, depth, &deferred);
+
+  // Check for trailing characters
+  parser.next();
+  return root;
+}
+
+void parse_deferred(const uint8_t *data, Json::Value &value) {
+  assert(value.isObject() && value.empty());
+  Parser parser(data, value.getOffsetLimit(), value.getOffsetStart());
+  parse_value(parser, parser.next(), value);
+}
+
+} // namespace freeisle::json
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <json/json.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace freeisle::json {
+
+/**
+ * An exception class for syntax errors in a JSON document.
+ */
+class ParseError : public std::runtime_error {
+public:
+  /**
+   * @param message A human-readable error message.
+   * @param offset Byte offset in the document where the error occurred.
+   * @param line Line in the document where the error occurred.
+   * @param col Column in the document where the error occurred.
+   */
+  ParseError(std::string message, size_t offset, uint32_t line, uint32_t col);
+
+  /**
+   * Returns the text of the error message, without position information.
+   */
+  const std::string &message() const;
+
+  /**
+   * Returns the byte offset in the document where the error occurred.
+   */
+  size_t offset() const;
+
+  /**
+   * Returns the line in the document where the error occurred.
+   */
+  uint32_t line() const;
+
+  /**
+   * Returns the column in the document where the error occurred.
+   */
+  uint32_t col() const;
+
+private:
+  const std::string message_;
+  const size_t offset_;
+  const uint32_t line_;
+  const uint32_t col_;
+};
+
+/**
+ * A pull parser for JSON documents. Instead of building a tree of the
+ * whole document, it reports one event at a time, such as the beginning
+ * of an object, a key, or a primitive value, as next() is called. The
+ * caller decides what to do with each event, so that values which are not
+ * needed can be skipped without allocating anything for them.
+ *
+ * The parser works on a buffer that must stay alive while the parser is
+ * in use. Besides standard JSON it accepts C and C++ style comments, like
+ * jsoncpp does. Syntax errors are reported by throwing ParseError.
+ */
+class Parser {
+public:
+  enum class Event {
+    BeginObject,
+    EndObject,
+    BeginArray,
+    EndArray,
+    Key,
+    String,
+    Int,
+    UInt,
+    Real,
+    Bool,
+    Null,
+    End,
+  };
+
+  /**
+   * Maximum nesting depth of objects and arrays.
+   */
+  static constexpr size_t MaxDepth = 1000;
+
+  /**
+   * @param data The buffer with the document.
+   * @param len Length of the buffer.
+   * @param begin Offset in the buffer where parsing starts. The part of the
+   *              buffer from there on must hold a single value. Offsets
+   *              reported by the parser are still relative to data.
+   */
+  Parser(const uint8_t *data, size_t len, size_t begin = 0);
+
+  Parser(const Parser &) = delete;
+  Parser(Parser &&) = default;
+  Parser &operator=(const Parser &) = delete;
+  Parser &operator=(Parser &&) = default;
+
+  /**
+   * Advance to the next event. After the end of the document has been
+   * reached, this keeps returning Event::End.
+   */
+  Event next();
+
+  /**
+   * Skip the value whose first event was returned by the last call to
+   * next(). For primitive values this does nothing; for objects and arrays
+   * it consumes all events up to and including the matching end event.
+   */
+  void skip();
+
+  /**
+   * Byte offset of the first character of the current token.
+   */
+  size_t offset() const { return token_begin_; }
+
+  /**
+   * Byte offset one past the last character of the current token. For
+   * Event::EndObject and Event::EndArray, this is one past the closing
+   * bracket.
+   */
+  size_t end_offset() const { return token_end_; }
+
+  /**
+   * Decoded text of the current Event::Key or Event::String. The string is
+   * reused for the next token; use take_string() to take ownership.
+   */
+  const std::string &string() const { return string_; }
+  std::string take_string() { return std::move(string_); }
+
+  /**
+   * Value of the current Event::Int, Event::UInt, Event::Real or
+   * Event::Bool.
+   */
+  int64_t int_value() const { return int_; }
+  uint64_t uint_value() const { return uint_; }
+  double real_value() const { return real_; }
+  bool bool_value() const { return bool_; }
+
+private:
+  enum class State : uint8_t {
+    Value,
+    FirstKey,
+    NextMember,
+    FirstElement,
+    NextElement,
+    Done,
+  };
+
+  [[noreturn]] void fail(const std::string &message, size_t offset) const;
+
+  void skip_whitespace();
+  Event read_event();
+  Event read_key();
+  Event read_value();
+  Event read_end(Event event);
+  Event end_value(Event event);
+  void read_string();
+  Event read_number();
+  void expect_literal(const char *literal);
+  uint32_t read_hex4();
+
+  const uint8_t *data_;
+  size_t len_;
+  size_t pos_;
+
+  /**
+   * Open containers, true for objects and false for arrays.
+   */
+  std::vector<bool> stack_;
+  State state_;
+  Event last_;
+
+  size_t token_begin_;
+  size_t token_end_;
+
+  std::string string_;
+  int64_t int_;
+  uint64_t uint_;
+  double real_;
+  bool bool_;
+};
+
+/**
+ * Parse a whole JSON document into a Json::Value, using Parser. The values
+ * in the tree have their offsets set, so that error messages can refer to
+ * locations in the document.
+ */
+Json::Value parse(const uint8_t *data, size_t len);
+
+/**
+ * Parse a whole JSON document like parse(), except that objects nested
+ * depth levels below the root are only checked for syntax errors. They
+ * are left empty in the tree, with their offsets still set to where they
+ * are in the document, and pointers to them are added to deferred, so that
+ * they can be filled in later with parse_deferred(). Only members of
+ * objects are deferred, not elements of arrays, and depth must be at least
+ * one, so that the pointers stay valid while the tree is moved around.
+ */
+Json::Value parse(const uint8_t *data, size_t len, uint32_t depth,
+                  std::vector<Json::Value *> &deferred);
+
+/**
+ * Parse the members of an object that was deferred by parse() into it.
+ * The data must be the same document that it was deferred from.
+ */
+void parse_deferred(const uint8_t *data, Json::Value &value);
+
+} // namespace freeisle::json
@@ -0,0 +1,181 @@
+#include "json/IncludeCache.hh"
+#include "json/Loader.hh"
+#include "json/Parser.hh"
+
+#include "fs/Path.hh"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <set>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace freeisle::json::loader {
+
+namespace {
+
+/**
+ * An include reference that still needs to be loaded: the normalized
+ * filename, and the search path level of the including file.
+ */
+using Task = std::pair<std::string, uint32_t>;
+
+class Prefetcher {
+public:
+  explicit Prefetcher(const std::vector<std::string> &search_paths)
+      : search_paths_(search_paths), active_(0) {}
+
+  /**
+   * Queue all include references in the given document.
+   */
+  void scan(const Json::Value &value, uint32_t level) {
+    if (!value.isObject()) {
+      return;
+    }
+
+    const Json::Value *include = value.find("include", "include" + 7);
+    if (include != nullptr && include->isString()) {
+      add(include->asString(), level);
+    }
+
+    for (Json::Value::const_iterator iter = value.begin();
+         iter != value.end(); ++iter) {
+      scan(*iter, level);
+    }
+  }
+
+  /**
+   * Queue all include references in the given document text. Unlike the
+   * tree of the root document, this also covers objects that have not been
+   * parsed yet, see Context::deferred.
+   */
+  void scan(const core::SharedBytes &data, uint32_t level) {
+    Parser parser(data.data(), data.size());
+    Parser::Event event;
+    while ((event = parser.next()) != Parser::Event::End) {
+      if (event == Parser::Event::Key && parser.string() == "include" &&
+          parser.next() == Parser::Event::String) {
+        add(parser.string(), level);
+      }
+    }
+  }
+
+  /**
+   * Process queued tasks until there are none left and no other worker
+   * can add new ones. Does not throw, so that the other workers are never
+   * left waiting for a task that is still counted as active.
+   */
+  void work() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+      cond_.wait(lock, [this] { return !queue_.empty() || active_ == 0; });
+      if (queue_.empty()) {
+        return;
+      }
+
+      const Task task = std::move(queue_.front());
+      queue_.pop_front();
+      ++active_;
+
+      lock.unlock();
+      try {
+        run(task);
+      } catch (const std::exception &ex) {
+        // Prefetching is best effort: the actual load reports the error.
+      }
+      lock.lock();
+
+      --active_;
+      if (active_ == 0 && queue_.empty()) {
+        cond_.notify_all();
+      }
+    }
+  }
+
+private:
+  void add(const std::string &name, uint32_t level) {
+    if (fs::path::is_absolute(name)) {
+      return;
+    }
+
+    std::string filename;
+    try {
+      filename = fs::path::resolve(name);
+    } catch (const std::invalid_argument &ex) {
+      return;
+    }
+
+    const std::lock_guard<std::mutex> lock(mutex_);
+    Task task(std::move(filename), level);
+    if (seen_.insert(task).second) {
+      queue_.push_back(std::move(task));
+      cond_.notify_one();
+    }
+  }
+
+  void run(const Task &task) {
+    std::vector<std::string> tried_candidates;
+    IncludeFile include = open_include(search_paths_, task.second, task.first,
+                                       tried_candidates);
+    if (!include.file) {
+      return;
+    }
+
+    std::shared_ptr<const IncludeCache::Document> document;
+    try {
+      document =
+          IncludeCache::global().load(include.file, include.file.info());
+    } catch (const std::exception &ex) {
+      return;
+    }
+
+    // Cyclic includes terminate because every task is only run once.
+    scan(document->root, include.level);
+  }
+
+  const std::vector<std::string> &search_paths_;
+
+  std::mutex mutex_;
+  std::condition_variable cond_;
+  std::deque<Task> queue_;
+  std::set<Task> seen_;
+
+  /**
+   * Number of tasks currently being run by a worker.
+   */
+  uint32_t active_;
+};
+
+} // namespace
+
+void prefetch_includes(const Context &ctx, uint32_t num_threads) {
+  if (ctx.search_paths.empty() || num_threads == 0) {
+    return;
+  }
+
+  Prefetcher prefetcher(ctx.search_paths);
+  prefetcher.scan(ctx.current_source->source_data,
+                  ctx.current_source->level);
+
+  std::vector<std::thread> threads;
+  try {
+    for (uint32_t i = 1; i < num_threads; ++i) {
+      threads.emplace_back([&prefetcher] { prefetcher.work(); });
+    }
+  } catch (const std::system_error &ex) {
+    // Out of threads: the ones started so far and the calling thread share
+    // the work.
+  }
+
+  prefetcher.work();
+
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+}
+
+} // namespace freeisle::json::loader
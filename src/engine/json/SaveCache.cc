@@ -0,0 +1,181 @@
+#include "json/SaveCache.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <stdexcept>
+
+namespace freeisle::json::saver {
+
+namespace {
+
+constexpr uint64_t Multiplier = 0x9e3779b97f4a7c15ull;
+
+uint64_t mix(uint64_t x) {
+  x ^= x >> 31;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 29;
+  return x;
+}
+
+uint64_t rotl(uint64_t x, uint32_t n) { return (x << n) | (x >> (64 - n)); }
+
+/**
+ * Returns the info of the file at the given path, or nothing if it does
+ * not exist or cannot be opened.
+ */
+std::optional<fs::FileInfo> stat(const std::string &path) {
+  try {
+    const fs::File file(path.c_str(),
+                        core::Bitmask<fs::File::OpenMode>(
+                            fs::File::OpenMode::Read),
+                        nullptr);
+    return file.info();
+  } catch (const std::runtime_error &) {
+    return std::nullopt;
+  }
+}
+
+} // namespace
+
+SaveCache::Hasher::Hasher()
+    : state_(Multiplier), length_(0), tail_{}, tail_length_(0) {}
+
+void SaveCache::Hasher::update(const uint8_t *data, size_t len) {
+  // Processes 8 bytes at a time; this only needs to detect changes, not
+  // resist attacks.
+  if (len == 0) {
+    return;
+  }
+
+  length_ += len;
+
+  if (tail_length_ > 0) {
+    const size_t fill = std::min(len, sizeof(tail_) - tail_length_);
+    std::memcpy(tail_ + tail_length_, data, fill);
+    tail_length_ += fill;
+    data += fill;
+    len -= fill;
+    if (tail_length_ < sizeof(tail_)) {
+      return;
+    }
+
+    uint64_t word;
+    std::memcpy(&word, tail_, 8);
+    state_ = rotl((state_ ^ mix(word)) * Multiplier, 27);
+    tail_length_ = 0;
+  }
+
+  size_t i = 0;
+  for (; i + 8 <= len; i += 8) {
+    uint64_t word;
+    std::memcpy(&word, data + i, 8);
+    state_ = rotl((state_ ^ mix(word)) * Multiplier, 27);
+  }
+
+  std::memcpy(tail_, data + i, len - i);
+  tail_length_ = len - i;
+}
+
+uint64_t SaveCache::Hasher::digest() const {
+  uint64_t h = state_;
+  if (tail_length_ > 0) {
+    uint64_t word = 0;
+    std::memcpy(&word, tail_, tail_length_);
+    h = rotl((h ^ mix(word)) * Multiplier, 27);
+  }
+
+  return mix(h ^ length_ * Multiplier);
+}
+
+SaveCache::SaveCache() : written_(0), skipped_(0) {}
+
+uint64_t SaveCache::hash(const uint8_t *data, size_t len) {
+  Hasher hasher;
+  hasher.update(data, len);
+  return hasher.digest();
+}
+
+bool SaveCache::is_current(const std::string &path, uint64_t version) const {
+  const std::map<std::string, Entry>::const_iterator iter =
+      entries_.find(path);
+  if (iter == entries_.end() || iter->second.version != version) {
+    return false;
+  }
+
+  const std::optional<fs::FileInfo> info = stat(path);
+  return info && info->size == iter->second.size &&
+         info->mtime_ns == iter->second.mtime_ns;
+}
+
+void SaveCache::write(const std::string &path, const uint8_t *data, size_t len,
+                      uint64_t version) {
+  // The data goes to a temporary file next to the target first, which then
+  // replaces the target in one step. Readers of the target, and the target
+  // itself if writing fails, never see a partially written file.
+  const std::string temp = temp_path(path);
+  try {
+    fs::File file(temp.c_str(),
+                  core::Bitmask<fs::File::OpenMode>(
+                      fs::File::OpenMode::Write, fs::File::OpenMode::Create,
+                      fs::File::OpenMode::Truncate),
+                  nullptr);
+    if (len > 0) {
+      fs::write_all(file, data, len);
+    }
+
+    replace(file, path, version);
+  } catch (const std::runtime_error &) {
+    remove_temp(temp);
+    throw;
+  }
+}
+
+std::string SaveCache::temp_path(const std::string &path) {
+  return path + ".tmp";
+}
+
+bool SaveCache::write_if_changed(const std::string &path, const uint8_t *data,
+                                 size_t len) {
+  const uint64_t version = hash(data, len);
+  if (is_current(path, version)) {
+    ++skipped_;
+    return false;
+  }
+
+  write(path, data, len, version);
+  return true;
+}
+
+void SaveCache::replace(fs::File &file, const std::string &path,
+                        uint64_t version) {
+  // Forget the old entry first, so that it is not used if renaming fails.
+  entries_.erase(path);
+
+  const fs::FileInfo info = file.info();
+  fs::rename_file(temp_path(path).c_str(), path.c_str(), nullptr);
+
+  entries_[path] = Entry{
+      .version = version,
+      .size = info.size,
+      .mtime_ns = info.mtime_ns,
+  };
+
+  ++written_;
+}
+
+void SaveCache::remove_temp(const std::string &temp) {
+  try {
+    fs::remove_file(temp.c_str(), nullptr);
+  } catch (const std::runtime_error &) {
+    // Not created in the first place
+  }
+}
+
+void SaveCache::clear() {
+  entries_.clear();
+  written_ = 0;
+  skipped_ = 0;
+}
+
+} // namespace freeisle::json::saver
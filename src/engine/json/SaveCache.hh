@@ -0,0 +1,198 @@
+#pragma once
+
+#include "fs/File.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace freeisle::json::saver {
+
+/**
+ * Remembers which files were written by previous saves, so that repeated
+ * saves of the same document, e.g. autosaves, only rewrite the files whose
+ * content changed.
+ *
+ * For each file written through the cache, it stores a version, typically
+ * a hash of the content, together with the size and modification time the
+ * file had after writing. A file is only skipped if it is still unchanged
+ * on disk, so files that were modified or removed by someone else are
+ * written again. Files are identified by the path they are written to.
+ *
+ * A cache is meant to be kept alive across saves by whoever triggers the
+ * saves, and passed to save_root_object(). It is not thread-safe.
+ */
+class SaveCache {
+public:
+  SaveCache();
+
+  SaveCache(const SaveCache &) = delete;
+  SaveCache(SaveCache &&) = default;
+  SaveCache &operator=(const SaveCache &) = delete;
+  SaveCache &operator=(SaveCache &&) = default;
+
+  /**
+   * Computes the same hash as hash(), for data that is produced in pieces.
+   */
+  class Hasher {
+  public:
+    Hasher();
+
+    void update(const uint8_t *data, size_t len);
+
+    /**
+     * Hash of all data passed to update() so far.
+     */
+    uint64_t digest() const;
+
+  private:
+    uint64_t state_;
+    uint64_t length_;
+
+    /**
+     * Data that does not fill a whole word yet.
+     */
+    uint8_t tail_[8];
+    size_t tail_length_;
+  };
+
+  /**
+   * Hash of the given data, to be used as a version.
+   */
+  static uint64_t hash(const uint8_t *data, size_t len);
+
+  /**
+   * Returns whether the file at the given path was last written through
+   * this cache with the given version, and has not been changed since.
+   */
+  bool is_current(const std::string &path, uint64_t version) const;
+
+  /**
+   * Write the given data to the file at the given path, and remember the
+   * given version for it. The data is written to temp_path() first, which
+   * is then renamed to the given path, so that the file at the given path
+   * is replaced in one step, and keeps its old content if writing fails.
+   */
+  void write(const std::string &path, const uint8_t *data, size_t len,
+             uint64_t version);
+
+  /**
+   * Returns the path of the temporary file that write() uses for the given
+   * path. It is in the same directory, so that it can be renamed.
+   */
+  static std::string temp_path(const std::string &path);
+
+  /**
+   * Write the given data to the file at the given path, unless the file is
+   * current with the hash of the data as version. Returns whether the file
+   * was written.
+   */
+  bool write_if_changed(const std::string &path, const uint8_t *data,
+                        size_t len);
+
+  /**
+   * Write the file at the given path with the given function, which writes
+   * into the fs::File it is passed and returns the version of what it wrote,
+   * typically a hash computed while writing. The output goes to temp_path()
+   * and replaces the file at the given path like in write(), unless that
+   * file is current with the returned version. In that case, the temporary
+   * file is removed again. Returns whether the file was replaced.
+   */
+  template <typename F>
+  bool write_if_changed(const std::string &path, F write) {
+    const std::string temp = temp_path(path);
+    try {
+      fs::File file(temp.c_str(),
+                    core::Bitmask<fs::File::OpenMode>(
+                        fs::File::OpenMode::Write, fs::File::OpenMode::Create,
+                        fs::File::OpenMode::Truncate),
+                    nullptr);
+      const uint64_t version = write(file);
+      if (is_current(path, version)) {
+        remove_temp(temp);
+        ++skipped_;
+        return false;
+      }
+
+      replace(file, path, version);
+    } catch (...) {
+      remove_temp(temp);
+      throw;
+    }
+
+    return true;
+  }
+
+  /**
+   * Write the file at the given path with the given function, which writes
+   * into the fs::File it is passed. Like write(), the output goes to
+   * temp_path() and then replaces the file at the given path, so that the
+   * file keeps its old content if the function throws. This is for writing
+   * without a cache, and therefore does not remember a version.
+   */
+  template <typename F>
+  static void write_replacing(const std::string &path, F write) {
+    const std::string temp = temp_path(path);
+    try {
+      fs::File file(temp.c_str(),
+                    core::Bitmask<fs::File::OpenMode>(
+                        fs::File::OpenMode::Write, fs::File::OpenMode::Create,
+                        fs::File::OpenMode::Truncate),
+                    nullptr);
+      write(file);
+      fs::rename_file(temp.c_str(), path.c_str(), nullptr);
+    } catch (...) {
+      remove_temp(temp);
+      throw;
+    }
+  }
+
+  /**
+   * Remove all entries from the cache, and reset written() and skipped().
+   */
+  void clear();
+
+  /**
+   * Number of files in the cache.
+   */
+  size_t size() const { return entries_.size(); }
+
+  /**
+   * Number of files that were written through the cache, and that were
+   * found to be current and therefore skipped, respectively.
+   */
+  uint64_t written() const { return written_; }
+  uint64_t skipped() const { return skipped_; }
+
+  /**
+   * Record that writing a file was skipped because it is current. This is
+   * for callers that check is_current() themselves.
+   */
+  void skip() { ++skipped_; }
+
+private:
+  /**
+   * Rename the given file, which was written to temp_path(path), to the
+   * given path, and remember the given version for it.
+   */
+  void replace(fs::File &file, const std::string &path, uint64_t version);
+
+  /**
+   * Remove the given temporary file after a failed or skipped write, if it
+   * exists.
+   */
+  static void remove_temp(const std::string &temp);
+
+  struct Entry {
+    uint64_t version;
+    uint64_t size;
+    uint64_t mtime_ns;
+  };
+
+  std::map<std::string, Entry> entries_;
+  uint64_t written_;
+  uint64_t skipped_;
+};
+
+} // namespace freeisle::json::saver
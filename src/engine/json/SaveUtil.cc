@@ -6,22 +6,38 @@
 
 namespace freeisle::json::saver {
 
+std::string binary_path(const Context &ctx, const char *filename) {
+  if (filename == nullptr || filename[0] == '\0' || ctx.path.empty()) {
+    return "";
+  }
+
+  return fs::path::join(fs::path::dirname(ctx.path), filename);
+}
+
+void save_binary_reference(Context &ctx, Json::Value &value, const char *key,
+                           const std::string &path) {
+  json::saver::save(ctx, value, key,
+                    "file:" + std::string(fs::path::make_relative(
+                                  path, fs::path::dirname(ctx.path))));
+}
+
 void save_binary(Context &ctx, Json::Value &value, const char *key,
                  const uint8_t *data, size_t len, const char *filename) {
-  if (filename != NULL && filename[0] != '\0' && !ctx.path.empty()) {
-    const std::string path =
-        fs::path::join(fs::path::dirname(ctx.path), filename);
-    fs::write_file(filename, data, len, nullptr);
-    json::saver::save(ctx, value, key,
-                      "file:" + std::string(fs::path::make_relative(
-                                    path, fs::path::dirname(ctx.path))));
+  const std::string path = binary_path(ctx, filename);
+  if (!path.empty()) {
+    if (ctx.cache != nullptr) {
+      ctx.cache->write_if_changed(path, data, len);
+    } else {
+      fs::write_file(path.c_str(), data, len, nullptr);
+    }
+
+    save_binary_reference(ctx, value, key, path);
   } else {
     std::string base64_encoded;
-    base64_encoded.resize(7 +
-                          base64::round_to_next_multiple_of<4>(len * 4 / 3));
+    base64_encoded.resize(7 + base64::encoded_size(len));
     memcpy(base64_encoded.data(), "base64:", 7);
     base64::encode(data, len, reinterpret_cast<uint8_t *>(&base64_encoded[7]));
-    json::saver::save(ctx, value, key, base64_encoded);
+    json::saver::save(ctx, value, key, std::move(base64_encoded));
   }
 }
 
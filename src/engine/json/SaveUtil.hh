@@ -10,6 +10,8 @@
 
 #include <cassert>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace freeisle::json::saver {
 
@@ -60,32 +62,90 @@ void save_bitmask(Context &ctx, Json::Value &value, const char *key,
 void save_binary(Context &ctx, Json::Value &value, const char *key,
                  const uint8_t *data, size_t len, const char *filename);
 
+/**
+ * Returns the path of the extra file with the given filename in which
+ * save_binary() stores binary data, or an empty string if the data is
+ * stored in the JSON document itself.
+ */
+std::string binary_path(const Context &ctx, const char *filename);
+
+/**
+ * Save a reference to the extra file at the given path, as returned by
+ * binary_path(), under the given key.
+ */
+void save_binary_reference(Context &ctx, Json::Value &value, const char *key,
+                           const std::string &path);
+
+/**
+ * Save a byte sequence like save_binary(), for data that is expensive to
+ * produce, such as an encoded image. The data is returned by produce(), and
+ * version identifies the input it is produced from, e.g. a hash of it. If
+ * the data goes to an extra file and the context's save cache knows that
+ * file to be current with the given version, then produce() is not called
+ * and the file is left as it is.
+ */
+template <typename F>
+void save_binary_cached(Context &ctx, Json::Value &value, const char *key,
+                        const char *filename, uint64_t version, F produce) {
+  const std::string path = binary_path(ctx, filename);
+  if (path.empty() || ctx.cache == nullptr) {
+    const std::vector<uint8_t> data = produce();
+    save_binary(ctx, value, key, data.data(), data.size(), filename);
+    return;
+  }
+
+  if (ctx.cache->is_current(path, version)) {
+    ctx.cache->skip();
+  } else {
+    const std::vector<uint8_t> data = produce();
+    ctx.cache->write(path, data.data(), data.size(), version);
+  }
+
+  save_binary_reference(ctx, value, key, path);
+}
+
 /**
  * Save an object handled by the given handler under the given key in the
- * value provided. Handles include reference restoration.
+ * value provided. Handles include reference restoration. If the value is
+ * being streamed, see Context::streaming, the object is written out instead
+ * of being added to the value.
  */
 template <typename THandler>
 void save_object(Context &ctx, Json::Value &value, const char *key,
                  THandler &handler) {
   const TreeLocationChange tc(ctx, key);
-  const std::map<std::string, IncludeInfo>::const_iterator iter =
-      ctx.include_map.find(ctx.current_location);
+  const IncludeInfo *info = find_include(ctx);
+  const bool stream = ctx.writer != nullptr && &value == ctx.streaming;
+
+  // Objects without include references are streamed along with their
+  // children:
+  if (stream && info == nullptr) {
+    ctx.writer->key(key);
+    stream_object(ctx, handler);
+    return;
+  }
+
+  Json::Value obj(Json::ValueType::objectValue);
 
   // This check is just a fast path to not even run the handler if not needed:
-  if (iter != ctx.include_map.end() && iter->second.override_keys.empty()) {
-    if (!iter->second.filename.empty()) {
-      value[key]["include"] = iter->second.filename;
+  if (info != nullptr && info->override_keys.empty()) {
+    if (info->filename.empty()) {
+      return;
     }
 
     // no override keys, can skip serialization of sub-object altogether
-    return;
+    obj["include"] = info->filename;
+  } else {
+    handler.save(ctx, obj);
+    restore_includes(ctx, obj);
   }
 
-  value[key] = Json::Value(Json::ValueType::objectValue);
-  Json::Value &obj = value[key];
-  handler.save(ctx, obj);
-
-  restore_includes(ctx, obj);
+  if (stream) {
+    ctx.writer->key(key);
+    ctx.writer->value(obj);
+  } else {
+    value[key] = std::move(obj);
+  }
 }
 
 /**
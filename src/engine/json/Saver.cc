@@ -4,33 +4,47 @@ namespace freeisle::json::saver {
 
 TreeLocationChange::TreeLocationChange(Context &ctx, const std::string &key)
     : ctx_(ctx), location_(ctx.current_location) {
-  ctx.current_location = location_ + "." + key;
+  ctx.current_location = ctx.paths.child(location_, key);
 }
 
 TreeLocationChange::~TreeLocationChange() {
-  assert(ctx_.current_location.rfind('.') != std::string::npos);
   assert(ctx_.current_location == location_ ||
-         ctx_.current_location.substr(0, ctx_.current_location.rfind('.')) ==
-             location_);
+         ctx_.paths.parent(ctx_.current_location) == location_);
 
   ctx_.current_location = location_;
 }
 
-void restore_includes(const Context &ctx, Json::Value &value) {
-  const std::map<std::string, IncludeInfo>::const_iterator iter =
-      ctx.include_map.find(ctx.current_location);
+const IncludeInfo *find_include(Context &ctx) {
+  if (!ctx.includes_indexed) {
+    for (const auto &[location, info] : ctx.include_map) {
+      ctx.includes.emplace(ctx.paths.intern(location), &info);
+    }
+    ctx.includes_indexed = true;
+  }
+
+  const std::unordered_map<uint32_t, const IncludeInfo *>::const_iterator
+      iter = ctx.includes.find(ctx.current_location);
+  if (iter == ctx.includes.end()) {
+    return nullptr;
+  }
+
+  return iter->second;
+}
+
+void restore_includes(Context &ctx, Json::Value &value) {
+  const IncludeInfo *info = find_include(ctx);
 
-  if (iter != ctx.include_map.end()) {
+  if (info != nullptr) {
     const Json::Value::Members members = value.getMemberNames();
-    if (!iter->second.filename.empty()) {
-      value["include"] = iter->second.filename;
+    if (!info->filename.empty()) {
+      value["include"] = info->filename;
     }
 
     // remove all members except the ones that were overridden
     for (const std::string &member : members) {
       const std::map<std::string, bool>::const_iterator override_iter =
-          iter->second.override_keys.find(member);
-      if (override_iter == iter->second.override_keys.end()) {
+          info->override_keys.find(member);
+      if (override_iter == info->override_keys.end()) {
         value.removeMember(member);
       } else if (!override_iter->second) {
         value[member] = Json::Value::null;
@@ -39,4 +53,14 @@ void restore_includes(const Context &ctx, Json::Value &value) {
   }
 }
 
+void write_members(Context &ctx, const Json::Value &obj) {
+  for (Json::Value::const_iterator iter = obj.begin(); iter != obj.end();
+       ++iter) {
+    const char *end;
+    const char *begin = iter.memberName(&end);
+    ctx.writer->key(std::string_view(begin, end - begin));
+    ctx.writer->value(*iter);
+  }
+}
+
 } // namespace freeisle::json::saver
@@ -4,6 +4,14 @@
 
 #include "fs/File.hh"
 #include "json/IncludeInfo.hh"
+#include "json/SaveCache.hh"
+#include "json/TreePaths.hh"
+#include "json/Writer.hh"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
 
 namespace freeisle::json::saver {
 
@@ -24,10 +32,10 @@ struct Context {
   const std::string path;
 
   /**
-   * Location in the object tree in the form ".a.b.c" where the object
+   * Node in paths for the location in the object tree where the object
    * currently being saved is located.
    */
-  std::string current_location;
+  uint32_t current_location = TreePaths::Root;
 
   /**
    * Mapping from paths in the object tree in the form of ".a.b.c" to
@@ -35,6 +43,36 @@ struct Context {
    * files instead of saving everything in the main file.
    */
   const std::map<std::string, IncludeInfo> &include_map;
+
+  /**
+   * Locations in the object tree that have been visited so far.
+   */
+  TreePaths paths;
+
+  /**
+   * Entries of include_map indexed by their node in paths. This is built
+   * on first use by find_include().
+   */
+  std::unordered_map<uint32_t, const IncludeInfo *> includes;
+  bool includes_indexed = false;
+
+  /**
+   * If set, files are written through this cache, so that files which did
+   * not change since the previous save are not written again.
+   */
+  SaveCache *cache = nullptr;
+
+  /**
+   * Writer the document is written into while it is being saved.
+   */
+  Writer *writer = nullptr;
+
+  /**
+   * Object whose members are currently being written into the writer.
+   * Objects that are saved into it with save_object() are written out as
+   * soon as they are complete, instead of being added to it.
+   */
+  Json::Value *streaming = nullptr;
 };
 
 /**
@@ -60,14 +98,65 @@ public:
 
 private:
   Context &ctx_;
-  const std::string location_;
+  const uint32_t location_;
 };
 
+/**
+ * Returns the entry of the context's include map for the current location,
+ * or nullptr if there is none.
+ */
+const IncludeInfo *find_include(Context &ctx);
+
 /**
  * Replaces all or parts of the information in the given JSON value with
  * an include reference if one is specified in the context's include map.
  */
-void restore_includes(const Context &ctx, Json::Value &value);
+void restore_includes(Context &ctx, Json::Value &value);
+
+/**
+ * Write the members of the given object into the context's writer.
+ */
+void write_members(Context &ctx, const Json::Value &obj);
+
+/**
+ * Save the object handled by the given handler into the context's writer.
+ * Objects that the handler saves with save_object() are written out as soon
+ * as they are complete, so that only the objects on the path from the root
+ * to the one currently being saved are held in memory. The remaining
+ * members, e.g. primitive values, are written after them.
+ */
+template <typename THandler>
+void stream_object(Context &ctx, THandler &handler) {
+  Json::Value obj(Json::ValueType::objectValue);
+  Json::Value *const parent = ctx.streaming;
+  ctx.streaming = &obj;
+
+  ctx.writer->begin_object();
+  handler.save(ctx, obj);
+  write_members(ctx, obj);
+  ctx.writer->end_object();
+
+  ctx.streaming = parent;
+}
+
+/**
+ * Save the document root handled by the given handler into the context's
+ * writer, and finish the document.
+ */
+template <typename THandler>
+void save_document(Context &ctx, THandler &handler) {
+  if (find_include(ctx) == nullptr) {
+    stream_object(ctx, handler);
+  } else {
+    // An include reference at the root needs the whole document to prune.
+    Json::Value root;
+    handler.save(ctx, root);
+    restore_includes(ctx, root);
+    ctx.writer->value(root);
+  }
+
+  ctx.writer->finish();
+}
 
 /**
  * Main entry point to the saver for saving to an in-memory JSON
@@ -76,34 +165,43 @@ void restore_includes(const Context &ctx, Json::Value &value);
 template <typename THandler>
 std::vector<uint8_t>
 save_root_object(THandler &handler,
-                 const std::map<std::string, IncludeInfo> *include_map) {
+                 const std::map<std::string, IncludeInfo> *include_map,
+                 Style style = Style::Pretty) {
   const std::map<std::string, IncludeInfo> empty_include_map;
   if (include_map == nullptr) {
     include_map = &empty_include_map;
   }
 
+  Writer writer(style);
   Context ctx{
       .path = "",
-      .current_location = "",
+      .current_location = TreePaths::Root,
       .include_map = *include_map,
+      .writer = &writer,
   };
 
-  Json::Value root;
-  handler.save(ctx, root);
-  restore_includes(ctx, root);
-
-  Json::StyledWriter writer;
-  std::string str = writer.write(root);
-  return std::vector<uint8_t>(str.begin(), str.end());
+  save_document(ctx, handler);
+  return writer.take();
 }
 
 /**
  * Main entry point to the saver for saving into a file in JSON
- * representation.
+ * representation. The document is written to the file while it is being
+ * saved, through a fixed-size buffer, see stream_object(). It is written to
+ * a temporary file which then replaces the file at the given path, so that
+ * a previous save at the same path is kept if saving fails.
+ *
+ * If a save cache is given, it is used for the document and for binary data
+ * saved in extra files, and files that have not changed since the last save
+ * with the same cache are not replaced. In that case, the document is
+ * hashed while it is written to a temporary file, which is removed again if
+ * the hash shows that the document did not change.
  */
 template <typename THandler>
 void save_root_object(const char *path, THandler &handler,
-                      const std::map<std::string, IncludeInfo> *include_map) {
+                      const std::map<std::string, IncludeInfo> *include_map,
+                      Style style = Style::Pretty,
+                      SaveCache *cache = nullptr) {
   const std::map<std::string, IncludeInfo> empty_include_map;
   if (include_map == nullptr) {
     include_map = &empty_include_map;
@@ -111,18 +209,31 @@ void save_root_object(const char *path, THandler &handler,
 
   Context ctx{
       .path = path,
-      .current_location = "",
+      .current_location = TreePaths::Root,
       .include_map = *include_map,
+      .cache = cache,
   };
 
-  Json::Value root;
-  handler.save(ctx, root);
-  restore_includes(ctx, root);
+  if (cache != nullptr) {
+    cache->write_if_changed(path, [&ctx, &handler, style](fs::File &file) {
+      SaveCache::Hasher hasher;
+      Writer writer(file, style);
+      writer.observe([&hasher](const uint8_t *data, uint64_t length) {
+        hasher.update(data, length);
+      });
+
+      ctx.writer = &writer;
+      save_document(ctx, handler);
+      return hasher.digest();
+    });
+    return;
+  }
 
-  Json::StyledWriter writer;
-  const std::string str = writer.write(root);
-  fs::write_file(path, reinterpret_cast<const uint8_t *>(str.data()),
-                 str.size(), nullptr);
+  SaveCache::write_replacing(path, [&ctx, &handler, style](fs::File &file) {
+    Writer writer(file, style);
+    ctx.writer = &writer;
+    save_document(ctx, handler);
+  });
 }
 
 } // namespace freeisle::json::saver
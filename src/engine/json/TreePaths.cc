@@ -0,0 +1,95 @@
+#include "json/TreePaths.hh"
+
+#include <cassert>
+#include <functional>
+
+namespace freeisle::json {
+
+TreePaths::TreePaths()
+    : nodes_{Node{.parent = Root, .key = "", .hash = 0}}, table_(16, Empty) {}
+
+uint32_t TreePaths::child(uint32_t parent, std::string_view key) {
+  assert(parent < nodes_.size());
+
+  const size_t h = hash(parent, key);
+  const size_t mask = table_.size() - 1;
+  for (size_t i = h & mask;; i = (i + 1) & mask) {
+    const uint32_t node = table_[i];
+    if (node == Empty) {
+      break;
+    }
+
+    if (nodes_[node].hash == h && nodes_[node].parent == parent &&
+        nodes_[node].key == key) {
+      return node;
+    }
+  }
+
+  const uint32_t node = nodes_.size();
+  nodes_.push_back(Node{.parent = parent, .key = std::string(key), .hash = h});
+
+  if (nodes_.size() * 2 > table_.size()) {
+    table_.assign(table_.size() * 2, Empty);
+    for (uint32_t i = 1; i < nodes_.size(); ++i) {
+      insert(i);
+    }
+  } else {
+    insert(node);
+  }
+
+  return node;
+}
+
+uint32_t TreePaths::intern(std::string_view location) {
+  if (location.empty()) {
+    return Root;
+  }
+
+  assert(location[0] == '.');
+
+  uint32_t node = Root;
+  size_t begin = 1;
+  while (true) {
+    const size_t end = location.find('.', begin);
+    if (end == std::string_view::npos) {
+      return child(node, location.substr(begin));
+    }
+
+    node = child(node, location.substr(begin, end - begin));
+    begin = end + 1;
+  }
+}
+
+std::string TreePaths::render(uint32_t node) const {
+  size_t len = 0;
+  for (uint32_t cur = node; cur != Root; cur = nodes_[cur].parent) {
+    len += nodes_[cur].key.size() + 1;
+  }
+
+  std::string result(len, '.');
+  for (uint32_t cur = node; cur != Root; cur = nodes_[cur].parent) {
+    const std::string &key = nodes_[cur].key;
+    len -= key.size();
+    result.replace(len, key.size(), key);
+    --len;
+  }
+
+  return result;
+}
+
+size_t TreePaths::hash(uint32_t parent, std::string_view key) {
+  const size_t h = std::hash<std::string_view>()(key);
+  return h ^ (parent + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2));
+}
+
+void TreePaths::insert(uint32_t node) {
+  const size_t mask = table_.size() - 1;
+  size_t i = nodes_[node].hash & mask;
+  while (table_[i] != Empty) {
+    i = (i + 1) & mask;
+  }
+
+  table_[i] = node;
+}
+
+} // namespace freeisle::json
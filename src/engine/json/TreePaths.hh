@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace freeisle::json {
+
+/**
+ * Interned locations in a JSON object tree, such as ".a.b.c".
+ *
+ * Each location that is visited is assigned a node ID, and a node knows its
+ * parent and its key. Descending to a child is a single hash table lookup,
+ * going back to the parent is an array access, and node IDs can be used as
+ * cheap hash keys. The string form of a location is only built by render(),
+ * e.g. for error messages or for the include map that is handed to the
+ * saver.
+ */
+class TreePaths {
+public:
+  /**
+   * Node ID of the root location, whose string form is "".
+   */
+  static constexpr uint32_t Root = 0;
+
+  TreePaths();
+
+  TreePaths(const TreePaths &) = delete;
+  TreePaths(TreePaths &&) = default;
+  TreePaths &operator=(const TreePaths &) = delete;
+  TreePaths &operator=(TreePaths &&) = default;
+
+  /**
+   * Returns the node ID of the child with the given key of the given node,
+   * creating it if needed.
+   */
+  uint32_t child(uint32_t parent, std::string_view key);
+
+  /**
+   * Returns the node ID of the parent of the given node. The parent of the
+   * root is the root itself.
+   */
+  uint32_t parent(uint32_t node) const { return nodes_[node].parent; }
+
+  /**
+   * Returns the key of the given node, which is empty for the root.
+   */
+  const std::string &key(uint32_t node) const { return nodes_[node].key; }
+
+  /**
+   * Returns the node ID of the given location in string form, such as
+   * ".a.b.c", creating it if needed.
+   */
+  uint32_t intern(std::string_view location);
+
+  /**
+   * Returns the string form of the given node, such as ".a.b.c".
+   */
+  std::string render(uint32_t node) const;
+
+  /**
+   * Number of nodes, including the root.
+   */
+  size_t size() const { return nodes_.size(); }
+
+private:
+  struct Node {
+    uint32_t parent;
+    std::string key;
+    size_t hash;
+  };
+
+  static constexpr uint32_t Empty = 0xffffffff;
+
+  static size_t hash(uint32_t parent, std::string_view key);
+  void insert(uint32_t node);
+
+  std::vector<Node> nodes_;
+
+  /**
+   * Open addressing hash table of node IDs, indexed by the hash of parent
+   * and key. The size is a power of two and at least twice the number of
+   * nodes.
+   */
+  std::vector<uint32_t> table_;
+};
+
+} // namespace freeisle::json
@@ -0,0 +1,276 @@
+#include "json/Writer.hh"
+
+#include <algorithm>
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <utility>
+
+namespace freeisle::json {
+
+namespace {
+
+const char HexDigits[] = "0123456789abcdef";
+
+bool needs_escape(char c) {
+  return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+} // namespace
+
+Writer::Writer(Style style) : style_(style), after_key_(false) {}
+
+Writer::Writer(fs::File &file, Style style, size_t buffer_size)
+    : out_(std::in_place, file, buffer_size), style_(style),
+      after_key_(false) {}
+
+void Writer::begin_object() { begin_container(true, '{'); }
+
+void Writer::end_object() { end_container(true, '}'); }
+
+void Writer::begin_array() { begin_container(false, '['); }
+
+void Writer::end_array() { end_container(false, ']'); }
+
+void Writer::key(std::string_view key) {
+  assert(!stack_.empty() && stack_.back().object);
+  assert(!after_key_);
+
+  if (!stack_.back().empty) {
+    put(',');
+  }
+
+  stack_.back().empty = false;
+  indent();
+  quoted(key);
+  put(style_ == Style::Pretty ? std::string_view(": ") : ":");
+  after_key_ = true;
+}
+
+void Writer::string(std::string_view str) {
+  begin_value();
+  quoted(str);
+}
+
+void Writer::int_value(int64_t val) {
+  begin_value();
+  char buf[24];
+  const std::to_chars_result result =
+      std::to_chars(buf, buf + sizeof(buf), val);
+  number(buf, result.ptr);
+}
+
+void Writer::uint_value(uint64_t val) {
+  begin_value();
+  char buf[24];
+  const std::to_chars_result result =
+      std::to_chars(buf, buf + sizeof(buf), val);
+  number(buf, result.ptr);
+}
+
+void Writer::real_value(double val) {
+  begin_value();
+  if (!std::isfinite(val)) {
+    // not representable in JSON
+    put("null");
+    return;
+  }
+
+  // shortest representation that reads back as the same value:
+  char buf[32];
+  const std::to_chars_result result =
+      std::to_chars(buf, buf + sizeof(buf), val);
+  number(buf, result.ptr);
+
+  // keep it a real when it is read back
+  if (std::string_view(buf, result.ptr - buf).find_first_of(".e") ==
+      std::string_view::npos) {
+    put(".0");
+  }
+}
+
+void Writer::bool_value(bool val) {
+  begin_value();
+  put(val ? std::string_view("true") : "false");
+}
+
+void Writer::null() {
+  begin_value();
+  put("null");
+}
+
+void Writer::value(const Json::Value &value) {
+  switch (value.type()) {
+  case Json::ValueType::nullValue:
+    null();
+    break;
+  case Json::ValueType::intValue:
+    int_value(value.asInt64());
+    break;
+  case Json::ValueType::uintValue:
+    uint_value(value.asUInt64());
+    break;
+  case Json::ValueType::realValue:
+    real_value(value.asDouble());
+    break;
+  case Json::ValueType::stringValue: {
+    const char *begin;
+    const char *end;
+    value.getString(&begin, &end);
+    string(std::string_view(begin, end - begin));
+  } break;
+  case Json::ValueType::booleanValue:
+    bool_value(value.asBool());
+    break;
+  case Json::ValueType::arrayValue:
+    begin_array();
+    for (Json::ArrayIndex i = 0; i < value.size(); ++i) {
+      this->value(value[i]);
+    }
+    end_array();
+    break;
+  case Json::ValueType::objectValue:
+    begin_object();
+    for (Json::Value::const_iterator iter = value.begin();
+         iter != value.end(); ++iter) {
+      const char *end;
+      const char *begin = iter.memberName(&end);
+      key(std::string_view(begin, end - begin));
+      this->value(*iter);
+    }
+    end_object();
+    break;
+  }
+}
+
+void Writer::finish() {
+  assert(stack_.empty());
+  if (style_ == Style::Pretty) {
+    put('\n');
+  }
+
+  if (out_) {
+    out_->flush();
+  }
+}
+
+void Writer::observe(fs::BufferedWriter::Observer observer) {
+  assert(out_ && out_->position() == 0);
+  out_->observe(std::move(observer));
+}
+
+std::vector<uint8_t> Writer::take() {
+  assert(!out_);
+  return std::move(memory_);
+}
+
+void Writer::begin_value() {
+  if (after_key_) {
+    after_key_ = false;
+    return;
+  }
+
+  if (stack_.empty()) {
+    return;
+  }
+
+  assert(!stack_.back().object);
+  if (!stack_.back().empty) {
+    put(',');
+  }
+
+  stack_.back().empty = false;
+  indent();
+}
+
+void Writer::begin_container(bool object, char bracket) {
+  begin_value();
+  put(bracket);
+  stack_.push_back(Level{.object = object, .empty = true});
+}
+
+void Writer::end_container(bool object, char bracket) {
+  assert(!stack_.empty() && stack_.back().object == object);
+  assert(!after_key_);
+
+  const bool empty = stack_.back().empty;
+  stack_.pop_back();
+
+  // empty containers are closed on the same line
+  if (!empty) {
+    indent();
+  }
+
+  put(bracket);
+}
+
+void Writer::indent() {
+  if (style_ == Style::Pretty) {
+    static constexpr std::string_view Spaces = "                ";
+    put('\n');
+    for (size_t n = stack_.size() * 2; n > 0;) {
+      const size_t chunk = std::min(n, Spaces.size());
+      put(Spaces.substr(0, chunk));
+      n -= chunk;
+    }
+  }
+}
+
+void Writer::quoted(std::string_view str) {
+  put('"');
+
+  const char *cur = str.data();
+  const char *const end = str.data() + str.size();
+  while (cur != end) {
+    // copy the run of characters that need no escaping in one go
+    const char *run = cur;
+    while (run != end && !needs_escape(*run)) {
+      ++run;
+    }
+
+    put(std::string_view(cur, run - cur));
+    if (run == end) {
+      break;
+    }
+
+    put('\\');
+    switch (*run) {
+    case '"':
+      put('"');
+      break;
+    case '\\':
+      put('\\');
+      break;
+    case '\b':
+      put('b');
+      break;
+    case '\f':
+      put('f');
+      break;
+    case '\n':
+      put('n');
+      break;
+    case '\r':
+      put('r');
+      break;
+    case '\t':
+      put('t');
+      break;
+    default:
+      put("u00");
+      put(HexDigits[static_cast<unsigned char>(*run) >> 4]);
+      put(HexDigits[static_cast<unsigned char>(*run) & 0xf]);
+      break;
+    }
+
+    cur = run + 1;
+  }
+
+  put('"');
+}
+
+void Writer::number(const char *begin, const char *end) {
+  put(std::string_view(begin, end - begin));
+}
+
+} // namespace freeisle::json
@@ -0,0 +1,156 @@
+#pragma once
+
+#include <json/json.h>
+
+#include "fs/BufferedWriter.hh"
+#include "fs/File.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+namespace freeisle::json {
+
+/**
+ * Output formats of Writer.
+ */
+enum class Style {
+  /**
+   * No whitespace at all between tokens.
+   */
+  Compact,
+
+  /**
+   * One object member or array element per line, indented by two spaces
+   * per nesting level.
+   */
+  Pretty,
+};
+
+/**
+ * Writes a JSON document token by token, either into memory or into a
+ * file. When writing into a file, the output goes through an
+ * fs::BufferedWriter, so that the document never needs to be held in memory
+ * as a whole, and long strings are written directly from the caller's
+ * memory rather than copied into the buffer.
+ *
+ * Values are written by calling the functions below in document order. For
+ * objects, each value needs to be preceded by a call to key(). The caller
+ * is responsible for producing a well-formed document; this is only checked
+ * with assertions.
+ */
+class Writer {
+public:
+  static constexpr size_t DefaultBufferSize =
+      fs::BufferedWriter::DefaultBufferSize;
+
+  /**
+   * Create a writer that writes into memory. Use take() to retrieve the
+   * result.
+   */
+  explicit Writer(Style style);
+
+  /**
+   * Create a writer that writes into the given file, which must stay open
+   * while the writer is in use.
+   */
+  Writer(fs::File &file, Style style,
+         size_t buffer_size = DefaultBufferSize);
+
+  Writer(const Writer &) = delete;
+  Writer(Writer &&) = default;
+  Writer &operator=(const Writer &) = delete;
+  Writer &operator=(Writer &&) = default;
+
+  void begin_object();
+  void end_object();
+  void begin_array();
+  void end_array();
+
+  /**
+   * Write the key of the next member of the current object.
+   */
+  void key(std::string_view key);
+
+  void string(std::string_view str);
+  void int_value(int64_t val);
+  void uint_value(uint64_t val);
+  void real_value(double val);
+  void bool_value(bool val);
+  void null();
+
+  /**
+   * Write a whole JSON value, including all of its children.
+   */
+  void value(const Json::Value &value);
+
+  /**
+   * End the document after the top-level value has been written, and
+   * write out all buffered output if writing into a file.
+   */
+  void finish();
+
+  /**
+   * Call the given function with all output as it is written to the file,
+   * see fs::BufferedWriter::observe(). Only valid for writers created with
+   * a file, before anything is written.
+   */
+  void observe(fs::BufferedWriter::Observer observer);
+
+  /**
+   * Returns the document written into memory. Only valid after finish()
+   * for writers created without a file.
+   */
+  std::vector<uint8_t> take();
+
+private:
+  struct Level {
+    bool object;
+    bool empty;
+  };
+
+  void begin_value();
+  void begin_container(bool object, char bracket);
+  void end_container(bool object, char bracket);
+  void indent();
+  void quoted(std::string_view str);
+  void number(const char *begin, const char *end);
+
+  void put(char c) {
+    if (out_) {
+      out_->put(static_cast<uint8_t>(c));
+    } else {
+      memory_.push_back(static_cast<uint8_t>(c));
+    }
+  }
+
+  void put(std::string_view str) {
+    if (out_) {
+      out_->write(str);
+    } else {
+      memory_.insert(memory_.end(), str.begin(), str.end());
+    }
+  }
+
+  /**
+   * Output when writing into a file.
+   */
+  std::optional<fs::BufferedWriter> out_;
+
+  /**
+   * Output when writing into memory.
+   */
+  std::vector<uint8_t> memory_;
+
+  Style style_;
+
+  /**
+   * Containers currently open, innermost last.
+   */
+  std::vector<Level> stack_;
+  bool after_key_;
+};
+
+} // namespace freeisle::json
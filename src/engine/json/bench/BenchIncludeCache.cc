@@ -0,0 +1,166 @@
+#include "json/IncludeCache.hh"
+#include "json/LoadUtil.hh"
+#include "json/Loader.hh"
+
+#include "fs/File.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <fmt/format.h>
+
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+struct CountHandler {
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    count = value["units"].size();
+  }
+
+  uint32_t count;
+};
+
+/**
+ * Write a scenario that includes a unit catalog with the given number of
+ * unit definitions, and return the path of the scenario.
+ */
+std::string write_scenario(uint32_t num_units) {
+  char templ[] = "/tmp/benchXXXXXX";
+  const std::string dir = ::mkdtemp(templ);
+
+  std::string catalog = "{\"units\": {";
+  for (uint32_t i = 0; i < num_units; ++i) {
+    catalog += fmt::format(
+        "{}\"unit{}\": {{\"name\": \"Unit {}\", \"movement\": 600, "
+        "\"weapons\": {{\"cannon\": {{\"damage\": 40, \"ammo\": 4}}}}}}",
+        i > 0 ? ", " : "", i, i);
+  }
+  catalog += "}}";
+
+  const std::string scenario = "{\"include\": \"catalog.json\"}";
+  freeisle::fs::write_file(
+      (dir + "/catalog.json").c_str(),
+      reinterpret_cast<const uint8_t *>(catalog.data()), catalog.size(),
+      nullptr);
+  freeisle::fs::write_file(
+      (dir + "/scenario.json").c_str(),
+      reinterpret_cast<const uint8_t *>(scenario.data()), scenario.size(),
+      nullptr);
+
+  return dir + "/scenario.json";
+}
+
+/**
+ * Loading a scenario whose include is in the cache (or not, if cold is
+ * set).
+ */
+void BM_LoadInclude(benchmark::State &state) {
+  const std::string path = write_scenario(state.range(0));
+  const bool cold = state.range(1);
+
+  for (auto _ : state) {
+    if (cold) {
+      freeisle::json::loader::IncludeCache::global().clear();
+    }
+
+    CountHandler handler;
+    freeisle::json::loader::load_root_object(path.c_str(), handler);
+    benchmark::DoNotOptimize(handler.count);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+struct UnitHandler {
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    movement = freeisle::json::loader::load<uint32_t>(ctx, value, "movement");
+  }
+
+  uint32_t movement;
+};
+
+struct UnitsHandler {
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    UnitHandler unit;
+    for (const std::string &key : value.getMemberNames()) {
+      freeisle::json::loader::load_object(ctx, value, key.c_str(), unit);
+    }
+  }
+};
+
+struct ScenarioHandler {
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    UnitsHandler units;
+    freeisle::json::loader::load_object(ctx, value, "units", units);
+  }
+};
+
+/**
+ * Write a scenario with the given number of units, each of which is
+ * defined in its own include file, and return the path of the scenario.
+ */
+std::string write_split_scenario(uint32_t num_units) {
+  char templ[] = "/tmp/benchXXXXXX";
+  const std::string dir = ::mkdtemp(templ);
+
+  std::string scenario = "{\"units\": {";
+  for (uint32_t i = 0; i < num_units; ++i) {
+    scenario += fmt::format("{}\"unit{}\": {{\"include\": \"unit{}.json\"}}",
+                            i > 0 ? ", " : "", i, i);
+
+    std::string unit = "{\"movement\": 600, \"weapons\": {";
+    for (uint32_t j = 0; j < 50; ++j) {
+      unit += fmt::format("{}\"weapon{}\": {{\"damage\": 40, \"ammo\": 4}}",
+                          j > 0 ? ", " : "", j);
+    }
+    unit += "}}";
+
+    freeisle::fs::write_file(
+        fmt::format("{}/unit{}.json", dir, i).c_str(),
+        reinterpret_cast<const uint8_t *>(unit.data()), unit.size(), nullptr);
+  }
+  scenario += "}}";
+
+  freeisle::fs::write_file(
+      (dir + "/scenario.json").c_str(),
+      reinterpret_cast<const uint8_t *>(scenario.data()), scenario.size(),
+      nullptr);
+
+  return dir + "/scenario.json";
+}
+
+/**
+ * Loading a scenario with many includes from a cold cache, with the
+ * given number of prefetch threads.
+ */
+void BM_LoadManyIncludes(benchmark::State &state) {
+  const std::string path = write_split_scenario(state.range(0));
+
+  for (auto _ : state) {
+    freeisle::json::loader::IncludeCache::global().clear();
+
+    ScenarioHandler handler;
+    freeisle::json::loader::load_root_object(path.c_str(), handler,
+                                             state.range(1));
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_LoadManyIncludes)
+    ->ArgNames({"units", "threads"})
+    ->Args({200, 0})
+    ->Args({200, 4})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK(BM_LoadInclude)
+    ->ArgNames({"units", "cold"})
+    ->Args({1000, 1})
+    ->Args({1000, 0})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,156 @@
+#include "json/LoadUtil.hh"
+#include "json/Parser.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <fmt/format.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+/**
+ * Generate a document that looks like a saved game with the given number
+ * of units.
+ */
+std::string make_document(uint32_t num_units) {
+  std::string text = "{\n  \"turn_num\": 17,\n  \"units\": {\n";
+  for (uint32_t i = 0; i < num_units; ++i) {
+    text += fmt::format(
+        "    \"unit{}\": {{\n"
+        "      \"def\": \"tank\",\n"
+        "      \"owner\": \"player{}\",\n"
+        "      \"location\": {{\"x\": {}, \"y\": {}}},\n"
+        "      \"level\": \"land\",\n"
+        "      \"health\": {},\n"
+        "      \"movement\": 600,\n"
+        "      \"has_actioned\": false,\n"
+        "      \"ammo\": {{\"cannon\": 4, \"machine_gun\": 12}},\n"
+        "      \"stats\": {{\"hits_dealt\": 3, \"damage_dealt\": 120.5}}\n"
+        "    }}{}\n",
+        i, i % 4, i % 256, i / 256, i % 100, i + 1 < num_units ? "," : "");
+  }
+  text += "  }\n}\n";
+  return text;
+}
+
+/**
+ * Parsing into a Json::Value tree with the jsoncpp reader that the loader
+ * used before.
+ */
+void BM_Reader(benchmark::State &state) {
+  const std::string text = make_document(state.range(0));
+
+  for (auto _ : state) {
+    Json::Reader reader;
+    Json::Value root;
+    reader.parse(text.data(), text.data() + text.size(), root, false);
+    benchmark::DoNotOptimize(root);
+  }
+
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/**
+ * Parsing into a Json::Value tree with json::parse().
+ */
+void BM_Parse(benchmark::State &state) {
+  const std::string text = make_document(state.range(0));
+
+  for (auto _ : state) {
+    Json::Value root = freeisle::json::parse(
+        reinterpret_cast<const uint8_t *>(text.data()), text.size());
+    benchmark::DoNotOptimize(root);
+  }
+
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+/**
+ * Pulling all events without building a tree.
+ */
+void BM_Pull(benchmark::State &state) {
+  const std::string text = make_document(state.range(0));
+
+  for (auto _ : state) {
+    freeisle::json::Parser parser(
+        reinterpret_cast<const uint8_t *>(text.data()), text.size());
+    uint32_t count = 0;
+    while (parser.next() != freeisle::json::Parser::Event::End) {
+      ++count;
+    }
+    benchmark::DoNotOptimize(count);
+  }
+
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+struct Location {
+  uint32_t x;
+  uint32_t y;
+
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    x = freeisle::json::loader::load<uint32_t>(ctx, value, "x");
+    y = freeisle::json::loader::load<uint32_t>(ctx, value, "y");
+  }
+};
+
+struct Unit {
+  std::string def;
+  std::string owner;
+  Location location;
+  uint32_t health;
+  uint32_t movement;
+
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    def = freeisle::json::loader::load<std::string>(ctx, value, "def");
+    owner = freeisle::json::loader::load<std::string>(ctx, value, "owner");
+    freeisle::json::loader::load_object(ctx, value, "location", location);
+    health = freeisle::json::loader::load<uint32_t>(ctx, value, "health");
+    movement = freeisle::json::loader::load<uint32_t>(ctx, value, "movement");
+  }
+};
+
+struct Units {
+  std::vector<Unit> units;
+
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    for (const std::string &id : value.getMemberNames()) {
+      units.emplace_back();
+      freeisle::json::loader::load_child(ctx, value, id.c_str(),
+                                         units.back());
+    }
+  }
+};
+
+struct Document {
+  Units units;
+
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    freeisle::json::loader::load_object(ctx, value, "units", units);
+  }
+};
+
+/**
+ * Loading all units of the document with handlers.
+ */
+void BM_Load(benchmark::State &state) {
+  const std::string text = make_document(state.range(0));
+
+  for (auto _ : state) {
+    Document document;
+    freeisle::json::loader::load_root_object(
+        std::vector<uint8_t>(text.begin(), text.end()), document);
+    benchmark::DoNotOptimize(document);
+  }
+
+  state.SetBytesProcessed(state.iterations() * text.size());
+}
+
+} // namespace
+
+BENCHMARK(BM_Reader)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Parse)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Pull)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_Load)->Arg(1000)->Arg(10000)->Unit(benchmark::kMillisecond);
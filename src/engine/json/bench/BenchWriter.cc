@@ -0,0 +1,91 @@
+#include "json/Writer.hh"
+
+#include "fs/File.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <fmt/format.h>
+
+#include <string>
+
+namespace {
+
+/**
+ * Generate a tree that looks like a saved game with the given number of
+ * units.
+ */
+Json::Value make_tree(uint32_t num_units) {
+  Json::Value root(Json::ValueType::objectValue);
+  root["turn_num"] = 17;
+
+  Json::Value &units = root["units"];
+  for (uint32_t i = 0; i < num_units; ++i) {
+    Json::Value &unit = units[fmt::format("unit{}", i)];
+    unit["def"] = "tank";
+    unit["owner"] = fmt::format("player{}", i % 4);
+    unit["location"]["x"] = i % 256;
+    unit["location"]["y"] = i / 256;
+    unit["level"] = "land";
+    unit["health"] = i % 100;
+    unit["movement"] = 600;
+    unit["has_actioned"] = false;
+    unit["ammo"]["cannon"] = 4;
+    unit["ammo"]["machine_gun"] = 12;
+    unit["stats"]["hits_dealt"] = 3;
+    unit["stats"]["damage_dealt"] = 120.5;
+  }
+
+  return root;
+}
+
+/**
+ * Rendering with the jsoncpp writer that the saver used before.
+ */
+void BM_StyledWriter(benchmark::State &state) {
+  const Json::Value tree = make_tree(state.range(0));
+
+  for (auto _ : state) {
+    Json::StyledWriter writer;
+    const std::string str = writer.write(tree);
+    benchmark::DoNotOptimize(str.data());
+  }
+}
+
+void BM_Writer(benchmark::State &state) {
+  const Json::Value tree = make_tree(state.range(0));
+  const freeisle::json::Style style =
+      static_cast<freeisle::json::Style>(state.range(1));
+
+  for (auto _ : state) {
+    freeisle::json::Writer writer(style);
+    writer.value(tree);
+    writer.finish();
+    const std::vector<uint8_t> result = writer.take();
+    benchmark::DoNotOptimize(result.data());
+  }
+}
+
+/**
+ * Rendering into a file through the writer's fs::BufferedWriter.
+ */
+void BM_WriterFile(benchmark::State &state) {
+  const Json::Value tree = make_tree(state.range(0));
+  freeisle::fs::File file("/dev/null", freeisle::fs::File::OpenMode::Write,
+                          nullptr);
+
+  for (auto _ : state) {
+    freeisle::json::Writer writer(file, freeisle::json::Style::Pretty);
+    writer.value(tree);
+    writer.finish();
+  }
+}
+
+} // namespace
+
+BENCHMARK(BM_StyledWriter)->Arg(100)->Arg(10000);
+BENCHMARK(BM_Writer)
+    ->Args({100, static_cast<int>(freeisle::json::Style::Compact)})
+    ->Args({100, static_cast<int>(freeisle::json::Style::Pretty)})
+    ->Args({10000, static_cast<int>(freeisle::json::Style::Compact)})
+    ->Args({10000, static_cast<int>(freeisle::json::Style::Pretty)});
+BENCHMARK(BM_WriterFile)->Arg(100)->Arg(10000);
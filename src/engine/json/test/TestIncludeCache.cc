@@ -0,0 +1,131 @@
+#include "json/IncludeCache.hh"
+#include "json/LoadUtil.hh"
+#include "json/Loader.hh"
+
+#include "fs/File.hh"
+#include "fs/test/util/TempDirFixture.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+namespace {
+
+struct AbHandler {
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    a = freeisle::json::loader::load<std::string>(ctx, value, "a");
+    b = freeisle::json::loader::load<uint32_t>(ctx, value, "b");
+  }
+
+  std::string a;
+  uint32_t b;
+};
+
+class TestIncludeCache : public freeisle::fs::test::TempDirFixture {
+public:
+  void SetUp() override {
+    freeisle::fs::test::TempDirFixture::SetUp();
+    freeisle::json::loader::IncludeCache::global().clear();
+  }
+
+  void write(const char *path, const char *content) {
+    freeisle::fs::write_file(path, reinterpret_cast<const uint8_t *>(content),
+                             std::strlen(content), nullptr);
+  }
+
+  AbHandler load(const char *path) {
+    AbHandler handler;
+    freeisle::json::loader::load_root_object(path, handler);
+    return handler;
+  }
+};
+
+} // namespace
+
+TEST_F(TestIncludeCache, SharedBetweenLoads) {
+  const freeisle::json::loader::IncludeCache &cache =
+      freeisle::json::loader::IncludeCache::global();
+
+  write("common.json", "{\"b\": 7}");
+  write("first.json", "{\"include\": \"common.json\", \"a\": \"first\"}");
+  write("second.json", "{\"include\": \"common.json\", \"a\": \"second\"}");
+
+  const uint64_t hits = cache.hits();
+  const uint64_t misses = cache.misses();
+
+  AbHandler first = load("first.json");
+  EXPECT_EQ(first.a, "first");
+  EXPECT_EQ(first.b, 7);
+
+  AbHandler second = load("second.json");
+  EXPECT_EQ(second.a, "second");
+  EXPECT_EQ(second.b, 7);
+
+  first = load("first.json");
+  EXPECT_EQ(first.b, 7);
+
+  EXPECT_EQ(cache.size(), 1);
+  EXPECT_EQ(cache.misses() - misses, 1);
+  EXPECT_EQ(cache.hits() - hits, 2);
+}
+
+TEST_F(TestIncludeCache, ModifiedFileIsReloaded) {
+  const freeisle::json::loader::IncludeCache &cache =
+      freeisle::json::loader::IncludeCache::global();
+
+  write("common.json", "{\"b\": 7}");
+  write("main.json", "{\"include\": \"common.json\", \"a\": \"main\"}");
+  EXPECT_EQ(load("main.json").b, 7);
+
+  write("common.json", "{\"b\": 42}");
+  EXPECT_EQ(load("main.json").b, 42);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(TestIncludeCache, ErrorsAreNotCached) {
+  const freeisle::json::loader::IncludeCache &cache =
+      freeisle::json::loader::IncludeCache::global();
+
+  write("common.json", "{\"b\": }");
+  write("main.json", "{\"include\": \"common.json\", \"a\": \"main\"}");
+  EXPECT_THROW(load("main.json"), freeisle::json::loader::Error);
+  EXPECT_EQ(cache.size(), 0);
+
+  write("common.json", "{\"b\": 3}");
+  EXPECT_EQ(load("main.json").b, 3);
+}
+
+TEST_F(TestIncludeCache, EvictsLeastRecentlyUsed) {
+  // Room for two of the files below:
+  freeisle::json::loader::IncludeCache cache(20);
+  const auto load = [&cache](const char *path) {
+    freeisle::fs::File file(path, freeisle::fs::File::OpenMode::Read, nullptr);
+    return cache.load(file, file.info());
+  };
+
+  write("a.json", "{\"b\": 1}");
+  write("b.json", "{\"b\": 2}");
+  write("c.json", "{\"b\": 3}");
+  write("big.json", "{\"b\": 4, \"a\": \"too large\"}");
+
+  load("a.json");
+  load("b.json");
+  load("a.json");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.bytes(), 16);
+
+  // b.json is evicted, and documents stay valid while they are used:
+  const std::shared_ptr<const freeisle::json::loader::IncludeCache::Document>
+      c = load("c.json");
+  EXPECT_EQ(cache.size(), 2);
+  load("a.json");
+  EXPECT_EQ(cache.misses(), 3);
+  load("b.json");
+  EXPECT_EQ(cache.misses(), 4);
+  EXPECT_EQ(c->root["b"].asUInt(), 3);
+
+  // Files larger than the limit are not cached:
+  EXPECT_EQ(load("big.json")->root["b"].asUInt(), 4);
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_LE(cache.bytes(), 20);
+}
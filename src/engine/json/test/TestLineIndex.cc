@@ -0,0 +1,65 @@
+#include "json/LineIndex.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+#include <utility>
+
+namespace {
+
+freeisle::json::LineIndex make_index(const char *text) {
+  return freeisle::json::LineIndex(reinterpret_cast<const uint8_t *>(text),
+                                   std::strlen(text));
+}
+
+} // namespace
+
+TEST(LineIndex, Empty) {
+  const freeisle::json::LineIndex index = make_index("");
+  EXPECT_EQ(index.lines(), 1);
+  EXPECT_EQ(index.position(0), std::make_pair(1u, 1u));
+}
+
+TEST(LineIndex, SingleLine) {
+  const freeisle::json::LineIndex index = make_index("{\"a\": 1}");
+  EXPECT_EQ(index.lines(), 1);
+  EXPECT_EQ(index.position(0), std::make_pair(1u, 1u));
+  EXPECT_EQ(index.position(6), std::make_pair(1u, 7u));
+  EXPECT_EQ(index.position(8), std::make_pair(1u, 9u));
+}
+
+TEST(LineIndex, MultipleLines) {
+  const freeisle::json::LineIndex index = make_index("{\n  \"a\": 1,\n\n}\n");
+  EXPECT_EQ(index.lines(), 5);
+  EXPECT_EQ(index.position(0), std::make_pair(1u, 1u));
+  EXPECT_EQ(index.position(1), std::make_pair(1u, 2u));
+  EXPECT_EQ(index.position(2), std::make_pair(2u, 1u));
+  EXPECT_EQ(index.position(4), std::make_pair(2u, 3u));
+  EXPECT_EQ(index.position(11), std::make_pair(2u, 10u));
+  EXPECT_EQ(index.position(12), std::make_pair(3u, 1u));
+  EXPECT_EQ(index.position(13), std::make_pair(4u, 1u));
+  EXPECT_EQ(index.position(15), std::make_pair(5u, 1u));
+}
+
+TEST(LineIndex, MatchesScan) {
+  std::string text;
+  for (uint32_t i = 0; i < 200; ++i) {
+    text += std::string(i % 13, 'x') + "\n";
+  }
+
+  const freeisle::json::LineIndex index(
+      reinterpret_cast<const uint8_t *>(text.data()), text.size());
+
+  uint32_t line = 1;
+  uint32_t col = 1;
+  for (size_t offset = 0; offset <= text.size(); ++offset) {
+    EXPECT_EQ(index.position(offset), std::make_pair(line, col));
+    if (offset < text.size() && text[offset] == '\n') {
+      ++line;
+      col = 1;
+    } else {
+      ++col;
+    }
+  }
+}
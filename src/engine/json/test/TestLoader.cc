@@ -64,12 +64,39 @@ struct AbcHandler {
   }
 };
 
+struct AbcListHandler {
+  Abc abcs[3];
+
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    const char *const names[] = {"first", "second", "third"};
+    for (uint32_t i = 0; i < 3; ++i) {
+      AbcHandler handler{abcs[i]};
+      load_object(ctx, value, names[i], handler);
+    }
+  }
+};
+
+/**
+ * Loads Abc objects as children of a collection, like the entries of
+ * def::Collection.
+ */
+struct AbcCollectionHandler {
+  std::map<std::string, Abc> abcs;
+
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    for (const std::string &key : value.getMemberNames()) {
+      AbcHandler handler{abcs[key]};
+      freeisle::json::loader::load_child(ctx, value, key.c_str(), handler);
+    }
+  }
+};
+
 struct BinaryHandler {
   void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
     data = freeisle::json::loader::load_binary(ctx, value, "data");
   }
 
-  std::vector<uint8_t> data;
+  freeisle::core::SharedBytes data;
 };
 
 } // namespace
@@ -145,6 +172,23 @@ TEST(Loader, SimpleBadSyntax) {
                std::runtime_error);
 }
 
+TEST(Loader, SimpleBadSyntaxLocation) {
+  Defg defg{};
+  DefgHandler handler{defg};
+
+  const std::string text =
+      "{\"d\": 54,\n \"e\": true,\n \"f\": \"omg\" \"g\": 1}";
+  std::vector<uint8_t> data(text.begin(), text.end());
+
+  ASSERT_THROW_KEEP_AS_E(
+      freeisle::json::loader::load_root_object(data, handler),
+      freeisle::json::loader::Error) {
+    EXPECT_EQ(e.path(), "");
+    EXPECT_EQ(e.line(), 3);
+    EXPECT_EQ(e.col(), 13);
+  }
+}
+
 TEST(Loader, SimpleCustomError) {
   Defg defg{};
   DefgHandler handler{defg};
@@ -854,3 +898,151 @@ TEST(Loader, BinaryExternalErrorNonexisting) {
                            "No such file or directory");
   }
 }
+
+TEST(Loader, ValidateWorking) {
+  Abc abc{};
+  AbcHandler handler{abc};
+
+  const std::vector<freeisle::json::loader::Error> errors =
+      freeisle::json::loader::validate_root_object("data/abc_working.json",
+                                                   handler);
+  EXPECT_TRUE(errors.empty());
+  EXPECT_EQ(abc.c.d, 42);
+}
+
+TEST(Loader, ValidateCollectsErrors) {
+  AbcListHandler handler;
+
+  const std::vector<freeisle::json::loader::Error> errors =
+      freeisle::json::loader::validate_root_object("data/abc_list_errors.json",
+                                                   handler);
+  ASSERT_EQ(errors.size(), 2);
+
+  EXPECT_EQ(freeisle::fs::path::basename(errors[0].path()),
+            "defg_custom_error.json");
+  EXPECT_EQ(errors[0].line(), 3);
+  EXPECT_EQ(errors[0].col(), 8);
+  EXPECT_EQ(errors[0].message(), "e cannot be false");
+
+  EXPECT_EQ(freeisle::fs::path::basename(errors[1].path()),
+            "abc_list_errors.json");
+  EXPECT_EQ(errors[1].line(), 21);
+  EXPECT_EQ(errors[1].col(), 10);
+
+  // objects without errors are loaded completely:
+  EXPECT_EQ(handler.abcs[0].c.d, 42);
+  EXPECT_EQ(handler.abcs[1].b, 2);
+}
+
+TEST(Loader, ValidateSyntaxError) {
+  Defg defg{};
+  DefgHandler handler{defg};
+
+  const std::vector<freeisle::json::loader::Error> errors =
+      freeisle::json::loader::validate_root_object(
+          "data/defg_syntax_error.json", handler);
+  ASSERT_EQ(errors.size(), 1);
+  EXPECT_EQ(errors[0].line(), 5);
+}
+
+TEST(Loader, ValidateErrorInRootObject) {
+  Defg defg{};
+  DefgHandler handler{defg};
+
+  const std::vector<freeisle::json::loader::Error> errors =
+      freeisle::json::loader::validate_root_object(
+          "data/defg_custom_error.json", handler);
+  ASSERT_EQ(errors.size(), 1);
+  EXPECT_EQ(errors[0].message(), "e cannot be false");
+}
+
+TEST(Loader, DeferredChildren) {
+  AbcCollectionHandler handler;
+
+  const std::string text =
+      "{\"abcs\": {\n"
+      "  \"first\": {\"a\": \"one\", \"b\": 1, \"c\": {\"d\": 41, "
+      "\"e\": true, \"f\": \"omg\", \"g\": 1.5}},\n"
+      "  \"second\": {\"a\": \"two\", \"b\": 2, \"c\": {\"d\": 42, "
+      "\"e\": true, \"f\": \"wtf\", \"g\": 2.5}}\n"
+      "}}";
+  std::vector<uint8_t> data(text.begin(), text.end());
+
+  std::pair<freeisle::json::loader::Context, Json::Value> pair =
+      freeisle::json::loader::make_root_source_context(data, nullptr);
+  freeisle::json::loader::Context &ctx = pair.first;
+  EXPECT_EQ(ctx.deferred.size(), 2);
+
+  // Children are parsed as they are loaded, and dropped again afterwards:
+  for (uint32_t pass = 0; pass < 2; ++pass) {
+    SCOPED_TRACE(pass);
+    freeisle::json::loader::load_object(ctx, pair.second, "abcs", handler);
+    EXPECT_EQ(ctx.deferred.size(), 2);
+    EXPECT_TRUE(pair.second["abcs"]["first"].empty());
+
+    ASSERT_EQ(handler.abcs.size(), 2);
+    EXPECT_EQ(handler.abcs["first"].a, "one");
+    EXPECT_EQ(handler.abcs["first"].c.d, 41);
+    EXPECT_EQ(handler.abcs["second"].b, 2);
+    EXPECT_EQ(handler.abcs["second"].c.f, "wtf");
+  }
+
+  // Other than load_child(), load_object() keeps the object:
+  AbcHandler abc_handler{handler.abcs["first"]};
+  freeisle::json::loader::load_object(ctx, pair.second["abcs"], "first",
+                                      abc_handler);
+  EXPECT_EQ(ctx.deferred.size(), 1);
+  EXPECT_EQ(pair.second["abcs"]["first"]["a"].asString(), "one");
+}
+
+TEST(Loader, DeferredRepeatedKey) {
+  AbcCollectionHandler handler;
+
+  // Same as Json::Reader, the last of repeated keys wins:
+  const std::string text =
+      "{\"abcs\": {\"zeroth\": {\"x\": 0}},\n"
+      "\"abcs\": {\n"
+      "  \"first\": {\"a\": \"one\", \"b\": 1, \"c\": {\"d\": 41, "
+      "\"e\": true, \"f\": \"omg\", \"g\": 1.5}}\n"
+      "}}";
+  std::vector<uint8_t> data(text.begin(), text.end());
+
+  std::pair<freeisle::json::loader::Context, Json::Value> pair =
+      freeisle::json::loader::make_root_source_context(data, nullptr);
+  freeisle::json::loader::Context &ctx = pair.first;
+  EXPECT_EQ(ctx.deferred.size(), 1);
+
+  freeisle::json::loader::load_object(ctx, pair.second, "abcs", handler);
+  ASSERT_EQ(handler.abcs.size(), 1);
+  EXPECT_EQ(handler.abcs["first"].a, "one");
+  EXPECT_EQ(handler.abcs["first"].c.d, 41);
+}
+
+TEST(Loader, DeferredChildError) {
+  AbcCollectionHandler handler;
+
+  const std::string text =
+      "{\"abcs\": {\n"
+      "  \"first\": {\"a\": \"one\", \"b\": 1, \"c\": {\"d\": 41, "
+      "\"e\": true, \"f\": \"omg\", \"g\": 1.5}},\n"
+      "  \"second\": {\"a\": \"two\", \"b\": 2, \"c\": {\"d\": 42, "
+      "\"e\": false, \"f\": \"wtf\", \"g\": 2.5}}\n"
+      "}}";
+  std::vector<uint8_t> data(text.begin(), text.end());
+
+  struct RootHandler {
+    AbcCollectionHandler &abcs;
+
+    void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+      freeisle::json::loader::load_object(ctx, value, "abcs", abcs);
+    }
+  } root_handler{handler};
+
+  ASSERT_THROW_KEEP_AS_E(
+      freeisle::json::loader::load_root_object(data, root_handler),
+      freeisle::json::loader::Error) {
+    EXPECT_EQ(e.line(), 3);
+    EXPECT_EQ(e.col(), 54);
+    EXPECT_EQ(e.message(), "e cannot be false");
+  }
+}
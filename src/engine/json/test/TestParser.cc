@@ -0,0 +1,205 @@
+#include "json/Parser.hh"
+
+#include "json/test/Util.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<freeisle::json::Parser::Event> events(const std::string &text) {
+  freeisle::json::Parser parser(reinterpret_cast<const uint8_t *>(text.data()),
+                                text.size());
+
+  std::vector<freeisle::json::Parser::Event> result;
+  do {
+    result.push_back(parser.next());
+  } while (result.back() != freeisle::json::Parser::Event::End);
+
+  return result;
+}
+
+Json::Value parse(const std::string &text) {
+  return freeisle::json::parse(reinterpret_cast<const uint8_t *>(text.data()),
+                               text.size());
+}
+
+size_t error_offset(const std::string &text) {
+  try {
+    parse(text);
+  } catch (const freeisle::json::ParseError &ex) {
+    return ex.offset();
+  }
+
+  ADD_FAILURE() << "No parse error for " << text;
+  return 0;
+}
+
+void expect_same_offsets(const Json::Value &v1, const Json::Value &v2) {
+  EXPECT_EQ(v1.getOffsetStart(), v2.getOffsetStart());
+  EXPECT_EQ(v1.getOffsetLimit(), v2.getOffsetLimit());
+
+  if (v1.isArray()) {
+    for (uint32_t i = 0; i < v1.size(); ++i) {
+      expect_same_offsets(v1[i], v2[i]);
+    }
+  } else if (v1.isObject()) {
+    for (const std::string &key : v1.getMemberNames()) {
+      SCOPED_TRACE(key);
+      expect_same_offsets(v1[key], v2[key]);
+    }
+  }
+}
+
+} // namespace
+
+TEST(Parser, Events) {
+  using Event = freeisle::json::Parser::Event;
+
+  EXPECT_EQ(events("{\"a\": [1, -2, 3.5, true, null], \"b\": {}}"),
+            (std::vector<Event>{Event::BeginObject, Event::Key,
+                                Event::BeginArray, Event::UInt, Event::Int,
+                                Event::Real, Event::Bool, Event::Null,
+                                Event::EndArray, Event::Key, Event::BeginObject,
+                                Event::EndObject, Event::EndObject,
+                                Event::End}));
+  EXPECT_EQ(events(" \"str\" "),
+            (std::vector<Event>{Event::String, Event::End}));
+}
+
+TEST(Parser, Skip) {
+  const std::string text = "{\"a\": {\"x\": [1, {\"y\": 2}]}, \"b\": 3}";
+  freeisle::json::Parser parser(reinterpret_cast<const uint8_t *>(text.data()),
+                                text.size());
+
+  EXPECT_EQ(parser.next(), freeisle::json::Parser::Event::BeginObject);
+  EXPECT_EQ(parser.next(), freeisle::json::Parser::Event::Key);
+  EXPECT_EQ(parser.string(), "a");
+  EXPECT_EQ(parser.next(), freeisle::json::Parser::Event::BeginObject);
+  parser.skip();
+  EXPECT_EQ(parser.end_offset(), 26);
+
+  EXPECT_EQ(parser.next(), freeisle::json::Parser::Event::Key);
+  EXPECT_EQ(parser.string(), "b");
+  EXPECT_EQ(parser.next(), freeisle::json::Parser::Event::UInt);
+  EXPECT_EQ(parser.uint_value(), 3);
+  EXPECT_EQ(parser.offset(), 33);
+  EXPECT_EQ(parser.next(), freeisle::json::Parser::Event::EndObject);
+  EXPECT_EQ(parser.next(), freeisle::json::Parser::Event::End);
+}
+
+TEST(Parser, Strings) {
+  EXPECT_EQ(parse("\"plain\"").asString(), "plain");
+  EXPECT_EQ(parse("\"a\\\"b\\\\c\\/d\\n\\t\"").asString(), "a\"b\\c/d\n\t");
+  EXPECT_EQ(parse("\"\\u00e4\\u20ac\"").asString(), "\xc3\xa4\xe2\x82\xac");
+  EXPECT_EQ(parse("\"\\ud83d\\ude00\"").asString(), "\xf0\x9f\x98\x80");
+}
+
+TEST(Parser, Numbers) {
+  EXPECT_EQ(parse("0").asUInt(), 0);
+  EXPECT_EQ(parse("-17").asInt(), -17);
+  EXPECT_EQ(parse("4294967295").asUInt(), 4294967295u);
+  EXPECT_EQ(parse("18446744073709551615").asUInt64(), 18446744073709551615ull);
+  EXPECT_EQ(parse("-9223372036854775808").asInt64(),
+            std::numeric_limits<int64_t>::min());
+  EXPECT_DOUBLE_EQ(parse("2.5e3").asDouble(), 2500.0);
+  EXPECT_DOUBLE_EQ(parse("-0.125").asDouble(), -0.125);
+  EXPECT_TRUE(parse("18446744073709551616").isDouble());
+
+  // Same value types as Json::Reader
+  EXPECT_EQ(parse("17").type(), Json::intValue);
+  EXPECT_EQ(parse("4294967295").type(), Json::uintValue);
+}
+
+TEST(Parser, Comments) {
+  const Json::Value value =
+      parse("// leading\n{ /* inline */ \"a\": 1 // trailing\n}");
+  EXPECT_EQ(value["a"].asUInt(), 1);
+}
+
+TEST(Parser, Errors) {
+  EXPECT_EQ(error_offset(""), 0);
+  EXPECT_EQ(error_offset("{\"a\": 1"), 7);
+  EXPECT_EQ(error_offset("{\"a\" 1}"), 5);
+  EXPECT_EQ(error_offset("{\"a\": 1,}"), 8);
+  EXPECT_EQ(error_offset("[1 2]"), 3);
+  EXPECT_EQ(error_offset("{\"a\": \"bla}"), 6);
+  EXPECT_EQ(error_offset("{\"a\": tru}"), 6);
+  EXPECT_EQ(error_offset("[01]"), 2);
+  EXPECT_EQ(error_offset("[1.]"), 1);
+  EXPECT_EQ(error_offset("\"\\x\""), 1);
+  EXPECT_EQ(error_offset("{} {}"), 3);
+  EXPECT_EQ(error_offset(std::string(2000, '[')),
+            freeisle::json::Parser::MaxDepth);
+}
+
+TEST(Parser, SameAsReader) {
+  const std::string text = R"({
+  "name": "Unit \"One\"",
+  "health": 100,
+  "ratio": 0.75,
+  "flags": [true, false, null],
+  "nested": {"levels": ["land", "air"], "empty": {}, "list": []},
+  "negative": -3
+})";
+
+  Json::Reader reader;
+  Json::Value expected;
+  ASSERT_TRUE(reader.parse(text.data(), text.data() + text.size(), expected,
+                           false));
+
+  const Json::Value value = parse(text);
+  freeisle::json::test::assert_json_equal(expected, value);
+  expect_same_offsets(expected, value);
+}
+
+TEST(Parser, Deferred) {
+  const std::string text = "{\"a\": {\"x\": {\"y\": [1, {\"z\": 2}]}, "
+                           "\"w\": [{\"v\": 3}], \"u\": {}}, \"b\": 4}";
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(text.data());
+
+  std::vector<Json::Value *> deferred;
+  Json::Value value = freeisle::json::parse(data, text.size(), 2, deferred);
+
+  // Objects in arrays are not deferred:
+  ASSERT_EQ(deferred.size(), 2);
+  EXPECT_EQ(deferred[0], &value["a"]["x"]);
+  EXPECT_EQ(deferred[1], &value["a"]["u"]);
+  EXPECT_TRUE(value["a"]["x"].empty());
+  EXPECT_EQ(value["a"]["w"][0]["v"].asUInt(), 3);
+  EXPECT_EQ(value["b"].asUInt(), 4);
+
+  const Json::Value expected = parse(text);
+  EXPECT_EQ(value["a"]["x"].getOffsetStart(),
+            expected["a"]["x"].getOffsetStart());
+  EXPECT_EQ(value["a"]["x"].getOffsetLimit(),
+            expected["a"]["x"].getOffsetLimit());
+
+  for (Json::Value *obj : deferred) {
+    freeisle::json::parse_deferred(data, *obj);
+  }
+  freeisle::json::test::assert_json_equal(expected, value);
+  expect_same_offsets(expected, value);
+}
+
+TEST(Parser, DeferredRepeatedKey) {
+  const std::string text = "{\"a\": {\"x\": {\"y\": 1}, \"w\": {}}, "
+                           "\"b\": {\"v\": {}}, \"a\": {\"u\": {\"z\": 2}}}";
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(text.data());
+
+  std::vector<Json::Value *> deferred;
+  Json::Value value = freeisle::json::parse(data, text.size(), 2, deferred);
+
+  // Objects of the replaced value are dropped, the last value wins:
+  ASSERT_EQ(deferred.size(), 2);
+  EXPECT_EQ(deferred[0], &value["b"]["v"]);
+  EXPECT_EQ(deferred[1], &value["a"]["u"]);
+  EXPECT_FALSE(value["a"].isMember("x"));
+
+  for (Json::Value *obj : deferred) {
+    freeisle::json::parse_deferred(data, *obj);
+  }
+  EXPECT_EQ(value["a"]["u"]["z"].asUInt(), 2);
+}
@@ -0,0 +1,144 @@
+#include "json/IncludeCache.hh"
+#include "json/LoadUtil.hh"
+#include "json/Loader.hh"
+
+#include "fs/File.hh"
+#include "core/test/util/Util.hh"
+#include "fs/test/util/TempDirFixture.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <string>
+
+namespace {
+
+struct ValuesHandler {
+  void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+    for (uint32_t i = 0; i < 8; ++i) {
+      const std::string key = "v" + std::to_string(i);
+      values.push_back(
+          freeisle::json::loader::load<uint32_t>(ctx, value, key.c_str()));
+    }
+  }
+
+  std::vector<uint32_t> values;
+};
+
+class TestPrefetch : public freeisle::fs::test::TempDirFixture {
+public:
+  void SetUp() override {
+    freeisle::fs::test::TempDirFixture::SetUp();
+    freeisle::json::loader::IncludeCache::global().clear();
+  }
+
+  void write(const std::string &path, const std::string &content) {
+    freeisle::fs::write_file(path.c_str(),
+                             reinterpret_cast<const uint8_t *>(content.data()),
+                             content.size(), nullptr);
+  }
+
+  /**
+   * Write a chain of includes: main.json includes part0.json, which
+   * includes part1.json, and so on. Each part defines one value, and
+   * some values are overridden by the including file.
+   */
+  void write_chain() {
+    write("main.json", "{\"include\": \"part0.json\", \"v0\": 100}");
+    for (uint32_t i = 0; i < 8; ++i) {
+      std::string content = "{";
+      if (i + 1 < 8) {
+        content += fmt::format("\"include\": \"part{}.json\", ", i + 1);
+      }
+      content += fmt::format("\"v{}\": {}, \"v7\": {}}}", i, i, i);
+      write(fmt::format("part{}.json", i), content);
+    }
+  }
+};
+
+} // namespace
+
+TEST_F(TestPrefetch, SameResult) {
+  write_chain();
+
+  ValuesHandler serial;
+  const std::map<std::string, freeisle::json::IncludeInfo> serial_includes =
+      freeisle::json::loader::load_root_object("main.json", serial);
+
+  freeisle::json::loader::IncludeCache::global().clear();
+
+  ValuesHandler parallel;
+  const std::map<std::string, freeisle::json::IncludeInfo> parallel_includes =
+      freeisle::json::loader::load_root_object("main.json", parallel, 4);
+
+  EXPECT_EQ(parallel.values, serial.values);
+  EXPECT_EQ(parallel.values,
+            (std::vector<uint32_t>{100, 1, 2, 3, 4, 5, 6, 0}));
+  EXPECT_EQ(parallel_includes.size(), serial_includes.size());
+}
+
+TEST_F(TestPrefetch, FillsCache) {
+  write_chain();
+
+  const freeisle::json::loader::IncludeCache &cache =
+      freeisle::json::loader::IncludeCache::global();
+
+  ValuesHandler handler;
+  freeisle::json::loader::load_root_object("main.json", handler, 3);
+
+  // All parts were parsed by the prefetch, and merging only hit the cache.
+  EXPECT_EQ(cache.size(), 8);
+  EXPECT_EQ(cache.misses(), 8);
+  EXPECT_EQ(cache.hits(), 8);
+}
+
+TEST_F(TestPrefetch, DeferredObjects) {
+  write_chain();
+  write("main.json",
+        "{\"parts\": {\"first\": {\"include\": \"part0.json\"}}}");
+
+  struct PartsHandler {
+    ValuesHandler values;
+
+    void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+      freeisle::json::loader::load_child(ctx, value, "first", values);
+    }
+  } parts;
+
+  struct RootHandler {
+    PartsHandler &parts;
+
+    void load(freeisle::json::loader::Context &ctx, Json::Value &value) {
+      freeisle::json::loader::load_object(ctx, value, "parts", parts);
+    }
+  } handler{parts};
+
+  freeisle::json::loader::load_root_object("main.json", handler, 3);
+
+  // The include in the object that was not parsed up front was prefetched
+  // as well:
+  const freeisle::json::loader::IncludeCache &cache =
+      freeisle::json::loader::IncludeCache::global();
+  EXPECT_EQ(cache.misses(), 8);
+  EXPECT_EQ(cache.hits(), 8);
+  EXPECT_EQ(parts.values.values,
+            (std::vector<uint32_t>{0, 1, 2, 3, 4, 5, 6, 0}));
+}
+
+TEST_F(TestPrefetch, Errors) {
+  write("main.json", "{\"include\": \"a.json\"}");
+  write("a.json", "{\"include\": \"b.json\"}");
+  write("b.json", "{\"include\": \"a.json\"}");
+
+  ValuesHandler handler;
+  ASSERT_THROW_KEEP_AS_E(
+      freeisle::json::loader::load_root_object("main.json", handler, 4),
+      freeisle::json::loader::Error) {
+    EXPECT_EQ(e.message(), "Cyclic include path");
+  }
+
+  write("a.json", "{\"include\": \"missing.json\"}");
+  EXPECT_THROW(
+      freeisle::json::loader::load_root_object("main.json", handler, 4),
+      freeisle::json::loader::Error);
+}
@@ -0,0 +1,171 @@
+#include "json/SaveCache.hh"
+
+#include "fs/File.hh"
+#include "fs/test/util/TempDirFixture.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace {
+
+class TestSaveCache : public freeisle::fs::test::TempDirFixture {
+public:
+  bool write(const char *path, const char *content) {
+    return cache.write_if_changed(
+        path, reinterpret_cast<const uint8_t *>(content),
+        std::strlen(content));
+  }
+
+  std::string read(const char *path) {
+    const std::vector<uint8_t> data = freeisle::fs::read_file(path, nullptr);
+    return std::string(data.begin(), data.end());
+  }
+
+  freeisle::json::saver::SaveCache cache;
+};
+
+} // namespace
+
+TEST(SaveCache, Hash) {
+  const uint8_t data[] = "0123456789abcdefghij";
+  const uint64_t hash = freeisle::json::saver::SaveCache::hash(data, 20);
+  EXPECT_EQ(freeisle::json::saver::SaveCache::hash(data, 20), hash);
+
+  // every length and every byte matters:
+  for (size_t len = 0; len < 20; ++len) {
+    EXPECT_NE(freeisle::json::saver::SaveCache::hash(data, len), hash);
+  }
+
+  for (size_t i = 0; i < 20; ++i) {
+    uint8_t changed[20];
+    std::memcpy(changed, data, 20);
+    changed[i] ^= 1;
+    EXPECT_NE(freeisle::json::saver::SaveCache::hash(changed, 20), hash);
+  }
+}
+
+TEST(SaveCache, Hasher) {
+  uint8_t data[100];
+  for (size_t i = 0; i < sizeof(data); ++i) {
+    data[i] = static_cast<uint8_t>(i * 7);
+  }
+
+  // The same hash, however the data is split:
+  for (size_t split = 0; split <= sizeof(data); split += 3) {
+    freeisle::json::saver::SaveCache::Hasher hasher;
+    hasher.update(data, split);
+    hasher.update(data + split, 0);
+    for (size_t i = split; i < sizeof(data); i += 5) {
+      hasher.update(data + i, std::min<size_t>(5, sizeof(data) - i));
+    }
+
+    EXPECT_EQ(hasher.digest(),
+              freeisle::json::saver::SaveCache::hash(data, sizeof(data)));
+  }
+}
+
+TEST_F(TestSaveCache, SkipsUnchanged) {
+  EXPECT_TRUE(write("a.json", "{}"));
+  EXPECT_TRUE(write("b.json", "[]"));
+  EXPECT_FALSE(write("a.json", "{}"));
+  EXPECT_FALSE(write("b.json", "[]"));
+  EXPECT_TRUE(write("a.json", "{\"a\": 1}"));
+
+  EXPECT_EQ(read("a.json"), "{\"a\": 1}");
+  EXPECT_EQ(read("b.json"), "[]");
+  EXPECT_EQ(cache.size(), 2);
+  EXPECT_EQ(cache.written(), 3);
+  EXPECT_EQ(cache.skipped(), 2);
+
+  cache.clear();
+  EXPECT_EQ(cache.size(), 0);
+  EXPECT_EQ(cache.written(), 0);
+  EXPECT_EQ(cache.skipped(), 0);
+  EXPECT_TRUE(write("a.json", "{\"a\": 1}"));
+}
+
+TEST_F(TestSaveCache, Version) {
+  const uint8_t data[] = {1, 2, 3};
+  cache.write("data.bin", data, sizeof(data), 42);
+  EXPECT_TRUE(cache.is_current("data.bin", 42));
+  EXPECT_FALSE(cache.is_current("data.bin", 43));
+  EXPECT_FALSE(cache.is_current("other.bin", 42));
+}
+
+TEST_F(TestSaveCache, ExternalChanges) {
+  EXPECT_TRUE(write("a.json", "{}"));
+
+  // removed:
+  ASSERT_EQ(::unlink("a.json"), 0);
+  EXPECT_TRUE(write("a.json", "{}"));
+  EXPECT_EQ(read("a.json"), "{}");
+
+  // overwritten with something else:
+  freeisle::fs::write_file("a.json",
+                           reinterpret_cast<const uint8_t *>("[1, 2]"), 6,
+                           nullptr);
+  EXPECT_TRUE(write("a.json", "{}"));
+  EXPECT_EQ(read("a.json"), "{}");
+  EXPECT_FALSE(write("a.json", "{}"));
+}
+
+TEST_F(TestSaveCache, ReplacesFile) {
+  EXPECT_TRUE(write("a.json", "{}"));
+  freeisle::fs::File old("a.json", freeisle::fs::File::OpenMode::Read, nullptr);
+
+  // The file is replaced rather than overwritten in place, so readers of
+  // the old file still see all of it:
+  EXPECT_TRUE(write("a.json", "[1, 2]"));
+  uint8_t data[2];
+  freeisle::fs::read_all(old, data, 2);
+  EXPECT_EQ(std::string(data, data + 2), "{}");
+  EXPECT_EQ(read("a.json"), "[1, 2]");
+  EXPECT_NE(::access(
+                freeisle::json::saver::SaveCache::temp_path("a.json").c_str(),
+                F_OK),
+            0);
+  EXPECT_FALSE(write("a.json", "[1, 2]"));
+
+  // A failed write leaves neither a temporary file nor a cache entry:
+  EXPECT_THROW(write("missing/a.json", "{}"), std::runtime_error);
+  EXPECT_EQ(cache.size(), 1);
+}
+
+TEST_F(TestSaveCache, WriteStreamed) {
+  const auto write_streamed = [this](const char *path, const char *content) {
+    return cache.write_if_changed(path, [content](freeisle::fs::File &file) {
+      freeisle::fs::write_all(file, reinterpret_cast<const uint8_t *>(content),
+                              std::strlen(content));
+      return freeisle::json::saver::SaveCache::hash(
+          reinterpret_cast<const uint8_t *>(content), std::strlen(content));
+    });
+  };
+
+  EXPECT_TRUE(write_streamed("a.json", "{}"));
+  EXPECT_FALSE(write("a.json", "{}"));
+  EXPECT_FALSE(write_streamed("a.json", "{}"));
+  EXPECT_TRUE(write_streamed("a.json", "[]"));
+  EXPECT_EQ(read("a.json"), "[]");
+  EXPECT_EQ(cache.written(), 2);
+  EXPECT_EQ(cache.skipped(), 2);
+  EXPECT_NE(::access(
+                freeisle::json::saver::SaveCache::temp_path("a.json").c_str(),
+                F_OK),
+            0);
+
+  // Errors while writing leave the old file:
+  EXPECT_THROW(cache.write_if_changed("a.json",
+                                      [](freeisle::fs::File &) -> uint64_t {
+                                        throw std::runtime_error("failed");
+                                      }),
+               std::runtime_error);
+  EXPECT_EQ(read("a.json"), "[]");
+  EXPECT_NE(::access(
+                freeisle::json::saver::SaveCache::temp_path("a.json").c_str(),
+                F_OK),
+            0);
+}
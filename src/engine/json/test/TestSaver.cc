@@ -60,6 +60,19 @@ struct BinaryHandler {
   std::vector<uint8_t> data;
 };
 
+/**
+ * Records whether the saved objects ended up in the document tree.
+ */
+struct StreamedAbcHandler {
+  AbcHandler abc_handler;
+  bool c_in_tree = false;
+
+  void save(freeisle::json::saver::Context &ctx, Json::Value &value) {
+    abc_handler.save(ctx, value);
+    c_in_tree = value.isMember("c");
+  }
+};
+
 class SaverFileTest : public freeisle::fs::test::TempDirFixture {};
 
 } // namespace
@@ -89,6 +102,36 @@ TEST_F(SaverFileTest, SimpleToFile) {
   freeisle::json::test::check(result, expected);
 }
 
+TEST_F(SaverFileTest, HandlerThrows) {
+  const Defg defg{.d = 54, .e = true, .f = "omg", .g = 3.5f};
+  DefgHandler handler{defg};
+  freeisle::json::saver::save_root_object("test.json", handler, nullptr);
+
+  struct ThrowingHandler {
+    DefgHandler &defg_handler;
+
+    void save(freeisle::json::saver::Context &ctx, Json::Value &value) {
+      defg_handler.save(ctx, value);
+      throw std::runtime_error("Failed to save");
+    }
+  } throwing_handler{handler};
+
+  EXPECT_THROW(freeisle::json::saver::save_root_object(
+                   "test.json", throwing_handler, nullptr),
+               std::runtime_error);
+
+  // The previous save is kept, and the temporary file is removed:
+  const std::vector<uint8_t> result =
+      freeisle::fs::read_file("test.json", nullptr);
+  freeisle::json::test::check(
+      result, "{\"d\": 54, \"e\": true, \"f\": \"omg\", \"g\": 3.5}");
+  EXPECT_THROW(freeisle::fs::read_file(
+                   freeisle::json::saver::SaveCache::temp_path("test.json")
+                       .c_str(),
+                   nullptr),
+               std::runtime_error);
+}
+
 TEST(Saver, SimpleWithRootInclude) {
   const Defg defg{.d = 54, .e = true, .f = "overridden", .g = 3.5f, .h = true};
   DefgHandler handler{defg};
@@ -121,6 +164,23 @@ TEST(Saver, CompositeWithoutIncludes) {
   freeisle::json::test::check(result, expected);
 }
 
+TEST(Saver, CompositeStreamed) {
+  const Abc abc{
+      .a = "text",
+      .b = 12,
+      .c = {.d = 54, .e = true, .f = "omg", .g = 3.5f, .h = false}};
+  StreamedAbcHandler handler{.abc_handler = AbcHandler(abc)};
+
+  const std::vector<uint8_t> result =
+      freeisle::json::saver::save_root_object(handler, nullptr);
+
+  // The sub-object is written out without being added to the tree:
+  EXPECT_FALSE(handler.c_in_tree);
+  const std::string expected = "{\"a\": \"text\", \"b\": 12, \"c\": {\"d\": "
+                               "54, \"e\": true, \"f\": \"omg\", \"g\": 3.5}}";
+  freeisle::json::test::check(result, expected);
+}
+
 TEST(Saver, CompositeWithSimpleInclude) {
   const Abc abc{
       .a = "hi",
@@ -315,3 +375,39 @@ TEST_F(SaverFileTest, BinaryExternal) {
   EXPECT_EQ(data[2], 1);
   EXPECT_EQ(data[3], 49);
 }
+
+TEST_F(SaverFileTest, Cached) {
+  Abc abc{.a = "text",
+          .b = 12,
+          .c = {.d = 54, .e = true, .f = "omg", .g = 3.5f, .h = false}};
+  AbcHandler handler{abc};
+  freeisle::json::saver::SaveCache cache;
+
+  const auto save = [&handler, &cache]() {
+    freeisle::json::saver::save_root_object("test.json", handler, nullptr,
+                                            freeisle::json::Style::Pretty,
+                                            &cache);
+    return freeisle::fs::read_file("test.json", nullptr);
+  };
+
+  const std::vector<uint8_t> first = save();
+  freeisle::json::test::check(first, "{\"a\": \"text\", \"b\": 12, \"c\": "
+                                     "{\"d\": 54, \"e\": true, \"f\": "
+                                     "\"omg\", \"g\": 3.5}}");
+  EXPECT_EQ(save(), first);
+  EXPECT_EQ(cache.written(), 1);
+  EXPECT_EQ(cache.skipped(), 1);
+
+  // The temporary file is removed when the document did not change:
+  EXPECT_THROW(freeisle::fs::read_file(
+                   freeisle::json::saver::SaveCache::temp_path("test.json")
+                       .c_str(),
+                   nullptr),
+               std::runtime_error);
+
+  abc.c.d = 55;
+  freeisle::json::test::check(save(), "{\"a\": \"text\", \"b\": 12, \"c\": "
+                                      "{\"d\": 55, \"e\": true, \"f\": "
+                                      "\"omg\", \"g\": 3.5}}");
+  EXPECT_EQ(cache.written(), 2);
+}
@@ -0,0 +1,71 @@
+#include "json/TreePaths.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+
+TEST(TreePaths, Root) {
+  freeisle::json::TreePaths paths;
+  EXPECT_EQ(paths.size(), 1);
+  EXPECT_EQ(paths.render(freeisle::json::TreePaths::Root), "");
+  EXPECT_EQ(paths.parent(freeisle::json::TreePaths::Root),
+            freeisle::json::TreePaths::Root);
+  EXPECT_EQ(paths.intern(""), freeisle::json::TreePaths::Root);
+}
+
+TEST(TreePaths, ChildIsInterned) {
+  freeisle::json::TreePaths paths;
+  const uint32_t a = paths.child(freeisle::json::TreePaths::Root, "a");
+  const uint32_t b = paths.child(a, "b");
+  const uint32_t other_b = paths.child(freeisle::json::TreePaths::Root, "b");
+
+  EXPECT_NE(a, b);
+  EXPECT_NE(b, other_b);
+  EXPECT_EQ(paths.child(freeisle::json::TreePaths::Root, "a"), a);
+  EXPECT_EQ(paths.child(a, "b"), b);
+  EXPECT_EQ(paths.size(), 4);
+
+  EXPECT_EQ(paths.parent(b), a);
+  EXPECT_EQ(paths.parent(a), freeisle::json::TreePaths::Root);
+  EXPECT_EQ(paths.key(b), "b");
+  EXPECT_EQ(paths.render(b), ".a.b");
+  EXPECT_EQ(paths.render(other_b), ".b");
+}
+
+TEST(TreePaths, Intern) {
+  freeisle::json::TreePaths paths;
+  const uint32_t node = paths.intern(".map.decorations.tree");
+  EXPECT_EQ(paths.render(node), ".map.decorations.tree");
+  EXPECT_EQ(paths.size(), 4);
+
+  const uint32_t decorations =
+      paths.child(paths.child(freeisle::json::TreePaths::Root, "map"),
+                  "decorations");
+  EXPECT_EQ(paths.parent(node), decorations);
+  EXPECT_EQ(paths.intern(".map.decorations"), decorations);
+  EXPECT_EQ(paths.child(decorations, "tree"), node);
+}
+
+TEST(TreePaths, EmptyKey) {
+  freeisle::json::TreePaths paths;
+  const uint32_t node = paths.child(freeisle::json::TreePaths::Root, "");
+  EXPECT_NE(node, freeisle::json::TreePaths::Root);
+  EXPECT_EQ(paths.render(node), ".");
+  EXPECT_EQ(paths.intern("."), node);
+}
+
+TEST(TreePaths, Grow) {
+  freeisle::json::TreePaths paths;
+  uint32_t node = freeisle::json::TreePaths::Root;
+  std::string expected;
+  for (uint32_t i = 0; i < 1000; ++i) {
+    const std::string key = "key" + std::to_string(i % 10);
+    node = paths.child(node, key);
+    expected += "." + key;
+  }
+
+  EXPECT_EQ(paths.size(), 1001);
+  EXPECT_EQ(paths.render(node), expected);
+  EXPECT_EQ(paths.intern(expected), node);
+  EXPECT_EQ(paths.size(), 1001);
+}
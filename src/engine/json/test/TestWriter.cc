@@ -0,0 +1,184 @@
+#include "json/Parser.hh"
+#include "json/Writer.hh"
+
+#include "fs/File.hh"
+#include "fs/test/util/TempDirFixture.hh"
+#include "json/test/Util.hh"
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <string>
+
+namespace {
+
+std::string to_string(const std::vector<uint8_t> &data) {
+  return std::string(data.begin(), data.end());
+}
+
+std::string write(const Json::Value &value, freeisle::json::Style style) {
+  freeisle::json::Writer writer(style);
+  writer.value(value);
+  writer.finish();
+  return to_string(writer.take());
+}
+
+Json::Value make_document() {
+  Json::Value value(Json::ValueType::objectValue);
+  value["name"] = "grunt";
+  value["armor"] = 250;
+  value["offset"] = -3;
+  value["ratio"] = 0.5;
+  value["caps"] = Json::Value(Json::ValueType::arrayValue);
+  value["caps"].append("capture");
+  value["caps"].append(true);
+  value["caps"].append(Json::Value::null);
+  value["empty_object"] = Json::Value(Json::ValueType::objectValue);
+  value["empty_array"] = Json::Value(Json::ValueType::arrayValue);
+  value["nested"]["a"]["b"] = 1u;
+  return value;
+}
+
+class TestWriter : public freeisle::fs::test::TempDirFixture {};
+
+} // namespace
+
+TEST(Writer, Compact) {
+  EXPECT_EQ(write(make_document(), freeisle::json::Style::Compact),
+            "{\"armor\":250,\"caps\":[\"capture\",true,null],"
+            "\"empty_array\":[],\"empty_object\":{},\"name\":\"grunt\","
+            "\"nested\":{\"a\":{\"b\":1}},\"offset\":-3,\"ratio\":0.5}");
+}
+
+TEST(Writer, Pretty) {
+  EXPECT_EQ(write(make_document(), freeisle::json::Style::Pretty),
+            "{\n"
+            "  \"armor\": 250,\n"
+            "  \"caps\": [\n"
+            "    \"capture\",\n"
+            "    true,\n"
+            "    null\n"
+            "  ],\n"
+            "  \"empty_array\": [],\n"
+            "  \"empty_object\": {},\n"
+            "  \"name\": \"grunt\",\n"
+            "  \"nested\": {\n"
+            "    \"a\": {\n"
+            "      \"b\": 1\n"
+            "    }\n"
+            "  },\n"
+            "  \"offset\": -3,\n"
+            "  \"ratio\": 0.5\n"
+            "}\n");
+}
+
+TEST(Writer, Primitives) {
+  EXPECT_EQ(write(Json::Value(42), freeisle::json::Style::Compact), "42");
+  EXPECT_EQ(write(Json::Value(), freeisle::json::Style::Compact), "null");
+  EXPECT_EQ(write(Json::Value(false), freeisle::json::Style::Pretty),
+            "false\n");
+  EXPECT_EQ(write(Json::Value(std::numeric_limits<uint64_t>::max()),
+                  freeisle::json::Style::Compact),
+            "18446744073709551615");
+  EXPECT_EQ(write(Json::Value(std::numeric_limits<int64_t>::min()),
+                  freeisle::json::Style::Compact),
+            "-9223372036854775808");
+}
+
+TEST(Writer, Reals) {
+  EXPECT_EQ(write(Json::Value(100.0), freeisle::json::Style::Compact),
+            "100.0");
+  EXPECT_EQ(write(Json::Value(34.2), freeisle::json::Style::Compact), "34.2");
+  EXPECT_EQ(write(Json::Value(1e300), freeisle::json::Style::Compact),
+            "1e+300");
+  EXPECT_EQ(write(Json::Value(std::nan("")), freeisle::json::Style::Compact),
+            "null");
+
+  // shortest representation still reads back as the same value
+  const double val = 0.1 + 0.2;
+  const std::string str =
+      write(Json::Value(val), freeisle::json::Style::Compact);
+  const Json::Value parsed = freeisle::json::parse(
+      reinterpret_cast<const uint8_t *>(str.data()), str.size());
+  EXPECT_EQ(parsed.asDouble(), val);
+}
+
+TEST(Writer, Escapes) {
+  EXPECT_EQ(write(Json::Value("a\"b\\c\nd\te\x01\xc3\xa4"),
+                  freeisle::json::Style::Compact),
+            "\"a\\\"b\\\\c\\nd\\te\\u0001\xc3\xa4\"");
+
+  Json::Value value(Json::ValueType::objectValue);
+  value["key\"with\"quotes"] = "";
+  EXPECT_EQ(write(value, freeisle::json::Style::Compact),
+            "{\"key\\\"with\\\"quotes\":\"\"}");
+}
+
+TEST(Writer, Events) {
+  freeisle::json::Writer writer(freeisle::json::Style::Compact);
+  writer.begin_object();
+  writer.key("a");
+  writer.begin_array();
+  writer.int_value(-1);
+  writer.uint_value(2);
+  writer.real_value(0.25);
+  writer.end_array();
+  writer.key("b");
+  writer.string("c");
+  writer.end_object();
+  writer.finish();
+
+  EXPECT_EQ(to_string(writer.take()), "{\"a\":[-1,2,0.25],\"b\":\"c\"}");
+}
+
+TEST_F(TestWriter, File) {
+  Json::Value value(Json::ValueType::arrayValue);
+  for (uint32_t i = 0; i < 1000; ++i) {
+    value.append(make_document());
+  }
+
+  // small buffer, so that it is flushed many times
+  {
+    freeisle::fs::File file(
+        "test.json",
+        freeisle::core::Bitmask<freeisle::fs::File::OpenMode>(
+            freeisle::fs::File::OpenMode::Write,
+            freeisle::fs::File::OpenMode::Create),
+        nullptr);
+    freeisle::json::Writer writer(file, freeisle::json::Style::Pretty, 64);
+    writer.value(value);
+    writer.finish();
+  }
+
+  const std::vector<uint8_t> data =
+      freeisle::fs::read_file("test.json", nullptr);
+  EXPECT_EQ(to_string(data), write(value, freeisle::json::Style::Pretty));
+  freeisle::json::test::check(data, write(value,
+                                          freeisle::json::Style::Compact));
+}
+
+TEST_F(TestWriter, FileLongStrings) {
+  // Strings at least a quarter of the buffer size are written directly,
+  // together with the buffered output before them:
+  Json::Value value(Json::ValueType::objectValue);
+  value["short"] = "abc";
+  value[std::string(40, 'k')] = std::string(100, 'x');
+  value["escaped"] = std::string(30, 'y') + "\n\"" + std::string(5000, 'z');
+  value["after"] = 1;
+
+  {
+    freeisle::fs::File file(
+        "test.json",
+        freeisle::core::Bitmask<freeisle::fs::File::OpenMode>(
+            freeisle::fs::File::OpenMode::Write,
+            freeisle::fs::File::OpenMode::Create),
+        nullptr);
+    freeisle::json::Writer writer(file, freeisle::json::Style::Pretty, 64);
+    writer.value(value);
+    writer.finish();
+  }
+
+  EXPECT_EQ(to_string(freeisle::fs::read_file("test.json", nullptr)),
+            write(value, freeisle::json::Style::Pretty));
+}
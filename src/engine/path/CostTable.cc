@@ -0,0 +1,115 @@
+#include "path/CostTable.hh"
+
+#include "path/MovementCost.hh"
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+namespace freeisle::path {
+
+CostTable::CostTable(const def::MapDef &map,
+                     const def::Collection<def::UnitDef> &defs)
+    : map_(&map), defs_(&defs), width_(0), height_(0) {
+  update_map();
+  update_unit_defs();
+}
+
+const uint16_t *CostTable::costs(const def::UnitDef &def,
+                                 def::Level level) const {
+  return entry(def).costs[static_cast<uint32_t>(level)];
+}
+
+uint32_t CostTable::max_cost(const def::UnitDef &def) const {
+  return entry(def).max_cost;
+}
+
+core::Grid<uint16_t> CostTable::cost_grid(const def::UnitDef &def,
+                                          def::Level level) const {
+  const uint16_t *table = costs(def, level);
+
+  core::Grid<uint16_t> grid(width_, height_);
+  uint16_t *out = &grid(0, 0);
+  for (size_t i = 0; i < codes_.size(); ++i) {
+    out[i] = table[codes_[i]];
+  }
+
+  return grid;
+}
+
+void CostTable::update_hex(uint32_t x, uint32_t y) {
+  assert(x < width_ && y < height_);
+  codes_[y * width_ + x] = terrain_code(map_->grid(x, y));
+}
+
+void CostTable::update_map() {
+  width_ = map_->grid.width();
+  height_ = map_->grid.height();
+  codes_.resize(static_cast<size_t>(width_) * height_);
+
+  for (uint32_t y = 0; y < height_; ++y) {
+    for (uint32_t x = 0; x < width_; ++x) {
+      codes_[y * width_ + x] = terrain_code(map_->grid(x, y));
+    }
+  }
+}
+
+void CostTable::update_unit_def(const def::UnitDef &def) {
+  const auto iter = index_.find(&def);
+  assert(iter != index_.end());
+  compile(def, entries_[iter->second]);
+}
+
+void CostTable::update_unit_defs() {
+  entries_.resize(defs_->size());
+  index_.clear();
+
+  uint32_t index = 0;
+  for (const auto &[id, def] : *defs_) {
+    compile(def, entries_[index]);
+    index_.emplace(&def, index);
+    ++index;
+  }
+}
+
+void CostTable::compile(const def::UnitDef &def, Entry &entry) {
+  entry.max_cost = 0;
+
+  for (uint32_t level = 0; level < NumLevels; ++level) {
+    for (uint32_t b = 0; b < static_cast<uint32_t>(def::BaseTerrainType::Num);
+         ++b) {
+      def::MapDef::Hex hex{.base_terrain =
+                               static_cast<def::BaseTerrainType>(b)};
+
+      for (uint32_t o = 0;
+           o <= static_cast<uint32_t>(def::OverlayTerrainType::Num); ++o) {
+        if (o < static_cast<uint32_t>(def::OverlayTerrainType::Num)) {
+          hex.overlay_terrain = static_cast<def::OverlayTerrainType>(o);
+        } else {
+          hex.overlay_terrain = decltype(hex.overlay_terrain)();
+        }
+
+        const uint32_t cost =
+            movement_cost(def, static_cast<def::Level>(level), hex);
+        if (cost > 0xffff) {
+          throw std::runtime_error(fmt::format(
+              "Movement cost {} of unit \"{}\" exceeds maximum of {}", cost,
+              def.name, 0xffff));
+        }
+
+        entry.costs[level][terrain_code(hex)] = cost;
+        entry.max_cost = std::max(entry.max_cost, cost);
+      }
+    }
+  }
+}
+
+const CostTable::Entry &CostTable::entry(const def::UnitDef &def) const {
+  const auto iter = index_.find(&def);
+  assert(iter != index_.end());
+  return entries_[iter->second];
+}
+
+} // namespace freeisle::path
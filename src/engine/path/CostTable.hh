@@ -0,0 +1,169 @@
+#pragma once
+
+#include "def/Collection.hh"
+#include "def/Level.hh"
+#include "def/MapDef.hh"
+#include "def/UnitDef.hh"
+
+#include "core/Grid.hh"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+namespace freeisle::path {
+
+/**
+ * Compact code for the terrain of a hex, combining base and overlay
+ * terrain into a single byte.
+ */
+using TerrainCode = uint8_t;
+
+/**
+ * Number of distinct terrain codes: every base terrain, either without
+ * overlay or with one of the overlay terrains.
+ */
+constexpr uint32_t NumTerrainCodes =
+    static_cast<uint32_t>(def::BaseTerrainType::Num) *
+    (static_cast<uint32_t>(def::OverlayTerrainType::Num) + 1);
+
+/**
+ * Number of levels a unit can be on.
+ */
+constexpr uint32_t NumLevels = static_cast<uint32_t>(def::Level::HighAir) + 1;
+
+/**
+ * Returns the terrain code for the given hex.
+ */
+inline TerrainCode terrain_code(const def::MapDef::Hex &hex) {
+  const uint32_t overlay =
+      hex.overlay_terrain ? static_cast<uint32_t>(*hex.overlay_terrain)
+                          : static_cast<uint32_t>(def::OverlayTerrainType::Num);
+
+  return static_cast<uint32_t>(hex.base_terrain) *
+             (static_cast<uint32_t>(def::OverlayTerrainType::Num) + 1) +
+         overlay;
+}
+
+/**
+ * Movement costs of a map, compiled for fast lookup.
+ *
+ * Every hex of the map is encoded as a terrain code, and for every unit
+ * definition and level there is a flat table mapping terrain codes to
+ * movement costs, with the overlay rule already applied. Looking up the cost
+ * of a hex is then a single indexed load, and scanning the whole map for a
+ * unit type is a linear pass over the terrain codes.
+ *
+ * The table refers to the map definition and unit definitions it was
+ * compiled from, which must outlive it. It does not notice changes to them
+ * by itself: whoever modifies the map or the unit definitions must call the
+ * corresponding update function, which recompiles only what is affected.
+ */
+class CostTable {
+public:
+  /**
+   * Compile the movement costs for the given map and all given unit
+   * definitions. Throws std::runtime_error if a movement cost exceeds the
+   * range of 16 bit.
+   */
+  CostTable(const def::MapDef &map, const def::Collection<def::UnitDef> &defs);
+
+  CostTable(const CostTable &) = delete;
+  CostTable(CostTable &&) = default;
+  CostTable &operator=(const CostTable &) = delete;
+  CostTable &operator=(CostTable &&) = default;
+
+  uint32_t width() const { return width_; }
+  uint32_t height() const { return height_; }
+
+  /**
+   * Returns the terrain codes of all hexes, in row-major order.
+   */
+  const TerrainCode *codes() const { return codes_.data(); }
+
+  /**
+   * Returns the terrain code of the hex at the given location.
+   */
+  TerrainCode code(uint32_t x, uint32_t y) const {
+    return codes_[y * width_ + x];
+  }
+
+  /**
+   * Returns the table of movement costs for a unit with the given definition
+   * at the given level, indexed by terrain code. A cost of 0 means that the
+   * terrain cannot be entered. The unit definition must be part of the
+   * collection the table was compiled from.
+   */
+  const uint16_t *costs(const def::UnitDef &def, def::Level level) const;
+
+  /**
+   * Returns the highest movement cost of any terrain for a unit with the
+   * given definition, at any level.
+   */
+  uint32_t max_cost(const def::UnitDef &def) const;
+
+  /**
+   * Returns the cost for a unit with the given definition at the given
+   * level to enter the hex at the given location.
+   */
+  uint32_t cost(const def::UnitDef &def, def::Level level, uint32_t x,
+                uint32_t y) const {
+    return costs(def, level)[code(x, y)];
+  }
+
+  /**
+   * Returns a grid with the movement cost of every hex of the map for a unit
+   * with the given definition at the given level.
+   */
+  core::Grid<uint16_t> cost_grid(const def::UnitDef &def,
+                                 def::Level level) const;
+
+  /**
+   * Recompile the terrain code of a single hex, after its terrain has been
+   * changed.
+   */
+  void update_hex(uint32_t x, uint32_t y);
+
+  /**
+   * Recompile the terrain codes of all hexes, e.g. after the map has been
+   * resized or replaced.
+   */
+  void update_map();
+
+  /**
+   * Recompile the cost tables of a single unit definition, after its
+   * movement costs have been changed.
+   */
+  void update_unit_def(const def::UnitDef &def);
+
+  /**
+   * Recompile the cost tables of all unit definitions, e.g. after unit
+   * definitions have been added or removed.
+   */
+  void update_unit_defs();
+
+private:
+  /**
+   * Cost tables of one unit definition, one for each level.
+   */
+  struct Entry {
+    uint16_t costs[NumLevels][NumTerrainCodes];
+    uint32_t max_cost;
+  };
+
+  static void compile(const def::UnitDef &def, Entry &entry);
+
+  const Entry &entry(const def::UnitDef &def) const;
+
+  const def::MapDef *map_;
+  const def::Collection<def::UnitDef> *defs_;
+
+  uint32_t width_;
+  uint32_t height_;
+  std::vector<TerrainCode> codes_;
+
+  std::vector<Entry> entries_;
+  std::unordered_map<const def::UnitDef *, uint32_t> index_;
+};
+
+} // namespace freeisle::path
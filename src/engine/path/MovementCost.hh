@@ -0,0 +1,34 @@
+#pragma once
+
+#include "def/Level.hh"
+#include "def/MapDef.hh"
+#include "def/UnitDef.hh"
+
+#include <cstdint>
+
+namespace freeisle::path {
+
+/**
+ * Returns whether overlay terrain on a hex applies to units at the given
+ * level. Overlay terrain such as roads or forests is only relevant for land
+ * units; e.g. a ship on a hex with water base terrain and a road overlay
+ * (a bridge) moves according to the water terrain.
+ */
+inline bool overlay_applies(def::Level level) {
+  return level == def::Level::Land;
+}
+
+/**
+ * Returns the cost for a unit with the given definition at the given level
+ * to enter the given hex. A cost of 0 means that the hex cannot be entered.
+ */
+inline uint32_t movement_cost(const def::UnitDef &def, def::Level level,
+                              const def::MapDef::Hex &hex) {
+  if (hex.overlay_terrain && overlay_applies(level)) {
+    return def.movement_cost[*hex.overlay_terrain];
+  }
+
+  return def.movement_cost[hex.base_terrain];
+}
+
+} // namespace freeisle::path
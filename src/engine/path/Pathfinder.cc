@@ -0,0 +1,254 @@
+#include "path/Pathfinder.hh"
+
+#include "path/MovementCost.hh"
+
+#include "state/Allegiance.hh"
+
+#include "core/Hex.hh"
+
+#include <algorithm>
+#include <cassert>
+
+namespace freeisle::path {
+
+namespace {
+
+/**
+ * Returns the highest movement cost of any terrain for the given unit,
+ * which bounds the range of costs pending in the bucket queue.
+ */
+uint32_t max_movement_cost(const def::UnitDef &def) {
+  return *std::max_element(def.movement_cost.data(),
+                           def.movement_cost.data() + def.movement_cost.size());
+}
+
+} // namespace
+
+Pathfinder::Pathfinder() : width_(0), height_(0), stamp_(0) {}
+
+void Pathfinder::reset(uint32_t width, uint32_t height, uint64_t num_buckets) {
+  if (width != width_ || height != height_) {
+    width_ = width;
+    height_ = height;
+    labels_.assign(static_cast<size_t>(width) * height, Label{0, 0});
+    stamp_ = 0;
+  }
+
+  if (++stamp_ == 0) {
+    // wrapped around: old stamps could become valid again
+    std::fill(labels_.begin(), labels_.end(), Label{0, 0});
+    stamp_ = 1;
+  }
+
+  nodes_.clear();
+
+  if (buckets_.size() < num_buckets) {
+    buckets_.resize(num_buckets);
+  }
+
+  for (uint64_t i = 0; i < num_buckets; ++i) {
+    buckets_[i].clear();
+  }
+}
+
+const std::vector<Node> &Pathfinder::compute(const state::Map &map,
+                                             const state::Unit &unit) {
+  assert(map.def != nullptr);
+  assert(unit.def);
+
+  const def::UnitDef &def = *unit.def;
+  const def::MapDef &map_def = *map.def;
+  const def::Level level = unit.level;
+
+  return search(map, unit, max_movement_cost(def),
+                [&def, &map_def, level](uint32_t x, uint32_t y) {
+                  return movement_cost(def, level, map_def.grid(x, y));
+                });
+}
+
+const std::vector<Node> &Pathfinder::compute(const state::Map &map,
+                                             const state::Unit &unit,
+                                             const CostTable &costs) {
+  assert(unit.def);
+  assert(costs.width() == map.grid.width());
+  assert(costs.height() == map.grid.height());
+
+  const uint16_t *table = costs.costs(*unit.def, unit.level);
+  const TerrainCode *codes = costs.codes();
+  const uint32_t width = costs.width();
+
+  return search(map, unit, costs.max_cost(*unit.def),
+                [table, codes, width](uint32_t x, uint32_t y) -> uint32_t {
+                  return table[codes[y * width + x]];
+                });
+}
+
+template <typename CostFn>
+const std::vector<Node> &Pathfinder::search(const state::Map &map,
+                                            const state::Unit &unit,
+                                            uint32_t max_cost,
+                                            CostFn cost_fn) {
+  const def::UnitDef &def = *unit.def;
+  // Steps costing more than the unit's movement are never queued, so the
+  // ring only needs to span the cheaper of the two. Computed in 64 bits,
+  // since both may be as large as UINT32_MAX.
+  const uint64_t num_buckets =
+      static_cast<uint64_t>(std::min(max_cost, unit.movement)) + 1;
+
+  reset(map.grid.width(), map.grid.height(), num_buckets);
+
+  const def::Location &start = unit.location;
+  assert(start.x < width_ && start.y < height_);
+
+  Label &start_label = labels_[start.y * width_ + start.x];
+  start_label.stamp = stamp_;
+  start_label.node = 0;
+  nodes_.push_back(Node{.location = start,
+                        .cost = 0,
+                        .steps = 0,
+                        .pred = Node::NoPred,
+                        .can_stop = true});
+
+  if (max_cost == 0) {
+    // unit cannot enter any terrain
+    return nodes_;
+  }
+
+  buckets_[0].push_back(0);
+  uint32_t pending = 1;
+
+  const bool subsurface = unit.level == def::Level::UnderWater;
+  const bool can_capture = def.caps.is_set(def::UnitDef::Cap::Capture);
+
+  for (uint32_t cost = 0; pending > 0 && cost <= unit.movement; ++cost) {
+    std::vector<uint32_t> &bucket = buckets_[cost % num_buckets];
+
+    // Note that the bucket cannot grow while it is being processed, since
+    // all step costs are at least 1 and less than num_buckets.
+    for (uint32_t i = 0; i < bucket.size(); ++i) {
+      const uint32_t index = bucket[i];
+      --pending;
+
+      if (nodes_[index].cost != cost) {
+        // stale entry; node was reached more cheaply in the meantime
+        continue;
+      }
+
+      const def::Location loc = nodes_[index].location;
+      const uint32_t steps = nodes_[index].steps;
+
+      if (index != 0 && map.grid(loc.x, loc.y).has_shop()) {
+        // Entering a shop ends movement
+        continue;
+      }
+
+      if (steps >= unit.fuel) {
+        continue;
+      }
+
+      uint32_t nx[core::hex::NumNeighbors];
+      uint32_t ny[core::hex::NumNeighbors];
+      const uint32_t n =
+          core::hex::neighbors(loc.x, loc.y, width_, height_, nx, ny);
+
+      for (uint32_t j = 0; j < n; ++j) {
+        const uint32_t step_cost = cost_fn(nx[j], ny[j]);
+        if (step_cost == 0 || step_cost > unit.movement - cost) {
+          continue;
+        }
+
+        const state::Map::Hex hex = map.grid(nx[j], ny[j]);
+        bool can_stop = true;
+
+        if (hex.has_shop()) {
+          const def::NullableRef<state::Shop> &shop = map.shop(nx[j], ny[j]);
+          if (!state::are_allied(shop->owner, unit.owner) && !can_capture) {
+            continue;
+          }
+        } else if (!hex.empty()) {
+          const def::NullableRef<state::Unit> &occupant =
+              map.unit(nx[j], ny[j], subsurface);
+          if (occupant) {
+            if (!state::are_allied(occupant->owner, unit.owner)) {
+              continue;
+            }
+
+            can_stop = false;
+          }
+        }
+
+        const uint32_t new_cost = cost + step_cost;
+        Label &label = labels_[ny[j] * width_ + nx[j]];
+
+        if (label.stamp != stamp_) {
+          label.stamp = stamp_;
+          label.node = nodes_.size();
+          nodes_.push_back(Node{.location = {.x = nx[j], .y = ny[j]},
+                                .cost = new_cost,
+                                .steps = steps + 1,
+                                .pred = index,
+                                .can_stop = can_stop});
+        } else {
+          Node &node = nodes_[label.node];
+          if (new_cost > node.cost ||
+              (new_cost == node.cost && steps + 1 >= node.steps)) {
+            continue;
+          }
+
+          const bool requeue = new_cost < node.cost;
+          node.cost = new_cost;
+          node.steps = steps + 1;
+          node.pred = index;
+
+          if (!requeue) {
+            // Already queued in the bucket for this cost
+            continue;
+          }
+        }
+
+        buckets_[new_cost % num_buckets].push_back(label.node);
+        ++pending;
+      }
+    }
+
+    bucket.clear();
+  }
+
+  return nodes_;
+}
+
+const std::vector<Node> &Pathfinder::nodes() const { return nodes_; }
+
+const Node *Pathfinder::find(uint32_t x, uint32_t y) const {
+  if (x >= width_ || y >= height_) {
+    return nullptr;
+  }
+
+  const Label &label = labels_[y * width_ + x];
+  if (label.stamp != stamp_) {
+    return nullptr;
+  }
+
+  return &nodes_[label.node];
+}
+
+std::vector<def::Location> Pathfinder::path_to(uint32_t x, uint32_t y) const {
+  std::vector<def::Location> result;
+
+  const Node *node = find(x, y);
+  if (node == nullptr) {
+    return result;
+  }
+
+  result.resize(node->steps + 1);
+  for (uint32_t i = node->steps + 1; i > 0; --i) {
+    assert(node != nullptr);
+    result[i - 1] = node->location;
+    node = node->pred == Node::NoPred ? nullptr : &nodes_[node->pred];
+  }
+
+  assert(node == nullptr);
+  return result;
+}
+
+} // namespace freeisle::path
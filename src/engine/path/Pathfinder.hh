@@ -0,0 +1,148 @@
+#pragma once
+
+#include "path/CostTable.hh"
+
+#include "state/Map.hh"
+#include "state/Unit.hh"
+
+#include "def/Location.hh"
+
+#include <cstdint>
+#include <vector>
+
+namespace freeisle::path {
+
+/**
+ * A hex that a unit can reach during its turn.
+ */
+struct Node {
+  /**
+   * Marks a node without predecessor, i.e. the start node.
+   */
+  static constexpr uint32_t NoPred = 0xffffffff;
+
+  /**
+   * Location of the hex on the map.
+   */
+  def::Location location;
+
+  /**
+   * Movement points needed to reach the hex.
+   */
+  uint32_t cost;
+
+  /**
+   * Number of hexes traversed to reach the hex. This is also the amount of
+   * fuel used.
+   */
+  uint32_t steps;
+
+  /**
+   * Index of the node from which this hex is entered on the cheapest path,
+   * or NoPred for the node where the unit starts.
+   */
+  uint32_t pred;
+
+  /**
+   * Whether the unit can end its movement on this hex. This is false for
+   * hexes that are occupied by friendly units, which can be passed through,
+   * but not stopped on.
+   */
+  bool can_stop;
+};
+
+/**
+ * Computes the set of hexes that a unit can reach with its remaining
+ * movement points and fuel, together with the cheapest path to each of them.
+ *
+ * The search is a Dijkstra search with a bucket queue, exploiting the fact
+ * that movement costs are small integers. A pathfinder keeps its scratch
+ * memory between searches, so that repeated searches on the same map do
+ * not allocate. Reuse one pathfinder object per thread.
+ *
+ * Movement rules:
+ *  - A hex with movement cost 0 for the unit cannot be entered.
+ *  - Hexes occupied by hostile units at the unit's layer (surface or
+ *    subsurface) cannot be entered. Hexes occupied by friendly units (same
+ *    owner or same team) can be passed through, but not stopped on.
+ *  - Shops end movement: a shop owned by a friendly player can be entered,
+ *    and other shops can be entered by units that can capture. Movement
+ *    does not continue beyond a shop.
+ *  - Fuel limits the number of hexes on the cheapest path: among paths of
+ *    equal cost, the one with the fewest hexes is chosen.
+ */
+class Pathfinder {
+public:
+  Pathfinder();
+
+  Pathfinder(const Pathfinder &) = delete;
+  Pathfinder(Pathfinder &&) = default;
+  Pathfinder &operator=(const Pathfinder &) = delete;
+  Pathfinder &operator=(Pathfinder &&) = default;
+
+  /**
+   * Compute all hexes reachable by the given unit on the given map. The
+   * first node returned is the unit's own location. The result is valid
+   * until the next call to compute().
+   */
+  const std::vector<Node> &compute(const state::Map &map,
+                                   const state::Unit &unit);
+
+  /**
+   * Same as above, but looks up movement costs in the given precompiled
+   * cost table instead of the map and unit definitions. The table must be
+   * compiled for the definition of the given map.
+   */
+  const std::vector<Node> &compute(const state::Map &map,
+                                   const state::Unit &unit,
+                                   const CostTable &costs);
+
+  /**
+   * Returns the nodes found by the last call to compute().
+   */
+  const std::vector<Node> &nodes() const;
+
+  /**
+   * Returns the node for the given location if it was found to be reachable
+   * by the last call to compute(), or nullptr otherwise.
+   */
+  const Node *find(uint32_t x, uint32_t y) const;
+
+  /**
+   * Returns the cheapest path from the unit's location to the given
+   * location, including both the start and the end. Returns an empty path
+   * if the location is not reachable.
+   */
+  std::vector<def::Location> path_to(uint32_t x, uint32_t y) const;
+
+private:
+  /**
+   * Per-hex bookkeeping. A label is only valid if its stamp matches the
+   * stamp of the current search, which avoids clearing the whole grid for
+   * every search.
+   */
+  struct Label {
+    uint32_t stamp;
+    uint32_t node;
+  };
+
+  void reset(uint32_t width, uint32_t height, uint64_t num_buckets);
+
+  /**
+   * Run the search. cost_fn(x, y) returns the cost for the unit to enter
+   * the hex at the given location, and max_cost bounds all such costs.
+   */
+  template <typename CostFn>
+  const std::vector<Node> &search(const state::Map &map,
+                                  const state::Unit &unit, uint32_t max_cost,
+                                  CostFn cost_fn);
+
+  uint32_t width_;
+  uint32_t height_;
+  uint32_t stamp_;
+  std::vector<Label> labels_;
+  std::vector<Node> nodes_;
+  std::vector<std::vector<uint32_t>> buckets_;
+};
+
+} // namespace freeisle::path
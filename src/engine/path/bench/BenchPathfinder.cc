@@ -0,0 +1,148 @@
+#include "path/Pathfinder.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  Fixture(uint32_t size) : Scenario(size, size) {
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> terrain(0, 9);
+
+    for (uint32_t y = 0; y < size; ++y) {
+      for (uint32_t x = 0; x < size; ++x) {
+        freeisle::def::MapDef::Hex &hex = scenario.map.grid(x, y);
+        switch (terrain(rng)) {
+        case 0:
+          hex.base_terrain = freeisle::def::BaseTerrainType::DeepWater;
+          break;
+        case 1:
+          hex.base_terrain = freeisle::def::BaseTerrainType::Hill;
+          break;
+        case 2:
+          hex.overlay_terrain = freeisle::def::OverlayTerrainType::Forest;
+          break;
+        case 3:
+          hex.overlay_terrain = freeisle::def::OverlayTerrainType::Road;
+          break;
+        default:
+          hex.base_terrain = freeisle::def::BaseTerrainType::Grass;
+          break;
+        }
+      }
+    }
+
+    freeisle::def::UnitDef &tank =
+        add_unit_def("tank", freeisle::def::UnitDef{
+                                 .name = "tank",
+                                 .level = freeisle::def::Level::Land,
+                             });
+    tank.movement_cost[freeisle::def::BaseTerrainType::DeepWater] = 0;
+    tank.movement_cost[freeisle::def::BaseTerrainType::Hill] = 200;
+    tank.movement_cost[freeisle::def::OverlayTerrainType::Forest] = 150;
+    tank.movement_cost[freeisle::def::OverlayTerrainType::Road] = 90;
+
+    add_player("rose");
+
+    unit = &add_unit("unit001", "tank", "rose", size / 2, size / 2);
+    scenario.map.grid(size / 2, size / 2).base_terrain =
+        freeisle::def::BaseTerrainType::Grass;
+  }
+
+  freeisle::state::Unit *unit;
+};
+
+/**
+ * Reachability of a unit with the given movement points; typical units
+ * have a movement range of 5-10 hexes.
+ */
+void BM_Reachability(benchmark::State &state) {
+  Fixture fixture(state.range(0));
+  fixture.unit->movement = state.range(1);
+  fixture.unit->fuel = 0xffffffff;
+
+  freeisle::path::Pathfinder pathfinder;
+  size_t nodes = 0;
+  for (auto _ : state) {
+    nodes = pathfinder.compute(fixture.state.map, *fixture.unit).size();
+    benchmark::DoNotOptimize(nodes);
+  }
+
+  state.counters["nodes"] = nodes;
+  state.SetItemsProcessed(state.iterations() * nodes);
+}
+
+/**
+ * Same as BM_Reachability, but with movement costs looked up in a compiled
+ * cost table.
+ */
+void BM_ReachabilityCostTable(benchmark::State &state) {
+  Fixture fixture(state.range(0));
+  fixture.unit->movement = state.range(1);
+  fixture.unit->fuel = 0xffffffff;
+
+  const freeisle::path::CostTable costs(fixture.scenario.map,
+                                        fixture.scenario.units);
+  freeisle::path::Pathfinder pathfinder;
+  size_t nodes = 0;
+  for (auto _ : state) {
+    nodes = pathfinder.compute(fixture.state.map, *fixture.unit, costs).size();
+    benchmark::DoNotOptimize(nodes);
+  }
+
+  state.counters["nodes"] = nodes;
+  state.SetItemsProcessed(state.iterations() * nodes);
+}
+
+/**
+ * Compiling the cost table for a map, which is required whenever the map
+ * changes.
+ */
+void BM_CompileCostTable(benchmark::State &state) {
+  Fixture fixture(state.range(0));
+
+  for (auto _ : state) {
+    freeisle::path::CostTable costs(fixture.scenario.map,
+                                    fixture.scenario.units);
+    benchmark::DoNotOptimize(costs.codes());
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0) *
+                          state.range(0));
+}
+
+} // namespace
+
+BENCHMARK(BM_Reachability)
+    ->Args({256, 600})
+    ->Args({256, 1200})
+    ->Args({1024, 600})
+    ->Args({1024, 1200})
+    ->Unit(benchmark::kMicrosecond);
+
+// Flood fill of the whole map, e.g. for AI distance maps
+BENCHMARK(BM_Reachability)
+    ->Args({256, 0xfffffff})
+    ->Args({1024, 0xfffffff})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_ReachabilityCostTable)
+    ->Args({256, 600})
+    ->Args({256, 1200})
+    ->Args({1024, 600})
+    ->Args({1024, 1200})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_ReachabilityCostTable)
+    ->Args({256, 0xfffffff})
+    ->Args({1024, 0xfffffff})
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK(BM_CompileCostTable)->Arg(256)->Arg(1024)->Unit(
+    benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
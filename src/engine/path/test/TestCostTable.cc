@@ -0,0 +1,183 @@
+#include "path/CostTable.hh"
+
+#include "path/MovementCost.hh"
+
+#include <gtest/gtest.h>
+
+class TestCostTable : public ::testing::Test {
+public:
+  TestCostTable()
+      : map_def{.grid =
+                    freeisle::core::Grid<freeisle::def::MapDef::Hex>(4, 3)} {
+    freeisle::def::UnitDef tank{
+        .name = "tank",
+        .level = freeisle::def::Level::Land,
+    };
+    set_costs(tank, 100);
+    tank.movement_cost[freeisle::def::BaseTerrainType::DeepWater] = 0;
+    tank.movement_cost[freeisle::def::OverlayTerrainType::Road] = 50;
+    unit_defs.try_emplace("tank", std::move(tank));
+
+    freeisle::def::UnitDef ship{
+        .name = "ship",
+        .level = freeisle::def::Level::Water,
+    };
+    set_costs(ship, 0);
+    ship.movement_cost[freeisle::def::BaseTerrainType::DeepWater] = 100;
+    ship.movement_cost[freeisle::def::OverlayTerrainType::Road] = 50;
+    unit_defs.try_emplace("ship", std::move(ship));
+
+    map_def.grid(1, 0).base_terrain = freeisle::def::BaseTerrainType::DeepWater;
+    map_def.grid(2, 1).base_terrain = freeisle::def::BaseTerrainType::DeepWater;
+    map_def.grid(2, 1).overlay_terrain =
+        freeisle::def::OverlayTerrainType::Road;
+    map_def.grid(3, 2).overlay_terrain =
+        freeisle::def::OverlayTerrainType::Road;
+  }
+
+  static void set_costs(freeisle::def::UnitDef &def, uint32_t cost) {
+    std::fill(def.movement_cost.data(),
+              def.movement_cost.data() + def.movement_cost.size(), cost);
+  }
+
+  const freeisle::def::UnitDef &tank() const {
+    return unit_defs.find("tank")->second;
+  }
+  const freeisle::def::UnitDef &ship() const {
+    return unit_defs.find("ship")->second;
+  }
+
+  freeisle::def::MapDef map_def;
+  freeisle::def::Collection<freeisle::def::UnitDef> unit_defs;
+};
+
+TEST_F(TestCostTable, TerrainCodesAreDistinct) {
+  std::vector<bool> seen(freeisle::path::NumTerrainCodes);
+
+  for (uint32_t b = 0;
+       b < static_cast<uint32_t>(freeisle::def::BaseTerrainType::Num); ++b) {
+    freeisle::def::MapDef::Hex hex{
+        .base_terrain = static_cast<freeisle::def::BaseTerrainType>(b)};
+
+    for (uint32_t o = 0;
+         o <= static_cast<uint32_t>(freeisle::def::OverlayTerrainType::Num);
+         ++o) {
+      if (o < static_cast<uint32_t>(freeisle::def::OverlayTerrainType::Num)) {
+        hex.overlay_terrain = static_cast<freeisle::def::OverlayTerrainType>(o);
+      } else {
+        hex.overlay_terrain = decltype(hex.overlay_terrain)();
+      }
+
+      const freeisle::path::TerrainCode code =
+          freeisle::path::terrain_code(hex);
+      ASSERT_LT(code, freeisle::path::NumTerrainCodes);
+      EXPECT_FALSE(seen[code]);
+      seen[code] = true;
+    }
+  }
+}
+
+TEST_F(TestCostTable, MatchesMovementCost) {
+  const freeisle::path::CostTable costs(map_def, unit_defs);
+  ASSERT_EQ(costs.width(), 4);
+  ASSERT_EQ(costs.height(), 3);
+
+  for (const auto &[id, def] : unit_defs) {
+    for (uint32_t level = 0; level < freeisle::path::NumLevels; ++level) {
+      for (uint32_t y = 0; y < 3; ++y) {
+        for (uint32_t x = 0; x < 4; ++x) {
+          EXPECT_EQ(costs.cost(def, static_cast<freeisle::def::Level>(level),
+                               x, y),
+                    freeisle::path::movement_cost(
+                        def, static_cast<freeisle::def::Level>(level),
+                        map_def.grid(x, y)));
+        }
+      }
+    }
+  }
+}
+
+TEST_F(TestCostTable, OverlayRule) {
+  const freeisle::path::CostTable costs(map_def, unit_defs);
+
+  // bridge: road for land units, water for water units
+  EXPECT_EQ(costs.cost(tank(), freeisle::def::Level::Land, 2, 1), 50);
+  EXPECT_EQ(costs.cost(ship(), freeisle::def::Level::Water, 2, 1), 100);
+  EXPECT_EQ(costs.cost(tank(), freeisle::def::Level::Land, 1, 0), 0);
+  EXPECT_EQ(costs.cost(ship(), freeisle::def::Level::Water, 3, 2), 0);
+
+  EXPECT_EQ(costs.max_cost(tank()), 100);
+  EXPECT_EQ(costs.max_cost(ship()), 100);
+}
+
+TEST_F(TestCostTable, CostGrid) {
+  const freeisle::path::CostTable costs(map_def, unit_defs);
+  const freeisle::core::Grid<uint16_t> grid =
+      costs.cost_grid(tank(), freeisle::def::Level::Land);
+
+  ASSERT_EQ(grid.width(), 4);
+  ASSERT_EQ(grid.height(), 3);
+  EXPECT_EQ(grid(0, 0), 100);
+  EXPECT_EQ(grid(1, 0), 0);
+  EXPECT_EQ(grid(2, 1), 50);
+  EXPECT_EQ(grid(3, 2), 50);
+}
+
+TEST_F(TestCostTable, UpdateHex) {
+  freeisle::path::CostTable costs(map_def, unit_defs);
+
+  map_def.grid(0, 2).base_terrain = freeisle::def::BaseTerrainType::DeepWater;
+  EXPECT_EQ(costs.cost(tank(), freeisle::def::Level::Land, 0, 2), 100);
+
+  costs.update_hex(0, 2);
+  EXPECT_EQ(costs.cost(tank(), freeisle::def::Level::Land, 0, 2), 0);
+  EXPECT_EQ(costs.cost(ship(), freeisle::def::Level::Water, 0, 2), 100);
+}
+
+TEST_F(TestCostTable, UpdateMap) {
+  freeisle::path::CostTable costs(map_def, unit_defs);
+
+  map_def.grid = freeisle::core::Grid<freeisle::def::MapDef::Hex>(2, 2);
+  map_def.grid(1, 1).overlay_terrain = freeisle::def::OverlayTerrainType::Road;
+  costs.update_map();
+
+  ASSERT_EQ(costs.width(), 2);
+  ASSERT_EQ(costs.height(), 2);
+  EXPECT_EQ(costs.cost(tank(), freeisle::def::Level::Land, 0, 0), 100);
+  EXPECT_EQ(costs.cost(tank(), freeisle::def::Level::Land, 1, 1), 50);
+}
+
+TEST_F(TestCostTable, UpdateUnitDef) {
+  freeisle::path::CostTable costs(map_def, unit_defs);
+
+  freeisle::def::UnitDef &def = unit_defs.find("tank")->second;
+  def.movement_cost[freeisle::def::BaseTerrainType::Grass] = 300;
+  EXPECT_EQ(costs.cost(def, freeisle::def::Level::Land, 0, 0), 100);
+
+  costs.update_unit_def(def);
+  EXPECT_EQ(costs.cost(def, freeisle::def::Level::Land, 0, 0), 300);
+  EXPECT_EQ(costs.max_cost(def), 300);
+}
+
+TEST_F(TestCostTable, UpdateUnitDefs) {
+  freeisle::path::CostTable costs(map_def, unit_defs);
+
+  freeisle::def::UnitDef heli{
+      .name = "heli",
+      .level = freeisle::def::Level::Air,
+  };
+  set_costs(heli, 80);
+  unit_defs.try_emplace("heli", std::move(heli));
+  costs.update_unit_defs();
+
+  const freeisle::def::UnitDef &def = unit_defs.find("heli")->second;
+  EXPECT_EQ(costs.cost(def, freeisle::def::Level::Air, 1, 0), 80);
+  EXPECT_EQ(costs.cost(tank(), freeisle::def::Level::Land, 1, 0), 0);
+}
+
+TEST_F(TestCostTable, CostOutOfRange) {
+  unit_defs.find("tank")->second.movement_cost
+      [freeisle::def::BaseTerrainType::Snow] = 70000;
+  EXPECT_THROW(freeisle::path::CostTable(map_def, unit_defs),
+               std::runtime_error);
+}
@@ -0,0 +1,349 @@
+#include "path/Pathfinder.hh"
+
+#include "core/Hex.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <gtest/gtest.h>
+
+class TestPathfinder : public ::testing::Test,
+                       public freeisle::state::test::Scenario {
+public:
+  TestPathfinder() : Scenario(7, 7) {
+    freeisle::def::UnitDef &tank =
+        add_unit_def("tank", freeisle::def::UnitDef{
+                                 .name = "tank",
+                                 .level = freeisle::def::Level::Land,
+                                 .movement = 200,
+                                 .fuel = 20,
+                             });
+    tank.movement_cost[freeisle::def::BaseTerrainType::DeepWater] = 0;
+    tank.movement_cost[freeisle::def::OverlayTerrainType::Road] = 50;
+
+    add_unit_def("grunt", freeisle::def::UnitDef{
+                              .name = "grunt",
+                              .level = freeisle::def::Level::Land,
+                              .caps = freeisle::def::UnitDef::Cap::Capture,
+                              .movement = 200,
+                              .fuel = 20,
+                          });
+
+    freeisle::def::UnitDef &ship =
+        add_unit_def("ship",
+                     freeisle::def::UnitDef{
+                         .name = "ship",
+                         .level = freeisle::def::Level::Water,
+                         .movement = 200,
+                         .fuel = 20,
+                     },
+                     0);
+    ship.movement_cost[freeisle::def::BaseTerrainType::DeepWater] = 100;
+    ship.movement_cost[freeisle::def::OverlayTerrainType::Road] = 50;
+
+    add_default_players();
+  }
+
+  freeisle::path::Pathfinder pathfinder;
+};
+
+TEST_F(TestPathfinder, NoMovement) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 0;
+
+  const std::vector<freeisle::path::Node> &nodes =
+      pathfinder.compute(state.map, unit);
+  ASSERT_EQ(nodes.size(), 1);
+  EXPECT_EQ(nodes[0].location.x, 3);
+  EXPECT_EQ(nodes[0].location.y, 3);
+  EXPECT_EQ(nodes[0].cost, 0);
+  EXPECT_EQ(nodes[0].steps, 0);
+  EXPECT_EQ(nodes[0].pred, freeisle::path::Node::NoPred);
+  EXPECT_TRUE(nodes[0].can_stop);
+}
+
+TEST_F(TestPathfinder, OpenField) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+
+  const std::vector<freeisle::path::Node> &nodes =
+      pathfinder.compute(state.map, unit);
+
+  // start, one ring of 6 and a second ring of 12 hexes
+  EXPECT_EQ(nodes.size(), 19);
+  for (uint32_t y = 0; y < 7; ++y) {
+    for (uint32_t x = 0; x < 7; ++x) {
+      const uint32_t distance = freeisle::core::hex::distance(3, 3, x, y);
+      const freeisle::path::Node *node = pathfinder.find(x, y);
+      if (distance > 2) {
+        EXPECT_EQ(node, nullptr) << x << "," << y;
+      } else {
+        ASSERT_NE(node, nullptr) << x << "," << y;
+        EXPECT_EQ(node->cost, distance * 100);
+        EXPECT_EQ(node->steps, distance);
+        EXPECT_TRUE(node->can_stop);
+      }
+    }
+  }
+}
+
+TEST_F(TestPathfinder, MapBorder) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 0, 0);
+  unit.movement = 100;
+
+  pathfinder.compute(state.map, unit);
+  EXPECT_EQ(pathfinder.nodes().size(), 3);
+  EXPECT_NE(pathfinder.find(1, 0), nullptr);
+  EXPECT_NE(pathfinder.find(0, 1), nullptr);
+  EXPECT_EQ(pathfinder.find(1, 1), nullptr);
+}
+
+TEST_F(TestPathfinder, ImpassableTerrain) {
+  for (uint32_t y = 0; y < 7; ++y) {
+    scenario.map.grid(4, y).base_terrain =
+        freeisle::def::BaseTerrainType::DeepWater;
+  }
+
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 1000;
+
+  pathfinder.compute(state.map, unit);
+  for (uint32_t y = 0; y < 7; ++y) {
+    for (uint32_t x = 4; x < 7; ++x) {
+      EXPECT_EQ(pathfinder.find(x, y), nullptr) << x << "," << y;
+    }
+  }
+
+  EXPECT_NE(pathfinder.find(0, 0), nullptr);
+}
+
+TEST_F(TestPathfinder, HugeTerrainCost) {
+  freeisle::def::UnitDef &tank = scenario.units.find("tank")->second;
+  tank.movement_cost[freeisle::def::BaseTerrainType::Desert] = UINT32_MAX;
+  for (uint32_t y = 0; y < 7; ++y) {
+    scenario.map.grid(4, y).base_terrain =
+        freeisle::def::BaseTerrainType::Desert;
+  }
+
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 1000;
+
+  pathfinder.compute(state.map, unit);
+  for (uint32_t y = 0; y < 7; ++y) {
+    EXPECT_EQ(pathfinder.find(4, y), nullptr) << y;
+  }
+
+  EXPECT_NE(pathfinder.find(0, 0), nullptr);
+}
+
+TEST_F(TestPathfinder, RoadOverlay) {
+  // road going up from the unit's location
+  for (uint32_t y = 0; y < 3; ++y) {
+    scenario.map.grid(3, y).overlay_terrain =
+        freeisle::def::OverlayTerrainType::Road;
+  }
+
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+
+  pathfinder.compute(state.map, unit);
+  ASSERT_NE(pathfinder.find(3, 0), nullptr);
+  EXPECT_EQ(pathfinder.find(3, 0)->cost, 150);
+  EXPECT_EQ(pathfinder.find(3, 0)->steps, 3);
+
+  const std::vector<freeisle::def::Location> path = pathfinder.path_to(3, 0);
+  ASSERT_EQ(path.size(), 4);
+  for (uint32_t i = 0; i < 4; ++i) {
+    EXPECT_EQ(path[i].x, 3);
+    EXPECT_EQ(path[i].y, 3 - i);
+  }
+}
+
+TEST_F(TestPathfinder, OverlayDoesNotApplyToWaterLevel) {
+  for (uint32_t y = 0; y < 7; ++y) {
+    for (uint32_t x = 0; x < 7; ++x) {
+      scenario.map.grid(x, y).base_terrain =
+          freeisle::def::BaseTerrainType::DeepWater;
+    }
+  }
+
+  // a bridge
+  scenario.map.grid(3, 2).overlay_terrain =
+      freeisle::def::OverlayTerrainType::Road;
+
+  freeisle::state::Unit &unit = add_unit("unit001", "ship", "rose", 3, 3);
+
+  pathfinder.compute(state.map, unit);
+  ASSERT_NE(pathfinder.find(3, 2), nullptr);
+  EXPECT_EQ(pathfinder.find(3, 2)->cost, 100);
+  EXPECT_EQ(pathfinder.nodes().size(), 19);
+}
+
+TEST_F(TestPathfinder, HostileUnitBlocks) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 100;
+  add_unit("unit002", "tank", "lily", 3, 2);
+
+  pathfinder.compute(state.map, unit);
+  EXPECT_EQ(pathfinder.nodes().size(), 6);
+  EXPECT_EQ(pathfinder.find(3, 2), nullptr);
+}
+
+TEST_F(TestPathfinder, FriendlyUnitCanBePassed) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  add_unit("unit002", "tank", "daisy", 3, 2);
+
+  pathfinder.compute(state.map, unit);
+  ASSERT_NE(pathfinder.find(3, 2), nullptr);
+  EXPECT_FALSE(pathfinder.find(3, 2)->can_stop);
+  ASSERT_NE(pathfinder.find(3, 1), nullptr);
+  EXPECT_TRUE(pathfinder.find(3, 1)->can_stop);
+  EXPECT_EQ(pathfinder.find(3, 1)->cost, 200);
+}
+
+TEST_F(TestPathfinder, SubsurfaceUnitDoesNotBlockSurface) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 100;
+
+  const freeisle::def::Collection<freeisle::state::Unit>::iterator iter =
+      state.units.try_emplace("unit002").first;
+  iter->second.owner = state.players.find("lily");
+  state.map.set_subsurface_unit(3, 2, iter);
+
+  pathfinder.compute(state.map, unit);
+  ASSERT_NE(pathfinder.find(3, 2), nullptr);
+  EXPECT_TRUE(pathfinder.find(3, 2)->can_stop);
+}
+
+TEST_F(TestPathfinder, FuelLimit) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 1000;
+  unit.fuel = 1;
+
+  pathfinder.compute(state.map, unit);
+  EXPECT_EQ(pathfinder.nodes().size(), 7);
+}
+
+TEST_F(TestPathfinder, FewestStepsOnEqualCost) {
+  for (uint32_t y = 0; y < 7; ++y) {
+    for (uint32_t x = 0; x < 7; ++x) {
+      scenario.map.grid(x, y).overlay_terrain =
+          freeisle::def::OverlayTerrainType::Road;
+    }
+  }
+
+  scenario.map.grid(3, 2).overlay_terrain =
+      freeisle::core::Sentinel<freeisle::def::OverlayTerrainType,
+                               freeisle::def::OverlayTerrainType::Num>();
+
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+
+  // Straight over the grass hex, or around it on the road:
+  pathfinder.compute(state.map, unit);
+  ASSERT_NE(pathfinder.find(3, 1), nullptr);
+  EXPECT_EQ(pathfinder.find(3, 1)->cost, 150);
+  EXPECT_EQ(pathfinder.find(3, 1)->steps, 2);
+}
+
+TEST_F(TestPathfinder, FriendlyShopEndsMovement) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 1000;
+
+  // wall of water with a shop as the only gap
+  for (uint32_t x = 0; x < 7; ++x) {
+    scenario.map.grid(x, 2).base_terrain =
+        freeisle::def::BaseTerrainType::DeepWater;
+  }
+
+  scenario.map.grid(3, 2).base_terrain = freeisle::def::BaseTerrainType::Grass;
+  add_shop("shop001", "rose", 3, 2);
+
+  pathfinder.compute(state.map, unit);
+  ASSERT_NE(pathfinder.find(3, 2), nullptr);
+  EXPECT_TRUE(pathfinder.find(3, 2)->can_stop);
+  EXPECT_EQ(pathfinder.find(3, 1), nullptr);
+}
+
+TEST_F(TestPathfinder, EnemyShop) {
+  add_shop("shop001", "lily", 3, 2);
+  add_shop("shop002", "", 2, 3);
+
+  freeisle::state::Unit &tank = add_unit("unit001", "tank", "rose", 3, 3);
+  tank.movement = 100;
+  pathfinder.compute(state.map, tank);
+  EXPECT_EQ(pathfinder.find(3, 2), nullptr);
+  EXPECT_EQ(pathfinder.find(2, 3), nullptr);
+
+  freeisle::state::Unit &grunt = add_unit("unit002", "grunt", "rose", 0, 0);
+  grunt.location = {.x = 3, .y = 3};
+  grunt.movement = 100;
+  pathfinder.compute(state.map, grunt);
+  EXPECT_NE(pathfinder.find(3, 2), nullptr);
+  EXPECT_NE(pathfinder.find(2, 3), nullptr);
+}
+
+TEST_F(TestPathfinder, PathToUnreachable) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+
+  pathfinder.compute(state.map, unit);
+  EXPECT_TRUE(pathfinder.path_to(0, 6).empty());
+  EXPECT_TRUE(pathfinder.path_to(100, 100).empty());
+}
+
+TEST_F(TestPathfinder, PathsAreConnected) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 1000;
+  scenario.map.grid(2, 3).base_terrain =
+      freeisle::def::BaseTerrainType::DeepWater;
+  scenario.map.grid(2, 4).base_terrain =
+      freeisle::def::BaseTerrainType::DeepWater;
+
+  pathfinder.compute(state.map, unit);
+  for (const freeisle::path::Node &node : pathfinder.nodes()) {
+    const std::vector<freeisle::def::Location> path =
+        pathfinder.path_to(node.location.x, node.location.y);
+    ASSERT_EQ(path.size(), node.steps + 1);
+    EXPECT_EQ(path.front().x, 3);
+    EXPECT_EQ(path.front().y, 3);
+
+    for (uint32_t i = 1; i < path.size(); ++i) {
+      EXPECT_EQ(freeisle::core::hex::distance(path[i - 1].x, path[i - 1].y,
+                                              path[i].x, path[i].y),
+                1);
+    }
+  }
+}
+
+TEST_F(TestPathfinder, Reuse) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  pathfinder.compute(state.map, unit);
+  EXPECT_EQ(pathfinder.nodes().size(), 19);
+
+  unit.movement = 100;
+  pathfinder.compute(state.map, unit);
+  EXPECT_EQ(pathfinder.nodes().size(), 7);
+  EXPECT_EQ(pathfinder.find(3, 1), nullptr);
+}
+
+TEST_F(TestPathfinder, CostTableMatchesDefs) {
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 3, 3);
+  unit.movement = 1000;
+  scenario.map.grid(2, 3).base_terrain =
+      freeisle::def::BaseTerrainType::DeepWater;
+  scenario.map.grid(4, 2).overlay_terrain =
+      freeisle::def::OverlayTerrainType::Road;
+  scenario.map.grid(4, 1).overlay_terrain =
+      freeisle::def::OverlayTerrainType::Road;
+
+  const freeisle::path::CostTable costs(scenario.map, scenario.units);
+  const std::vector<freeisle::path::Node> expected =
+      pathfinder.compute(state.map, unit);
+  const std::vector<freeisle::path::Node> &nodes =
+      pathfinder.compute(state.map, unit, costs);
+
+  ASSERT_EQ(nodes.size(), expected.size());
+  for (uint32_t i = 0; i < nodes.size(); ++i) {
+    EXPECT_EQ(nodes[i].location.x, expected[i].location.x);
+    EXPECT_EQ(nodes[i].location.y, expected[i].location.y);
+    EXPECT_EQ(nodes[i].cost, expected[i].cost);
+    EXPECT_EQ(nodes[i].steps, expected[i].steps);
+    EXPECT_EQ(nodes[i].pred, expected[i].pred);
+  }
+}
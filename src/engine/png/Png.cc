@@ -1,6 +1,21 @@
 #include "png/Png.hh"
 
 #include <png.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <initializer_list>
+#include <memory>
+#include <system_error>
+#include <thread>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 namespace freeisle::png {
 
@@ -56,13 +71,550 @@ void user_write_fn(png_structp png_ptr, png_bytep buf, png_size_t len) {
   io->data.insert(io->data.end(), buf, buf + len);
 }
 
+/**
+ * Collects the distinct colors of an image, up to the number that fits into
+ * a palette, and maps colors to their palette index.
+ */
+class Palette {
+public:
+  static constexpr uint32_t MaxColors = 256;
+
+  Palette() : keys_(), indices_() {}
+
+  /**
+   * Adds the colors of the given row that are not known yet. Returns false
+   * if there is no room for them.
+   */
+  bool add(const core::color::Rgb8 *row, uint32_t width) {
+    // Neighbouring pixels mostly have the same color, so the last one is
+    // kept at hand:
+    uint32_t last_key = 0;
+    for (uint32_t x = 0; x < width; ++x) {
+      const uint32_t key = make_key(row[x]);
+      if (key == last_key) {
+        continue;
+      }
+
+      const uint32_t slot = find(key);
+      if (keys_[slot] == 0) {
+        if (colors_.size() == MaxColors) {
+          return false;
+        }
+
+        keys_[slot] = key;
+        indices_[slot] = colors_.size();
+        colors_.push_back(png_color{row[x].r, row[x].g, row[x].b});
+      }
+
+      last_key = key;
+    }
+
+    return true;
+  }
+
+  /**
+   * Writes the palette indices of the given row, whose colors must have
+   * been added, to result.
+   */
+  void index(const core::color::Rgb8 *row, uint32_t width,
+             uint8_t *result) const {
+    uint32_t last_key = 0;
+    uint8_t last_index = 0;
+    for (uint32_t x = 0; x < width; ++x) {
+      const uint32_t key = make_key(row[x]);
+      if (key != last_key) {
+        last_key = key;
+        last_index = indices_[find(key)];
+      }
+
+      result[x] = last_index;
+    }
+  }
+
+  const std::vector<png_color> &colors() const { return colors_; }
+
+  /**
+   * Smallest bit depth that can address all colors.
+   */
+  int bit_depth() const {
+    if (colors_.size() <= 2) {
+      return 1;
+    } else if (colors_.size() <= 4) {
+      return 2;
+    } else if (colors_.size() <= 16) {
+      return 4;
+    }
+
+    return 8;
+  }
+
+private:
+  // Open addressing with at most a quarter of the slots in use, so probe
+  // sequences stay short. Key 0 marks an empty slot.
+  static constexpr uint32_t TableBits = 10;
+  static constexpr uint32_t TableSize = 1 << TableBits;
+
+  static uint32_t make_key(core::color::Rgb8 color) {
+    return 0x1000000 | (color.r << 16) | (color.g << 8) | color.b;
+  }
+
+  uint32_t find(uint32_t key) const {
+    uint32_t slot = (key * 0x9e3779b1) >> (32 - TableBits);
+    while (keys_[slot] != 0 && keys_[slot] != key) {
+      slot = (slot + 1) & (TableSize - 1);
+    }
+
+    return slot;
+  }
+
+  uint32_t keys_[TableSize];
+  uint8_t indices_[TableSize];
+  std::vector<png_color> colors_;
+};
+
+void set_compression(png_structp png, Compression compression,
+                     bool palette) {
+  switch (compression) {
+  case Compression::Default:
+    break;
+  case Compression::Fast:
+    png_set_compression_level(png, Z_BEST_SPEED);
+    png_set_filter(png, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+    break;
+  case Compression::Small:
+    png_set_compression_level(png, Z_BEST_COMPRESSION);
+    png_set_compression_mem_level(png, MAX_MEM_LEVEL);
+    // Filters do not help with palette indices:
+    png_set_filter(png, PNG_FILTER_TYPE_BASE,
+                   palette ? PNG_FILTER_NONE : PNG_ALL_FILTERS);
+    break;
+  }
+}
+
+/**
+ * Size of the uncompressed data of a band for parallel encoding. Bands are
+ * compressed independently, so larger ones compress better but give less
+ * parallelism. This is the block size used by pigz.
+ */
+constexpr uint64_t BandSize = 128 * 1024;
+
+/**
+ * Applies PNG filters to rows, see the "Filtering" section of the PNG
+ * specification. Like libpng, it picks the filter with the smallest sum of
+ * absolute differences for each row, which is a good guess for the one that
+ * compresses best.
+ */
+class RowFilter {
+public:
+  RowFilter(uint32_t row_bytes, uint32_t bpp, bool adaptive)
+      : row_bytes_(row_bytes), bpp_(bpp), adaptive_(adaptive),
+        candidate_(row_bytes + 1), best_(row_bytes + 1) {}
+
+  /**
+   * Filters the given row, which follows prior in the image, or is the first
+   * one if prior is nullptr. Returns the filter type byte followed by the
+   * filtered row.
+   */
+  const std::vector<uint8_t> &filter(const uint8_t *row,
+                                     const uint8_t *prior) {
+    best_[0] = PNG_FILTER_VALUE_NONE;
+    std::copy(row, row + row_bytes_, best_.begin() + 1);
+    if (!adaptive_) {
+      return best_;
+    }
+
+    uint64_t best_sum = sum(best_);
+    for (uint8_t type = PNG_FILTER_VALUE_SUB; type < PNG_FILTER_VALUE_LAST;
+         ++type) {
+      apply(type, row, prior);
+      const uint64_t candidate_sum = sum(candidate_);
+      if (candidate_sum < best_sum) {
+        best_sum = candidate_sum;
+        std::swap(best_, candidate_);
+      }
+    }
+
+    return best_;
+  }
+
+private:
+  static uint64_t sum(const std::vector<uint8_t> &filtered) {
+    uint64_t result = 0;
+    for (uint64_t i = 1; i < filtered.size(); ++i) {
+      const uint8_t v = filtered[i];
+      result += v < 128 ? v : 256 - v;
+    }
+
+    return result;
+  }
+
+  static uint8_t paeth(uint8_t a, uint8_t b, uint8_t c) {
+    const int32_t p = a + b - c;
+    const int32_t pa = std::abs(p - a);
+    const int32_t pb = std::abs(p - b);
+    const int32_t pc = std::abs(p - c);
+    if (pa <= pb && pa <= pc) {
+      return a;
+    } else if (pb <= pc) {
+      return b;
+    }
+
+    return c;
+  }
+
+  void apply(uint8_t type, const uint8_t *row, const uint8_t *prior) {
+    // The first row is filtered as if it followed a row of zeros:
+    if (prior == nullptr) {
+      zeros_.resize(row_bytes_);
+      prior = zeros_.data();
+    }
+
+    uint8_t *out = candidate_.data() + 1;
+    candidate_[0] = type;
+    const uint32_t bpp = std::min(bpp_, row_bytes_);
+
+    // The first pixel has no left neighbour, which counts as zero:
+    switch (type) {
+    case PNG_FILTER_VALUE_SUB:
+      std::copy(row, row + bpp, out);
+      for (uint32_t i = bpp; i < row_bytes_; ++i) {
+        out[i] = row[i] - row[i - bpp];
+      }
+      break;
+    case PNG_FILTER_VALUE_UP:
+      for (uint32_t i = 0; i < row_bytes_; ++i) {
+        out[i] = row[i] - prior[i];
+      }
+      break;
+    case PNG_FILTER_VALUE_AVG:
+      for (uint32_t i = 0; i < bpp; ++i) {
+        out[i] = row[i] - prior[i] / 2;
+      }
+      for (uint32_t i = bpp; i < row_bytes_; ++i) {
+        out[i] = row[i] - (row[i - bpp] + prior[i]) / 2;
+      }
+      break;
+    case PNG_FILTER_VALUE_PAETH:
+      for (uint32_t i = 0; i < bpp; ++i) {
+        out[i] = row[i] - prior[i];
+      }
+      for (uint32_t i = bpp; i < row_bytes_; ++i) {
+        out[i] = row[i] - paeth(row[i - bpp], prior[i], prior[i - bpp]);
+      }
+      break;
+    }
+  }
+
+  const uint32_t row_bytes_;
+  const uint32_t bpp_;
+  const bool adaptive_;
+  std::vector<uint8_t> candidate_;
+  std::vector<uint8_t> best_;
+  std::vector<uint8_t> zeros_;
+};
+
+/**
+ * Encodes the image data of a PNG in bands of rows on multiple threads, in
+ * the style of pigz: each band is compressed as a raw deflate stream of its
+ * own, ending in a full flush at a byte boundary, so that the bands can be
+ * concatenated into a single valid zlib stream.
+ */
+class ParallelEncoder {
+public:
+  ParallelEncoder(uint32_t width, uint32_t height,
+                  const WriteRowFn &write_row, const Palette *palette,
+                  Compression compression)
+      : width_(width), height_(height), write_row_(write_row),
+        palette_(palette), compression_(compression),
+        bit_depth_(palette != nullptr ? palette->bit_depth() : 8),
+        row_bytes_(palette != nullptr ? (width * bit_depth_ + 7) / 8
+                                      : width * 3),
+        rows_per_band_(std::max<uint64_t>(1, BandSize / (row_bytes_ + 1))),
+        bands_((height + rows_per_band_ - 1) / rows_per_band_),
+        next_band_(0) {}
+
+  /**
+   * Encodes the image using the given number of threads, including the
+   * calling one.
+   */
+  std::vector<uint8_t> encode(uint32_t num_threads) {
+    std::vector<std::thread> threads;
+    try {
+      for (uint32_t i = 1;
+           i < std::min<uint64_t>(num_threads, bands_.size()); ++i) {
+        threads.emplace_back([this] { work(); });
+      }
+    } catch (const std::system_error &ex) {
+      // Out of threads: the ones started so far and the calling thread share
+      // the bands.
+    }
+
+    work();
+
+    for (std::thread &thread : threads) {
+      thread.join();
+    }
+
+    for (const Band &band : bands_) {
+      if (band.error) {
+        std::rethrow_exception(band.error);
+      }
+    }
+
+    return assemble();
+  }
+
+private:
+  struct Band {
+    std::vector<uint8_t> data;
+    uint32_t adler = 0;
+    uint64_t len = 0;
+    std::exception_ptr error;
+  };
+
+  /**
+   * Compresses bands until none are left. Errors are kept with their band,
+   * so this does not throw, and the threads can always be joined.
+   */
+  void work() {
+    for (uint64_t i = next_band_++; i < bands_.size(); i = next_band_++) {
+      try {
+        compress(i);
+      } catch (...) {
+        bands_[i].error = std::current_exception();
+      }
+    }
+  }
+
+  /**
+   * Produces the given row and converts it into PNG pixel data.
+   */
+  void read(uint32_t y, std::vector<core::color::Rgb8> &pixels,
+            std::vector<uint8_t> &result) const {
+    write_row_(y, pixels.data());
+    if (palette_ == nullptr) {
+      const uint8_t *data = reinterpret_cast<const uint8_t *>(pixels.data());
+      std::copy(data, data + row_bytes_, result.begin());
+      return;
+    }
+
+    palette_->index(pixels.data(), width_, result.data());
+    if (bit_depth_ < 8) {
+      // Packs indices into bytes, leftmost pixel in the high bits:
+      const uint32_t per_byte = 8 / bit_depth_;
+      for (uint32_t i = 0; i < row_bytes_; ++i) {
+        uint8_t packed = 0;
+        for (uint32_t j = 0; j < per_byte; ++j) {
+          const uint32_t x = i * per_byte + j;
+          const uint8_t index = x < width_ ? result[x] : 0;
+          packed |= index << (8 - bit_depth_ * (j + 1));
+        }
+
+        result[i] = packed;
+      }
+    }
+  }
+
+  void compress(uint64_t index) {
+    const int level = compression_ == Compression::Fast ? Z_BEST_SPEED
+                      : compression_ == Compression::Small
+                          ? Z_BEST_COMPRESSION
+                          : Z_DEFAULT_COMPRESSION;
+    const int mem_level =
+        compression_ == Compression::Small ? MAX_MEM_LEVEL : 8;
+
+    z_stream stream = {};
+    if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, mem_level,
+                     Z_DEFAULT_STRATEGY) != Z_OK) {
+      throw std::runtime_error("failed to initialize deflate stream");
+    }
+
+    std::unique_ptr<z_stream, int (*)(z_stream *)> guard(&stream,
+                                                         deflateEnd);
+
+    // Palette indices do not benefit from filters, see set_compression():
+    RowFilter filter(row_bytes_, palette_ != nullptr ? 1 : 3,
+                     palette_ == nullptr &&
+                         compression_ != Compression::Fast);
+
+    // Buffers are at least as large as a row of unpacked indices:
+    std::vector<core::color::Rgb8> pixels(width_);
+    std::vector<uint8_t> row(std::max(row_bytes_, width_));
+    std::vector<uint8_t> prior(row.size());
+
+    Band &band = bands_[index];
+    const uint32_t begin = index * rows_per_band_;
+    const uint32_t end =
+        std::min<uint64_t>(begin + rows_per_band_, height_);
+
+    // The filters of the first row may refer to the last row of the
+    // previous band:
+    if (begin > 0) {
+      read(begin - 1, pixels, prior);
+    }
+
+    band.adler = adler32(0, nullptr, 0);
+    band.data.resize(deflateBound(&stream, (end - begin) * (row_bytes_ + 1)));
+    stream.next_out = band.data.data();
+    stream.avail_out = band.data.size();
+
+    for (uint32_t y = begin; y < end; ++y) {
+      read(y, pixels, row);
+      const std::vector<uint8_t> &filtered =
+          filter.filter(row.data(), y > 0 ? prior.data() : nullptr);
+      std::swap(row, prior);
+
+      band.adler = adler32(band.adler, filtered.data(), filtered.size());
+      band.len += filtered.size();
+
+      stream.next_in = const_cast<uint8_t *>(filtered.data());
+      stream.avail_in = filtered.size();
+      const int flush = y + 1 < end ? Z_NO_FLUSH
+                        : end == height_ ? Z_FINISH
+                                         : Z_FULL_FLUSH;
+      deflate_all(stream, band.data, flush);
+    }
+
+    band.data.resize(stream.next_out - band.data.data());
+  }
+
+  /**
+   * Deflates all pending input, growing the output if needed.
+   */
+  static void deflate_all(z_stream &stream, std::vector<uint8_t> &out,
+                          int flush) {
+    for (;;) {
+      if (stream.avail_out == 0) {
+        const uint64_t used = out.size();
+        out.resize(used * 2 + 64);
+        stream.next_out = out.data() + used;
+        stream.avail_out = out.size() - used;
+      }
+
+      const int result = deflate(&stream, flush);
+      if (result == Z_STREAM_ERROR) {
+        throw std::runtime_error("failed to deflate image data");
+      }
+
+      if (stream.avail_in == 0 && stream.avail_out > 0 &&
+          (flush == Z_NO_FLUSH || flush == Z_FULL_FLUSH ||
+           result == Z_STREAM_END)) {
+        return;
+      }
+    }
+  }
+
+  /**
+   * Stitches the header, palette, bands and trailer together.
+   */
+  std::vector<uint8_t> assemble() const {
+    uint64_t size = 8 + 3 * 12 + 13 + 2 + 4;
+    for (const Band &band : bands_) {
+      size += band.data.size() + 12;
+    }
+
+    std::vector<uint8_t> result;
+    result.reserve(size + (palette_ != nullptr ? 3 * 256 : 0));
+
+    const uint8_t signature[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+    result.insert(result.end(), signature, signature + 8);
+
+    uint8_t header[13];
+    put_u32(header, width_);
+    put_u32(header + 4, height_);
+    header[8] = bit_depth_;
+    header[9] = palette_ != nullptr ? PNG_COLOR_TYPE_PALETTE
+                                    : PNG_COLOR_TYPE_RGB;
+    header[10] = PNG_COMPRESSION_TYPE_BASE;
+    header[11] = PNG_FILTER_TYPE_BASE;
+    header[12] = PNG_INTERLACE_NONE;
+    write_chunk(result, "IHDR", {{header, sizeof(header)}});
+
+    if (palette_ != nullptr) {
+      std::vector<uint8_t> colors;
+      for (const png_color &color : palette_->colors()) {
+        colors.insert(colors.end(), {color.red, color.green, color.blue});
+      }
+
+      write_chunk(result, "PLTE", {{colors.data(), colors.size()}});
+    }
+
+    // The zlib header goes in front of the first band, and the checksum of
+    // all bands after the last one, each band in an IDAT chunk of its own:
+    const uint8_t zlib_header[2] = {
+        0x78, static_cast<uint8_t>(compression_ == Compression::Fast ? 0x01
+                                   : compression_ == Compression::Small
+                                       ? 0xda
+                                       : 0x9c)};
+    uint32_t adler = adler32(0, nullptr, 0);
+    for (uint64_t i = 0; i < bands_.size(); ++i) {
+      const Band &band = bands_[i];
+      adler = adler32_combine(adler, band.adler, band.len);
+
+      uint8_t trailer[4];
+      put_u32(trailer, adler);
+      write_chunk(result, "IDAT",
+                  {{zlib_header, i == 0 ? sizeof(zlib_header) : 0},
+                   {band.data.data(), band.data.size()},
+                   {trailer, i + 1 == bands_.size() ? sizeof(trailer) : 0}});
+    }
+
+    write_chunk(result, "IEND", {});
+    return result;
+  }
+
+  static void put_u32(uint8_t *out, uint32_t value) {
+    out[0] = value >> 24;
+    out[1] = value >> 16;
+    out[2] = value >> 8;
+    out[3] = value;
+  }
+
+  static void
+  write_chunk(std::vector<uint8_t> &out, const char *type,
+              std::initializer_list<std::pair<const uint8_t *, uint64_t>>
+                  parts) {
+    uint64_t len = 0;
+    for (const std::pair<const uint8_t *, uint64_t> &part : parts) {
+      len += part.second;
+    }
+
+    uint8_t header[8];
+    put_u32(header, len);
+    std::copy(type, type + 4, header + 4);
+    out.insert(out.end(), header, header + 8);
+
+    uint32_t crc = crc32(0, header + 4, 4);
+    for (const std::pair<const uint8_t *, uint64_t> &part : parts) {
+      out.insert(out.end(), part.first, part.first + part.second);
+      crc = crc32(crc, part.first, part.second);
+    }
+
+    uint8_t trailer[4];
+    put_u32(trailer, crc);
+    out.insert(out.end(), trailer, trailer + 4);
+  }
+
+  const uint32_t width_;
+  const uint32_t height_;
+  const WriteRowFn &write_row_;
+  const Palette *const palette_;
+  const Compression compression_;
+  const uint32_t bit_depth_;
+  const uint32_t row_bytes_;
+  const uint64_t rows_per_band_;
+  std::vector<Band> bands_;
+  std::atomic<uint64_t> next_band_;
+};
+
 } // namespace
 
-core::Grid<core::color::Rgb8> decode_rgb8(const uint8_t *data, uint64_t len,
-                                          log::Logger logger) {
+void decode_rgb8_rows(const uint8_t *data, uint64_t len, const SizeFn &size,
+                      const ReadRowFn &read_row, log::Logger logger) {
   ExtraData extra = {.logger = &logger};
 
   PngHelper png;
+  std::vector<core::color::Rgb8> buffer;
 
   png.png = png_create_read_struct(PNG_LIBPNG_VER_STRING, &extra, user_error_fn,
                                    user_warning_fn);
@@ -97,24 +649,80 @@ core::Grid<core::color::Rgb8> decode_rgb8(const uint8_t *data, uint64_t len,
   png_set_palette_to_rgb(png.png);
   png_set_expand_gray_1_2_4_to_8(png.png);
   png_set_gray_to_rgb(png.png);
+  const int passes = png_set_interlace_handling(png.png);
 
   png_read_update_info(png.png, png.info);
 
-  core::Grid<core::color::Rgb8> result(width, height);
-  std::vector<png_bytep> row_pointers(height);
-  for (uint32_t i = 0; i < height; ++i) {
-    row_pointers[i] = reinterpret_cast<png_bytep>(&result(0, i));
+  size(width, height);
+
+  if (passes == 1) {
+    buffer.resize(width);
+    for (uint32_t y = 0; y < height; ++y) {
+      png_read_row(png.png, reinterpret_cast<png_bytep>(buffer.data()),
+                   nullptr);
+      read_row(y, buffer.data());
+    }
+  } else {
+    // Rows of interlaced images are only complete after the last pass, so
+    // the whole image needs to be decoded first:
+    buffer.resize(static_cast<uint64_t>(width) * height);
+    std::vector<png_bytep> row_pointers(height);
+    for (uint32_t y = 0; y < height; ++y) {
+      row_pointers[y] = reinterpret_cast<png_bytep>(&buffer[y * width]);
+    }
+
+    png_read_image(png.png, row_pointers.data());
+    for (uint32_t y = 0; y < height; ++y) {
+      read_row(y, &buffer[y * width]);
+    }
   }
+}
+
+core::Grid<core::color::Rgb8> decode_rgb8(const uint8_t *data, uint64_t len,
+                                          log::Logger logger) {
+  core::Grid<core::color::Rgb8> result;
+  decode_rgb8_rows(
+      data, len,
+      [&](uint32_t width, uint32_t height) {
+        result = core::Grid<core::color::Rgb8>(width, height);
+      },
+      [&](uint32_t y, const core::color::Rgb8 *row) {
+        std::copy(row, row + result.width(), &result(0, y));
+      },
+      std::move(logger));
 
-  png_read_image(png.png, row_pointers.data());
   return result;
 }
 
-std::vector<uint8_t> encode_rgb8(const core::Grid<core::color::Rgb8> &image,
-                                 log::Logger logger) {
+std::vector<uint8_t> encode_rgb8_rows(uint32_t width, uint32_t height,
+                                      const WriteRowFn &write_row,
+                                      const EncodeOptions &options,
+                                      log::Logger logger) {
+  std::vector<core::color::Rgb8> row(width);
+
+  // Collect the colors first, since the palette is needed before the first
+  // row can be written:
+  std::unique_ptr<Palette> palette;
+  if (options.palette) {
+    palette = std::make_unique<Palette>();
+    for (uint32_t y = 0; y < height && palette; ++y) {
+      write_row(y, row.data());
+      if (!palette->add(row.data(), width)) {
+        palette.reset();
+      }
+    }
+  }
+
+  if (options.num_threads > 1) {
+    ParallelEncoder encoder(width, height, write_row, palette.get(),
+                            options.compression);
+    return encoder.encode(options.num_threads);
+  }
+
   ExtraData extra = {.logger = &logger};
 
   PngHelper png;
+  std::vector<uint8_t> indices(palette ? width : 0);
 
   png.png = png_create_write_struct(PNG_LIBPNG_VER_STRING, &extra,
                                     user_error_fn, user_warning_fn);
@@ -134,22 +742,96 @@ std::vector<uint8_t> encode_rgb8(const core::Grid<core::color::Rgb8> &image,
   PngWriteIo io;
   png_set_write_fn(png.png, &io, user_write_fn, nullptr);
 
-  png_set_IHDR(png.png, png.info, image.width(), image.height(), 8,
-               PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
-               PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+  if (palette) {
+    png_set_IHDR(png.png, png.info, width, height, palette->bit_depth(),
+                 PNG_COLOR_TYPE_PALETTE, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_set_PLTE(png.png, png.info, palette->colors().data(),
+                 palette->colors().size());
+  } else {
+    png_set_IHDR(png.png, png.info, width, height, 8, PNG_COLOR_TYPE_RGB,
+                 PNG_INTERLACE_NONE, PNG_COMPRESSION_TYPE_DEFAULT,
+                 PNG_FILTER_TYPE_DEFAULT);
+  }
+
+  set_compression(png.png, options.compression, palette != nullptr);
 
   png_write_info(png.png, png.info);
 
-  std::vector<png_bytep> row_pointers(image.height());
-  for (uint32_t i = 0; i < image.height(); ++i) {
-    png_const_bytep ptr = reinterpret_cast<png_const_bytep>(&image(0, i));
-    row_pointers[i] = const_cast<png_bytep>(ptr);
+  if (palette) {
+    // Indices are passed one per byte, and packed by libpng:
+    png_set_packing(png.png);
+
+    for (uint32_t y = 0; y < height; ++y) {
+      write_row(y, row.data());
+      palette->index(row.data(), width, indices.data());
+      png_write_row(png.png, indices.data());
+    }
+  } else {
+    for (uint32_t y = 0; y < height; ++y) {
+      write_row(y, row.data());
+      png_write_row(png.png, reinterpret_cast<png_const_bytep>(row.data()));
+    }
   }
 
-  png_write_image(png.png, row_pointers.data());
   png_write_end(png.png, NULL);
 
-  return io.data;
+  return std::move(io.data);
+}
+
+std::vector<uint8_t> encode_rgb8(const core::Grid<core::color::Rgb8> &image,
+                                 log::Logger logger) {
+  return encode_rgb8(image, EncodeOptions{}, std::move(logger));
+}
+
+std::vector<uint8_t> encode_rgb8(const core::Grid<core::color::Rgb8> &image,
+                                 const EncodeOptions &options,
+                                 log::Logger logger) {
+  return encode_rgb8_rows(
+      image.width(), image.height(),
+      [&](uint32_t y, core::color::Rgb8 *row) {
+        std::copy(&image(0, y), &image(0, y) + image.width(), row);
+      },
+      options, std::move(logger));
+}
+
+core::color::Rgb8 channel_max(const core::color::Rgb8 *pixels,
+                              uint64_t num) {
+  const uint8_t *data = reinterpret_cast<const uint8_t *>(pixels);
+  uint8_t max[3] = {0, 0, 0};
+  uint64_t i = 0;
+
+#ifdef __SSE2__
+  if (num >= 16) {
+    // 16 pixels span three vectors, and each byte lane of a vector always
+    // holds the same channel, so the lanes can be reduced independently:
+    __m128i acc[3] = {_mm_setzero_si128(), _mm_setzero_si128(),
+                      _mm_setzero_si128()};
+    for (; i + 16 <= num; i += 16) {
+      const __m128i *p = reinterpret_cast<const __m128i *>(data + i * 3);
+      acc[0] = _mm_max_epu8(acc[0], _mm_loadu_si128(p));
+      acc[1] = _mm_max_epu8(acc[1], _mm_loadu_si128(p + 1));
+      acc[2] = _mm_max_epu8(acc[2], _mm_loadu_si128(p + 2));
+    }
+
+    alignas(16) uint8_t lanes[48];
+    for (uint32_t j = 0; j < 3; ++j) {
+      _mm_store_si128(reinterpret_cast<__m128i *>(lanes) + j, acc[j]);
+    }
+
+    for (uint32_t j = 0; j < 48; ++j) {
+      max[j % 3] = std::max(max[j % 3], lanes[j]);
+    }
+  }
+#endif
+
+  for (; i < num; ++i) {
+    max[0] = std::max(max[0], data[i * 3 + 0]);
+    max[1] = std::max(max[1], data[i * 3 + 1]);
+    max[2] = std::max(max[2], data[i * 3 + 2]);
+  }
+
+  return core::color::Rgb8{max[0], max[1], max[2]};
 }
 
 } // namespace freeisle::png
@@ -5,6 +5,7 @@
 #include "log/Logger.hh"
 
 #include <cstdint>
+#include <functional>
 #include <vector>
 
 namespace freeisle::png {
@@ -15,10 +16,107 @@ namespace freeisle::png {
 core::Grid<core::color::Rgb8> decode_rgb8(const uint8_t *data, uint64_t len,
                                           log::Logger logger);
 
+/**
+ * Trade-off between encoding time and size of the encoded image.
+ */
+enum class Compression {
+  /**
+   * libpng's defaults, a balance between time and size.
+   */
+  Default,
+
+  /**
+   * Fastest compression, without filtering. Meant for data that is saved
+   * often, e.g. autosaves.
+   */
+  Fast,
+
+  /**
+   * Best compression, trying all filters.
+   */
+  Small,
+};
+
+/**
+ * Options for encoding images.
+ */
+struct EncodeOptions {
+  Compression compression = Compression::Default;
+
+  /**
+   * Whether to store the image with a palette if it has at most 256 distinct
+   * colors. This needs an extra pass over the image to collect the colors,
+   * but makes the image a lot smaller and faster to compress if it has only
+   * a few of them. The decoded image is the same either way.
+   */
+  bool palette = true;
+
+  /**
+   * Number of threads to compress the image with. With more than one, the
+   * image is split into bands of rows that are compressed independently,
+   * which makes it slightly larger. Rows may then be requested from several
+   * threads at the same time, and in any order.
+   */
+  uint32_t num_threads = 1;
+};
+
 /**
  * Encode an 8-bit RGB image as a PNG bytestream.
  */
 std::vector<uint8_t> encode_rgb8(const core::Grid<core::color::Rgb8> &image,
                                  log::Logger logger);
 
+/**
+ * Encode an 8-bit RGB image as a PNG bytestream, with the given options.
+ */
+std::vector<uint8_t> encode_rgb8(const core::Grid<core::color::Rgb8> &image,
+                                 const EncodeOptions &options,
+                                 log::Logger logger);
+
+/**
+ * Called with the image dimensions before the first row is decoded or
+ * encoded.
+ */
+using SizeFn = std::function<void(uint32_t width, uint32_t height)>;
+
+/**
+ * Called with each decoded row of an image, from top to bottom. The row has
+ * as many pixels as the image is wide, and is only valid during the call.
+ */
+using ReadRowFn =
+    std::function<void(uint32_t y, const core::color::Rgb8 *row)>;
+
+/**
+ * Called for each row of an image to be encoded, from top to bottom, to fill
+ * in as many pixels as the image is wide.
+ */
+using WriteRowFn = std::function<void(uint32_t y, core::color::Rgb8 *row)>;
+
+/**
+ * Decode a PNG-encoded image into 8-bit RGB, one row at a time, so that the
+ * caller can convert each row into its own representation without holding
+ * the whole image in memory. Exceptions thrown by the callbacks abort
+ * decoding and are passed on to the caller.
+ */
+void decode_rgb8_rows(const uint8_t *data, uint64_t len, const SizeFn &size,
+                      const ReadRowFn &read_row, log::Logger logger);
+
+/**
+ * Encode an 8-bit RGB image of the given size as a PNG bytestream, one row at
+ * a time, with the pixels provided by write_row. If a palette is allowed by
+ * the options, every row is requested twice, and must be the same both
+ * times.
+ */
+std::vector<uint8_t> encode_rgb8_rows(uint32_t width, uint32_t height,
+                                      const WriteRowFn &write_row,
+                                      const EncodeOptions &options,
+                                      log::Logger logger);
+
+/**
+ * Returns the maximum of each channel over the given pixels, or all zeros
+ * if there are none. This allows range checks of whole rows at once.
+ */
+core::color::Rgb8 channel_max(const core::color::Rgb8 *pixels,
+                              uint64_t num);
+
 } // namespace freeisle::png
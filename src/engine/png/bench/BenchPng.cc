@@ -0,0 +1,99 @@
+#include "png/Png.hh"
+
+#include "log/test/util/System.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <vector>
+
+namespace {
+
+/**
+ * Size of the image, e.g. a large map.
+ */
+constexpr uint32_t Size = 1024;
+
+/**
+ * Size of the image for comparing parallel encoding, a very large map.
+ */
+constexpr uint32_t LargeSize = 4096;
+
+/**
+ * Creates an image that looks like an encoded map: regions of a few dozen
+ * distinct colors.
+ */
+freeisle::core::Grid<freeisle::core::color::Rgb8>
+make_map(uint32_t size = Size) {
+  freeisle::core::Grid<freeisle::core::color::Rgb8> image(size, size);
+  for (uint32_t y = 0; y < size; ++y) {
+    for (uint32_t x = 0; x < size; ++x) {
+      const uint32_t region = (x / 37 + y / 23) % 48;
+      image(x, y) = freeisle::core::color::Rgb8{
+          static_cast<uint8_t>(region % 6),
+          static_cast<uint8_t>(region / 6 % 4),
+          static_cast<uint8_t>((x * y) % 97 == 0 ? region % 2 + 1 : 0)};
+    }
+  }
+
+  return image;
+}
+
+void BM_Encode(benchmark::State &state) {
+  const freeisle::png::EncodeOptions options = {
+      .compression =
+          static_cast<freeisle::png::Compression>(state.range(0)),
+      .palette = state.range(1) != 0,
+  };
+
+  const freeisle::core::Grid<freeisle::core::color::Rgb8> image = make_map();
+  freeisle::log::test::System system;
+
+  uint64_t size = 0;
+  for (auto _ : state) {
+    const std::vector<uint8_t> encoded = freeisle::png::encode_rgb8(
+        image, options, system.logger.make_child_logger("encode"));
+    size = encoded.size();
+  }
+
+  state.counters["size"] = size;
+  state.SetBytesProcessed(state.iterations() * Size * Size *
+                          sizeof(freeisle::core::color::Rgb8));
+}
+
+void BM_EncodeParallel(benchmark::State &state) {
+  const freeisle::png::EncodeOptions options = {
+      .compression =
+          static_cast<freeisle::png::Compression>(state.range(0)),
+      .palette = state.range(1) != 0,
+      .num_threads = static_cast<uint32_t>(state.range(2)),
+  };
+
+  const freeisle::core::Grid<freeisle::core::color::Rgb8> image =
+      make_map(LargeSize);
+  freeisle::log::test::System system;
+
+  uint64_t size = 0;
+  for (auto _ : state) {
+    const std::vector<uint8_t> encoded = freeisle::png::encode_rgb8(
+        image, options, system.logger.make_child_logger("encode"));
+    size = encoded.size();
+  }
+
+  state.counters["size"] = size;
+  state.SetBytesProcessed(state.iterations() * LargeSize * LargeSize *
+                          sizeof(freeisle::core::color::Rgb8));
+}
+
+} // namespace
+
+BENCHMARK(BM_Encode)
+    ->ArgsProduct({{0, 1, 2}, {0, 1}})
+    ->Unit(benchmark::kMillisecond);
+
+// One thread is the libpng path, more use the band encoder:
+BENCHMARK(BM_EncodeParallel)
+    ->ArgsProduct({{0, 1}, {0, 1}, {1, 2, 8}})
+    ->Unit(benchmark::kMillisecond)
+    ->UseRealTime();
+
+BENCHMARK_MAIN();
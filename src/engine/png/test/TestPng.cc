@@ -8,6 +8,8 @@
 
 #include <gtest/gtest.h>
 
+#include <png.h>
+
 extern "C" {
 
 void set_create_read_struct_fail() __attribute__((weak));
@@ -290,3 +292,262 @@ TEST_F(PngTest, EncodeWriteFailure) {
   EXPECT_EQ(test.sink.domain_, "test.encode");
   EXPECT_EQ(test.sink.message_, "Mock error");
 }
+
+TEST_F(PngTest, DecodeRows) {
+  const std::vector<uint8_t> data =
+      freeisle::fs::read_file("data/rgb8.png", nullptr);
+
+  uint32_t width = 0;
+  uint32_t height = 0;
+  std::vector<freeisle::core::color::Rgb8> pixels;
+  freeisle::png::decode_rgb8_rows(
+      data.data(), data.size(),
+      [&](uint32_t w, uint32_t h) {
+        width = w;
+        height = h;
+      },
+      [&](uint32_t y, const freeisle::core::color::Rgb8 *row) {
+        EXPECT_EQ(y * width, pixels.size());
+        pixels.insert(pixels.end(), row, row + width);
+      },
+      std::move(test.logger));
+
+  EXPECT_FALSE(test.sink.called_);
+
+  ASSERT_EQ(width, 2);
+  ASSERT_EQ(height, 2);
+  ASSERT_EQ(pixels.size(), 4);
+
+  EXPECT_EQ(pixels[1].r, 161);
+  EXPECT_EQ(pixels[1].g, 99);
+  EXPECT_EQ(pixels[1].b, 197);
+
+  EXPECT_EQ(pixels[3].r, 18);
+  EXPECT_EQ(pixels[3].g, 255);
+  EXPECT_EQ(pixels[3].b, 0);
+}
+
+TEST_F(PngTest, DecodeRowsCallbackThrows) {
+  const std::vector<uint8_t> data =
+      freeisle::fs::read_file("data/rgb8.png", nullptr);
+
+  EXPECT_THROW(freeisle::png::decode_rgb8_rows(
+                   data.data(), data.size(), [](uint32_t, uint32_t) {},
+                   [](uint32_t y, const freeisle::core::color::Rgb8 *) {
+                     if (y == 1) {
+                       throw std::invalid_argument("bad row");
+                     }
+                   },
+                   std::move(test.logger)),
+               std::invalid_argument);
+
+  EXPECT_FALSE(test.sink.called_);
+}
+
+TEST_F(PngTest, EncodeRows) {
+  const std::vector<uint8_t> encoded = freeisle::png::encode_rgb8_rows(
+      3, 2,
+      [](uint32_t y, freeisle::core::color::Rgb8 *row) {
+        for (uint32_t x = 0; x < 3; ++x) {
+          row[x] = freeisle::core::color::Rgb8{
+              static_cast<uint8_t>(x), static_cast<uint8_t>(y), 42};
+        }
+      },
+      freeisle::png::EncodeOptions{}, test.logger.make_child_logger("encode"));
+  const freeisle::core::Grid<freeisle::core::color::Rgb8> decoded =
+      freeisle::png::decode_rgb8(encoded.data(), encoded.size(),
+                                 test.logger.make_child_logger("decode"));
+
+  EXPECT_FALSE(test.sink.called_);
+
+  ASSERT_EQ(decoded.width(), 3);
+  ASSERT_EQ(decoded.height(), 2);
+
+  for (uint32_t y = 0; y < 2; ++y) {
+    for (uint32_t x = 0; x < 3; ++x) {
+      EXPECT_EQ(decoded(x, y).r, x);
+      EXPECT_EQ(decoded(x, y).g, y);
+      EXPECT_EQ(decoded(x, y).b, 42);
+    }
+  }
+}
+
+TEST(PngChannelMaxTest, ChannelMax) {
+  const freeisle::core::color::Rgb8 none =
+      freeisle::png::channel_max(nullptr, 0);
+  EXPECT_EQ(none.r, 0);
+  EXPECT_EQ(none.g, 0);
+  EXPECT_EQ(none.b, 0);
+
+  // Covers both whole blocks of 16 pixels and the remainder:
+  for (uint32_t num : {1, 15, 16, 17, 48, 100}) {
+    for (uint32_t at = 0; at < num; ++at) {
+      std::vector<freeisle::core::color::Rgb8> pixels(num, {1, 2, 3});
+      pixels[at] = freeisle::core::color::Rgb8{200, 3, 100};
+      pixels[num - 1 - at].g = 7;
+
+      const freeisle::core::color::Rgb8 max =
+          freeisle::png::channel_max(pixels.data(), pixels.size());
+      EXPECT_EQ(max.r, 200);
+      EXPECT_EQ(max.g, 7);
+      EXPECT_EQ(max.b, 100);
+    }
+  }
+}
+
+TEST_F(PngTest, EncodePalette) {
+  freeisle::core::Grid<freeisle::core::color::Rgb8> image(20, 3);
+  for (uint32_t y = 0; y < image.height(); ++y) {
+    for (uint32_t x = 0; x < image.width(); ++x) {
+      image(x, y) = freeisle::core::color::Rgb8{
+          static_cast<uint8_t>(x % 5), static_cast<uint8_t>(y), 7};
+    }
+  }
+
+  const std::vector<uint8_t> encoded = freeisle::png::encode_rgb8(
+      image, test.logger.make_child_logger("encode"));
+
+  // 15 colors fit into a 4-bit palette; bit depth and color type are stored
+  // at fixed offsets in the IHDR chunk:
+  ASSERT_GT(encoded.size(), 25);
+  EXPECT_EQ(encoded[24], 4);
+  EXPECT_EQ(encoded[25], PNG_COLOR_TYPE_PALETTE);
+
+  const freeisle::core::Grid<freeisle::core::color::Rgb8> decoded =
+      freeisle::png::decode_rgb8(encoded.data(), encoded.size(),
+                                 test.logger.make_child_logger("decode"));
+
+  EXPECT_FALSE(test.sink.called_);
+
+  ASSERT_EQ(decoded.width(), image.width());
+  ASSERT_EQ(decoded.height(), image.height());
+  for (uint32_t y = 0; y < image.height(); ++y) {
+    for (uint32_t x = 0; x < image.width(); ++x) {
+      EXPECT_EQ(decoded(x, y).r, image(x, y).r);
+      EXPECT_EQ(decoded(x, y).g, image(x, y).g);
+      EXPECT_EQ(decoded(x, y).b, image(x, y).b);
+    }
+  }
+}
+
+TEST_F(PngTest, EncodeTooManyColorsForPalette) {
+  freeisle::core::Grid<freeisle::core::color::Rgb8> image(17, 17);
+  for (uint32_t y = 0; y < image.height(); ++y) {
+    for (uint32_t x = 0; x < image.width(); ++x) {
+      image(x, y) = freeisle::core::color::Rgb8{static_cast<uint8_t>(x),
+                                                static_cast<uint8_t>(y), 0};
+    }
+  }
+
+  const std::vector<uint8_t> encoded = freeisle::png::encode_rgb8(
+      image, test.logger.make_child_logger("encode"));
+  ASSERT_GT(encoded.size(), 25);
+  EXPECT_EQ(encoded[24], 8);
+  EXPECT_EQ(encoded[25], PNG_COLOR_TYPE_RGB);
+
+  const freeisle::core::Grid<freeisle::core::color::Rgb8> decoded =
+      freeisle::png::decode_rgb8(encoded.data(), encoded.size(),
+                                 test.logger.make_child_logger("decode"));
+  ASSERT_EQ(decoded.width(), 17);
+  ASSERT_EQ(decoded.height(), 17);
+  EXPECT_EQ(decoded(16, 15).r, 16);
+  EXPECT_EQ(decoded(16, 15).g, 15);
+}
+
+TEST_F(PngTest, EncodeCompression) {
+  freeisle::core::Grid<freeisle::core::color::Rgb8> image(64, 64);
+  for (uint32_t y = 0; y < image.height(); ++y) {
+    for (uint32_t x = 0; x < image.width(); ++x) {
+      image(x, y) = freeisle::core::color::Rgb8{
+          static_cast<uint8_t>(x * y), static_cast<uint8_t>(x + y), 0};
+    }
+  }
+
+  for (freeisle::png::Compression compression :
+       {freeisle::png::Compression::Default, freeisle::png::Compression::Fast,
+        freeisle::png::Compression::Small}) {
+    for (bool palette : {false, true}) {
+      const std::vector<uint8_t> encoded = freeisle::png::encode_rgb8(
+          image,
+          freeisle::png::EncodeOptions{.compression = compression,
+                                       .palette = palette},
+          test.logger.make_child_logger("encode"));
+      const freeisle::core::Grid<freeisle::core::color::Rgb8> decoded =
+          freeisle::png::decode_rgb8(encoded.data(), encoded.size(),
+                                     test.logger.make_child_logger("decode"));
+
+      ASSERT_EQ(decoded.width(), 64);
+      ASSERT_EQ(decoded.height(), 64);
+      for (uint32_t y = 0; y < image.height(); ++y) {
+        for (uint32_t x = 0; x < image.width(); ++x) {
+          EXPECT_EQ(decoded(x, y).r, image(x, y).r);
+          EXPECT_EQ(decoded(x, y).g, image(x, y).g);
+        }
+      }
+    }
+  }
+
+  EXPECT_FALSE(test.sink.called_);
+}
+
+TEST_F(PngTest, EncodeParallel) {
+  // Large enough to be split into several bands, both as RGB and with a
+  // 4-bit palette:
+  for (uint32_t num_colors : {1024, 16}) {
+    freeisle::core::Grid<freeisle::core::color::Rgb8> image(301, 1030);
+    for (uint32_t y = 0; y < image.height(); ++y) {
+      for (uint32_t x = 0; x < image.width(); ++x) {
+        const uint32_t color = (x * 7 + y * 3 + x * y) % num_colors;
+        image(x, y) = freeisle::core::color::Rgb8{
+            static_cast<uint8_t>(color), static_cast<uint8_t>(color >> 8),
+            static_cast<uint8_t>(x)};
+        if (num_colors <= 16) {
+          image(x, y).b = 0;
+        }
+      }
+    }
+
+    for (freeisle::png::Compression compression :
+         {freeisle::png::Compression::Default,
+          freeisle::png::Compression::Fast,
+          freeisle::png::Compression::Small}) {
+      const std::vector<uint8_t> encoded = freeisle::png::encode_rgb8(
+          image,
+          freeisle::png::EncodeOptions{.compression = compression,
+                                       .num_threads = 4},
+          test.logger.make_child_logger("encode"));
+      const freeisle::core::Grid<freeisle::core::color::Rgb8> decoded =
+          freeisle::png::decode_rgb8(encoded.data(), encoded.size(),
+                                     test.logger.make_child_logger("decode"));
+
+      ASSERT_EQ(decoded.width(), image.width());
+      ASSERT_EQ(decoded.height(), image.height());
+      for (uint32_t y = 0; y < image.height(); ++y) {
+        for (uint32_t x = 0; x < image.width(); ++x) {
+          ASSERT_EQ(decoded(x, y).r, image(x, y).r) << x << "," << y;
+          ASSERT_EQ(decoded(x, y).g, image(x, y).g) << x << "," << y;
+          ASSERT_EQ(decoded(x, y).b, image(x, y).b) << x << "," << y;
+        }
+      }
+    }
+  }
+
+  EXPECT_FALSE(test.sink.called_);
+}
+
+TEST_F(PngTest, EncodeParallelCallbackThrows) {
+  EXPECT_THROW(freeisle::png::encode_rgb8_rows(
+                   100, 5000,
+                   [](uint32_t y, freeisle::core::color::Rgb8 *row) {
+                     if (y == 4000) {
+                       throw std::invalid_argument("bad row");
+                     }
+
+                     std::fill(row, row + 100,
+                               freeisle::core::color::Rgb8{1, 2, 3});
+                   },
+                   freeisle::png::EncodeOptions{.palette = false,
+                                                .num_threads = 4},
+                   test.logger.make_child_logger("encode")),
+               std::invalid_argument);
+}
@@ -0,0 +1,77 @@
+#include "spatial/UnitIndex.hh"
+
+#include <algorithm>
+#include <cassert>
+
+namespace freeisle::spatial {
+
+bool is_indexed(const state::Unit &unit) {
+  return !unit.contained_in_unit && !unit.contained_in_shop;
+}
+
+UnitIndex::UnitIndex() : UnitIndex(0, 0) {}
+
+UnitIndex::UnitIndex(uint32_t width, uint32_t height)
+    : width_(width), height_(height),
+      chunks_x_((width + ChunkSize - 1) >> ChunkBits),
+      chunks_y_((height + ChunkSize - 1) >> ChunkBits), size_(0),
+      buckets_(NumLevels * chunks_x_ * chunks_y_) {}
+
+UnitIndex::UnitIndex(state::State &state)
+    : UnitIndex(state.map.grid.width(), state.map.grid.height()) {
+  rebuild(state);
+}
+
+void UnitIndex::rebuild(state::State &state) {
+  *this = UnitIndex(state.map.grid.width(), state.map.grid.height());
+
+  for (auto &[id, unit] : state.units) {
+    if (is_indexed(unit)) {
+      add_unit(unit);
+    }
+  }
+}
+
+void UnitIndex::add_unit(state::Unit &unit) {
+  assert(unit.location.x < width_);
+  assert(unit.location.y < height_);
+  insert(bucket(unit.level, unit.location.x, unit.location.y), unit);
+}
+
+void UnitIndex::remove_unit(state::Unit &unit) {
+  erase(bucket(unit.level, unit.location.x, unit.location.y), unit);
+}
+
+void UnitIndex::move_unit(state::Unit &unit, def::Location from,
+                          def::Level from_level) {
+  assert(unit.location.x < width_);
+  assert(unit.location.y < height_);
+
+  const uint32_t from_bucket = bucket(from_level, from.x, from.y);
+  const uint32_t to_bucket =
+      bucket(unit.level, unit.location.x, unit.location.y);
+
+  // Buckets only know the chunk, so moves within a chunk are free
+  if (from_bucket != to_bucket) {
+    erase(from_bucket, unit);
+    insert(to_bucket, unit);
+  }
+}
+
+void UnitIndex::insert(uint32_t bucket, state::Unit &unit) {
+  buckets_[bucket].push_back(&unit);
+  ++size_;
+}
+
+void UnitIndex::erase(uint32_t bucket, state::Unit &unit) {
+  std::vector<state::Unit *> &units = buckets_[bucket];
+  const std::vector<state::Unit *>::iterator iter =
+      std::find(units.begin(), units.end(), &unit);
+  assert(iter != units.end());
+
+  *iter = units.back();
+  units.pop_back();
+  --size_;
+}
+
+} // namespace freeisle::spatial
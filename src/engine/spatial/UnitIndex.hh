@@ -0,0 +1,205 @@
+#pragma once
+
+#include "state/Allegiance.hh"
+#include "state/Player.hh"
+#include "state/State.hh"
+#include "state/Unit.hh"
+
+#include "def/Level.hh"
+#include "def/Location.hh"
+
+#include "core/Hex.hh"
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+namespace freeisle::spatial {
+
+/**
+ * Number of levels a unit can be on.
+ */
+constexpr uint32_t NumLevels = std::size(def::Levels);
+
+/**
+ * Bit mask selecting a single level in range queries.
+ */
+constexpr uint32_t level_bit(def::Level level) {
+  return 1u << static_cast<uint32_t>(level);
+}
+
+/**
+ * Bit mask selecting all levels in range queries.
+ */
+constexpr uint32_t AllLevels = (1u << NumLevels) - 1;
+
+/**
+ * Returns whether the given unit is tracked by the unit index, i.e. whether
+ * it is on the map rather than contained in another unit or in a shop.
+ */
+bool is_indexed(const state::Unit &unit);
+
+/**
+ * Spatial index of the units on the map, to find units within a certain
+ * distance of a hex without looking at all units of the game.
+ *
+ * The map is divided into square chunks of ChunkSize x ChunkSize hexes, and
+ * every unit is stored in the bucket of its chunk and level. Range queries
+ * only visit the buckets of the chunks that overlap the bounding box of the
+ * range, so their cost scales with the number of units near the queried hex
+ * rather than with the total number of units.
+ *
+ * Like the fog of war, the index is maintained incrementally: whenever a
+ * unit appears, disappears or moves, the corresponding function needs to be
+ * called. Units are referenced by pointer, so they must stay alive while
+ * they are indexed.
+ */
+class UnitIndex {
+public:
+  static constexpr uint32_t ChunkBits = 3;
+  static constexpr uint32_t ChunkSize = 1u << ChunkBits;
+
+  /**
+   * Create an empty index for an empty map.
+   */
+  UnitIndex();
+
+  /**
+   * Create an empty index for a map of the given size.
+   */
+  UnitIndex(uint32_t width, uint32_t height);
+
+  /**
+   * Create an index of all units in the given state.
+   */
+  explicit UnitIndex(state::State &state);
+
+  uint32_t width() const { return width_; }
+  uint32_t height() const { return height_; }
+
+  /**
+   * Number of units in the index.
+   */
+  uint32_t size() const { return size_; }
+
+  /**
+   * Clear the index, and add all units of the given state to it.
+   */
+  void rebuild(state::State &state);
+
+  /**
+   * Add the given unit at its current location and level. Call this when a
+   * unit is placed on the map, e.g. when it is produced or unloaded.
+   */
+  void add_unit(state::Unit &unit);
+
+  /**
+   * Remove the given unit from its current location and level. Call this
+   * before a unit is removed from the map, e.g. when it is destroyed or
+   * loaded into a container.
+   */
+  void remove_unit(state::Unit &unit);
+
+  /**
+   * Move the given unit from the given location and level to its current
+   * location and level. Call this after the unit has been updated.
+   */
+  void move_unit(state::Unit &unit, def::Location from, def::Level from_level);
+
+  /**
+   * Call fn for every unit on one of the given levels whose distance to
+   * the given hex is at least min_range and at most max_range. Levels are
+   * given as a bit mask of level_bit() values. The order in which units are
+   * visited is unspecified.
+   */
+  template <typename Fn>
+  void for_each_in_range(uint32_t x, uint32_t y, uint32_t min_range,
+                         uint32_t max_range, uint32_t levels, Fn fn) const;
+
+  /**
+   * Call fn for every unit on one of the given levels at exactly the given
+   * distance to the given hex.
+   */
+  template <typename Fn>
+  void for_each_in_ring(uint32_t x, uint32_t y, uint32_t range,
+                        uint32_t levels, Fn fn) const {
+    for_each_in_range(x, y, range, range, levels, fn);
+  }
+
+  /**
+   * Call fn for every unit within the given range that is owned by a player
+   * who is not allied with the given player. Units without owner are not
+   * considered enemies.
+   */
+  template <typename Fn>
+  void for_each_enemy_in_range(const state::Player &player, uint32_t x,
+                               uint32_t y, uint32_t min_range,
+                               uint32_t max_range, uint32_t levels,
+                               Fn fn) const {
+    for_each_in_range(x, y, min_range, max_range, levels,
+                      [&player, &fn](state::Unit &unit) {
+                        if (unit.owner &&
+                            !state::are_allied(*unit.owner, player)) {
+                          fn(unit);
+                        }
+                      });
+  }
+
+private:
+  uint32_t bucket(def::Level level, uint32_t x, uint32_t y) const {
+    return (static_cast<uint32_t>(level) * chunks_y_ + (y >> ChunkBits)) *
+               chunks_x_ +
+           (x >> ChunkBits);
+  }
+
+  void insert(uint32_t bucket, state::Unit &unit);
+  void erase(uint32_t bucket, state::Unit &unit);
+
+  uint32_t width_;
+  uint32_t height_;
+  uint32_t chunks_x_;
+  uint32_t chunks_y_;
+  uint32_t size_;
+
+  /**
+   * Units of each chunk, for each level. Indexed by bucket().
+   */
+  std::vector<std::vector<state::Unit *>> buckets_;
+};
+
+template <typename Fn>
+void UnitIndex::for_each_in_range(uint32_t x, uint32_t y, uint32_t min_range,
+                                  uint32_t max_range, uint32_t levels,
+                                  Fn fn) const {
+  if (min_range > max_range || size_ == 0) {
+    return;
+  }
+
+  // Hexes within range differ by at most the range in both coordinates
+  const uint32_t x0 = x > max_range ? x - max_range : 0;
+  const uint32_t y0 = y > max_range ? y - max_range : 0;
+  const uint32_t x1 = max_range < width_ - 1 - x ? x + max_range : width_ - 1;
+  const uint32_t y1 =
+      max_range < height_ - 1 - y ? y + max_range : height_ - 1;
+
+  for (uint32_t level = 0; level < NumLevels; ++level) {
+    if (!(levels & (1u << level))) {
+      continue;
+    }
+
+    for (uint32_t cy = y0 >> ChunkBits; cy <= y1 >> ChunkBits; ++cy) {
+      const uint32_t row = (level * chunks_y_ + cy) * chunks_x_;
+      for (uint32_t cx = x0 >> ChunkBits; cx <= x1 >> ChunkBits; ++cx) {
+        for (state::Unit *unit : buckets_[row + cx]) {
+          const uint32_t distance = core::hex::distance(
+              x, y, unit->location.x, unit->location.y);
+          if (distance >= min_range && distance <= max_range) {
+            fn(*unit);
+          }
+        }
+      }
+    }
+  }
+}
+
+} // namespace freeisle::spatial
@@ -0,0 +1,135 @@
+#include "spatial/UnitIndex.hh"
+
+#include "state/Allegiance.hh"
+
+#include "core/Hex.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  Fixture(uint32_t size, uint32_t num_units) : Scenario(size, size) {
+    add_unit_def("tank",
+                 freeisle::def::UnitDef{.level = freeisle::def::Level::Land});
+
+    // two teams of two players each
+    add_team("north");
+    add_team("south");
+    for (uint32_t i = 0; i < 4; ++i) {
+      add_player("player" + std::to_string(i), i % 2 ? "north" : "south");
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> coord(0, size - 1);
+    for (uint32_t i = 0; i < num_units; ++i) {
+      const uint32_t x = coord(rng);
+      const uint32_t y = coord(rng);
+      add_unit("unit" + std::to_string(i), "tank",
+               "player" + std::to_string(i % 4), x, y);
+    }
+
+    index.rebuild(state);
+  }
+
+  freeisle::spatial::UnitIndex index;
+};
+
+/**
+ * Count enemies of a player within weapon range of every unit, using the
+ * spatial index.
+ */
+void BM_EnemiesInRangeIndex(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+  const uint32_t range = state.range(2);
+
+  for (auto _ : state) {
+    uint32_t count = 0;
+    for (const auto &[id, unit] : fixture.state.units) {
+      fixture.index.for_each_enemy_in_range(
+          *unit.owner, unit.location.x, unit.location.y, 1, range,
+          freeisle::spatial::AllLevels,
+          [&count](freeisle::state::Unit &) { ++count; });
+    }
+    benchmark::DoNotOptimize(count);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+/**
+ * Same as BM_EnemiesInRangeIndex, but scanning all units for each query.
+ */
+void BM_EnemiesInRangeScan(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+  const uint32_t range = state.range(2);
+
+  for (auto _ : state) {
+    uint32_t count = 0;
+    for (const auto &[id, unit] : fixture.state.units) {
+      for (const auto &[other_id, other] : fixture.state.units) {
+        const uint32_t distance = freeisle::core::hex::distance(
+            unit.location.x, unit.location.y, other.location.x,
+            other.location.y);
+        if (distance >= 1 && distance <= range &&
+            !freeisle::state::are_allied(unit.owner, other.owner)) {
+          ++count;
+        }
+      }
+    }
+    benchmark::DoNotOptimize(count);
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(1));
+}
+
+/**
+ * Moving a unit by one hex, which is what keeping the index up to date
+ * costs per move.
+ */
+void BM_MoveUnit(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+
+  std::vector<freeisle::state::Unit *> units;
+  for (auto &[id, unit] : fixture.state.units) {
+    units.push_back(&unit);
+  }
+
+  uint32_t i = 0;
+  for (auto _ : state) {
+    freeisle::state::Unit &unit = *units[i++ % units.size()];
+    const freeisle::def::Location from = unit.location;
+
+    uint32_t nx[freeisle::core::hex::NumNeighbors];
+    uint32_t ny[freeisle::core::hex::NumNeighbors];
+    const uint32_t n = freeisle::core::hex::neighbors(
+        from.x, from.y, state.range(0), state.range(0), nx, ny);
+    unit.location = {.x = nx[i % n], .y = ny[i % n]};
+    fixture.index.move_unit(unit, from, unit.level);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_EnemiesInRangeIndex)
+    ->Args({256, 1000, 3})
+    ->Args({256, 5000, 3})
+    ->Args({256, 5000, 8})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_EnemiesInRangeScan)
+    ->Args({256, 1000, 3})
+    ->Args({256, 5000, 3})
+    ->Args({256, 5000, 8})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK(BM_MoveUnit)->Args({256, 1000})->Args({256, 5000});
+
+BENCHMARK_MAIN();
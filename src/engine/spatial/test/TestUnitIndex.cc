@@ -0,0 +1,202 @@
+#include "spatial/UnitIndex.hh"
+
+#include "core/Hex.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+class TestUnitIndex : public ::testing::Test,
+                      public freeisle::state::test::Scenario {
+public:
+  TestUnitIndex() : Scenario(20, 17) {
+    add_unit_def("sub", freeisle::def::UnitDef{
+                            .level = freeisle::def::Level::UnderWater});
+    add_unit_def("ship",
+                 freeisle::def::UnitDef{.level = freeisle::def::Level::Water});
+    add_unit_def("tank",
+                 freeisle::def::UnitDef{.level = freeisle::def::Level::Land});
+    add_unit_def("plane",
+                 freeisle::def::UnitDef{.level = freeisle::def::Level::Air});
+
+    add_default_players();
+  }
+
+  template <typename Query> std::vector<std::string> ids(Query query) {
+    std::vector<std::string> result;
+    query([this, &result](freeisle::state::Unit &unit) {
+      for (const auto &[id, candidate] : state.units) {
+        if (&candidate == &unit) {
+          result.push_back(id);
+        }
+      }
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+  }
+
+  std::vector<std::string> in_range(const freeisle::spatial::UnitIndex &index,
+                                    uint32_t x, uint32_t y, uint32_t min_range,
+                                    uint32_t max_range,
+                                    uint32_t levels =
+                                        freeisle::spatial::AllLevels) {
+    return ids([&](auto fn) {
+      index.for_each_in_range(x, y, min_range, max_range, levels, fn);
+    });
+  }
+};
+
+TEST_F(TestUnitIndex, Empty) {
+  const freeisle::spatial::UnitIndex index(state);
+  EXPECT_EQ(index.size(), 0);
+  EXPECT_EQ(index.width(), 20);
+  EXPECT_EQ(index.height(), 17);
+  EXPECT_TRUE(in_range(index, 5, 5, 0, 100).empty());
+
+  const freeisle::spatial::UnitIndex empty;
+  EXPECT_TRUE(in_range(empty, 0, 0, 0, 100).empty());
+}
+
+TEST_F(TestUnitIndex, RangeAndRing) {
+  add_unit("unit001", "tank", "rose", 5, 5);
+  add_unit("unit002", "tank", "rose", 6, 5);
+  add_unit("unit003", "tank", "rose", 5, 8);
+  add_unit("unit004", "tank", "rose", 19, 16);
+
+  const freeisle::spatial::UnitIndex index(state);
+  EXPECT_EQ(index.size(), 4);
+
+  EXPECT_EQ(in_range(index, 5, 5, 0, 0),
+            (std::vector<std::string>{"unit001"}));
+  EXPECT_EQ(in_range(index, 5, 5, 1, 3),
+            (std::vector<std::string>{"unit002", "unit003"}));
+  EXPECT_EQ(in_range(index, 5, 5, 2, 3),
+            (std::vector<std::string>{"unit003"}));
+  EXPECT_EQ(ids([&](auto fn) { index.for_each_in_ring(5, 5, 1, 31, fn); }),
+            (std::vector<std::string>{"unit002"}));
+  EXPECT_EQ(in_range(index, 5, 5, 0, 1000),
+            (std::vector<std::string>{"unit001", "unit002", "unit003",
+                                      "unit004"}));
+  EXPECT_TRUE(in_range(index, 5, 5, 3, 2).empty());
+}
+
+TEST_F(TestUnitIndex, Levels) {
+  add_unit("unit001", "sub", "rose", 5, 5);
+  add_unit("unit002", "ship", "rose", 5, 5);
+  add_unit("unit003", "plane", "rose", 5, 6);
+
+  const freeisle::spatial::UnitIndex index(state);
+  EXPECT_EQ(in_range(index, 5, 5, 0, 1,
+                     freeisle::spatial::level_bit(
+                         freeisle::def::Level::UnderWater)),
+            (std::vector<std::string>{"unit001"}));
+  EXPECT_EQ(
+      in_range(index, 5, 5, 0, 1,
+               freeisle::spatial::level_bit(freeisle::def::Level::Water) |
+                   freeisle::spatial::level_bit(freeisle::def::Level::Air)),
+      (std::vector<std::string>{"unit002", "unit003"}));
+  EXPECT_TRUE(in_range(index, 5, 5, 0, 1,
+                       freeisle::spatial::level_bit(
+                           freeisle::def::Level::Land))
+                  .empty());
+}
+
+TEST_F(TestUnitIndex, ContainedUnitsAreNotIndexed) {
+  add_unit("unit001", "tank", "rose", 5, 5);
+  freeisle::state::Unit &passenger = add_unit("unit002", "tank", "rose", 5, 5);
+  passenger.contained_in_unit = state.units.find("unit001");
+
+  const freeisle::spatial::UnitIndex index(state);
+  EXPECT_EQ(index.size(), 1);
+  EXPECT_EQ(in_range(index, 5, 5, 0, 0),
+            (std::vector<std::string>{"unit001"}));
+}
+
+TEST_F(TestUnitIndex, Enemies) {
+  add_unit("unit001", "tank", "rose", 5, 5);
+  add_unit("unit002", "tank", "daisy", 5, 6);
+  add_unit("unit003", "tank", "lily", 6, 6);
+  add_unit("unit004", "tank", "", 4, 5);
+  add_unit("unit005", "tank", "lily", 12, 12);
+
+  const freeisle::spatial::UnitIndex index(state);
+  EXPECT_EQ(ids([&](auto fn) {
+              index.for_each_enemy_in_range(state.players["rose"], 5, 5, 1, 2,
+                                            freeisle::spatial::AllLevels, fn);
+            }),
+            (std::vector<std::string>{"unit003"}));
+  EXPECT_EQ(ids([&](auto fn) {
+              index.for_each_enemy_in_range(state.players["lily"], 5, 5, 0, 2,
+                                            freeisle::spatial::AllLevels, fn);
+            }),
+            (std::vector<std::string>{"unit001", "unit002"}));
+}
+
+TEST_F(TestUnitIndex, AddRemoveMove) {
+  freeisle::spatial::UnitIndex index(state);
+
+  freeisle::state::Unit &unit = add_unit("unit001", "tank", "rose", 1, 1);
+  index.add_unit(unit);
+  EXPECT_EQ(in_range(index, 1, 1, 0, 0),
+            (std::vector<std::string>{"unit001"}));
+
+  // within the same chunk
+  const freeisle::def::Location from = unit.location;
+  unit.location = {.x = 2, .y = 1};
+  index.move_unit(unit, from, freeisle::def::Level::Land);
+  EXPECT_TRUE(in_range(index, 1, 1, 0, 0).empty());
+  EXPECT_EQ(in_range(index, 2, 1, 0, 0),
+            (std::vector<std::string>{"unit001"}));
+
+  // across chunks and levels
+  unit.location = {.x = 15, .y = 12};
+  unit.level = freeisle::def::Level::Air;
+  index.move_unit(unit, {.x = 2, .y = 1}, freeisle::def::Level::Land);
+  EXPECT_TRUE(in_range(index, 2, 1, 0, 5).empty());
+  EXPECT_EQ(in_range(index, 15, 12, 0, 0,
+                     freeisle::spatial::level_bit(freeisle::def::Level::Air)),
+            (std::vector<std::string>{"unit001"}));
+  EXPECT_EQ(index.size(), 1);
+
+  index.remove_unit(unit);
+  EXPECT_EQ(index.size(), 0);
+  EXPECT_TRUE(in_range(index, 15, 12, 0, 100).empty());
+}
+
+TEST_F(TestUnitIndex, MatchesScan) {
+  std::mt19937 rng(42);
+  std::uniform_int_distribution<uint32_t> x_dist(0, 19);
+  std::uniform_int_distribution<uint32_t> y_dist(0, 16);
+  for (uint32_t i = 0; i < 100; ++i) {
+    const uint32_t x = x_dist(rng);
+    const uint32_t y = y_dist(rng);
+    add_unit("unit" + std::to_string(i), "tank", "rose", x, y);
+  }
+
+  const freeisle::spatial::UnitIndex index(state);
+  for (uint32_t y = 0; y < 17; ++y) {
+    for (uint32_t x = 0; x < 20; ++x) {
+      for (const auto &[min_range, max_range] :
+           {std::pair{0u, 1u}, std::pair{2u, 4u}, std::pair{7u, 9u}}) {
+        std::vector<std::string> expected;
+        for (const auto &[id, unit] : state.units) {
+          const uint32_t distance = freeisle::core::hex::distance(
+              x, y, unit.location.x, unit.location.y);
+          if (distance >= min_range && distance <= max_range) {
+            expected.push_back(id);
+          }
+        }
+
+        std::sort(expected.begin(), expected.end());
+        EXPECT_EQ(in_range(index, x, y, min_range, max_range), expected)
+            << x << "," << y << ": " << min_range << "-" << max_range;
+      }
+    }
+  }
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "state/Player.hh"
+
+#include "def/Collection.hh"
+
+namespace freeisle::state {
+
+/**
+ * Returns whether two players are allied, i.e. whether they are the same
+ * player or play in the same team.
+ */
+inline bool are_allied(const Player &a, const Player &b) {
+  return &a == &b || (a.team && a.team == b.team);
+}
+
+/**
+ * Returns whether the owners of two objects are allied. Objects without an
+ * owner are not allied with anybody.
+ */
+inline bool are_allied(const def::NullableRef<Player> &a,
+                       const def::NullableRef<Player> &b) {
+  return a && b && are_allied(*a, *b);
+}
+
+} // namespace freeisle::state
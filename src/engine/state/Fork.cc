@@ -0,0 +1,149 @@
+#include "state/Fork.hh"
+
+#include <cassert>
+
+namespace freeisle::state {
+
+namespace {
+
+/**
+ * Returns a reference to the object in the given collection that has the
+ * same handle as the object that ref points to.
+ */
+template <typename T>
+def::NullableRef<T> rebind(const def::NullableRef<T> &ref,
+                           def::Collection<T> &collection) {
+  if (!ref) {
+    return def::NullableRef<T>();
+  }
+
+  return collection.find(ref.handle());
+}
+
+template <typename T>
+def::Ref<T> rebind(const def::Ref<T> &ref, def::Collection<T> &collection) {
+  const typename def::Collection<T>::iterator iter =
+      collection.find(ref.handle());
+  assert(iter != collection.end());
+  return iter;
+}
+
+/**
+ * Returns a copy of a reference into the scenario. Scenario objects are
+ * shared between original and fork, and refs cannot be copied from const
+ * refs, so this drops the const of the original ref.
+ */
+template <typename T> T share(const T &ref) { return const_cast<T &>(ref); }
+
+void copy_container(const Container &from, Container &to,
+                    def::Collection<Unit> &units) {
+  to.def = from.def;
+  for (const def::Ref<Unit> &unit : from.units) {
+    to.units.push_back(rebind(unit, units));
+  }
+}
+
+void copy_player(const Player &from, Player &to, State &state) {
+  to.name = from.name;
+  to.color = from.color;
+  to.team = rebind(from.team, state.teams);
+  to.fow = from.fow.clone();
+  to.wealth = from.wealth;
+  to.captain = rebind(from.captain, state.units);
+  to.lose_conditions = from.lose_conditions;
+  to.is_eliminated = from.is_eliminated;
+  // Source is ordered already, so every insertion goes to the end
+  for (const def::Ref<Unit> &unit : from.units) {
+    to.units.insert(to.units.end(), rebind(unit, state.units));
+  }
+}
+
+void copy_shop(const Shop &from, Shop &to, State &state) {
+  to.def = share(from.def);
+  to.owner = rebind(from.owner, state.players);
+  copy_container(from.container, to.container, state.units);
+}
+
+void copy_unit(const Unit &from, Unit &to, State &state) {
+  to.def = share(from.def);
+  to.owner = rebind(from.owner, state.players);
+  to.location = from.location;
+  to.health = from.health;
+  to.level = from.level;
+  to.movement = from.movement;
+  to.fuel = from.fuel;
+  to.experience = from.experience;
+  to.has_actioned = from.has_actioned;
+  to.has_soared = from.has_soared;
+  to.supplies = from.supplies;
+  for (const auto &[weapon, ammo] : from.ammo) {
+    to.ammo.emplace_hint(to.ammo.end(), share(weapon), ammo);
+  }
+  copy_container(from.container, to.container, state.units);
+  to.contained_in_unit = rebind(from.contained_in_unit, state.units);
+  to.contained_in_shop = rebind(from.contained_in_shop, state.shops);
+  to.stats = from.stats;
+}
+
+void copy_map(const Map &from, Map &to, State &state) {
+  to.def = from.def;
+  to.grid = from.grid.clone();
+  to.occupants.reserve(from.occupants.size());
+  for (const Map::Occupants &occupants : from.occupants) {
+    to.occupants.push_back(Map::Occupants{
+        .surface_unit = rebind(occupants.surface_unit, state.units),
+        .subsurface_unit = rebind(occupants.subsurface_unit, state.units),
+        .shop = rebind(occupants.shop, state.shops),
+    });
+  }
+  to.free_occupants = from.free_occupants;
+}
+
+/**
+ * Copy all objects of a collection whose layout has already been copied.
+ */
+template <typename T, typename CopyFn>
+void copy_objects(const def::Collection<T> &from, def::Collection<T> &to,
+                  CopyFn copy) {
+  for (auto iter = from.begin(); iter != from.end(); ++iter) {
+    const typename def::Collection<T>::iterator target =
+        to.find(def::Collection<T>::handle(iter));
+    assert(target != to.end());
+    copy(iter->second, target->second);
+  }
+}
+
+} // namespace
+
+State fork(const State &state) {
+  State result{
+      .scenario = state.scenario,
+      .teams = state.teams,
+      .turn_num = state.turn_num,
+  };
+
+  // Create all objects first, so that references between them can be
+  // re-bound while copying.
+  result.players.copy_layout(state.players);
+  result.shops.copy_layout(state.shops);
+  result.units.copy_layout(state.units);
+
+  copy_objects(state.players, result.players,
+               [&result](const Player &from, Player &to) {
+                 copy_player(from, to, result);
+               });
+  copy_objects(state.shops, result.shops,
+               [&result](const Shop &from, Shop &to) {
+                 copy_shop(from, to, result);
+               });
+  copy_objects(state.units, result.units,
+               [&result](const Unit &from, Unit &to) {
+                 copy_unit(from, to, result);
+               });
+
+  copy_map(state.map, result.map, result);
+  result.player_at_turn = rebind(state.player_at_turn, result.players);
+  return result;
+}
+
+} // namespace freeisle::state
@@ -0,0 +1,19 @@
+#pragma once
+
+#include "state/State.hh"
+
+namespace freeisle::state {
+
+/**
+ * Returns an independent copy of the given state, e.g. for looking ahead
+ * during AI search.
+ *
+ * Teams, players, shops and units are copied into the same slots of their
+ * collections, so that handles of the original state are valid for the
+ * fork as well, and all references between them are re-bound to the
+ * copies. The scenario and the definitions it contains are immutable and
+ * shared between the original and the fork.
+ */
+State fork(const State &state);
+
+} // namespace freeisle::state
@@ -7,16 +7,27 @@
 
 #include "core/Grid.hh"
 
+#include <cstdint>
+#include <vector>
+
 namespace freeisle::state {
 
 /**
  * State of the map.
+ *
+ * Most hexes of a map are empty, so the grid only stores a packed 32-bit
+ * value per hex, with flags that tell which kind of occupants the hex has.
+ * The occupants themselves are stored in a separate table, which only has
+ * entries for occupied hexes. This keeps sweeps over the whole map compact.
+ *
+ * Use the accessor functions to query and modify the occupants of a hex,
+ * which keep grid and occupant table consistent.
  */
 struct Map {
   /**
-   * Information stored for each hex of the map.
+   * Units and shops on a hex.
    */
-  struct Hex {
+  struct Occupants {
     /**
      * Which unit is on the surface (or in the air) of this hex, if any.
      */
@@ -33,6 +44,32 @@ struct Map {
     def::NullableRef<Shop> shop;
   };
 
+  /**
+   * Information stored for each hex of the map: the lower bits are flags
+   * for the kinds of occupants on the hex, and the upper bits hold the index
+   * of the hex's entry in the occupant table, if it has any occupants.
+   */
+  struct Hex {
+    static constexpr uint32_t SurfaceUnit = 1u << 0;
+    static constexpr uint32_t SubsurfaceUnit = 1u << 1;
+    static constexpr uint32_t Shop = 1u << 2;
+    static constexpr uint32_t FlagBits = 3;
+    static constexpr uint32_t FlagMask = (1u << FlagBits) - 1;
+
+    bool empty() const { return value == 0; }
+    bool has_surface_unit() const { return value & SurfaceUnit; }
+    bool has_subsurface_unit() const { return value & SubsurfaceUnit; }
+    bool has_shop() const { return value & Shop; }
+
+    /**
+     * Index of the hex's entry in the occupant table. Only valid if the hex
+     * is not empty.
+     */
+    uint32_t index() const { return value >> FlagBits; }
+
+    uint32_t value;
+  };
+
   /**
    * Map definition.
    */
@@ -42,6 +79,142 @@ struct Map {
    * Grid with information for all hex tiles.
    */
   core::Grid<Hex> grid;
+
+  /**
+   * Occupants of all non-empty hexes, indexed by Hex::index().
+   */
+  std::vector<Occupants> occupants;
+
+  /**
+   * Entries of the occupant table that are not in use.
+   */
+  std::vector<uint32_t> free_occupants;
+
+  /**
+   * Returns the unit on the surface of the given hex, if any.
+   */
+  const def::NullableRef<Unit> &surface_unit(uint32_t x, uint32_t y) const {
+    const Hex hex = grid(x, y);
+    return hex.has_surface_unit() ? occupants[hex.index()].surface_unit
+                                  : null_unit();
+  }
+
+  /**
+   * Returns the unit below the surface of the given hex, if any.
+   */
+  const def::NullableRef<Unit> &subsurface_unit(uint32_t x,
+                                                uint32_t y) const {
+    const Hex hex = grid(x, y);
+    return hex.has_subsurface_unit() ? occupants[hex.index()].subsurface_unit
+                                     : null_unit();
+  }
+
+  /**
+   * Returns the unit on the given hex at the surface or below it.
+   */
+  const def::NullableRef<Unit> &unit(uint32_t x, uint32_t y,
+                                     bool subsurface) const {
+    return subsurface ? subsurface_unit(x, y) : surface_unit(x, y);
+  }
+
+  /**
+   * Returns the shop on the given hex, if any.
+   */
+  const def::NullableRef<Shop> &shop(uint32_t x, uint32_t y) const {
+    const Hex hex = grid(x, y);
+    return hex.has_shop() ? occupants[hex.index()].shop : null_shop();
+  }
+
+  /**
+   * Set or clear the unit on the surface of the given hex.
+   */
+  void set_surface_unit(uint32_t x, uint32_t y, def::NullableRef<Unit> unit) {
+    const bool set = static_cast<bool>(unit);
+    entry(x, y).surface_unit = unit;
+    update_flag(x, y, Hex::SurfaceUnit, set);
+  }
+
+  /**
+   * Set or clear the unit below the surface of the given hex.
+   */
+  void set_subsurface_unit(uint32_t x, uint32_t y,
+                           def::NullableRef<Unit> unit) {
+    const bool set = static_cast<bool>(unit);
+    entry(x, y).subsurface_unit = unit;
+    update_flag(x, y, Hex::SubsurfaceUnit, set);
+  }
+
+  /**
+   * Set or clear the unit on the given hex at the surface or below it.
+   */
+  void set_unit(uint32_t x, uint32_t y, bool subsurface,
+                def::NullableRef<Unit> unit) {
+    if (subsurface) {
+      set_subsurface_unit(x, y, unit);
+    } else {
+      set_surface_unit(x, y, unit);
+    }
+  }
+
+  /**
+   * Set or clear the shop on the given hex.
+   */
+  void set_shop(uint32_t x, uint32_t y, def::NullableRef<Shop> shop) {
+    const bool set = static_cast<bool>(shop);
+    entry(x, y).shop = shop;
+    update_flag(x, y, Hex::Shop, set);
+  }
+
+private:
+  static const def::NullableRef<Unit> &null_unit() {
+    static const def::NullableRef<Unit> null;
+    return null;
+  }
+
+  static const def::NullableRef<Shop> &null_shop() {
+    static const def::NullableRef<Shop> null;
+    return null;
+  }
+
+  /**
+   * Returns the occupant table entry of the given hex, allocating one if
+   * the hex is empty.
+   */
+  Occupants &entry(uint32_t x, uint32_t y) {
+    Hex &hex = grid(x, y);
+    if (hex.empty()) {
+      uint32_t index;
+      if (!free_occupants.empty()) {
+        index = free_occupants.back();
+        free_occupants.pop_back();
+      } else {
+        index = occupants.size();
+        occupants.emplace_back();
+      }
+
+      hex.value = index << Hex::FlagBits;
+    }
+
+    return occupants[hex.index()];
+  }
+
+  /**
+   * Set or clear a flag of the given hex, releasing its occupant table entry
+   * if no flags are left. The hex must have an entry.
+   */
+  void update_flag(uint32_t x, uint32_t y, uint32_t flag, bool set) {
+    Hex &hex = grid(x, y);
+    if (set) {
+      hex.value |= flag;
+    } else {
+      hex.value &= ~flag;
+    }
+
+    if ((hex.value & Hex::FlagMask) == 0) {
+      free_occupants.push_back(hex.index());
+      hex.value = 0;
+    }
+  }
 };
 
 } // namespace freeisle::state
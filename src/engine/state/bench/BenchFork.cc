@@ -0,0 +1,59 @@
+#include "state/Fork.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <random>
+#include <string>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  Fixture(uint32_t size, uint32_t num_units) : Scenario(size, size) {
+    freeisle::def::UnitDef &tank = add_unit_def(
+        "tank", freeisle::def::UnitDef{.name = "tank",
+                                       .level = freeisle::def::Level::Land});
+    tank.weapons.try_emplace("cannon", freeisle::def::WeaponDef{.ammo = 4});
+
+    for (uint32_t i = 0; i < 4; ++i) {
+      add_player("player" + std::to_string(i));
+    }
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> coord(0, size - 1);
+    for (uint32_t i = 0; i < num_units; ++i) {
+      uint32_t x, y;
+      do {
+        x = coord(rng);
+        y = coord(rng);
+      } while (state.map.surface_unit(x, y));
+
+      add_unit("unit" + std::to_string(i), "tank",
+               "player" + std::to_string(i % 4), x, y);
+    }
+  }
+};
+
+/**
+ * Forking a state with four players.
+ */
+void BM_Fork(benchmark::State &state) {
+  Fixture fixture(state.range(0), state.range(1));
+
+  for (auto _ : state) {
+    freeisle::state::State fork = freeisle::state::fork(fixture.state);
+    benchmark::DoNotOptimize(fork.units.size());
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_Fork)
+    ->Args({64, 200})
+    ->Args({256, 2000})
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
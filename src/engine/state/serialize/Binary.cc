@@ -0,0 +1,1249 @@
+#include "state/serialize/Binary.hh"
+
+#include "fow/View.hh"
+
+#include "fs/File.hh"
+#include "fs/MappedFile.hh"
+
+#include <fmt/format.h>
+
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <unordered_map>
+
+namespace freeisle::state::serialize {
+
+namespace {
+
+constexpr char Magic[8] = {'F', 'I', 'S', 'T', 'A', 'T', 'E', '\0'};
+constexpr uint32_t Version = 1;
+
+/**
+ * Written in the byte order of the host, to detect containers that were
+ * written on a host with a different byte order.
+ */
+constexpr uint32_t ByteOrderMark = 0x01020304;
+
+/**
+ * Alignment of the container data and of each section within it. This is
+ * the largest alignment required by any record.
+ */
+constexpr uint64_t SectionAlignment = 8;
+
+/**
+ * Index stored for references that do not refer to any object.
+ */
+constexpr uint32_t NoIndex = 0xffffffff;
+
+constexpr uint32_t NumTerrainTypes =
+    static_cast<uint32_t>(def::BaseTerrainType::Num) +
+    static_cast<uint32_t>(def::OverlayTerrainType::Num);
+constexpr uint32_t NumDamageTypes =
+    static_cast<uint32_t>(def::DamageType::Num);
+
+/**
+ * Sections of the container, in the order in which they are stored.
+ */
+enum class SectionId : uint32_t {
+  Strings,
+  Scenario,
+  Decorations,
+  Hexes,
+  UnitDefs,
+  Weapons,
+  ShopDefs,
+  Production,
+  Teams,
+  Players,
+  Fow,
+  Shops,
+  Units,
+  Ammo,
+  Includes,
+  OverrideKeys,
+  State,
+
+  Num,
+};
+
+constexpr uint32_t NumSections = static_cast<uint32_t>(SectionId::Num);
+
+struct FileHeader {
+  char magic[8];
+  uint32_t version;
+  uint32_t byte_order;
+  uint32_t num_sections;
+  uint32_t reserved;
+};
+
+struct SectionEntry {
+  uint32_t id;
+  uint32_t reserved;
+  uint64_t offset;
+  uint64_t size;
+};
+
+/**
+ * A string in the string table.
+ */
+struct StringRef {
+  uint32_t offset;
+  uint32_t length;
+};
+
+struct ScenarioRecord {
+  StringRef name;
+  StringRef description;
+  uint32_t width;
+  uint32_t height;
+};
+
+struct DecorationRecord {
+  StringRef id;
+  StringRef name;
+};
+
+struct HexRecord {
+  uint8_t base_terrain;
+  /**
+   * OverlayTerrainType::Num if the hex has no overlay terrain.
+   */
+  uint8_t overlay_terrain;
+  uint16_t reserved;
+  uint32_t decoration;
+};
+
+struct ContainerRecord {
+  uint32_t max_units;
+  uint32_t max_weight;
+  uint32_t supported_levels;
+};
+
+struct UnitDefRecord {
+  StringRef id;
+  StringRef name;
+  StringRef description;
+  uint32_t level;
+  uint32_t caps;
+  uint32_t armor;
+  uint32_t movement;
+  uint32_t fuel;
+  uint32_t weight;
+  uint32_t movement_cost[NumTerrainTypes];
+  uint32_t protection[NumTerrainTypes];
+  uint32_t resistance[NumDamageTypes];
+  uint32_t supplies_fuel;
+  uint32_t supplies_repair;
+  uint32_t supplies_ammo[NumDamageTypes];
+  ContainerRecord container;
+  uint32_t value;
+  uint32_t view_range;
+  uint32_t jamming_range;
+  /**
+   * Range of this unit def's weapons in the weapons section.
+   */
+  uint32_t first_weapon;
+  uint32_t num_weapons;
+};
+
+struct WeaponRecord {
+  StringRef id;
+  StringRef name;
+  uint32_t damage_type;
+  uint32_t damage;
+  uint32_t min_range;
+  uint32_t max_range;
+  uint32_t ammo;
+};
+
+struct ShopDefRecord {
+  StringRef id;
+  StringRef name;
+  uint32_t type;
+  uint32_t income;
+  ContainerRecord container;
+  uint32_t x;
+  uint32_t y;
+  /**
+   * Range of this shop def's unit def indices in the production section.
+   */
+  uint32_t first_production;
+  uint32_t num_production;
+};
+
+struct TeamRecord {
+  StringRef id;
+  StringRef name;
+};
+
+struct PlayerRecord {
+  StringRef id;
+  StringRef name;
+  uint8_t red;
+  uint8_t green;
+  uint8_t blue;
+  uint8_t reserved;
+  uint32_t team;
+  uint32_t wealth;
+  uint32_t captain;
+  uint32_t lose_conditions;
+  uint32_t is_eliminated;
+};
+
+struct ShopRecord {
+  StringRef id;
+  uint32_t def;
+  uint32_t owner;
+};
+
+struct UnitRecord {
+  static constexpr uint32_t HasActioned = 1u << 0;
+  static constexpr uint32_t HasSoared = 1u << 1;
+
+  StringRef id;
+  uint32_t def;
+  uint32_t owner;
+  uint32_t x;
+  uint32_t y;
+  uint32_t health;
+  uint32_t level;
+  uint32_t movement;
+  uint32_t fuel;
+  uint32_t experience;
+  uint32_t flags;
+  uint32_t supplies_fuel;
+  uint32_t supplies_repair;
+  uint32_t supplies_ammo[NumDamageTypes];
+  uint32_t contained_in_unit;
+  uint32_t contained_in_shop;
+  uint32_t hits_dealt;
+  uint32_t hits_taken;
+  uint32_t damage_dealt;
+  uint32_t damage_taken;
+  uint32_t hexes_moved;
+  /**
+   * Range of this unit's weapon ammo in the ammo section.
+   */
+  uint32_t first_ammo;
+  uint32_t num_ammo;
+};
+
+struct AmmoRecord {
+  /**
+   * Index of the weapon within the weapons of the unit's def.
+   */
+  uint32_t weapon;
+  uint32_t ammo;
+};
+
+struct IncludeRecord {
+  StringRef location;
+  StringRef filename;
+  /**
+   * Range of this include's override keys in the override keys section.
+   */
+  uint32_t first_override;
+  uint32_t num_overrides;
+};
+
+struct OverrideKeyRecord {
+  StringRef key;
+  uint32_t overridden;
+};
+
+struct StateRecord {
+  uint32_t turn_num;
+  uint32_t player_at_turn;
+};
+
+/**
+ * Fills the sections of a container and lays them out.
+ */
+class Builder {
+public:
+  StringRef string(const std::string &str) {
+    if (strings_.size() + str.size() > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error("String table exceeds 4 GiB");
+    }
+
+    const StringRef ref{
+        .offset = static_cast<uint32_t>(strings_.size()),
+        .length = static_cast<uint32_t>(str.size()),
+    };
+
+    strings_.insert(strings_.end(), str.begin(), str.end());
+    return ref;
+  }
+
+  template <typename T>
+  void add(SectionId id, const std::vector<T> &records) {
+    static_assert(std::is_trivially_copyable_v<T>);
+
+    const uint8_t *begin = reinterpret_cast<const uint8_t *>(records.data());
+    sections_[static_cast<uint32_t>(id)].assign(
+        begin, begin + records.size() * sizeof(T));
+  }
+
+  std::vector<uint8_t> finish() {
+    sections_[static_cast<uint32_t>(SectionId::Strings)] = std::move(strings_);
+
+    FileHeader header{
+        .version = Version,
+        .byte_order = ByteOrderMark,
+        .num_sections = NumSections,
+        .reserved = 0,
+    };
+    memcpy(header.magic, Magic, sizeof(Magic));
+
+    std::vector<uint8_t> result(sizeof(FileHeader) +
+                                NumSections * sizeof(SectionEntry));
+    memcpy(result.data(), &header, sizeof(header));
+
+    for (uint32_t i = 0; i < NumSections; ++i) {
+      const uint64_t offset = (result.size() + SectionAlignment - 1) /
+                              SectionAlignment * SectionAlignment;
+      const SectionEntry entry{
+          .id = i,
+          .reserved = 0,
+          .offset = offset,
+          .size = sections_[i].size(),
+      };
+
+      memcpy(result.data() + sizeof(FileHeader) + i * sizeof(SectionEntry),
+             &entry, sizeof(entry));
+
+      result.resize(offset);
+      result.insert(result.end(), sections_[i].begin(), sections_[i].end());
+    }
+
+    return result;
+  }
+
+private:
+  std::vector<uint8_t> strings_;
+  std::vector<uint8_t> sections_[NumSections];
+};
+
+/**
+ * The records of one section, used in place.
+ */
+template <typename T> struct Records {
+  const T *data;
+  uint32_t size;
+
+  const T *begin() const { return data; }
+  const T *end() const { return data + size; }
+
+  const T &operator[](uint32_t index) const {
+    assert(index < size);
+    return data[index];
+  }
+};
+
+/**
+ * Provides access to the sections of an existing container. All accesses
+ * are checked to stay within the container.
+ */
+class Container {
+public:
+  Container(const uint8_t *data, size_t len) : data_(data), len_(len) {
+    if (reinterpret_cast<uintptr_t>(data) % SectionAlignment != 0) {
+      throw std::invalid_argument("Binary state data is not aligned");
+    }
+
+    if (len < sizeof(FileHeader)) {
+      throw std::runtime_error("Binary state is truncated");
+    }
+
+    const FileHeader &header = *reinterpret_cast<const FileHeader *>(data);
+    if (memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+      throw std::runtime_error("Not a binary state");
+    }
+
+    if (header.byte_order != ByteOrderMark) {
+      throw std::runtime_error(
+          "Binary state was written with a different byte order");
+    }
+
+    if (header.version != Version) {
+      throw std::runtime_error(fmt::format(
+          "Binary state has version {}, but expected version {}",
+          header.version, Version));
+    }
+
+    if (header.num_sections != NumSections ||
+        len < sizeof(FileHeader) + NumSections * sizeof(SectionEntry)) {
+      throw std::runtime_error("Binary state is truncated");
+    }
+
+    sections_ = reinterpret_cast<const SectionEntry *>(data + sizeof(header));
+    for (uint32_t i = 0; i < NumSections; ++i) {
+      const SectionEntry &entry = sections_[i];
+      if (entry.id != i || entry.offset % SectionAlignment != 0 ||
+          entry.offset > len || entry.size > len - entry.offset) {
+        throw std::runtime_error(
+            fmt::format("Binary state has invalid section {}", i));
+      }
+    }
+
+    const SectionEntry &strings =
+        sections_[static_cast<uint32_t>(SectionId::Strings)];
+    strings_ = reinterpret_cast<const char *>(data + strings.offset);
+    strings_len_ = strings.size;
+  }
+
+  template <typename T> Records<T> section(SectionId id) const {
+    static_assert(std::is_trivially_copyable_v<T>);
+    static_assert(alignof(T) <= SectionAlignment);
+
+    const SectionEntry &entry = sections_[static_cast<uint32_t>(id)];
+    if (entry.size % sizeof(T) != 0 ||
+        entry.size / sizeof(T) > std::numeric_limits<uint32_t>::max()) {
+      throw std::runtime_error(fmt::format(
+          "Binary state section {} has invalid size {}", entry.id, entry.size));
+    }
+
+    return Records<T>{
+        .data = reinterpret_cast<const T *>(data_ + entry.offset),
+        .size = static_cast<uint32_t>(entry.size / sizeof(T)),
+    };
+  }
+
+  /**
+   * Returns the only record of a section that holds exactly one record.
+   */
+  template <typename T> const T &single(SectionId id) const {
+    const Records<T> records = section<T>(id);
+    if (records.size != 1) {
+      throw std::runtime_error(fmt::format(
+          "Binary state section {} has {} records, but expected one",
+          static_cast<uint32_t>(id), records.size));
+    }
+
+    return records[0];
+  }
+
+  std::string string(StringRef ref) const {
+    if (uint64_t{ref.offset} + ref.length > strings_len_) {
+      throw std::runtime_error("Binary state has invalid string reference");
+    }
+
+    return std::string(strings_ + ref.offset, ref.length);
+  }
+
+private:
+  const uint8_t *data_;
+  size_t len_;
+  const SectionEntry *sections_;
+  const char *strings_;
+  uint64_t strings_len_;
+};
+
+template <typename T>
+using Indices = std::unordered_map<const T *, uint32_t>;
+
+/**
+ * Returns the index of every object in the collection, in iteration order.
+ */
+template <typename T>
+Indices<T> make_indices(const def::Collection<T> &collection) {
+  Indices<T> indices;
+  uint32_t index = 0;
+  for (const std::pair<const std::string, T> &entry : collection) {
+    indices.emplace(&entry.second, index++);
+  }
+
+  return indices;
+}
+
+template <typename T>
+uint32_t index_of(const Indices<T> &indices, const T *object) {
+  if (object == nullptr) {
+    return NoIndex;
+  }
+
+  const typename Indices<T>::const_iterator iter = indices.find(object);
+  assert(iter != indices.end());
+  return iter->second;
+}
+
+template <typename T>
+uint32_t index_of(const Indices<T> &indices, const def::NullableRef<T> &ref) {
+  return index_of(indices, ref ? &*ref : nullptr);
+}
+
+template <typename T, uint32_t N>
+uint32_t encode_bitmask(core::Bitmask<T> mask,
+                        const core::EnumEntry<T> (&entries)[N]) {
+  uint32_t bits = 0;
+  for (const core::EnumEntry<T> &entry : entries) {
+    if (mask.is_set(entry.value)) {
+      bits |= 1u << static_cast<uint32_t>(entry.value);
+    }
+  }
+
+  return bits;
+}
+
+template <typename T, uint32_t N>
+core::Bitmask<T> decode_bitmask(uint32_t bits,
+                                const core::EnumEntry<T> (&entries)[N],
+                                const char *what) {
+  core::Bitmask<T> mask;
+  for (const core::EnumEntry<T> &entry : entries) {
+    const uint32_t bit = 1u << static_cast<uint32_t>(entry.value);
+    if (bits & bit) {
+      mask |= core::Bitmask<T>(entry.value);
+      bits &= ~bit;
+    }
+  }
+
+  if (bits != 0) {
+    throw std::runtime_error(
+        fmt::format("Binary state has invalid {} bits {:#x}", what, bits));
+  }
+
+  return mask;
+}
+
+template <typename T, uint32_t N>
+T decode_enum(uint32_t value, const core::EnumEntry<T> (&entries)[N],
+              const char *what) {
+  for (const core::EnumEntry<T> &entry : entries) {
+    if (static_cast<uint32_t>(entry.value) == value) {
+      return entry.value;
+    }
+  }
+
+  throw std::runtime_error(
+      fmt::format("Binary state has invalid {} value {}", what, value));
+}
+
+/**
+ * Checks that a reference read from the container is in bounds, and
+ * returns it.
+ */
+uint32_t check_index(uint32_t index, size_t size, const char *what) {
+  if (index >= size) {
+    throw std::runtime_error(
+        fmt::format("Binary state has invalid {} reference {}", what, index));
+  }
+
+  return index;
+}
+
+/**
+ * Checks that a range of records read from the container is in bounds.
+ */
+void check_range(uint32_t first, uint32_t num, uint32_t size,
+                 const char *what) {
+  if (first > size || num > size - first) {
+    throw std::runtime_error(
+        fmt::format("Binary state has invalid {} range", what));
+  }
+}
+
+template <typename T>
+typename def::Collection<T>::iterator
+insert(const Container &container, def::Collection<T> &collection,
+       StringRef id) {
+  std::pair<typename def::Collection<T>::iterator, bool> result =
+      collection.try_emplace(container.string(id));
+  if (!result.second) {
+    throw std::runtime_error(fmt::format(
+        "Binary state has duplicate object ID \"{}\"", result.first->first));
+  }
+
+  return result.first;
+}
+
+ContainerRecord encode_container(const def::ContainerDef &def) {
+  return ContainerRecord{
+      .max_units = def.max_units,
+      .max_weight = def.max_weight,
+      .supported_levels = encode_bitmask(def.supported_levels, def::Levels),
+  };
+}
+
+def::ContainerDef decode_container(const ContainerRecord &record) {
+  return def::ContainerDef{
+      .max_units = record.max_units,
+      .max_weight = record.max_weight,
+      .supported_levels = decode_bitmask(record.supported_levels, def::Levels,
+                                         "supported levels"),
+  };
+}
+
+/**
+ * Size of the FoW bitmap of each player, in bytes. The bitmaps use the same
+ * layout as in the JSON format.
+ */
+uint64_t fow_size(uint32_t width, uint32_t height) {
+  return (uint64_t{width} * height + 7) / 8;
+}
+
+/**
+ * Checks that every unit is contained in at most one container, and that no
+ * unit is contained in itself, directly or through other units.
+ */
+void check_containment(
+    const Records<UnitRecord> &records,
+    const std::vector<def::Collection<Unit>::iterator> &units) {
+  // 0: not visited, 1: on the current chain, 2: known to end outside a unit
+  std::vector<uint8_t> state(records.size, 0);
+  for (uint32_t i = 0; i < records.size; ++i) {
+    if (records[i].contained_in_unit != NoIndex) {
+      check_index(records[i].contained_in_unit, records.size, "unit");
+    }
+  }
+
+  for (uint32_t i = 0; i < records.size; ++i) {
+    if (records[i].contained_in_unit != NoIndex &&
+        records[i].contained_in_shop != NoIndex) {
+      throw std::runtime_error(fmt::format(
+          "Binary state has unit \"{}\" contained in both unit and shop",
+          units[i]->first));
+    }
+
+    uint32_t index = i;
+    while (index != NoIndex && state[index] == 0) {
+      state[index] = 1;
+      index = records[index].contained_in_unit;
+    }
+
+    if (index != NoIndex && state[index] == 1) {
+      throw std::runtime_error(
+          fmt::format("Binary state has unit \"{}\" contained in itself",
+                      units[index]->first));
+    }
+
+    for (index = i; index != NoIndex && state[index] == 1;
+         index = records[index].contained_in_unit) {
+      state[index] = 2;
+    }
+  }
+}
+
+} // namespace
+
+std::vector<uint8_t> encode_binary(const SerializableState &state) {
+  const def::Scenario &scenario = *state.scenario;
+  const State &game = state.state;
+  const uint32_t width = scenario.map.grid.width();
+  const uint32_t height = scenario.map.grid.height();
+
+  const Indices<def::DecorationDef> decoration_indices =
+      make_indices(scenario.map.decoration_defs);
+  const Indices<def::UnitDef> unit_def_indices = make_indices(scenario.units);
+  const Indices<def::ShopDef> shop_def_indices = make_indices(scenario.shops);
+  const Indices<Team> team_indices = make_indices(game.teams);
+  const Indices<Player> player_indices = make_indices(game.players);
+  const Indices<Shop> shop_indices = make_indices(game.shops);
+  const Indices<Unit> unit_indices = make_indices(game.units);
+
+  Builder builder;
+
+  builder.add(SectionId::Scenario,
+              std::vector<ScenarioRecord>{{
+                  .name = builder.string(scenario.name),
+                  .description = builder.string(scenario.description),
+                  .width = width,
+                  .height = height,
+              }});
+
+  std::vector<DecorationRecord> decorations;
+  for (const std::pair<const std::string, def::DecorationDef> &entry :
+       scenario.map.decoration_defs) {
+    decorations.push_back(DecorationRecord{
+        .id = builder.string(entry.first),
+        .name = builder.string(entry.second.name),
+    });
+  }
+
+  std::vector<HexRecord> hexes;
+  hexes.reserve(uint64_t{width} * height);
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      const def::MapDef::Hex &hex = scenario.map.grid(x, y);
+      hexes.push_back(HexRecord{
+          .base_terrain = static_cast<uint8_t>(hex.base_terrain),
+          .overlay_terrain = static_cast<uint8_t>(
+              hex.overlay_terrain ? *hex.overlay_terrain
+                                  : def::OverlayTerrainType::Num),
+          .reserved = 0,
+          .decoration = index_of(decoration_indices, hex.decoration),
+      });
+    }
+  }
+
+  // Index of every weapon within the weapons of its unit def:
+  Indices<def::WeaponDef> weapon_indices;
+  std::vector<UnitDefRecord> unit_defs;
+  std::vector<WeaponRecord> weapons;
+  for (const std::pair<const std::string, def::UnitDef> &entry :
+       scenario.units) {
+    const def::UnitDef &def = entry.second;
+
+    UnitDefRecord record{};
+    record.id = builder.string(entry.first);
+    record.name = builder.string(def.name);
+    record.description = builder.string(def.description);
+    record.level = static_cast<uint32_t>(def.level);
+    record.caps = encode_bitmask(def.caps, def::UnitDefCaps);
+    record.armor = def.armor;
+    record.movement = def.movement;
+    record.fuel = def.fuel;
+    record.weight = def.weight;
+    memcpy(record.movement_cost, def.movement_cost.data(),
+           sizeof(record.movement_cost));
+    memcpy(record.protection, def.protection.data(),
+           sizeof(record.protection));
+    memcpy(record.resistance, def.resistance.data(),
+           sizeof(record.resistance));
+    record.supplies_fuel = def.supplies.fuel;
+    record.supplies_repair = def.supplies.repair;
+    memcpy(record.supplies_ammo, def.supplies.ammo.data(),
+           sizeof(record.supplies_ammo));
+    record.container = encode_container(def.container);
+    record.value = def.value;
+    record.view_range = def.view_range;
+    record.jamming_range = def.jamming_range;
+    record.first_weapon = weapons.size();
+    record.num_weapons = def.weapons.size();
+    unit_defs.push_back(record);
+
+    for (const std::pair<const std::string, def::WeaponDef> &weapon :
+         def.weapons) {
+      weapon_indices.emplace(&weapon.second,
+                             weapons.size() - record.first_weapon);
+      weapons.push_back(WeaponRecord{
+          .id = builder.string(weapon.first),
+          .name = builder.string(weapon.second.name),
+          .damage_type = static_cast<uint32_t>(weapon.second.damage_type),
+          .damage = weapon.second.damage,
+          .min_range = weapon.second.min_range,
+          .max_range = weapon.second.max_range,
+          .ammo = weapon.second.ammo,
+      });
+    }
+  }
+
+  std::vector<ShopDefRecord> shop_defs;
+  std::vector<uint32_t> production;
+  for (const std::pair<const std::string, def::ShopDef> &entry :
+       scenario.shops) {
+    const def::ShopDef &def = entry.second;
+    shop_defs.push_back(ShopDefRecord{
+        .id = builder.string(entry.first),
+        .name = builder.string(def.name),
+        .type = static_cast<uint32_t>(def.type),
+        .income = def.income,
+        .container = encode_container(def.container),
+        .x = def.location.x,
+        .y = def.location.y,
+        .first_production = static_cast<uint32_t>(production.size()),
+        .num_production = static_cast<uint32_t>(def.production_list.size()),
+    });
+
+    for (const def::Ref<def::UnitDef> &unit_def : def.production_list) {
+      production.push_back(index_of(unit_def_indices, &*unit_def));
+    }
+  }
+
+  std::vector<TeamRecord> teams;
+  for (const std::pair<const std::string, Team> &entry : game.teams) {
+    teams.push_back(TeamRecord{
+        .id = builder.string(entry.first),
+        .name = builder.string(entry.second.name),
+    });
+  }
+
+  std::vector<PlayerRecord> players;
+  std::vector<uint8_t> fow(game.players.size() * fow_size(width, height));
+  for (const std::pair<const std::string, Player> &entry : game.players) {
+    const Player &player = entry.second;
+    assert(player.fow.width() == width && player.fow.height() == height);
+
+    uint8_t *bits = fow.data() + players.size() * fow_size(width, height);
+    for (uint32_t y = 0; y < height; ++y) {
+      for (uint32_t x = 0; x < width; ++x) {
+        const uint64_t index = uint64_t{y} * width + x;
+        if (player.fow(x, y).discovered) {
+          bits[index / 8] |= (1 << (index % 8));
+        }
+      }
+    }
+
+    players.push_back(PlayerRecord{
+        .id = builder.string(entry.first),
+        .name = builder.string(player.name),
+        .red = player.color.r,
+        .green = player.color.g,
+        .blue = player.color.b,
+        .reserved = 0,
+        .team = index_of(team_indices, player.team),
+        .wealth = player.wealth,
+        .captain = index_of(unit_indices, player.captain),
+        .lose_conditions =
+            encode_bitmask(player.lose_conditions, def::Goals),
+        .is_eliminated = player.is_eliminated,
+    });
+  }
+
+  std::vector<ShopRecord> shops;
+  for (const std::pair<const std::string, Shop> &entry : game.shops) {
+    shops.push_back(ShopRecord{
+        .id = builder.string(entry.first),
+        .def = index_of(shop_def_indices, entry.second.def),
+        .owner = index_of(player_indices, entry.second.owner),
+    });
+  }
+
+  std::vector<UnitRecord> units;
+  std::vector<AmmoRecord> ammo;
+  for (const std::pair<const std::string, Unit> &entry : game.units) {
+    const Unit &unit = entry.second;
+
+    UnitRecord record{};
+    record.id = builder.string(entry.first);
+    record.def = index_of(unit_def_indices, unit.def);
+    record.owner = index_of(player_indices, unit.owner);
+    record.x = unit.location.x;
+    record.y = unit.location.y;
+    record.health = unit.health;
+    record.level = static_cast<uint32_t>(unit.level);
+    record.movement = unit.movement;
+    record.fuel = unit.fuel;
+    record.experience = unit.experience;
+    record.flags = (unit.has_actioned ? UnitRecord::HasActioned : 0) |
+                   (unit.has_soared ? UnitRecord::HasSoared : 0);
+    record.supplies_fuel = unit.supplies.fuel;
+    record.supplies_repair = unit.supplies.repair;
+    memcpy(record.supplies_ammo, unit.supplies.ammo.data(),
+           sizeof(record.supplies_ammo));
+    record.contained_in_unit = index_of(unit_indices, unit.contained_in_unit);
+    record.contained_in_shop = index_of(shop_indices, unit.contained_in_shop);
+    record.hits_dealt = unit.stats.hits_dealt;
+    record.hits_taken = unit.stats.hits_taken;
+    record.damage_dealt = unit.stats.damage_dealt;
+    record.damage_taken = unit.stats.damage_taken;
+    record.hexes_moved = unit.stats.hexes_moved;
+    record.first_ammo = ammo.size();
+    record.num_ammo = unit.ammo.size();
+    units.push_back(record);
+
+    for (const std::pair<const def::Ref<def::WeaponDef>, uint32_t> &weapon :
+         unit.ammo) {
+      ammo.push_back(AmmoRecord{
+          .weapon = index_of(weapon_indices, &*weapon.first),
+          .ammo = weapon.second,
+      });
+    }
+  }
+
+  std::vector<IncludeRecord> includes;
+  std::vector<OverrideKeyRecord> override_keys;
+  for (const std::pair<const std::string, json::IncludeInfo> &entry :
+       state.include_map) {
+    includes.push_back(IncludeRecord{
+        .location = builder.string(entry.first),
+        .filename = builder.string(entry.second.filename),
+        .first_override = static_cast<uint32_t>(override_keys.size()),
+        .num_overrides =
+            static_cast<uint32_t>(entry.second.override_keys.size()),
+    });
+
+    for (const std::pair<const std::string, bool> &key :
+         entry.second.override_keys) {
+      override_keys.push_back(OverrideKeyRecord{
+          .key = builder.string(key.first),
+          .overridden = key.second,
+      });
+    }
+  }
+
+  builder.add(SectionId::Decorations, decorations);
+  builder.add(SectionId::Hexes, hexes);
+  builder.add(SectionId::UnitDefs, unit_defs);
+  builder.add(SectionId::Weapons, weapons);
+  builder.add(SectionId::ShopDefs, shop_defs);
+  builder.add(SectionId::Production, production);
+  builder.add(SectionId::Teams, teams);
+  builder.add(SectionId::Players, players);
+  builder.add(SectionId::Fow, fow);
+  builder.add(SectionId::Shops, shops);
+  builder.add(SectionId::Units, units);
+  builder.add(SectionId::Ammo, ammo);
+  builder.add(SectionId::Includes, includes);
+  builder.add(SectionId::OverrideKeys, override_keys);
+  builder.add(SectionId::State,
+              std::vector<StateRecord>{{
+                  .turn_num = game.turn_num,
+                  .player_at_turn =
+                      index_of(player_indices, game.player_at_turn),
+              }});
+
+  return builder.finish();
+}
+
+SerializableState decode_binary(const uint8_t *data, size_t len) {
+  const Container container(data, len);
+
+  SerializableState result;
+  result.scenario = std::make_unique<def::Scenario>();
+  def::Scenario &scenario = *result.scenario;
+  State &game = result.state;
+
+  const ScenarioRecord &scenario_record =
+      container.single<ScenarioRecord>(SectionId::Scenario);
+  const uint32_t width = scenario_record.width;
+  const uint32_t height = scenario_record.height;
+  scenario.name = container.string(scenario_record.name);
+  scenario.description = container.string(scenario_record.description);
+
+  std::vector<def::Collection<def::DecorationDef>::iterator> decorations;
+  for (const DecorationRecord &record :
+       container.section<DecorationRecord>(SectionId::Decorations)) {
+    decorations.push_back(
+        insert(container, scenario.map.decoration_defs, record.id));
+    decorations.back()->second.name = container.string(record.name);
+  }
+
+  const Records<HexRecord> hexes =
+      container.section<HexRecord>(SectionId::Hexes);
+  if (hexes.size != uint64_t{width} * height) {
+    throw std::runtime_error(fmt::format(
+        "Binary state has {} hexes, but expected {}x{}", hexes.size, width,
+        height));
+  }
+
+  scenario.map.grid = core::Grid<def::MapDef::Hex>(width, height);
+  for (uint32_t y = 0; y < height; ++y) {
+    for (uint32_t x = 0; x < width; ++x) {
+      const HexRecord &record = hexes[y * width + x];
+      def::MapDef::Hex &hex = scenario.map.grid(x, y);
+
+      hex.base_terrain = decode_enum(record.base_terrain,
+                                     def::BaseTerrainTypes, "base terrain");
+      if (record.overlay_terrain !=
+          static_cast<uint8_t>(def::OverlayTerrainType::Num)) {
+        hex.overlay_terrain =
+            decode_enum(record.overlay_terrain, def::OverlayTerrainTypes,
+                        "overlay terrain");
+      }
+
+      if (record.decoration != NoIndex) {
+        hex.decoration =
+            &decorations[check_index(record.decoration, decorations.size(),
+                                     "decoration")]
+                 ->second;
+      }
+    }
+  }
+
+  const Records<WeaponRecord> weapon_records =
+      container.section<WeaponRecord>(SectionId::Weapons);
+  std::vector<def::Collection<def::UnitDef>::iterator> unit_defs;
+  std::vector<std::vector<def::Collection<def::WeaponDef>::iterator>> weapons;
+  for (const UnitDefRecord &record :
+       container.section<UnitDefRecord>(SectionId::UnitDefs)) {
+    unit_defs.push_back(insert(container, scenario.units, record.id));
+    def::UnitDef &def = unit_defs.back()->second;
+
+    def.name = container.string(record.name);
+    def.description = container.string(record.description);
+    def.level = decode_enum(record.level, def::Levels, "level");
+    def.caps = decode_bitmask(record.caps, def::UnitDefCaps, "caps");
+    def.armor = record.armor;
+    def.movement = record.movement;
+    def.fuel = record.fuel;
+    def.weight = record.weight;
+    memcpy(def.movement_cost.data(), record.movement_cost,
+           sizeof(record.movement_cost));
+    memcpy(def.protection.data(), record.protection,
+           sizeof(record.protection));
+    memcpy(def.resistance.data(), record.resistance,
+           sizeof(record.resistance));
+    def.supplies.fuel = record.supplies_fuel;
+    def.supplies.repair = record.supplies_repair;
+    memcpy(def.supplies.ammo.data(), record.supplies_ammo,
+           sizeof(record.supplies_ammo));
+    def.container = decode_container(record.container);
+    def.value = record.value;
+    def.view_range = record.view_range;
+    def.jamming_range = record.jamming_range;
+
+    check_range(record.first_weapon, record.num_weapons, weapon_records.size,
+                "weapon");
+    weapons.emplace_back();
+    for (uint32_t i = 0; i < record.num_weapons; ++i) {
+      const WeaponRecord &weapon_record =
+          weapon_records[record.first_weapon + i];
+      weapons.back().push_back(insert(container, def.weapons,
+                                      weapon_record.id));
+      def::WeaponDef &weapon = weapons.back().back()->second;
+
+      weapon.name = container.string(weapon_record.name);
+      weapon.damage_type = decode_enum(weapon_record.damage_type,
+                                       def::DamageTypes, "damage type");
+      weapon.damage = weapon_record.damage;
+      weapon.min_range = weapon_record.min_range;
+      weapon.max_range = weapon_record.max_range;
+      weapon.ammo = weapon_record.ammo;
+    }
+  }
+
+  const Records<uint32_t> production =
+      container.section<uint32_t>(SectionId::Production);
+  std::vector<def::Collection<def::ShopDef>::iterator> shop_defs;
+  for (const ShopDefRecord &record :
+       container.section<ShopDefRecord>(SectionId::ShopDefs)) {
+    shop_defs.push_back(insert(container, scenario.shops, record.id));
+    def::ShopDef &def = shop_defs.back()->second;
+
+    if (record.x >= width || record.y >= height) {
+      throw std::runtime_error(fmt::format(
+          "Binary state has shop \"{}\" outside of the map",
+          shop_defs.back()->first));
+    }
+
+    def.name = container.string(record.name);
+    def.type = decode_enum(record.type, def::ShopDefTypes, "shop type");
+    def.income = record.income;
+    def.container = decode_container(record.container);
+    def.location = def::Location{.x = record.x, .y = record.y};
+
+    check_range(record.first_production, record.num_production,
+                production.size, "production list");
+    for (uint32_t i = 0; i < record.num_production; ++i) {
+      def.production_list.emplace(
+          unit_defs[check_index(production[record.first_production + i],
+                                unit_defs.size(), "unit def")]);
+    }
+  }
+
+  game.scenario = &scenario;
+  game.map.def = &scenario.map;
+  game.map.grid = core::Grid<Map::Hex>(width, height);
+
+  std::vector<def::Collection<Team>::iterator> teams;
+  for (const TeamRecord &record :
+       container.section<TeamRecord>(SectionId::Teams)) {
+    teams.push_back(insert(container, game.teams, record.id));
+    teams.back()->second.name = container.string(record.name);
+  }
+
+  const Records<PlayerRecord> player_records =
+      container.section<PlayerRecord>(SectionId::Players);
+  const Records<uint8_t> fow = container.section<uint8_t>(SectionId::Fow);
+  if (fow.size != player_records.size * fow_size(width, height)) {
+    throw std::runtime_error("Binary state has FoW of unexpected size");
+  }
+
+  std::vector<def::Collection<Player>::iterator> players;
+  for (const PlayerRecord &record : player_records) {
+    const uint8_t *bits = fow.data + players.size() * fow_size(width, height);
+    players.push_back(insert(container, game.players, record.id));
+    Player &player = players.back()->second;
+
+    player.name = container.string(record.name);
+    player.color.r = record.red;
+    player.color.g = record.green;
+    player.color.b = record.blue;
+    if (record.team != NoIndex) {
+      player.team = teams[check_index(record.team, teams.size(), "team")];
+    }
+
+    player.fow = core::Grid<Player::Fow>(width, height);
+    for (uint32_t y = 0; y < height; ++y) {
+      for (uint32_t x = 0; x < width; ++x) {
+        const uint64_t index = uint64_t{y} * width + x;
+        player.fow(x, y).discovered = bits[index / 8] & (1 << (index % 8));
+      }
+    }
+
+    player.wealth = record.wealth;
+    player.lose_conditions =
+        decode_bitmask(record.lose_conditions, def::Goals, "lose conditions");
+    player.is_eliminated = record.is_eliminated;
+  }
+
+  std::vector<def::Collection<Shop>::iterator> shops;
+  for (const ShopRecord &record :
+       container.section<ShopRecord>(SectionId::Shops)) {
+    shops.push_back(insert(container, game.shops, record.id));
+    Shop &shop = shops.back()->second;
+
+    shop.def = shop_defs[check_index(record.def, shop_defs.size(), "shop def")];
+    if (record.owner != NoIndex) {
+      shop.owner =
+          players[check_index(record.owner, players.size(), "player")];
+    }
+
+    shop.container.def = &shop.def->container;
+
+    const def::Location &location = shop.def->location;
+    if (!game.map.grid(location.x, location.y).empty()) {
+      throw std::runtime_error(
+          fmt::format("Binary state has location x={}, y={} occupied twice",
+                      location.x, location.y));
+    }
+
+    game.map.set_shop(location.x, location.y, shops.back());
+  }
+
+  // Units refer to each other, so all of them need to exist before any is
+  // filled in.
+  const Records<UnitRecord> unit_records =
+      container.section<UnitRecord>(SectionId::Units);
+  std::vector<def::Collection<Unit>::iterator> units;
+  for (const UnitRecord &record : unit_records) {
+    units.push_back(insert(container, game.units, record.id));
+  }
+
+  check_containment(unit_records, units);
+
+  const Records<AmmoRecord> ammo =
+      container.section<AmmoRecord>(SectionId::Ammo);
+  for (uint32_t i = 0; i < unit_records.size; ++i) {
+    const UnitRecord &record = unit_records[i];
+    Unit &unit = units[i]->second;
+
+    const uint32_t def_index =
+        check_index(record.def, unit_defs.size(), "unit def");
+    unit.def = unit_defs[def_index];
+    if (record.owner != NoIndex) {
+      unit.owner =
+          players[check_index(record.owner, players.size(), "player")];
+    }
+
+    if (record.x >= width || record.y >= height) {
+      throw std::runtime_error(fmt::format(
+          "Binary state has unit \"{}\" outside of the map", units[i]->first));
+    }
+
+    unit.location = def::Location{.x = record.x, .y = record.y};
+    unit.health = record.health;
+    unit.level = decode_enum(record.level, def::Levels, "level");
+    unit.movement = record.movement;
+    unit.fuel = record.fuel;
+    unit.experience = record.experience;
+    unit.has_actioned = record.flags & UnitRecord::HasActioned;
+    unit.has_soared = record.flags & UnitRecord::HasSoared;
+    unit.supplies.fuel = record.supplies_fuel;
+    unit.supplies.repair = record.supplies_repair;
+    memcpy(unit.supplies.ammo.data(), record.supplies_ammo,
+           sizeof(record.supplies_ammo));
+
+    check_range(record.first_ammo, record.num_ammo, ammo.size, "ammo");
+    for (uint32_t j = 0; j < record.num_ammo; ++j) {
+      const AmmoRecord &ammo_record = ammo[record.first_ammo + j];
+      unit.ammo.emplace(
+          weapons[def_index][check_index(ammo_record.weapon,
+                                         weapons[def_index].size(), "weapon")],
+          ammo_record.ammo);
+    }
+
+    unit.container.def = &unit.def->container;
+    if (record.contained_in_unit != NoIndex) {
+      unit.contained_in_unit = units[check_index(record.contained_in_unit,
+                                                 units.size(), "unit")];
+    }
+
+    if (record.contained_in_shop != NoIndex) {
+      unit.contained_in_shop = shops[check_index(record.contained_in_shop,
+                                                 shops.size(), "shop")];
+    }
+
+    unit.stats = Unit::Stats{
+        .hits_dealt = record.hits_dealt,
+        .hits_taken = record.hits_taken,
+        .damage_dealt = record.damage_dealt,
+        .damage_taken = record.damage_taken,
+        .hexes_moved = record.hexes_moved,
+    };
+
+    if (unit.contained_in_shop) {
+      unit.contained_in_shop->container.units.push_back(units[i]);
+    } else if (unit.contained_in_unit) {
+      unit.contained_in_unit->container.units.push_back(units[i]);
+    } else {
+      const def::Location &location = unit.location;
+      const bool subsurface = unit.level == def::Level::UnderWater;
+      if (game.map.shop(location.x, location.y) ||
+          (subsurface ? game.map.subsurface_unit(location.x, location.y)
+                      : game.map.surface_unit(location.x, location.y))) {
+        throw std::runtime_error(
+            fmt::format("Binary state has location x={}, y={} occupied twice",
+                        location.x, location.y));
+      }
+
+      game.map.set_unit(location.x, location.y, subsurface, units[i]);
+    }
+
+    if (unit.owner) {
+      unit.owner->units.insert(units[i]);
+    }
+  }
+
+  for (uint32_t i = 0; i < player_records.size; ++i) {
+    if (player_records[i].captain != NoIndex) {
+      players[i]->second.captain = units[check_index(
+          player_records[i].captain, units.size(), "unit")];
+    }
+  }
+
+  // View factors depend on the alliances of all players, so can only be
+  // computed once all players are loaded.
+  fow::rebuild(game);
+
+  const StateRecord &state_record =
+      container.single<StateRecord>(SectionId::State);
+  game.turn_num = state_record.turn_num;
+  game.player_at_turn = players[check_index(state_record.player_at_turn,
+                                            players.size(), "player")];
+
+  const Records<OverrideKeyRecord> override_keys =
+      container.section<OverrideKeyRecord>(SectionId::OverrideKeys);
+  for (const IncludeRecord &record :
+       container.section<IncludeRecord>(SectionId::Includes)) {
+    json::IncludeInfo &info =
+        result.include_map[container.string(record.location)];
+    info.filename = container.string(record.filename);
+
+    check_range(record.first_override, record.num_overrides,
+                override_keys.size, "override key");
+    for (uint32_t i = 0; i < record.num_overrides; ++i) {
+      const OverrideKeyRecord &key = override_keys[record.first_override + i];
+      info.override_keys.emplace(container.string(key.key), key.overridden);
+    }
+  }
+
+  return result;
+}
+
+void save_binary(const SerializableState &state, const char *path) {
+  const std::vector<uint8_t> data = encode_binary(state);
+  fs::write_file(path, data.data(), data.size(), nullptr);
+}
+
+SerializableState load_binary(const char *path) {
+  // Decoded in place; all of the container is needed:
+  const fs::MappedFile mapping(path, nullptr, fs::MappedFile::Access::WillNeed);
+  return decode_binary(mapping.data(), mapping.size());
+}
+
+void convert_to_binary(const char *json_path, const char *binary_path,
+                       log::Logger logger) {
+  save_binary(load(json_path, std::move(logger)), binary_path);
+}
+
+void convert_to_json(const char *binary_path, const char *json_path,
+                     log::Logger logger) {
+  save(load_binary(binary_path), json_path, std::move(logger));
+}
+
+} // namespace freeisle::state::serialize
@@ -0,0 +1,68 @@
+#pragma once
+
+#include "state/serialize/Serialize.hh"
+
+#include "log/Logger.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace freeisle::state::serialize {
+
+/**
+ * Encode a game state in the binary container format.
+ *
+ * The container starts with a header carrying a magic number, the format
+ * version and the byte order of the host that wrote it, followed by a table
+ * of sections. Each section is an array of fixed-size records, aligned so
+ * that it can be used in place from a memory-mapped file. Strings are kept
+ * in a separate string table, references between objects are stored as
+ * indices into the referenced collection, and the map and FoW grids are
+ * stored as flat arrays.
+ *
+ * Only the information that is also saved in the JSON format is stored,
+ * including the include references, so that a state can be converted back
+ * and forth without loss. Everything that can be derived, such as map
+ * occupants, container contents or FoW view counts, is rebuilt on load.
+ */
+std::vector<uint8_t> encode_binary(const SerializableState &state);
+
+/**
+ * Decode a game state from a binary container produced by encode_binary().
+ *
+ * The container is checked to be structurally intact, i.e. all sections,
+ * strings and references are in bounds. The game rules are not checked
+ * again, as they are when loading from JSON, since the container is only
+ * ever written from a valid state. Throws std::runtime_error if the data is
+ * not a valid container, or if it was written with a different format
+ * version or byte order.
+ */
+SerializableState decode_binary(const uint8_t *data, size_t len);
+
+/**
+ * Save a game state into a file in the binary container format.
+ */
+void save_binary(const SerializableState &state, const char *path);
+
+/**
+ * Load a game state from a file in the binary container format.
+ */
+SerializableState load_binary(const char *path);
+
+/**
+ * Convert a game state saved in JSON format into the binary container
+ * format.
+ */
+void convert_to_binary(const char *json_path, const char *binary_path,
+                       log::Logger logger);
+
+/**
+ * Convert a game state saved in the binary container format back into JSON
+ * format. Definitions are referenced in the same way as in the JSON file the
+ * binary container was converted from.
+ */
+void convert_to_json(const char *binary_path, const char *json_path,
+                     log::Logger logger);
+
+} // namespace freeisle::state::serialize
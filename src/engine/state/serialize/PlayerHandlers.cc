@@ -60,7 +60,7 @@ void PlayerLoader::load(json::loader::Context &ctx, Json::Value &value) {
 
   const uint32_t expected_size =
       (map_.grid.width() * map_.grid.height() + 7) / 8;
-  const std::vector<uint8_t> fow = json::loader::load_binary(ctx, value, "fow");
+  const core::SharedBytes fow = json::loader::load_binary(ctx, value, "fow");
   if (fow.size() != expected_size) {
     const std::string message = fmt::format(
         "FoW field does not have expected length; got {} but expected {}",
@@ -100,8 +100,6 @@ void PlayerLoader::load(json::loader::Context &ctx, Json::Value &value) {
     if (iter->second.owner && &*iter->second.owner == player_) {
       player_->units.insert(iter);
     }
-
-    // TODO(armin): update FoW view
   }
 }
 
@@ -143,13 +143,25 @@ SerializableState load(const char *path, log::Logger logger) {
   return result;
 }
 
-void save(const SerializableState &state, const char *path,
-          log::Logger logger) {
-  log::Logger sub_logger = logger.make_child_logger("save");
+std::vector<json::loader::Error> validate(const char *path,
+                                          log::Logger logger) {
+  log::Logger sub_logger = logger.make_child_logger("validate_state");
   def::serialize::AuxData aux{.logger = sub_logger};
 
+  SerializableState result;
+  SerializableStateLoader loader(result, aux);
+  return json::loader::validate_root_object(path, loader);
+}
+
+void save(const SerializableState &state, const char *path, log::Logger logger,
+          json::saver::SaveCache *cache, png::Compression compression) {
+  log::Logger sub_logger = logger.make_child_logger("save");
+  def::serialize::AuxData aux{.logger = sub_logger,
+                              .map_compression = compression};
+
   SerializableStateSaver saver(state.state, aux);
-  json::saver::save_root_object(path, saver, &state.include_map);
+  json::saver::save_root_object(path, saver, &state.include_map,
+                                json::Style::Pretty, cache);
 }
 
 void save(const State &state, const char *path, log::Logger logger) {
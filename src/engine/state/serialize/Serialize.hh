@@ -6,6 +6,10 @@
 #include "state/State.hh"
 
 #include "json/IncludeInfo.hh"
+#include "json/Loader.hh"
+#include "json/SaveCache.hh"
+
+#include "png/Png.hh"
 
 #include <string>
 #include <vector>
@@ -92,11 +96,29 @@ SerializableState create_scenario(const CreateOptions &options,
  */
 SerializableState load(const char *path, log::Logger logger);
 
+/**
+ * Check the game state in the given file for errors. Unlike load(), this
+ * does not stop at the first error but returns all errors found, see
+ * json::loader::validate_root_object().
+ */
+std::vector<json::loader::Error> validate(const char *path,
+                                          log::Logger logger);
+
 /**
  * Store loaded game state. Definitions will be referenced where they
  * were loaded from.
+ *
+ * If a save cache is given, files that did not change since the last save
+ * with the same cache, such as the map image or FoW bitmaps, are not
+ * written again. This is meant for repeated saves to the same location,
+ * e.g. autosaves.
+ *
+ * The compression determines how much time is spent on making the map image
+ * small; autosaves would typically use png::Compression::Fast.
  */
-void save(const SerializableState &state, const char *path, log::Logger logger);
+void save(const SerializableState &state, const char *path, log::Logger logger,
+          json::saver::SaveCache *cache = nullptr,
+          png::Compression compression = png::Compression::Default);
 
 /**
  * Store loaded game state. Definitions will be packed into the output file
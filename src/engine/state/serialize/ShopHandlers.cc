@@ -25,15 +25,15 @@ void ShopLoader::load(json::loader::Context &ctx, Json::Value &value) {
   const def::Location &location = shop_->def->location;
   assert(location.x <= map_.grid.width() && location.y <= map_.grid.height());
 
-  if (map_.grid(location.x, location.y).shop ||
-      map_.grid(location.x, location.y).surface_unit ||
-      map_.grid(location.x, location.y).subsurface_unit) {
+  if (map_.shop(location.x, location.y) ||
+      map_.surface_unit(location.x, location.y) ||
+      map_.subsurface_unit(location.x, location.y)) {
     const std::string message = fmt::format(
         "Location x={}, y={} is already occupied", location.x, location.y);
     throw json::loader::Error::create(ctx, "def", value["def"], message);
   }
 
-  map_.grid(location.x, location.y).shop = shop_;
+  map_.set_shop(location.x, location.y, shop_);
 }
 
 ShopSaver::ShopSaver(const def::Collection<def::ShopDef> &shop_defs,
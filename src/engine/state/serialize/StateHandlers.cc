@@ -6,6 +6,8 @@
 #include "def/serialize/CollectionLoaders.hh"
 #include "def/serialize/CollectionSavers.hh"
 
+#include "fow/View.hh"
+
 namespace freeisle::state::serialize {
 
 StateLoader::StateLoader(State &state, def::Scenario &scenario,
@@ -39,6 +41,10 @@ void StateLoader::load(json::loader::Context &ctx, Json::Value &value) {
   json::loader::load_object(ctx, value, "shops", shops);
   json::loader::load_object(ctx, value, "units", units);
   json::loader::load_object(ctx, value, "players", players);
+
+  // View factors depend on the alliances of all players, so can only be
+  // computed once all players are loaded.
+  fow::rebuild(state_);
   state_.turn_num = json::loader::load<uint32_t>(ctx, value, "turn");
   state_.player_at_turn = def::serialize::load_mandatory_ref<Player>(
       ctx, value, "player_at_turn", state_.players);
@@ -226,25 +226,25 @@ void UnitLoader::load(json::loader::Context &ctx, Json::Value &value) {
     // TODO(armin): check whether unit can be on this hex in the first place
     // based on movement_cost array... (and level?)
     if (unit_->level == def::Level::UnderWater) {
-      if (map_.grid(location.x, location.y).shop ||
-          map_.grid(location.x, location.y).subsurface_unit) {
+      if (map_.shop(location.x, location.y) ||
+          map_.subsurface_unit(location.x, location.y)) {
         const std::string message = fmt::format(
             "Location x={}, y={} is already occupied", location.x, location.y);
         throw json::loader::Error::create(ctx, "location", value["location"],
                                           message);
       }
 
-      map_.grid(location.x, location.y).subsurface_unit = unit_;
+      map_.set_subsurface_unit(location.x, location.y, unit_);
     } else {
-      if (map_.grid(location.x, location.y).shop ||
-          map_.grid(location.x, location.y).surface_unit) {
+      if (map_.shop(location.x, location.y) ||
+          map_.surface_unit(location.x, location.y)) {
         const std::string message = fmt::format(
             "Location x={}, y={} is already occupied", location.x, location.y);
         throw json::loader::Error::create(ctx, "location", value["location"],
                                           message);
       }
 
-      map_.grid(location.x, location.y).surface_unit = unit_;
+      map_.set_surface_unit(location.x, location.y, unit_);
     }
   }
 
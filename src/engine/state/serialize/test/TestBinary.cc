@@ -0,0 +1,300 @@
+#include "state/serialize/Binary.hh"
+
+#include "fow/View.hh"
+#include "fs/File.hh"
+#include "fs/Path.hh"
+
+#include "fs/test/util/TempDirFixture.hh"
+#include "log/test/util/System.hh"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+class TestBinary : public ::freeisle::fs::test::TempDirFixture {
+public:
+  TestBinary() {}
+
+  /**
+   * Creates a state that makes use of all the information stored in the
+   * binary format.
+   */
+  freeisle::state::serialize::SerializableState create_state() {
+    const std::string_view base_dir =
+        freeisle::fs::path::dirname(freeisle::fs::path::dirname(
+            freeisle::fs::path::dirname(orig_directory)));
+
+    const freeisle::state::serialize::CreateOptions options = {
+        .name = "My Scenario",
+        .description = "East End Boys and West End Girls",
+        .width = 10,
+        .height = 8,
+        .players = {{"north", {255, 0, 0}}, {"south", {0, 0, 255}}},
+        .base_dir = std::string(base_dir),
+        .unit_defs = {"def/serialize/test/data/unit_grunt.json"},
+        .decoration_defs = {"state/serialize/test/data/deco_flowers.json"}};
+
+    freeisle::state::serialize::SerializableState state =
+        freeisle::state::serialize::create_scenario(
+            options, system.logger.make_child_logger("test"));
+
+    freeisle::def::Scenario &scenario = *state.scenario;
+    freeisle::state::State &game = state.state;
+
+    scenario.map.grid(1, 2).base_terrain =
+        freeisle::def::BaseTerrainType::Desert;
+    scenario.map.grid(3, 3).overlay_terrain =
+        freeisle::def::OverlayTerrainType::Forest;
+    scenario.map.grid(4, 4).decoration =
+        &scenario.map.decoration_defs.begin()->second;
+
+    const freeisle::def::Collection<freeisle::def::UnitDef>::iterator grunt =
+        scenario.units.begin();
+    const freeisle::def::Collection<freeisle::def::ShopDef>::iterator
+        shop_def = scenario.shops.try_emplace("shopdef001").first;
+    shop_def->second.name = "Factory";
+    shop_def->second.type = freeisle::def::ShopDef::Type::Factory;
+    shop_def->second.income = 200;
+    shop_def->second.container = {
+        .max_units = 2,
+        .max_weight = 1000,
+        .supported_levels = freeisle::def::Level::Land,
+    };
+    shop_def->second.production_list.emplace(grunt);
+    shop_def->second.location = {.x = 5, .y = 5};
+
+    const freeisle::def::Collection<freeisle::state::Team>::iterator team =
+        game.teams.try_emplace("team001").first;
+    team->second.name = "Alliance";
+
+    const freeisle::def::Collection<freeisle::state::Player>::iterator north =
+        game.players.find("player001");
+    const freeisle::def::Collection<freeisle::state::Player>::iterator south =
+        game.players.find("player002");
+    north->second.team = team;
+    north->second.wealth = 1500;
+    north->second.fow(2, 3).discovered = true;
+    north->second.fow(9, 7).discovered = true;
+    south->second.lose_conditions = freeisle::def::Goal::EliminateCaptain;
+    south->second.is_eliminated = true;
+
+    const freeisle::def::Collection<freeisle::state::Shop>::iterator shop =
+        game.shops.try_emplace("shop001").first;
+    shop->second.def = shop_def;
+    shop->second.owner = north;
+    shop->second.container.def = &shop_def->second.container;
+    game.map.set_shop(5, 5, shop);
+
+    const freeisle::def::Collection<freeisle::state::Unit>::iterator
+        soldier = game.units.try_emplace("unit001").first;
+    freeisle::state::Unit &unit = soldier->second;
+    unit.def = grunt;
+    unit.owner = north;
+    unit.location = {.x = 2, .y = 3};
+    unit.health = 80;
+    unit.level = freeisle::def::Level::Land;
+    unit.movement = 300;
+    unit.fuel = 20;
+    unit.experience = 3;
+    unit.has_actioned = true;
+    unit.ammo.emplace(grunt->second.weapons.begin(), 4);
+    unit.container.def = &grunt->second.container;
+    unit.stats.hits_dealt = 5;
+    unit.stats.hexes_moved = 12;
+    game.map.set_surface_unit(2, 3, soldier);
+    north->second.units.insert(soldier);
+    north->second.captain = soldier;
+
+    const freeisle::def::Collection<freeisle::state::Unit>::iterator
+        reserve = game.units.try_emplace("unit002").first;
+    reserve->second.def = grunt;
+    reserve->second.owner = north;
+    reserve->second.location = {.x = 5, .y = 5};
+    reserve->second.health = 100;
+    reserve->second.level = freeisle::def::Level::Land;
+    reserve->second.ammo.emplace(grunt->second.weapons.begin(), 6);
+    reserve->second.container.def = &grunt->second.container;
+    reserve->second.contained_in_shop = shop;
+    shop->second.container.units.push_back(reserve);
+    north->second.units.insert(reserve);
+
+    // Marks the hexes around unit001 as discovered:
+    freeisle::fow::rebuild(game);
+
+    game.turn_num = 7;
+    game.player_at_turn = south;
+
+    state.include_map[".scenario.units.unitdef001"].override_keys["armor"] =
+        true;
+    return state;
+  }
+
+  freeisle::log::test::System system;
+};
+
+TEST_F(TestBinary, RoundTrip) {
+  const freeisle::state::serialize::SerializableState state = create_state();
+
+  const std::vector<uint8_t> data =
+      freeisle::state::serialize::encode_binary(state);
+  const freeisle::state::serialize::SerializableState result =
+      freeisle::state::serialize::decode_binary(data.data(), data.size());
+
+  // Everything stored is encoded the same way again:
+  EXPECT_EQ(freeisle::state::serialize::encode_binary(result), data);
+
+  const freeisle::def::Scenario &scenario = *result.scenario;
+  const freeisle::state::State &game = result.state;
+
+  EXPECT_EQ(scenario.name, "My Scenario");
+  ASSERT_EQ(scenario.map.grid.width(), 10);
+  ASSERT_EQ(scenario.map.grid.height(), 8);
+  EXPECT_EQ(scenario.map.grid(1, 2).base_terrain,
+            freeisle::def::BaseTerrainType::Desert);
+  EXPECT_EQ(*scenario.map.grid(3, 3).overlay_terrain,
+            freeisle::def::OverlayTerrainType::Forest);
+  EXPECT_FALSE(scenario.map.grid(3, 4).overlay_terrain);
+  EXPECT_EQ(scenario.map.grid(4, 4).decoration,
+            &scenario.map.decoration_defs.at("deco001"));
+
+  const freeisle::def::UnitDef &grunt = scenario.units.at("unitdef001");
+  EXPECT_EQ(grunt.name, "grunt");
+  EXPECT_EQ(grunt.caps, freeisle::def::UnitDef::Cap::Capture);
+  EXPECT_EQ(grunt.movement_cost[freeisle::def::OverlayTerrainType::Road], 90);
+  EXPECT_EQ(grunt.resistance[freeisle::def::DamageType::Explosive], 80);
+  EXPECT_EQ(grunt.weapons.at("rifle").ammo, 6);
+
+  const freeisle::def::ShopDef &shop_def = scenario.shops.at("shopdef001");
+  EXPECT_EQ(shop_def.type, freeisle::def::ShopDef::Type::Factory);
+  EXPECT_EQ(shop_def.container.supported_levels,
+            freeisle::def::Level::Land);
+  ASSERT_EQ(shop_def.production_list.size(), 1);
+  EXPECT_EQ(&**shop_def.production_list.begin(), &grunt);
+
+  EXPECT_EQ(game.scenario, &scenario);
+  EXPECT_EQ(game.map.def, &scenario.map);
+  EXPECT_EQ(game.turn_num, 7);
+  EXPECT_EQ(game.player_at_turn, game.players.find("player002"));
+
+  const freeisle::state::Player &north = game.players.at("player001");
+  EXPECT_EQ(north.name, "north");
+  EXPECT_EQ(north.color.b, 0);
+  EXPECT_EQ(north.team, game.teams.find("team001"));
+  EXPECT_EQ(north.wealth, 1500);
+  EXPECT_TRUE(north.fow(2, 3).discovered);
+  EXPECT_TRUE(north.fow(9, 7).discovered);
+  EXPECT_FALSE(north.fow(9, 0).discovered);
+  EXPECT_EQ(north.captain, game.units.find("unit001"));
+  EXPECT_EQ(north.units.size(), 2);
+  EXPECT_TRUE(game.players.at("player002").is_eliminated);
+
+  // Derived information is rebuilt:
+  EXPECT_GT(north.fow(2, 3).view, 0);
+  EXPECT_EQ(game.map.shop(5, 5), game.shops.find("shop001"));
+  EXPECT_EQ(game.map.surface_unit(2, 3), game.units.find("unit001"));
+  EXPECT_FALSE(game.map.surface_unit(5, 5));
+
+  const freeisle::state::Shop &shop = game.shops.at("shop001");
+  EXPECT_EQ(shop.container.def, &shop_def.container);
+  ASSERT_EQ(shop.container.units.size(), 1);
+  EXPECT_EQ(shop.container.units.front().id(), "unit002");
+
+  const freeisle::state::Unit &unit = game.units.at("unit001");
+  EXPECT_EQ(unit.health, 80);
+  EXPECT_TRUE(unit.has_actioned);
+  EXPECT_FALSE(unit.has_soared);
+  EXPECT_EQ(unit.stats.hexes_moved, 12);
+  EXPECT_EQ(unit.container.def, &grunt.container);
+  ASSERT_EQ(unit.ammo.size(), 1);
+  EXPECT_EQ(unit.ammo.begin()->first.id(), "rifle");
+  EXPECT_EQ(unit.ammo.begin()->second, 4);
+
+  ASSERT_EQ(result.include_map.size(), state.include_map.size());
+  EXPECT_EQ(result.include_map.at(".scenario.units.unitdef001").filename,
+            "def/serialize/test/data/unit_grunt.json");
+  EXPECT_EQ(result.include_map.at(".scenario.units.unitdef001")
+                .override_keys.at("armor"),
+            true);
+}
+
+TEST_F(TestBinary, Invalid) {
+  std::vector<uint8_t> data =
+      freeisle::state::serialize::encode_binary(create_state());
+
+  EXPECT_THROW(freeisle::state::serialize::decode_binary(data.data(), 16),
+               std::runtime_error);
+  EXPECT_THROW(
+      freeisle::state::serialize::decode_binary(data.data(), data.size() - 8),
+      std::runtime_error);
+
+  std::vector<uint8_t> wrong_version = data;
+  ++wrong_version[8];
+  EXPECT_THROW(freeisle::state::serialize::decode_binary(
+                   wrong_version.data(), wrong_version.size()),
+               std::runtime_error);
+
+  std::vector<uint8_t> wrong_magic = data;
+  wrong_magic[0] = 'X';
+  EXPECT_THROW(freeisle::state::serialize::decode_binary(wrong_magic.data(),
+                                                         wrong_magic.size()),
+               std::runtime_error);
+}
+
+TEST_F(TestBinary, Convert) {
+  const std::string json_path =
+      freeisle::fs::path::join(orig_directory, "data", "state.json");
+
+  freeisle::state::serialize::convert_to_binary(
+      json_path.c_str(), "state.bin", system.logger.make_child_logger("test"));
+
+  const freeisle::state::serialize::SerializableState state =
+      freeisle::state::serialize::load(json_path.c_str(),
+                                       system.logger.make_child_logger("test"));
+  const freeisle::state::serialize::SerializableState converted =
+      freeisle::state::serialize::load_binary("state.bin");
+  EXPECT_EQ(freeisle::state::serialize::encode_binary(converted),
+            freeisle::state::serialize::encode_binary(state));
+
+  freeisle::state::serialize::convert_to_json(
+      "state.bin", "converted.json", system.logger.make_child_logger("test"));
+  freeisle::state::serialize::save(state, "saved.json",
+                                   system.logger.make_child_logger("test"));
+  EXPECT_EQ(freeisle::fs::read_file("converted.json", nullptr),
+            freeisle::fs::read_file("saved.json", nullptr));
+}
+
+TEST_F(TestBinary, InvalidContainment) {
+  freeisle::state::serialize::SerializableState state = create_state();
+  freeisle::state::State &game = state.state;
+  const freeisle::def::Collection<freeisle::state::Unit>::iterator soldier =
+      game.units.find("unit001");
+  const freeisle::def::Collection<freeisle::state::Unit>::iterator reserve =
+      game.units.find("unit002");
+
+  const auto decode = [&state]() {
+    const std::vector<uint8_t> data =
+        freeisle::state::serialize::encode_binary(state);
+    freeisle::state::serialize::decode_binary(data.data(), data.size());
+  };
+
+  reserve->second.contained_in_unit = soldier;
+  try {
+    decode();
+    FAIL() << "Expected decode_binary to throw";
+  } catch (const std::runtime_error &e) {
+    EXPECT_STREQ(
+        e.what(),
+        "Binary state has unit \"unit002\" contained in both unit and shop");
+  }
+
+  reserve->second.contained_in_shop =
+      freeisle::def::NullableRef<freeisle::state::Shop>();
+  soldier->second.contained_in_unit = reserve;
+  try {
+    decode();
+    FAIL() << "Expected decode_binary to throw";
+  } catch (const std::runtime_error &e) {
+    EXPECT_STREQ(e.what(),
+                 "Binary state has unit \"unit001\" contained in itself");
+  }
+}
@@ -440,3 +440,155 @@ TEST_F(TestSerialize, LoadScenario) {
   EXPECT_EQ(player.is_eliminated, false);
   EXPECT_EQ(player.units.size(), 0);
 }
+
+TEST_F(TestSerialize, ValidateScenario) {
+  const std::vector<freeisle::json::loader::Error> errors =
+      freeisle::state::serialize::validate(
+          freeisle::fs::path::join(orig_directory, "data", "state.json")
+              .c_str(),
+          system.logger.make_child_logger("test"));
+
+  EXPECT_TRUE(errors.empty());
+}
+
+TEST_F(TestSerialize, ValidateBrokenUnits) {
+  const std::string_view base_dir = freeisle::fs::path::dirname(
+      freeisle::fs::path::dirname(freeisle::fs::path::dirname(orig_directory)));
+
+  const freeisle::state::serialize::CreateOptions options = {
+      .name = "My Scenario",
+      .description = "East End Boys and West End Girls",
+      .width = 10,
+      .height = 10,
+      .players = {{"my_player", {255, 0, 0}}},
+      .base_dir = std::string(base_dir),
+      .unit_defs = {"def/serialize/test/data/unit_grunt.json"},
+      .decoration_defs = {"state/serialize/test/data/deco_flowers.json"}};
+
+  freeisle::state::serialize::SerializableState state =
+      freeisle::state::serialize::create_scenario(
+          options, system.logger.make_child_logger("test"));
+
+  for (uint32_t i = 0; i < 3; ++i) {
+    const freeisle::def::Collection<freeisle::state::Unit>::iterator iter =
+        state.state.units.try_emplace(fmt::format("unit{:03}", i)).first;
+    freeisle::state::Unit &unit = iter->second;
+    unit.def = state.scenario->units.begin();
+    unit.owner = state.state.players.begin();
+    unit.location = {.x = i, .y = i};
+    unit.health = 100;
+    unit.level = unit.def->level;
+    unit.container.def = &unit.def->container;
+    for (auto weapon = unit.def->weapons.begin();
+         weapon != unit.def->weapons.end(); ++weapon) {
+      unit.ammo.emplace(weapon, weapon->second.ammo);
+    }
+    unit.owner->units.insert(iter);
+    state.state.map.set_surface_unit(i, i, iter);
+  }
+
+  // Without the include references, the definitions are saved along:
+  state.include_map.clear();
+  freeisle::state::serialize::save(state, "save.json",
+                                   system.logger.make_child_logger("test"));
+  EXPECT_TRUE(freeisle::state::serialize::validate(
+                  "save.json", system.logger.make_child_logger("test"))
+                  .empty());
+
+  // One unit outside of the map, one with a broken nested object:
+  const std::vector<uint8_t> data =
+      freeisle::fs::read_file("save.json", nullptr);
+  Json::Value root;
+  Json::Reader reader;
+  ASSERT_TRUE(reader.parse(reinterpret_cast<const char *>(data.data()),
+                           reinterpret_cast<const char *>(data.data()) +
+                               data.size(),
+                           root, false));
+  root["units"]["unit000"]["location"]["x"] = 50;
+  root["units"]["unit002"]["stats"]["hits_dealt"] = "many";
+
+  const std::string text = Json::StyledWriter().write(root);
+  freeisle::fs::write_file("save.json",
+                           reinterpret_cast<const uint8_t *>(text.data()),
+                           text.size(), nullptr);
+
+  const std::vector<freeisle::json::loader::Error> errors =
+      freeisle::state::serialize::validate(
+          "save.json", system.logger.make_child_logger("test"));
+  ASSERT_EQ(errors.size(), 2);
+  EXPECT_EQ(errors[0].message(),
+            "Location is out of bounds; loc=50,0 but bounds=10x10");
+  EXPECT_EQ(errors[1].message(), "Value is not convertible to UInt.");
+
+  EXPECT_THROW(freeisle::state::serialize::load(
+                   "save.json", system.logger.make_child_logger("test")),
+               freeisle::json::loader::Error);
+}
+
+TEST_F(TestSerialize, IncrementalSave) {
+  const std::string_view base_dir = freeisle::fs::path::dirname(
+      freeisle::fs::path::dirname(freeisle::fs::path::dirname(orig_directory)));
+
+  const freeisle::state::serialize::CreateOptions options = {
+      .name = "My Scenario",
+      .description = "East End Boys and West End Girls",
+      .width = 10,
+      .height = 10,
+      .players = {{"my_player", {255, 0, 0}}},
+      .base_dir = std::string(base_dir),
+      .unit_defs = {"def/serialize/test/data/unit_grunt.json"},
+      .decoration_defs = {"state/serialize/test/data/deco_flowers.json"}};
+
+  freeisle::state::serialize::SerializableState state =
+      freeisle::state::serialize::create_scenario(
+          options, system.logger.make_child_logger("test"));
+
+  freeisle::json::saver::SaveCache cache;
+  // returns the number of files written and skipped:
+  const auto save = [&](freeisle::png::Compression compression =
+                            freeisle::png::Compression::Default) {
+    const uint64_t written = cache.written();
+    const uint64_t skipped = cache.skipped();
+    freeisle::state::serialize::save(state, "save.json",
+                                     system.logger.make_child_logger("test"),
+                                     &cache, compression);
+    return std::make_pair(cache.written() - written,
+                          cache.skipped() - skipped);
+  };
+
+  // save.json, map.png and fow.1.bin:
+  EXPECT_EQ(save(), std::make_pair(uint64_t{3}, uint64_t{0}));
+  const std::vector<uint8_t> first =
+      freeisle::fs::read_file("save.json", nullptr);
+
+  EXPECT_EQ(save(), std::make_pair(uint64_t{0}, uint64_t{3}));
+  EXPECT_EQ(freeisle::fs::read_file("save.json", nullptr), first);
+
+  freeisle::state::Player &player = state.state.players.begin()->second;
+  player.wealth = 100;
+  EXPECT_EQ(save(), std::make_pair(uint64_t{1}, uint64_t{2}));
+
+  const std::vector<uint8_t> fow =
+      freeisle::fs::read_file("fow.1.bin", nullptr);
+  player.fow(3, 4).discovered = true;
+  EXPECT_EQ(save(), std::make_pair(uint64_t{1}, uint64_t{2}));
+  EXPECT_NE(freeisle::fs::read_file("fow.1.bin", nullptr), fow);
+
+  // only the image changes, not the reference to it in save.json:
+  const std::vector<uint8_t> map = freeisle::fs::read_file("map.png", nullptr);
+  state.scenario->map.grid(1, 2).base_terrain =
+      freeisle::def::BaseTerrainType::Desert;
+  EXPECT_EQ(save(), std::make_pair(uint64_t{1}, uint64_t{2}));
+  EXPECT_NE(freeisle::fs::read_file("map.png", nullptr), map);
+
+  // files changed by someone else are written again:
+  freeisle::fs::write_file("map.png", nullptr, 0, nullptr);
+  EXPECT_EQ(save(), std::make_pair(uint64_t{1}, uint64_t{2}));
+  EXPECT_FALSE(freeisle::fs::read_file("map.png", nullptr).empty());
+
+  // the same image with a different compression is written again:
+  EXPECT_EQ(save(freeisle::png::Compression::Small),
+            std::make_pair(uint64_t{1}, uint64_t{2}));
+  EXPECT_EQ(save(freeisle::png::Compression::Small),
+            std::make_pair(uint64_t{0}, uint64_t{3}));
+}
@@ -131,7 +131,7 @@ TEST_F(TestShopHandlers, LoadShopAtOccupiedSpot) {
   freeisle::def::Collection<freeisle::state::Unit> units;
   units.try_emplace("unit001",
                     freeisle::state::Unit{.location = {.x = 3, .y = 1}});
-  map.grid(3, 1).surface_unit = units.find("unit001");
+  map.set_surface_unit(3, 1, units.find("unit001"));
 
   freeisle::def::Collection<freeisle::state::Shop> shops;
   shops.try_emplace("shop001");
@@ -36,6 +36,7 @@ public:
             .weapons = freeisle::def::make_collection<freeisle::def::WeaponDef>(
                 std::make_pair("weapon001",
                                freeisle::def::WeaponDef{.ammo = 4})),
+            .view_range = 1,
         });
   }
 
@@ -181,8 +182,19 @@ TEST_F(TestStateHandlers, LoadState) {
   ASSERT_EQ(state.map.grid.width(), 5);
   ASSERT_EQ(state.map.grid.height(), 5);
 
-  EXPECT_EQ(state.map.grid(0, 0).surface_unit, state.units.find("unit001"));
-  EXPECT_EQ(state.map.grid(3, 1).shop, state.shops.find("shop001"));
+  EXPECT_EQ(state.map.surface_unit(0, 0), state.units.find("unit001"));
+  EXPECT_EQ(state.map.shop(3, 1), state.shops.find("shop001"));
+
+  const freeisle::core::Grid<freeisle::state::Player::Fow> &fow =
+      state.players["player001"].fow;
+  ASSERT_EQ(fow.width(), 5);
+  ASSERT_EQ(fow.height(), 5);
+  EXPECT_EQ(fow(0, 0).view, 1);
+  EXPECT_EQ(fow(1, 0).view, 1);
+  EXPECT_EQ(fow(0, 1).view, 1);
+  EXPECT_EQ(fow(2, 0).view, 0);
+  EXPECT_TRUE(fow(1, 0).discovered);
+  EXPECT_FALSE(fow(2, 0).discovered);
 }
 
 TEST_F(TestStateHandlers, Save) {
@@ -232,8 +244,8 @@ TEST_F(TestStateHandlers, Save) {
   state.players["player001"].captain = state.units.find("unit001");
 
   state.map.grid = freeisle::core::Grid<freeisle::state::Map::Hex>(5, 5);
-  state.map.grid(0, 0).surface_unit = state.units.find("unit001");
-  state.map.grid(3, 1).shop = state.shops.find("shop001");
+  state.map.set_surface_unit(0, 0, state.units.find("unit001"));
+  state.map.set_shop(3, 1, state.shops.find("shop001"));
 
   state.turn_num = 1;
   state.player_at_turn = state.players.find("player001");
@@ -134,9 +134,9 @@ public:
     shops.try_emplace("shop_water", freeisle::state::Shop{
                                         .def = shop_defs.find("shop003"),
                                         .owner = players.find("player001")});
-    map.grid(3, 1).shop = shops.find("shop_owned");
-    map.grid(4, 3).shop = shops.find("shop_unowned");
-    map.grid(0, 4).shop = shops.find("shop_water");
+    map.set_shop(3, 1, shops.find("shop_owned"));
+    map.set_shop(4, 3, shops.find("shop_unowned"));
+    map.set_shop(0, 4, shops.find("shop_water"));
 
     map_def.grid(0, 3).base_terrain = freeisle::def::BaseTerrainType::DeepWater;
     map_def.grid(0, 4).base_terrain = freeisle::def::BaseTerrainType::DeepWater;
@@ -233,7 +233,7 @@ TEST_F(TestUnitHandlers, LoadUnit) {
   EXPECT_FALSE(unit.contained_in_shop);
   EXPECT_FALSE(unit.contained_in_unit);
 
-  EXPECT_EQ(map.grid(0, 0).surface_unit, units.find("unit001"));
+  EXPECT_EQ(map.surface_unit(0, 0), units.find("unit001"));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitExceedFuelSupply) {
@@ -634,7 +634,7 @@ TEST_F(TestUnitHandlers, LoadUnitAirSoared) {
   EXPECT_FALSE(unit.contained_in_shop);
   EXPECT_FALSE(unit.contained_in_unit);
 
-  EXPECT_EQ(map.grid(0, 0).surface_unit, units.find("unit001"));
+  EXPECT_EQ(map.surface_unit(0, 0), units.find("unit001"));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitAirWrongSoared) {
@@ -810,7 +810,7 @@ TEST_F(TestUnitHandlers, LoadUnitWaterSoared) {
   EXPECT_FALSE(unit.contained_in_shop);
   EXPECT_FALSE(unit.contained_in_unit);
 
-  EXPECT_EQ(map.grid(0, 0).subsurface_unit, units.find("unit001"));
+  EXPECT_EQ(map.subsurface_unit(0, 0), units.find("unit001"));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitWaterWrongSoared) {
@@ -1071,7 +1071,7 @@ TEST_F(TestUnitHandlers, LoadUnitUnderwaterOccupiedByUnderwaterUnit) {
                                    .location = {.x = 0, .y = 3},
                                    .level = freeisle::def::Level::UnderWater});
 
-  map.grid(0, 3).subsurface_unit = units.find("unit002");
+  map.set_subsurface_unit(0, 3, units.find("unit002"));
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
                                                 players);
@@ -1127,7 +1127,7 @@ TEST_F(TestUnitHandlers, LoadUnitUnderwaterOccupiedByWaterUnit) {
                                    .location = {.x = 0, .y = 3},
                                    .level = freeisle::def::Level::Water});
 
-  map.grid(0, 3).surface_unit = units.find("unit002");
+  map.set_surface_unit(0, 3, units.find("unit002"));
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
                                                 players);
   loader.set(units.find("unit001"));
@@ -1197,9 +1197,9 @@ TEST_F(TestUnitHandlers, LoadUnitUnderwaterOccupiedByWaterUnit) {
   EXPECT_FALSE(unit.contained_in_shop);
   EXPECT_FALSE(unit.contained_in_unit);
 
-  EXPECT_FALSE(map.grid(0, 3).shop);
-  EXPECT_EQ(map.grid(0, 3).surface_unit, units.find("unit002"));
-  EXPECT_EQ(map.grid(0, 3).subsurface_unit, units.find("unit001"));
+  EXPECT_FALSE(map.shop(0, 3));
+  EXPECT_EQ(map.surface_unit(0, 3), units.find("unit002"));
+  EXPECT_EQ(map.subsurface_unit(0, 3), units.find("unit001"));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitSurfaceOccupiedByShop) { // TODO
@@ -1264,7 +1264,7 @@ TEST_F(TestUnitHandlers, LoadUnitSurfaceOccupiedByUnit) {
                                    .location = {.x = 0, .y = 3},
                                    .level = freeisle::def::Level::Water});
 
-  map.grid(0, 3).surface_unit = units.find("unit002");
+  map.set_surface_unit(0, 3, units.find("unit002"));
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
                                                 players);
@@ -1320,7 +1320,7 @@ TEST_F(TestUnitHandlers, LoadUnitSurfaceOccupiedByUnderWaterUnit) {
                                    .location = {.x = 0, .y = 3},
                                    .level = freeisle::def::Level::UnderWater});
 
-  map.grid(0, 3).subsurface_unit = units.find("unit002");
+  map.set_subsurface_unit(0, 3, units.find("unit002"));
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
                                                 players);
@@ -1391,9 +1391,9 @@ TEST_F(TestUnitHandlers, LoadUnitSurfaceOccupiedByUnderWaterUnit) {
   EXPECT_FALSE(unit.contained_in_shop);
   EXPECT_FALSE(unit.contained_in_unit);
 
-  EXPECT_FALSE(map.grid(0, 3).shop);
-  EXPECT_EQ(map.grid(0, 3).surface_unit, units.find("unit001"));
-  EXPECT_EQ(map.grid(0, 3).subsurface_unit, units.find("unit002"));
+  EXPECT_FALSE(map.shop(0, 3));
+  EXPECT_EQ(map.surface_unit(0, 3), units.find("unit001"));
+  EXPECT_EQ(map.subsurface_unit(0, 3), units.find("unit002"));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitContainedInShop) {
@@ -1481,7 +1481,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInShop) {
   EXPECT_EQ(shop->container.units.size(), 1);
   EXPECT_EQ(shop->container.units.front(), units.find("unit001"));
 
-  EXPECT_FALSE(map.grid(3, 1).surface_unit);
+  EXPECT_FALSE(map.surface_unit(3, 1));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitContainedInShopWrongOwner) {
@@ -1804,7 +1804,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInLoadedUnit) {
                                    .location = {.x = 2, .y = 2},
                                    .level = freeisle::def::Level::Land,
                                });
-  map.grid(2, 2).surface_unit = units.find("unit002");
+  map.set_surface_unit(2, 2, units.find("unit002"));
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
                                                 players);
@@ -1887,7 +1887,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInLoadedUnit) {
   EXPECT_EQ(container->container.units.size(), 1);
   EXPECT_EQ(container->container.units.front(), units.find("unit001"));
 
-  EXPECT_EQ(map.grid(2, 2).surface_unit, container);
+  EXPECT_EQ(map.surface_unit(2, 2), container);
 }
 
 TEST_F(TestUnitHandlers, LoadUnitContainedInUnloadedUnit) {
@@ -1977,7 +1977,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInUnloadedUnit) {
   EXPECT_EQ(container->container.units.size(), 1);
   EXPECT_EQ(container->container.units.front(), units.find("unit001"));
 
-  EXPECT_FALSE(map.grid(2, 2).surface_unit);
+  EXPECT_FALSE(map.surface_unit(2, 2));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitContainer) {
@@ -2061,7 +2061,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainer) {
   EXPECT_EQ(unit.container.units.size(), 1);
   EXPECT_EQ(unit.container.units.front(), units.find("unit001"));
 
-  EXPECT_EQ(map.grid(4, 4).surface_unit, units.find("unit002"));
+  EXPECT_EQ(map.surface_unit(4, 4), units.find("unit002"));
 }
 
 TEST_F(TestUnitHandlers, LoadUnitContainedInLoadedUnitWrongOwner) {
@@ -2073,7 +2073,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInLoadedUnitWrongOwner) {
                                    .location = {.x = 2, .y = 2},
                                    .level = freeisle::def::Level::Land,
                                });
-  map.grid(2, 2).surface_unit = units.find("unit002");
+  map.set_surface_unit(2, 2, units.find("unit002"));
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
                                                 players);
@@ -2136,7 +2136,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInLoadedUnitWrongLocation) {
                                    .location = {.x = 2, .y = 2},
                                    .level = freeisle::def::Level::Land,
                                });
-  map.grid(2, 2).surface_unit = units.find("unit002");
+  map.set_surface_unit(2, 2, units.find("unit002"));
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
                                                 players);
@@ -2213,7 +2213,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInUnitExceedCount) {
   units.find("unit002")->second.container.units.push_back(
       units.find("unit004"));
 
-  map.grid(2, 2).surface_unit = units.find("unit002");
+  map.set_surface_unit(2, 2, units.find("unit002"));
   units.try_emplace("unit001");
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
@@ -2287,7 +2287,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInLoadedUnitExceedWeight) {
   units.find("unit002")->second.container.units.push_back(
       units.find("unit003"));
 
-  map.grid(2, 2).surface_unit = units.find("unit002");
+  map.set_surface_unit(2, 2, units.find("unit002"));
   units.try_emplace("unit001");
 
   freeisle::state::serialize::UnitLoader loader(unit_defs, map, shops, units,
@@ -2351,7 +2351,7 @@ TEST_F(TestUnitHandlers, LoadUnitContainedInLoadedUnitWrongLevel) {
                                    .location = {.x = 2, .y = 2},
                                    .level = freeisle::def::Level::Land,
                                });
-  map.grid(2, 2).surface_unit = units.find("unit002");
+  map.set_surface_unit(2, 2, units.find("unit002"));
 
   units.try_emplace("unit001");
 
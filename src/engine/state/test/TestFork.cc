@@ -0,0 +1,137 @@
+#include "state/Fork.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <gtest/gtest.h>
+
+class TestFork : public ::testing::Test,
+                 public freeisle::state::test::Scenario {
+public:
+  TestFork() : Scenario(5, 5) {
+    freeisle::def::UnitDef &def = add_unit_def(
+        "def001",
+        freeisle::def::UnitDef{
+            .name = "def001",
+            .level = freeisle::def::Level::Land,
+            .container = {.max_units = 1,
+                          .max_weight = 2000,
+                          .supported_levels = freeisle::def::Level::Land},
+        });
+    def.weapons.try_emplace("weapon001", freeisle::def::WeaponDef{.ammo = 4});
+
+    state.turn_num = 7;
+
+    add_team("north").name = "North";
+    add_player("rose", "north");
+    add_player("lily");
+    state.players["rose"].fow(1, 1) = {.discovered = true, .view = 2};
+    state.player_at_turn = state.players.find("lily");
+
+    freeisle::state::Shop &shop =
+        add_shop("shop001", "rose", 3, 1,
+                 {.max_units = 2,
+                  .max_weight = 2000,
+                  .supported_levels = freeisle::def::Level::Land});
+
+    add_unit("unit001", "def001", "rose", 0, 0);
+    add_unit("unit002", "def001", "rose", 0, 0);
+    add_unit("unit003", "def001", "lily", 3, 1);
+    add_unit("unit004", "def001", "lily", 4, 4);
+    for (auto &[id, unit] : state.units) {
+      unit.ammo.begin()->second = 3;
+    }
+
+    state.units["unit002"].contained_in_unit = state.units.find("unit001");
+    state.units["unit001"].container.units.push_back(
+        state.units.find("unit002"));
+    state.units["unit003"].contained_in_shop = state.shops.find("shop001");
+    shop.container.units.push_back(state.units.find("unit003"));
+    state.players["rose"].captain = state.units.find("unit001");
+  }
+};
+
+TEST_F(TestFork, CopiesObjects) {
+  const freeisle::state::State fork = freeisle::state::fork(state);
+
+  EXPECT_EQ(fork.scenario, &scenario);
+  EXPECT_EQ(fork.turn_num, 7);
+  EXPECT_EQ(fork.teams.find("north")->second.name, "North");
+  EXPECT_EQ(fork.players.size(), 2);
+  EXPECT_EQ(fork.shops.size(), 1);
+  EXPECT_EQ(fork.units.size(), 4);
+
+  const freeisle::state::Player &rose = fork.players.find("rose")->second;
+  EXPECT_NE(&rose, &state.players["rose"]);
+  EXPECT_EQ(rose.name, "rose");
+  EXPECT_TRUE(rose.fow(1, 1).discovered);
+  EXPECT_EQ(rose.fow(1, 1).view, 2);
+  EXPECT_NE(&rose.fow(1, 1), &state.players["rose"].fow(1, 1));
+}
+
+TEST_F(TestFork, RebindsReferences) {
+  freeisle::state::State fork = freeisle::state::fork(state);
+
+  freeisle::state::Player &rose = fork.players["rose"];
+  freeisle::state::Unit &unit001 = fork.units["unit001"];
+  freeisle::state::Unit &unit002 = fork.units["unit002"];
+  freeisle::state::Unit &unit003 = fork.units["unit003"];
+  freeisle::state::Shop &shop = fork.shops["shop001"];
+
+  EXPECT_EQ(rose.team, fork.teams.find("north"));
+  EXPECT_EQ(rose.captain, fork.units.find("unit001"));
+  EXPECT_EQ(rose.units.size(), 2);
+  EXPECT_EQ(&**rose.units.begin(), &unit001);
+  EXPECT_EQ(fork.player_at_turn, fork.players.find("lily"));
+
+  EXPECT_EQ(unit001.owner, fork.players.find("rose"));
+  EXPECT_EQ(unit002.contained_in_unit, fork.units.find("unit001"));
+  ASSERT_EQ(unit001.container.units.size(), 1);
+  EXPECT_EQ(&*unit001.container.units.front(), &unit002);
+  EXPECT_EQ(unit003.contained_in_shop, fork.shops.find("shop001"));
+  ASSERT_EQ(shop.container.units.size(), 1);
+  EXPECT_EQ(&*shop.container.units.front(), &unit003);
+  EXPECT_EQ(shop.owner, fork.players.find("rose"));
+
+  EXPECT_EQ(fork.map.surface_unit(0, 0), fork.units.find("unit001"));
+  EXPECT_EQ(fork.map.surface_unit(4, 4), fork.units.find("unit004"));
+  EXPECT_EQ(fork.map.shop(3, 1), fork.shops.find("shop001"));
+  EXPECT_FALSE(fork.map.surface_unit(1, 1));
+
+  // handles are the same in both states
+  EXPECT_EQ(fork.units.find(freeisle::def::Collection<
+                            freeisle::state::Unit>::handle(
+                    state.units.find("unit003"))),
+            fork.units.find("unit003"));
+}
+
+TEST_F(TestFork, SharesScenario) {
+  const freeisle::state::State fork = freeisle::state::fork(state);
+
+  const freeisle::state::Unit &unit = fork.units.find("unit001")->second;
+  EXPECT_EQ(&*unit.def, &scenario.units["def001"]);
+  ASSERT_EQ(unit.ammo.size(), 1);
+  EXPECT_EQ(&*unit.ammo.begin()->first,
+            &scenario.units["def001"].weapons["weapon001"]);
+  EXPECT_EQ(unit.ammo.begin()->second, 3);
+  EXPECT_EQ(unit.container.def, &scenario.units["def001"].container);
+  EXPECT_EQ(&*fork.shops.find("shop001")->second.def,
+            &scenario.shops["shop001"]);
+  EXPECT_EQ(fork.map.def, &scenario.map);
+}
+
+TEST_F(TestFork, Independent) {
+  freeisle::state::State fork = freeisle::state::fork(state);
+
+  fork.units["unit004"].health = 10;
+  fork.map.set_surface_unit(4, 4, {});
+  fork.map.set_surface_unit(2, 2, fork.units.find("unit004"));
+  fork.players["lily"].fow(2, 2).view = 5;
+  fork.units.erase("unit001");
+
+  EXPECT_EQ(state.units["unit004"].health, 100);
+  EXPECT_EQ(state.map.surface_unit(4, 4), state.units.find("unit004"));
+  EXPECT_FALSE(state.map.surface_unit(2, 2));
+  EXPECT_EQ(state.players["lily"].fow(2, 2).view, 0);
+  EXPECT_EQ(state.units.size(), 4);
+  EXPECT_EQ(state.players["rose"].captain, state.units.find("unit001"));
+}
@@ -0,0 +1,85 @@
+#include "state/Map.hh"
+
+#include <gtest/gtest.h>
+
+static_assert(sizeof(freeisle::state::Map::Hex) == 4);
+
+namespace {
+
+class TestMap : public ::testing::Test {
+protected:
+  TestMap()
+      : map{.grid = freeisle::core::Grid<freeisle::state::Map::Hex>(4, 4)} {
+    units.try_emplace("unit001");
+    units.try_emplace("unit002");
+    shops.try_emplace("shop001");
+  }
+
+  freeisle::def::Collection<freeisle::state::Unit> units;
+  freeisle::def::Collection<freeisle::state::Shop> shops;
+  freeisle::state::Map map;
+};
+
+} // namespace
+
+TEST_F(TestMap, Empty) {
+  for (uint32_t y = 0; y < 4; ++y) {
+    for (uint32_t x = 0; x < 4; ++x) {
+      EXPECT_TRUE(map.grid(x, y).empty());
+      EXPECT_FALSE(map.surface_unit(x, y));
+      EXPECT_FALSE(map.subsurface_unit(x, y));
+      EXPECT_FALSE(map.shop(x, y));
+    }
+  }
+
+  EXPECT_TRUE(map.occupants.empty());
+}
+
+TEST_F(TestMap, SetAndClear) {
+  map.set_surface_unit(1, 2, units.find("unit001"));
+  map.set_subsurface_unit(1, 2, units.find("unit002"));
+
+  EXPECT_TRUE(map.grid(1, 2).has_surface_unit());
+  EXPECT_TRUE(map.grid(1, 2).has_subsurface_unit());
+  EXPECT_FALSE(map.grid(1, 2).has_shop());
+  EXPECT_EQ(map.surface_unit(1, 2), units.find("unit001"));
+  EXPECT_EQ(map.subsurface_unit(1, 2), units.find("unit002"));
+  EXPECT_EQ(map.unit(1, 2, false), units.find("unit001"));
+  EXPECT_EQ(map.unit(1, 2, true), units.find("unit002"));
+  EXPECT_EQ(map.occupants.size(), 1);
+
+  map.set_surface_unit(1, 2, {});
+  EXPECT_FALSE(map.surface_unit(1, 2));
+  EXPECT_EQ(map.subsurface_unit(1, 2), units.find("unit002"));
+
+  map.set_unit(1, 2, true, {});
+  EXPECT_TRUE(map.grid(1, 2).empty());
+  EXPECT_FALSE(map.subsurface_unit(1, 2));
+  EXPECT_EQ(map.free_occupants.size(), 1);
+}
+
+TEST_F(TestMap, ReuseEntries) {
+  map.set_shop(0, 0, shops.find("shop001"));
+  map.set_surface_unit(3, 3, units.find("unit001"));
+  EXPECT_EQ(map.occupants.size(), 2);
+
+  map.set_shop(0, 0, {});
+  map.set_surface_unit(2, 1, units.find("unit002"));
+  EXPECT_EQ(map.occupants.size(), 2);
+  EXPECT_TRUE(map.free_occupants.empty());
+
+  EXPECT_FALSE(map.shop(0, 0));
+  EXPECT_EQ(map.surface_unit(3, 3), units.find("unit001"));
+  EXPECT_EQ(map.surface_unit(2, 1), units.find("unit002"));
+}
+
+TEST_F(TestMap, ClearEmptyHex) {
+  map.set_surface_unit(1, 1, {});
+  EXPECT_TRUE(map.grid(1, 1).empty());
+  EXPECT_EQ(map.free_occupants.size(), 1);
+
+  // released entry is reused rather than growing the table
+  map.set_shop(2, 2, shops.find("shop001"));
+  EXPECT_EQ(map.occupants.size(), 1);
+  EXPECT_EQ(map.shop(2, 2), shops.find("shop001"));
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include "state/State.hh"
+
+#include "def/Scenario.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace freeisle::state::test {
+
+/**
+ * A hand-built game for tests and benchmarks: a scenario with an empty map
+ * of the given size, and a state that refers to it. Teams, players, unit
+ * definitions, shops and units are added with the functions below, which
+ * keep the references between them and the map consistent.
+ *
+ * The scenario cannot be copied or moved, since the state points into it.
+ */
+class Scenario {
+public:
+  Scenario(uint32_t width, uint32_t height) {
+    scenario.map.grid = core::Grid<def::MapDef::Hex>(width, height);
+
+    state.scenario = &scenario;
+    state.map = Map{
+        .def = &scenario.map,
+        .grid = core::Grid<Map::Hex>(width, height),
+    };
+    state.turn_num = 1;
+  }
+
+  Scenario(const Scenario &) = delete;
+  Scenario &operator=(const Scenario &) = delete;
+
+  /**
+   * Add the players "rose" and "daisy", who are allied in team "north", and
+   * "lily", who is in no team. "rose" is at turn.
+   */
+  void add_default_players() {
+    add_team("north");
+    add_player("rose", "north");
+    add_player("daisy", "north");
+    add_player("lily");
+    state.player_at_turn = state.players.find("rose");
+  }
+
+  Team &add_team(const std::string &id) {
+    Team &team = state.teams.try_emplace(id).first->second;
+    team.name = id;
+    return team;
+  }
+
+  /**
+   * Add a player with a FoW grid covering the map, in the given team unless
+   * it is empty.
+   */
+  Player &add_player(const std::string &id, const std::string &team = "") {
+    Player &player = state.players.try_emplace(id).first->second;
+    player.name = id;
+    player.fow = core::Grid<Player::Fow>(scenario.map.grid.width(),
+                                         scenario.map.grid.height());
+    if (!team.empty()) {
+      player.team = state.teams.find(team);
+    }
+    return player;
+  }
+
+  /**
+   * Add a unit definition. Entering any terrain costs the given amount of
+   * movement, unless the definition overrides it afterwards.
+   */
+  def::UnitDef &add_unit_def(const std::string &id, def::UnitDef def,
+                             uint32_t cost = 100) {
+    std::fill(def.movement_cost.data(),
+              def.movement_cost.data() + def.movement_cost.size(), cost);
+    return scenario.units.try_emplace(id, std::move(def)).first->second;
+  }
+
+  /**
+   * Add a shop together with its definition, and place it on the map. The
+   * shop is owned by the given player unless the owner is empty.
+   */
+  Shop &add_shop(const std::string &id, const std::string &owner, uint32_t x,
+                 uint32_t y, const def::ContainerDef &container = {}) {
+    scenario.shops.try_emplace(
+        id, def::ShopDef{.container = container, .location = {.x = x, .y = y}});
+
+    const def::Collection<Shop>::iterator iter =
+        state.shops.try_emplace(id).first;
+    Shop &shop = iter->second;
+    shop.def = scenario.shops.find(id);
+    shop.container.def = &shop.def->container;
+    if (!owner.empty()) {
+      shop.owner = state.players.find(owner);
+    }
+
+    state.map.set_shop(x, y, iter);
+    return shop;
+  }
+
+  /**
+   * Add a unit of the given definition, with full health, movement, fuel
+   * and ammo. The unit is owned by the given player unless the owner is
+   * empty.
+   *
+   * The unit is placed on the map, unless the hex has a shop or another
+   * unit at the same level. In that case it is left to the caller to put
+   * the unit into the container it is in.
+   */
+  Unit &add_unit(const std::string &id, const std::string &def,
+                 const std::string &owner, uint32_t x, uint32_t y) {
+    const def::Collection<Unit>::iterator iter =
+        state.units.try_emplace(id).first;
+    Unit &unit = iter->second;
+    unit.def = scenario.units.find(def);
+    unit.location = {.x = x, .y = y};
+    unit.health = 100;
+    unit.level = unit.def->level;
+    unit.movement = unit.def->movement;
+    unit.fuel = unit.def->fuel;
+    unit.container.def = &unit.def->container;
+    for (auto weapon = unit.def->weapons.begin();
+         weapon != unit.def->weapons.end(); ++weapon) {
+      unit.ammo.emplace(weapon, weapon->second.ammo);
+    }
+
+    if (!owner.empty()) {
+      unit.owner = state.players.find(owner);
+      unit.owner->units.insert(iter);
+    }
+
+    const bool subsurface = unit.level == def::Level::UnderWater;
+    if (!state.map.grid(x, y).has_shop() &&
+        !state.map.unit(x, y, subsurface)) {
+      state.map.set_unit(x, y, subsurface, iter);
+    }
+
+    return unit;
+  }
+
+  template <typename T>
+  static def::Handle<T> handle(const def::Collection<T> &collection,
+                               const std::string &id) {
+    return def::Collection<T>::handle(collection.find(id));
+  }
+
+  def::Scenario scenario;
+  State state;
+};
+
+} // namespace freeisle::state::test
@@ -0,0 +1,65 @@
+#include "zobrist/Zobrist.hh"
+
+namespace freeisle::zobrist {
+
+namespace {
+
+template <typename T> std::string_view id(const def::NullableRef<T> &ref) {
+  return ref ? std::string_view(ref.id()) : std::string_view();
+}
+
+} // namespace
+
+uint64_t hash(std::string_view id, const state::Unit &unit) {
+  const uint64_t object = object_key(id);
+
+  uint64_t result = position_key(object, unit.location, unit.level);
+  result ^= key(Feature::UnitHealth, object, unit.health);
+  result ^= key(Feature::UnitMovement, object, unit.movement);
+  result ^= key(Feature::UnitFuel, object, unit.fuel);
+  result ^= key(Feature::UnitExperience, object, unit.experience);
+  result ^= key(Feature::UnitHasActioned, object, unit.has_actioned);
+  result ^= key(Feature::UnitHasSoared, object, unit.has_soared);
+  result ^=
+      key(Feature::UnitOwner, object, object_key(zobrist::id(unit.owner)));
+
+  for (const auto &[weapon, ammo] : unit.ammo) {
+    result ^= ammo_key(object, object_key(weapon.id()), ammo);
+  }
+
+  result ^= key(Feature::UnitSupplyFuel, object, unit.supplies.fuel);
+  result ^= key(Feature::UnitSupplyRepair, object, unit.supplies.repair);
+  for (uint32_t i = 0; i < unit.supplies.ammo.size(); ++i) {
+    const def::DamageType type = static_cast<def::DamageType>(i);
+    result ^= supply_ammo_key(object, type, unit.supplies.ammo[type]);
+  }
+
+  return result;
+}
+
+uint64_t hash(const state::State &state) {
+  uint64_t result = key(Feature::TurnNum, 0, state.turn_num);
+  result ^= key(Feature::PlayerAtTurn, 0,
+                object_key(id(state.player_at_turn)));
+
+  for (const auto &[id, player] : state.players) {
+    const uint64_t object = object_key(id);
+    result ^= key(Feature::PlayerWealth, object, player.wealth);
+    result ^= key(Feature::PlayerCaptain, object,
+                  object_key(zobrist::id(player.captain)));
+    result ^= key(Feature::PlayerEliminated, object, player.is_eliminated);
+  }
+
+  for (const auto &[id, shop] : state.shops) {
+    result ^= key(Feature::ShopOwner, object_key(id),
+                  object_key(zobrist::id(shop.owner)));
+  }
+
+  for (const auto &[id, unit] : state.units) {
+    result ^= hash(id, unit);
+  }
+
+  return result;
+}
+
+} // namespace freeisle::zobrist
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "state/State.hh"
+#include "state/Unit.hh"
+
+#include "def/DamageType.hh"
+#include "def/Level.hh"
+#include "def/Location.hh"
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Functions in zobrist compute a 64-bit hash of a game state, which can be
+ * used to recognize positions that were seen before, e.g. in a transposition
+ * table, or to deduplicate saved games.
+ *
+ * The hash is the XOR of one key for each feature of the state, such as the
+ * position of a unit or the owner of a shop. When a feature changes, the
+ * hash can be updated in constant time by XORing it with the key of the old
+ * value and the key of the new value.
+ *
+ * Keys are not drawn from a random table but computed by mixing the ID of
+ * the object with the feature and its value. This makes the hash stable
+ * across processes and independent of the order in which objects were
+ * loaded, so that hashes of saved games can be compared with each other.
+ *
+ * The hash covers the turn number, the player at turn, the owners of shops
+ * and units, the wealth, captain and elimination of players, and the
+ * location, level, health, movement, fuel, experience, action flags, ammo
+ * and supplies of units.
+ */
+namespace freeisle::zobrist {
+
+enum class Feature : uint8_t {
+  UnitPosition,
+  UnitHealth,
+  UnitMovement,
+  UnitFuel,
+  UnitExperience,
+  UnitHasActioned,
+  UnitHasSoared,
+  UnitAmmo,
+  UnitOwner,
+  ShopOwner,
+  PlayerWealth,
+  TurnNum,
+  PlayerAtTurn,
+  UnitSupplyFuel,
+  UnitSupplyRepair,
+  UnitSupplyAmmo,
+  PlayerCaptain,
+  PlayerEliminated,
+};
+
+/**
+ * Mix the bits of the given value, such that every input bit affects every
+ * output bit.
+ */
+constexpr uint64_t mix(uint64_t value) {
+  value ^= value >> 30;
+  value *= 0xbf58476d1ce4e5b9ull;
+  value ^= value >> 27;
+  value *= 0x94d049bb133111ebull;
+  value ^= value >> 31;
+  return value;
+}
+
+/**
+ * Returns the key of an object with the given ID. The empty ID, which is
+ * used for the absence of an object, has key 0.
+ */
+constexpr uint64_t object_key(std::string_view id) {
+  if (id.empty()) {
+    return 0;
+  }
+
+  uint64_t key = 0xcbf29ce484222325ull;
+  for (const char c : id) {
+    key ^= static_cast<unsigned char>(c);
+    key *= 0x100000001b3ull;
+  }
+
+  return key;
+}
+
+/**
+ * Returns the key of the given feature of the object with the given key
+ * having the given value.
+ */
+constexpr uint64_t key(Feature feature, uint64_t object, uint64_t value) {
+  return mix(object ^
+             mix((static_cast<uint64_t>(feature) << 56) ^ value ^
+                 0x9e3779b97f4a7c15ull));
+}
+
+/**
+ * Returns the key of a unit being at the given location and level.
+ */
+constexpr uint64_t position_key(uint64_t unit, def::Location location,
+                                def::Level level) {
+  return key(Feature::UnitPosition, unit,
+             static_cast<uint64_t>(location.x) |
+                 static_cast<uint64_t>(location.y) << 24 |
+                 static_cast<uint64_t>(level) << 48);
+}
+
+/**
+ * Returns the key of a unit having the given ammo for the weapon with the
+ * given key.
+ */
+constexpr uint64_t ammo_key(uint64_t unit, uint64_t weapon, uint32_t ammo) {
+  return key(Feature::UnitAmmo, unit ^ mix(weapon), ammo);
+}
+
+/**
+ * Returns the key of a unit carrying the given amount of ammo supplies of
+ * the given damage type.
+ */
+constexpr uint64_t supply_ammo_key(uint64_t unit, def::DamageType type,
+                                   uint32_t ammo) {
+  return key(Feature::UnitSupplyAmmo, unit,
+             static_cast<uint64_t>(type) << 32 | ammo);
+}
+
+/**
+ * Returns the XOR of the keys of all features of the given unit.
+ */
+uint64_t hash(std::string_view id, const state::Unit &unit);
+
+/**
+ * Compute the hash of the given state from scratch.
+ */
+uint64_t hash(const state::State &state);
+
+} // namespace freeisle::zobrist
@@ -0,0 +1,68 @@
+#include "zobrist/Zobrist.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  explicit Fixture(uint32_t num_units) : Scenario(256, num_units / 256 + 1) {
+    freeisle::def::UnitDef &tank = add_unit_def(
+        "tank", freeisle::def::UnitDef{.name = "tank",
+                                       .level = freeisle::def::Level::Land});
+    tank.weapons.try_emplace("cannon", freeisle::def::WeaponDef{.ammo = 4});
+
+    for (uint32_t i = 0; i < 4; ++i) {
+      add_player("player" + std::to_string(i));
+    }
+
+    for (uint32_t i = 0; i < num_units; ++i) {
+      add_unit("unit" + std::to_string(i), "tank",
+               "player" + std::to_string(i % 4), i % 256, i / 256);
+    }
+  }
+};
+
+/**
+ * Hashing a whole state from scratch.
+ */
+void BM_Hash(benchmark::State &state) {
+  Fixture fixture(state.range(0));
+
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(freeisle::zobrist::hash(fixture.state));
+  }
+
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+/**
+ * Updating the hash incrementally for a unit move.
+ */
+void BM_UpdateMove(benchmark::State &state) {
+  Fixture fixture(1);
+  uint64_t hash = freeisle::zobrist::hash(fixture.state);
+
+  const uint64_t object = freeisle::zobrist::object_key("unit0");
+  uint32_t x = 0;
+  for (auto _ : state) {
+    hash ^= freeisle::zobrist::position_key(object, {.x = x, .y = 0},
+                                            freeisle::def::Level::Land);
+    x = (x + 1) % 256;
+    hash ^= freeisle::zobrist::position_key(object, {.x = x, .y = 0},
+                                            freeisle::def::Level::Land);
+    benchmark::DoNotOptimize(hash);
+  }
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+} // namespace
+
+BENCHMARK(BM_Hash)->Arg(200)->Arg(2000)->Unit(benchmark::kMicrosecond);
+BENCHMARK(BM_UpdateMove);
+
+BENCHMARK_MAIN();
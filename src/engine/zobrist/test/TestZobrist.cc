@@ -0,0 +1,110 @@
+#include "zobrist/Zobrist.hh"
+
+#include "state/test/util/Scenario.hh"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Fixture : freeisle::state::test::Scenario {
+  explicit Fixture(const std::vector<std::string> &unit_ids)
+      : Scenario(5, 5) {
+    freeisle::def::UnitDef &def = add_unit_def(
+        "def001", freeisle::def::UnitDef{.name = "def001",
+                                         .level = freeisle::def::Level::Land});
+    def.weapons.try_emplace("weapon001", freeisle::def::WeaponDef{.ammo = 4});
+
+    state.turn_num = 3;
+    add_player("rose").wealth = 100;
+    add_player("lily").wealth = 200;
+    state.player_at_turn = state.players.find("rose");
+    add_shop("shop001", "lily", 4, 4);
+
+    for (const std::string &id : unit_ids) {
+      add_unit(id, "def001", "rose", static_cast<uint32_t>(id.back() - '0'),
+               2);
+    }
+  }
+};
+
+} // namespace
+
+TEST(Zobrist, ObjectKey) {
+  EXPECT_EQ(freeisle::zobrist::object_key(""), 0);
+  EXPECT_NE(freeisle::zobrist::object_key("unit001"), 0);
+  EXPECT_NE(freeisle::zobrist::object_key("unit001"),
+            freeisle::zobrist::object_key("unit002"));
+}
+
+TEST(Zobrist, IndependentOfInsertionOrder) {
+  const Fixture a({"unit1", "unit2", "unit3"});
+  const Fixture b({"unit3", "unit1", "unit2"});
+  EXPECT_EQ(freeisle::zobrist::hash(a.state),
+            freeisle::zobrist::hash(b.state));
+}
+
+TEST(Zobrist, ChangesWithState) {
+  Fixture fixture({"unit1", "unit2"});
+  const uint64_t base = freeisle::zobrist::hash(fixture.state);
+
+  fixture.state.turn_num = 4;
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+  fixture.state.turn_num = 3;
+  EXPECT_EQ(freeisle::zobrist::hash(fixture.state), base);
+
+  fixture.state.player_at_turn = fixture.state.players.find("lily");
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+  fixture.state.player_at_turn = fixture.state.players.find("rose");
+
+  fixture.state.shops["shop001"].owner =
+      freeisle::def::NullableRef<freeisle::state::Player>();
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+  fixture.state.shops["shop001"].owner = fixture.state.players.find("lily");
+
+  fixture.state.units["unit1"].ammo.begin()->second = 3;
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+  fixture.state.units["unit1"].ammo.begin()->second = 4;
+
+  freeisle::def::Resupply &supplies = fixture.state.units["unit1"].supplies;
+  supplies.ammo[freeisle::def::DamageType::Missile] = 2;
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+  supplies.ammo[freeisle::def::DamageType::Missile] = 0;
+
+  fixture.state.players["rose"].captain = fixture.state.units.find("unit2");
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+  fixture.state.players["rose"].captain =
+      freeisle::def::NullableRef<freeisle::state::Unit>();
+
+  fixture.state.players["lily"].is_eliminated = true;
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+  fixture.state.players["lily"].is_eliminated = false;
+  EXPECT_EQ(freeisle::zobrist::hash(fixture.state), base);
+
+  // Swapping the locations of two units is a different state
+  fixture.state.units["unit1"].location.x = 2;
+  fixture.state.units["unit2"].location.x = 1;
+  EXPECT_NE(freeisle::zobrist::hash(fixture.state), base);
+}
+
+TEST(Zobrist, IncrementalUpdate) {
+  Fixture fixture({"unit1", "unit2"});
+  uint64_t hash = freeisle::zobrist::hash(fixture.state);
+
+  freeisle::state::Unit &unit = fixture.state.units["unit2"];
+  const uint64_t object = freeisle::zobrist::object_key("unit2");
+  hash ^= freeisle::zobrist::position_key(object, unit.location, unit.level);
+  unit.location = {.x = 4, .y = 4};
+  unit.level = freeisle::def::Level::Air;
+  hash ^= freeisle::zobrist::position_key(object, unit.location, unit.level);
+
+  hash ^= freeisle::zobrist::key(freeisle::zobrist::Feature::UnitHealth, object,
+                                 unit.health);
+  unit.health = 40;
+  hash ^= freeisle::zobrist::key(freeisle::zobrist::Feature::UnitHealth, object,
+                                 unit.health);
+
+  EXPECT_EQ(hash, freeisle::zobrist::hash(fixture.state));
+}